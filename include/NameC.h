@@ -28,6 +28,133 @@
   control statements, declarations and directives. Expressions are created using
   Context object and passed to them. MacroFuncScope cannot contain directives.
 
+  ### AsyncEmitter
+
+  AsyncEmitter emits the regions sealed in CFile streaming mode on a
+  background thread, with a bounded queue for backpressure.
+
+  ### FlatContext
+
+  FlatContext is a compact alternative of Context and CFile for huge outputs,
+  storing a subset of nodes in struct-of-arrays tables with 32-bit indices.
+  Its builder mirrors the method names of Context, TopLevel and FuncScope.
+
+  ### GenCache
+
+  GenCache is a persistent on-disk cache of emitted code keyed by a fingerprint
+  of the generator inputs. On a hit no nodes are constructed at all.
+
+  ### RecursiveVisitor, Rewriter
+
+  RecursiveVisitor and Rewriter are CRTP bases walking the nodes of a CFile.
+  RecursiveVisitor calls visit_* hooks in pre-order, and Rewriter replaces
+  expressions and scope entries in post-order.
+
+  ### StructuralHasher
+
+  StructuralHasher computes stable 128-bit hashes of nodes from their
+  structure, memoized per node. Equal hashes mean the nodes emit the same code
+  up to comments, so they serve deduplication and on-disk cache keys.
+
+  ### fold_identical_functions
+
+  fold_identical_functions() keeps one of the top-level function definitions
+  with structurally identical bodies and replaces the others by forwarding
+  definitions, __attribute__((alias)) declarations or #define of the name.
+
+  ### eliminate_dead_decls
+
+  eliminate_dead_decls() removes the static functions and variables, typedefs,
+  structs, unions and enums in the top-levels that are unreachable from the
+  non-static declarations and the given roots, and reports the removed bytes.
+  The bodies of the functions defined by TopLevel::def_func_lazy() are built
+  only when the pass reaches them, or by materialize() before emission.
+
+  ### fold_constants
+
+  The integer literals made by Context::expr_int() and so on are IntLiteral,
+  a RawExpr with the typed value. fold_constants() evaluates the operators
+  over them with the C conversion and overflow rules, keeping the ones with
+  undefined results.
+
+  ### hoist_common_subexprs
+
+  hoist_common_subexprs() finds the pure subexpressions repeated in a
+  statement by StructuralHasher, and hoists them into const locals defined
+  just before the statement.
+
+  ### shard_file
+
+  shard_file() splits the top-level definitions of a CFile into N sources
+  balanced by emitted size, sharing one header with the directives, types,
+  prototypes and extern declarations, so that they compile in parallel.
+  Static definitions stay with the sources referring to them.
+  split_file() makes the same header and one source, so that other
+  translation units include only the declarations.
+
+  ### dedup_includes, extract_common_includes
+
+  dedup_includes() removes the includes already in effect in a file.
+  extract_common_includes() makes a PrecompiledHeader of the leading includes
+  common to many files, with a CMake snippet compiling it once.
+
+  ### order_declarations
+
+  order_declarations() sorts the top-level declarations by their uses, so
+  that a struct is defined before it is used by value, and inserts
+  `struct X;` and function prototypes for the uses that need only a
+  declaration. Directives and raw code are not moved.
+
+  ### specialize_directives
+
+  specialize_directives() evaluates the #if, #ifdef and #ifndef directives
+  over a MacroEnv of the macros known at generation time and the #define
+  before them, and splices in the live branch, so that configuration
+  specialized builds emit only the code they compile.
+
+  ### build_ref_index
+
+  build_ref_index() makes a RefIndex of the call graph, its reverse edges,
+  the call sites of each function and the uses of each VarDecl in one
+  traversal of a CFile, for the passes needing who calls whom.
+
+  ### layout_functions
+
+  layout_functions() moves the hot function definitions, by the execution
+  counts, to be contiguous and the cold ones to the end, leaving prototypes
+  behind. The hot ones are ordered by Pettis-Hansen over the call graph, so
+  that the callers and callees sit together. Optionally the hot, cold and
+  section attributes are added.
+
+  ### Attribute
+
+  FuncDecl and VarDecl have typed GNU attributes such as hot, noinline,
+  aligned(16) or target("avx2"), added by add_attr(). They are emitted in
+  both the declarations and the definitions, including the split forms.
+
+  ### Likelihood
+
+  The branches of IfStmt, WhileStmt, ForStmt, DoStmt and CaseStmt can be
+  marked as likely or unlikely by set_likelihood(), emitted by
+  __builtin_expect.
+
+  ### assign_profile_ids, instrument_profile, apply_profile
+
+  assign_profile_ids() gives the functions and the branches IDs stable
+  across generations. instrument_profile() makes the generated program count
+  them into a CSV, and Profile also reads the function counts of gcov JSON.
+  apply_profile() applies the counts to the next generation as hot and cold
+  attributes, branch likelihood and layout_functions().
+
+  ### emit_with_origins
+
+  FuncDecl and Stmt can carry an origin, such as the file and the line of
+  the model element, by set_origin() with Context::add_origin().
+  emit_with_origins() emits them with #line directives and returns
+  OriginMap, the byte ranges of them in the output, written as a sidecar
+  file by emit_to_file_with_origins(). So the profiles and the compiler
+  messages point back to the model. The plain emit() ignores the origins.
+
   ## Examples
 
   Some examples here. For more examples, visit the source code and see the
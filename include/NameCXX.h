@@ -38,6 +38,37 @@ fields, inner classes and so on. Note that here we cannot define namespaces.
 controls. The namecxx::Class class itself does not have member factory method.
 This is different point from namec::Struct.
 
+  ### RecursiveVisitor, Rewriter
+
+  The same as namec. Rewriter replaces scope entries by the return value of
+  transform_entry(), since the scopes do not own their entries.
+
+  ### fold_identical_functions
+
+  Like namec, but the bodies of the duplicates are always replaced by the
+  forwarding calls, keeping their linkage. The bodies are compared by
+  namecxx::StructuralHasher.
+
+  ### shard_file
+
+  The same as namec. The namespaces are reopened around the entries in each
+  file, and classes, templates and inline functions go to the header.
+  split_file() keeps the out-of-line MethodSplitDecl and CtorSplitDecl
+  definitions in the source, except the ones of class templates.
+
+  ### dedup_includes, extract_common_includes
+
+  The same as namec. The includes in namespace bodies are not touched.
+
+  ### build_ref_index
+
+  The same as namec, resolving the qualified names and the overloads by the
+  number of arguments.
+
+  ### Likelihood
+
+  The same as namec, emitted as [[likely]] and [[unlikely]] on the branches.
+
   ## Examples
 
   Some examples here. For more examples, visit the source code and see the
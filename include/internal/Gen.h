@@ -1,17 +1,36 @@
 #ifndef NAMEC_GEN_H
 #define NAMEC_GEN_H
 
+#include "internal/Gen/AsyncEmitter.h"
+#include "internal/Gen/Attribute.h"
+#include "internal/Gen/CommonSubexpr.h"
+#include "internal/Gen/ConstantFolding.h"
 #include "internal/Gen/Context.h"
+#include "internal/Gen/DeadDecl.h"
 #include "internal/Gen/Decl.h"
+#include "internal/Gen/DeclOrder.h"
 #include "internal/Gen/Directive.h"
 #include "internal/Gen/Emit.h"
 #include "internal/Gen/Exprs.h"
 #include "internal/Gen/File.h"
+#include "internal/Gen/FlatContext.h"
 #include "internal/Gen/Forwards.h"
-#include "internal/Gen/Mixins.h"
+#include "internal/Gen/FunctionFolding.h"
+#include "internal/Gen/Includes.h"
+#include "internal/Gen/IntValue.h"
+#include "internal/Gen/Layout.h"
+#include "internal/Gen/MixIns.h"
+#include "internal/Gen/Origin.h"
+#include "internal/Gen/Profile.h"
+#include "internal/Gen/RefIndex.h"
 #include "internal/Gen/Scope.h"
+#include "internal/Gen/Sharding.h"
+#include "internal/Gen/Specialize.h"
 #include "internal/Gen/Stmts.h"
+#include "internal/Gen/StructuralHash.h"
 #include "internal/Gen/Types.h"
+#include "internal/Gen/Visitor.h"
+#include "internal/Util/GenCache.h"
 
 namespace namec {
 // standard way to cast a pointer
@@ -0,0 +1,85 @@
+#ifndef NAMEC_GEN_ASYNC_EMITTER_H
+#define NAMEC_GEN_ASYNC_EMITTER_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#include "internal/Gen/File.h"
+
+namespace namec {
+
+/// @brief Statistics of AsyncEmitter.
+struct AsyncEmitterStats {
+  size_t Regions = 0;
+  // Number of times the generator waited for the emitter because the queue
+  // was full.
+  size_t Stalls = 0;
+};
+
+/**
+  @brief AsyncEmitter emits the regions sealed in CFile streaming mode on a
+  background thread, while the generator builds the next region.
+
+  Sealed regions are passed over a bounded queue. When the queue is full,
+  seal() blocks until the emitter pops one, so at most MaxRegions sealed
+  regions are alive at once even if the output is slower than the
+  generation. The background thread also destroys the regions. The lazy
+  functions of a region are built by seal() before it is queued.
+
+  The generator must not touch the nodes of sealed regions, as in streaming
+  mode. Types are shared with the emitter, but only read by it.
+
+  If emitting throws, the rest of the regions are discarded and finish()
+  rethrows the exception. The attached CFile must outlive this. Destroying
+  this ends its streaming mode, leaving the unsealed entries in it.
+
+  ```cpp
+  std::ofstream OS("out.c");
+  AsyncEmitter E(OS);
+  E.attach(F);
+  // ... build and seal ...
+  F.end_stream();
+  E.finish();
+  ```
+ */
+class AsyncEmitter {
+  std::ostream &OS;
+  size_t MaxRegions;
+  std::deque<std::unique_ptr<SealedRegion>> Queue;
+  bool IsDone = false;
+  // The exception thrown by emitting, rethrown by finish().
+  std::exception_ptr Error;
+  std::mutex Mutex;
+  std::condition_variable CV;
+  AsyncEmitterStats Stats;
+  CFile *Attached = nullptr;
+  std::thread Worker;
+
+  void push(std::unique_ptr<SealedRegion> R);
+  void run();
+  void stop();
+
+public:
+  AsyncEmitter(std::ostream &OS, size_t MaxRegions = 16);
+  AsyncEmitter(const AsyncEmitter &) = delete;
+  AsyncEmitter &operator=(const AsyncEmitter &) = delete;
+  ~AsyncEmitter();
+
+  /// @brief Start streaming mode of F, emitting its sealed regions by this.
+  void attach(CFile &F);
+  /// @brief Wait until all the pushed regions are emitted and stop the
+  /// thread. Call this after CFile::end_stream(). Rethrows the exception
+  /// thrown by emitting, if any.
+  void finish();
+  /// @brief Only valid after finish().
+  AsyncEmitterStats get_stats() { return Stats; }
+};
+
+} // namespace namec
+
+#endif // NAMEC_GEN_ASYNC_EMITTER_H
@@ -0,0 +1,113 @@
+#ifndef NAMEC_GEN_ATTRIBUTE_H
+#define NAMEC_GEN_ATTRIBUTE_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace namec {
+
+enum class AttributeKind {
+  Hot,
+  Cold,
+  AlwaysInline,
+  NoInline,
+  Pure,
+  Const,
+  Flatten,
+  Aligned,
+  Visibility,
+  Target,
+  Section,
+  Destructor,
+};
+
+/**
+  @brief GNU attribute of a declaration, such as hot or section(".text.hot").
+  The attributes of a declaration are emitted together before it, as
+  __attribute__((hot,section(".text.hot"))).
+
+  hot, cold, always_inline, noinline, pure, const, flatten, target and
+  destructor are for functions, and aligned, visibility and section are for
+  both functions and variables. They are not checked against the declaration.
+ */
+class Attribute {
+  AttributeKind Kind;
+  // The argument, such as the section name.
+  std::string Arg;
+
+public:
+  Attribute(AttributeKind Kind, std::string Arg = "")
+      : Kind(Kind), Arg(std::move(Arg)) {}
+  static Attribute hot() { return Attribute(AttributeKind::Hot); }
+  static Attribute cold() { return Attribute(AttributeKind::Cold); }
+  static Attribute always_inline() {
+    return Attribute(AttributeKind::AlwaysInline);
+  }
+  static Attribute noinline() { return Attribute(AttributeKind::NoInline); }
+  static Attribute pure() { return Attribute(AttributeKind::Pure); }
+  /// @brief The const attribute, for the functions reading no memory.
+  static Attribute const_() { return Attribute(AttributeKind::Const); }
+  static Attribute flatten() { return Attribute(AttributeKind::Flatten); }
+  /// @brief aligned(Align), or aligned without the argument for the largest
+  /// alignment of the target if Align is 0.
+  static Attribute aligned(size_t Align = 0) {
+    return Attribute(AttributeKind::Aligned,
+                     Align ? std::to_string(Align) : "");
+  }
+  /// @brief Visibility is default, hidden, internal or protected.
+  static Attribute visibility(std::string Visibility) {
+    return Attribute(AttributeKind::Visibility, std::move(Visibility));
+  }
+  /// @brief Options is such as "avx2" or "arch=haswell".
+  static Attribute target(std::string Options) {
+    return Attribute(AttributeKind::Target, std::move(Options));
+  }
+  static Attribute section(std::string Name) {
+    return Attribute(AttributeKind::Section, std::move(Name));
+  }
+  /// @brief The destructor attribute, to run the function at exit.
+  static Attribute destructor() {
+    return Attribute(AttributeKind::Destructor);
+  }
+
+  AttributeKind get_kind() const { return Kind; }
+  const std::string &get_arg() const { return Arg; }
+  /// @brief The attribute without __attribute__, such as section(".text").
+  std::string to_string() const;
+};
+
+/// @brief Emit __attribute__((...)) of Attrs followed by a space, or nothing
+/// if empty.
+void emit_attributes(std::ostream &SS, const std::vector<Attribute> &Attrs);
+
+/**
+  @brief The attributes of FuncDecl and VarDecl, at most one of each kind.
+  They are emitted in the order of addition, both in the declarations and in
+  the definitions, so that the split forms agree.
+ */
+class Attributed {
+  std::vector<Attribute> Attrs;
+
+public:
+  /// @brief Add the attribute A, replacing the one of the same kind.
+  void add_attr(Attribute A);
+  /// @brief Remove the attribute of Kind if any.
+  void remove_attr(AttributeKind Kind);
+  /// @brief nullptr if no attribute of Kind.
+  const Attribute *get_attr(AttributeKind Kind) const;
+  bool has_attr(AttributeKind Kind) const { return get_attr(Kind); }
+  const std::vector<Attribute> &attrs() const { return Attrs; }
+  /// @brief Add the attributes of Other.
+  void copy_attrs(const Attributed &Other);
+
+protected:
+  void emit_attrs(std::ostream &SS) const { emit_attributes(SS, Attrs); }
+  /// @brief Mark the node having the attributes modified.
+  virtual void note_attrs_modified() = 0;
+};
+
+} // namespace namec
+
+#endif // NAMEC_GEN_ATTRIBUTE_H
@@ -0,0 +1,47 @@
+#ifndef NAMEC_GEN_COMMON_SUBEXPR_H
+#define NAMEC_GEN_COMMON_SUBEXPR_H
+
+#include <cstddef>
+#include <string>
+
+#include "internal/Gen/Forwards.h"
+
+namespace namec {
+
+struct CSEStats {
+  size_t Hoisted = 0;  // const locals defined.
+  size_t Replaced = 0; // Occurrences replaced by them.
+};
+
+/**
+  @brief Hoist the subexpressions repeated in a statement of S and its nested
+  scopes into const locals defined by def_var() just before the statement.
+
+  The subexpressions are found by StructuralHasher. Only pure operators over
+  variables, literals and plain names are hoisted, without calls,
+  assignments or increments. Only the occurrences evaluated unconditionally
+  and not sequenced after other parts of the statement are counted and
+  replaced, i.e. not in the right of &&, || and comma, nor in the branches of
+  ?:. So evaluating them once before the statement is one of the orders C
+  allows. The conditions of loops and else-ifs, which are evaluated
+  repeatedly or conditionally, are left as they are.
+
+  The largest repeated subexpression is hoisted first, and then the ones in
+  its initializer. The type of the local is inferred for the integer
+  arithmetic of the builtin types and the pointer arithmetic over variables
+  and casts; the subexpressions of the other types are not hoisted. The
+  locals of pointer types are not const, which would qualify the pointee.
+  Reads of volatile variables are not pure. The first statement of a case
+  goes into a block with its locals, since a declaration cannot follow a
+  label before C23. The locals are named Prefix followed by a number unique
+  in S.
+ */
+CSEStats hoist_common_subexprs(Context &C, FuncScope *S,
+                               const std::string &Prefix = "_cse");
+/// @brief Hoist in the body of each function defined in the top-levels of F.
+CSEStats hoist_common_subexprs(Context &C, CFile &F,
+                               const std::string &Prefix = "_cse");
+
+} // namespace namec
+
+#endif // NAMEC_GEN_COMMON_SUBEXPR_H
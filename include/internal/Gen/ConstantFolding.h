@@ -0,0 +1,37 @@
+#ifndef NAMEC_GEN_CONSTANT_FOLDING_H
+#define NAMEC_GEN_CONSTANT_FOLDING_H
+
+#include <cstddef>
+#include <optional>
+
+#include "internal/Gen/Forwards.h"
+#include "internal/Gen/IntValue.h"
+
+namespace namec {
+
+/// @brief The value of E if it is an IntLiteral, possibly in parentheses.
+std::optional<IntValue> get_int_constant(Expr *E);
+/// @brief The IntKind of the builtin type T such as type_int().
+std::optional<IntKind> get_int_kind(Type *T);
+/// @brief The builtin type of the IntKind.
+Type *get_int_type(Context &C, IntKind K);
+
+/**
+  @brief Fold the integer UnaryOp, BinaryOp and TernaryOp over IntLiterals in
+  E, and the parentheses around the literals. Returns the folded E.
+
+  Evaluation follows C (eval_binary()), and operations with undefined or
+  implementation-defined results are kept. RawExpr other than IntLiteral is
+  never looked into. The identities such as x + 0 and x * 1 are folded only
+  when x is a variable of the same integer type as the literal, so that the
+  type of the expression does not change. Negative results are parenthesized,
+  since the operators are emitted without spaces.
+ */
+Expr *fold_constants(Context &C, Expr *E);
+/// @brief Fold all the expressions in F. Returns the number of replaced
+/// expressions.
+size_t fold_constants(Context &C, CFile &F);
+
+} // namespace namec
+
+#endif // NAMEC_GEN_CONSTANT_FOLDING_H
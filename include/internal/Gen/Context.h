@@ -1,7 +1,9 @@
 #ifndef NAMEC_GEN_CONTEXT_H
 #define NAMEC_GEN_CONTEXT_H
 
-#include "Util/CommonMixins.h"
+#include <unordered_set>
+
+#include "internal/Util/CommonMixins.h"
 #include "internal/Gen/Decl.h"
 #include "internal/Gen/Exprs.h"
 #include "internal/Gen/Forwards.h"
@@ -89,6 +91,7 @@ class Context
   std::map<Type *, Pointer *> PointerTypeMap;
   std::map<Type *, Array *> ArrayTypeMap;
   std::map<Decl *, Named *> NamedTypeMap;
+  OriginTable Origins;
 
   template <typename T> T *add_decl(T *D) {
     Decls.push_back(std::unique_ptr<Decl>(D));
@@ -118,6 +121,35 @@ public:
 
   FuncScope *add_scope();
 
+  /// @brief Position in the node arena. See take_arena_since().
+  struct ArenaMark {
+    size_t Scopes = 0;
+    size_t Decls = 0;
+    size_t Exprs = 0;
+  };
+  /// @brief Nodes taken out of the arena. They are destroyed with this.
+  struct ArenaRegion {
+    std::vector<std::unique_ptr<FuncScope>> Scopes;
+    std::vector<std::unique_ptr<Decl>> Decls;
+    std::vector<std::unique_ptr<Expr>> Exprs;
+  };
+  ArenaMark get_arena_mark() {
+    return {Scopes.size(), Decls.size(), Exprs.size()};
+  }
+  /// @brief Take the ownership of the scopes, decls and exprs created after M.
+  /// Types are kept in the Context since they are shared and cached.
+  ArenaRegion take_arena_since(ArenaMark M);
+  /// @brief The scopes, decls and exprs created after M, the ones
+  /// take_arena_since() would take.
+  std::unordered_set<const void *> get_arena_since(ArenaMark M);
+
+  /// @brief Add the origin File:Line for set_origin() of FuncDecl and Stmt,
+  /// such as the model element or __FILE__ and __LINE__ of the generator.
+  OriginId add_origin(const std::string &File, unsigned Line) {
+    return Origins.add(File, Line);
+  }
+  const OriginTable &get_origins() { return Origins; }
+
 private:
   // Decl factory APIs. Not public to user. Intended to be used by internal
   // VarInitialize in File and Scope.
@@ -158,8 +190,29 @@ public:
                                std::vector<Expr *> Size, Expr *Init = nullptr) {
     return add_decl(new ArrayVarDecl(Name, T, Size, Init));
   }
-  RawExpr *expr_true() { return expr_raw("1"); }
-  RawExpr *expr_false() { return expr_raw("0"); }
+  // Integer literals typed for fold_constants(). They override the ones of
+  // LiteralExprAPIMixin, with the same spellings.
+  IntLiteral *expr_int_value(IntValue V) { return add_expr(new IntLiteral(V)); }
+  IntLiteral *expr_int(int Val) override {
+    return expr_int_value(IntValue(IntKind::Int, Val));
+  }
+  IntLiteral *expr_uint(unsigned int Val) override {
+    return expr_int_value(IntValue(IntKind::UInt, Val));
+  }
+  IntLiteral *expr_long(long Val) override {
+    return expr_int_value(IntValue(IntKind::Long, Val));
+  }
+  IntLiteral *expr_ulong(unsigned long Val) override {
+    return expr_int_value(IntValue(IntKind::ULong, Val));
+  }
+  IntLiteral *expr_llong(long long Val) override {
+    return expr_int_value(IntValue(IntKind::LLong, Val));
+  }
+  IntLiteral *expr_ullong(unsigned long long Val) override {
+    return expr_int_value(IntValue(IntKind::ULLong, Val));
+  }
+  IntLiteral *expr_true() { return expr_int_value(IntValue::of_bool(true)); }
+  IntLiteral *expr_false() { return expr_int_value(IntValue::of_bool(false)); }
 
   RawExpr *expr_nullptr() { return expr_raw("((void*)0)"); }
   VariableExpr *expr_var(VarDecl *D) { return add_expr(new VariableExpr(D)); }
@@ -0,0 +1,40 @@
+#ifndef NAMEC_GEN_DEAD_DECL_H
+#define NAMEC_GEN_DEAD_DECL_H
+
+#include <cstddef>
+
+#include "internal/Gen/Forwards.h"
+
+namespace namec {
+
+struct DeadDeclStats {
+  size_t Removed = 0; // Entries removed from the top-levels.
+  size_t Bytes = 0;   // Bytes of the emitted code removed.
+  size_t Unbuilt = 0; // Lazy functions removed without being built, which
+                      // are not counted in Bytes.
+};
+
+/**
+  @brief Remove the internal declarations in the top-levels of F that are not
+  reachable from the roots, before emission.
+
+  The candidates are static functions and variables, typedefs, structs,
+  unions and enums defined directly in the top-levels. Everything else is a
+  root: non-static functions and variables, other statements, directives and
+  the entries in #if branches, plus the declarations named in ExtraRoots, such
+  as the ones exported by address or by a version script.
+
+  The references are followed through VariableExpr, Named and the aliases of
+  TypedefDecl. Functions are referred by names in the callees of CallExpr,
+  so the identifiers in all raw code (RawExpr, RawStmt, RawType, directives
+  and so on) are conservatively taken as references.
+
+  Lazy functions (TopLevel::def_func_lazy) are materialized when reached, so
+  the unreachable ones are removed without being built.
+ */
+DeadDeclStats
+eliminate_dead_decls(CFile &F, const std::vector<std::string> &ExtraRoots = {});
+
+} // namespace namec
+
+#endif // NAMEC_GEN_DEAD_DECL_H
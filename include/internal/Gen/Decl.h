@@ -1,14 +1,42 @@
 #ifndef NAMEC_GEN_DECL_H
 #define NAMEC_GEN_DECL_H
 
+#include <functional>
+
+#include "internal/Gen/Attribute.h"
 #include "internal/Gen/Emit.h"
 #include "internal/Gen/Forwards.h"
+#include "internal/Gen/Origin.h"
 
 namespace namec {
 
+/// @brief Kind of Decl, to dispatch on the node class without dynamic_cast.
+enum class DeclKind {
+  Raw,
+  Var,
+  ArrayVar,
+  Typedef,
+  Func,
+  FuncSplit,
+  FuncSplitForward,
+  Struct,
+  Union,
+  Enum,
+};
+
 class Decl : public Emit {
+  DeclKind Kind;
+
+protected:
+  Decl(DeclKind Kind) : Emit(EmitKind::Decl), Kind(Kind) {}
+
 public:
   virtual ~Decl() = default;
+  DeclKind get_kind() { return Kind; }
+  bool is_var() { return Kind == DeclKind::Var || Kind == DeclKind::ArrayVar; }
+  bool is_func() {
+    return Kind == DeclKind::Func || Kind == DeclKind::FuncSplit;
+  }
   virtual void emit_impl(std::ostream &SS) = 0;
   virtual std::string get_name() = 0;
 };
@@ -17,7 +45,7 @@ class RawDecl : public Decl {
   std::string Val;
 
 public:
-  RawDecl(std::string Val) : Val(Val) {}
+  RawDecl(std::string Val) : Decl(DeclKind::Raw), Val(Val) {}
   std::string get_val() { return Val; }
   std::string get_name() override { return Val; }
 
@@ -25,7 +53,7 @@ protected:
   void emit_impl(std::ostream &SS) override;
 };
 
-class VarDecl : public Decl {
+class VarDecl : public Decl, public Attributed {
   Type *Ty;
   std::string Name;
   Expr *Init = nullptr;
@@ -36,26 +64,54 @@ class VarDecl : public Decl {
   bool IsVolatile = false;
   bool IsRestrict = false;
 
+protected:
+  VarDecl(DeclKind Kind, std::string Name, Type *Ty, Expr *Init)
+      : Decl(Kind), Ty(Ty), Name(Name), Init(Init) {}
+
 public:
-  VarDecl(std::string Name, Type *Ty) : Ty(Ty), Name(Name) {}
+  VarDecl(std::string Name, Type *Ty)
+      : VarDecl(DeclKind::Var, Name, Ty, nullptr) {}
   VarDecl(std::string Name, Type *Ty, Expr *Init)
-      : Ty(Ty), Name(Name), Init(Init) {}
+      : VarDecl(DeclKind::Var, Name, Ty, Init) {}
   Type *get_type() { return Ty; }
   std::string get_name() override { return Name; }
   Expr *get_init() { return Init; }
-  void set_const(bool IsConst) { this->IsConst = IsConst; }
+  void set_init(Expr *E) {
+    Init = E;
+    note_modified();
+  }
+  void set_const(bool IsConst) {
+    this->IsConst = IsConst;
+    note_modified();
+  }
   bool is_const() { return IsConst; }
-  void set_extern(bool IsExtern) { this->IsExtern = IsExtern; }
+  void set_extern(bool IsExtern) {
+    this->IsExtern = IsExtern;
+    note_modified();
+  }
   bool is_extern() { return IsExtern; }
-  void set_static(bool IsStatic) { this->IsStatic = IsStatic; }
+  void set_static(bool IsStatic) {
+    this->IsStatic = IsStatic;
+    note_modified();
+  }
   bool is_static() { return IsStatic; }
-  void set_volatile(bool IsVolatile) { this->IsVolatile = IsVolatile; }
+  void set_volatile(bool IsVolatile) {
+    this->IsVolatile = IsVolatile;
+    note_modified();
+  }
   bool is_volatile() { return IsVolatile; }
-  void set_restrict(bool IsRestrict) { this->IsRestrict = IsRestrict; }
+  void set_restrict(bool IsRestrict) {
+    this->IsRestrict = IsRestrict;
+    note_modified();
+  }
   bool is_restrict() { return IsRestrict; }
+  /// @brief Emit the extern declaration of this variable, without the
+  /// initializer.
+  virtual void emit_extern(std::ostream &SS);
 
 protected:
   void emit_impl(std::ostream &SS) override;
+  void note_attrs_modified() override { note_modified(); }
 };
 
 class ArrayVarDecl : public VarDecl {
@@ -64,13 +120,14 @@ class ArrayVarDecl : public VarDecl {
 public:
   using size_iterator = decltype(Size)::iterator;
   ArrayVarDecl(std::string Name, Type *Ty, std::vector<Expr *> Size)
-      : VarDecl(Name, Ty), Size(Size) {}
+      : VarDecl(DeclKind::ArrayVar, Name, Ty, nullptr), Size(Size) {}
   ArrayVarDecl(std::string Name, Type *Ty, std::vector<Expr *> Size, Expr *Init)
-      : VarDecl(Name, Ty, Init), Size(Size) {}
+      : VarDecl(DeclKind::ArrayVar, Name, Ty, Init), Size(Size) {}
   std::vector<Expr *> get_size() { return Size; }
   IteratorRange<size_iterator> sizes() {
     return IteratorRange<size_iterator>(Size.begin(), Size.end());
   }
+  void emit_extern(std::ostream &SS) override;
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -80,7 +137,7 @@ class TypedefDecl : public Decl {
   TypeAlias *TA;
 
 public:
-  TypedefDecl(TypeAlias *TA) : TA(TA) {}
+  TypedefDecl(TypeAlias *TA) : Decl(DeclKind::Typedef), TA(TA) {}
   TypeAlias *get_type_alias() { return TA; }
   std::string get_name() override;
 
@@ -89,7 +146,7 @@ protected:
 };
 
 class FuncSplitForwardDecl;
-class FuncDecl : public Decl {
+class FuncDecl : public Decl, public Attributed {
   friend class FuncSplitForwardDecl;
 
 protected:
@@ -100,34 +157,81 @@ protected:
   // Empty for declaration
   FuncScope *Body = nullptr;
   bool IsVarArg;
+  // Non-empty for an alias declaration of another function.
+  std::string Alias;
+  // Builds the body on materialize() for a lazy definition.
+  std::function<void(FuncScope *)> Builder;
 
   bool IsExtern = false;
   bool IsStatic = false;
+  OriginId Origin = 0;
+
+  FuncDecl(DeclKind Kind, Context &C, std::string Name, Type *RetTy,
+           std::vector<VarDecl *> Params, bool IsVarArg)
+      : Decl(Kind), C(C), RetTy(RetTy), Name(Name), Params(Params),
+        IsVarArg(IsVarArg) {}
 
 public:
   using param_iterator = decltype(Params)::iterator;
   FuncDecl(Context &C, std::string Name, Type *RetTy,
            std::vector<VarDecl *> Params, bool IsVarArg)
-      : C(C), RetTy(RetTy), Name(Name), Params(Params), IsVarArg(IsVarArg) {}
+      : FuncDecl(DeclKind::Func, C, Name, RetTy, Params, IsVarArg) {}
   Type *get_ret_type() { return RetTy; }
   std::string get_name() override { return Name; }
   std::vector<VarDecl *> get_params() { return Params; }
   IteratorRange<param_iterator> params() {
     return IteratorRange<param_iterator>(Params.begin(), Params.end());
   }
+  /// @brief nullptr for declaration.
+  FuncScope *get_body() { return Body; }
   FuncScope *get_or_add_body();
-  void set_extern(bool IsExtern) { this->IsExtern = IsExtern; }
+  /// @brief Discard the body and start a new empty one.
+  FuncScope *replace_body();
+  /// @brief Make this an alias of the function Target by
+  /// __attribute__((alias)), dropping the body. Target must be defined in the
+  /// same translation unit.
+  void set_alias(std::string Target) {
+    Alias = Target;
+    Body = nullptr;
+    Builder = nullptr;
+    note_modified();
+  }
+  std::string get_alias() { return Alias; }
+  /// @brief Make this a lazy definition whose body is built by Builder on
+  /// materialize(). Until then get_body() is nullptr.
+  void set_builder(std::function<void(FuncScope *)> Builder) {
+    this->Builder = std::move(Builder);
+    note_modified();
+  }
+  bool is_lazy() { return Builder != nullptr; }
+  /// @brief Build the body of a lazy definition if not yet. Called before
+  /// emission by the enclosing TopLevel, and by eliminate_dead_decls() when
+  /// it is reachable.
+  void materialize() override;
+  void set_extern(bool IsExtern) {
+    this->IsExtern = IsExtern;
+    note_modified();
+  }
   bool is_extern() { return IsExtern; }
-  void set_static(bool IsStatic) { this->IsStatic = IsStatic; }
+  void set_static(bool IsStatic) {
+    this->IsStatic = IsStatic;
+    note_modified();
+  }
   bool is_static() { return IsStatic; }
-  bool is_forward() { return !Body; }
+  /// @brief The origin by Context::add_origin(), for emit_with_origins().
+  void set_origin(OriginId Origin) { this->Origin = Origin; }
+  OriginId get_origin() { return Origin; }
+  bool is_forward() { return !Body && !Builder; }
   bool is_vararg() { return IsVarArg; }
   virtual bool is_split_definition() { return false; }
+  /// @brief Emit the prototype of this function.
+  void emit_forward(std::ostream &SS) { emit_impl_impl(SS, true, false); }
 
 protected:
   virtual void emit_impl_impl(std::ostream &SS, bool IsForward,
                               bool IsSplitDefinition);
   void emit_impl(std::ostream &SS) override;
+  void note_attrs_modified() override { note_modified(); }
 };
 
 class FuncSplitDecl : public FuncDecl {
@@ -135,11 +239,10 @@ class FuncSplitDecl : public FuncDecl {
 public:
   FuncSplitDecl(Context &C, std::string Name, Type *RetTy,
                 std::vector<VarDecl *> Params, bool IsVarArg)
-      : FuncDecl(C, Name, RetTy, Params, IsVarArg) {
+      : FuncDecl(DeclKind::FuncSplit, C, Name, RetTy, Params, IsVarArg) {
     get_or_add_body();
   }
   bool is_split_definition() override { return true; }
-  FuncScope *get_body() { return get_or_add_body(); }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -151,7 +254,8 @@ protected:
   FuncSplitDecl *FD;
 
 public:
-  FuncSplitForwardDecl(FuncSplitDecl *FD) : FD(FD) {}
+  FuncSplitForwardDecl(FuncSplitDecl *FD)
+      : Decl(DeclKind::FuncSplitForward), FD(FD) {}
   FuncDecl *get_func_decl() { return FD; }
   std::string get_name() override { return FD->get_name(); }
 
@@ -164,7 +268,8 @@ class StructDecl : public Decl {
   bool IsForward;
 
 public:
-  StructDecl(Struct *S, bool IsForward) : S(S), IsForward(IsForward) {}
+  StructDecl(Struct *S, bool IsForward)
+      : Decl(DeclKind::Struct), S(S), IsForward(IsForward) {}
   Struct *get_struct() { return S; }
   std::string get_name() override;
   bool is_forward() { return IsForward; }
@@ -178,7 +283,8 @@ class UnionDecl : public Decl {
   bool IsForward = false;
 
 public:
-  UnionDecl(Union *U, bool IsForward) : U(U), IsForward(IsForward) {}
+  UnionDecl(Union *U, bool IsForward)
+      : Decl(DeclKind::Union), U(U), IsForward(IsForward) {}
   Union *get_union() { return U; }
   std::string get_name() override;
   bool is_forward() { return IsForward; }
@@ -192,7 +298,8 @@ class EnumDecl : public Decl {
   bool IsForward = false;
 
 public:
-  EnumDecl(Enum *E, bool IsForward) : E(E), IsForward(IsForward) {}
+  EnumDecl(Enum *E, bool IsForward)
+      : Decl(DeclKind::Enum), E(E), IsForward(IsForward) {}
   Enum *get_enum() { return E; }
   std::string get_name() override;
   bool is_forward() { return IsForward; }
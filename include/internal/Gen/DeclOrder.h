@@ -0,0 +1,46 @@
+#ifndef NAMEC_GEN_DECL_ORDER_H
+#define NAMEC_GEN_DECL_ORDER_H
+
+#include <cstddef>
+
+#include "internal/Gen/Forwards.h"
+
+namespace namec {
+
+struct DeclOrderStats {
+  size_t Moved = 0;    // Entries placed at a different position.
+  size_t Forwards = 0; // Forward declarations inserted.
+  size_t Cycles = 0;   // Runs left partially unordered by a cycle of complete
+                       // type uses, such as structs containing each other.
+};
+
+/**
+  @brief Order the declarations in the top-levels of F by their dependencies,
+  and insert the forward declarations needed, so that the definitions can be
+  generated in any order.
+
+  The declarations ordered are structs, unions, enums, typedefs, functions
+  and variables. They are moved only within the runs between the other
+  entries, such as directives and RawDecl, which stay in place. In each run
+  the definitions are topologically sorted, keeping the original order where
+  it is free.
+
+  A use needing the complete type, such as a member or a variable of the
+  struct, needs the definition before it. A use only through Pointer, a
+  typedef of the struct or a parameter of a prototype needs only a
+  declaration, so a forward `struct X;` is inserted if the definition comes
+  later. A call of a function defined later gets a prototype. Function
+  bodies are conservatively taken to need the complete types they use.
+
+  Named types, typedef aliases, VariableExpr and the identifiers in raw
+  expressions and statements are followed; RawType is not. The lazy bodies
+  not built yet are left unbuilt, taken to use everything: such a function
+  follows the types and the variables of its run, and the prototypes of all
+  the functions not declared yet precede the first one. Build them by
+  materialize() or eliminate_dead_decls() first for the exact order.
+ */
+DeclOrderStats order_declarations(CFile &F);
+
+} // namespace namec
+
+#endif // NAMEC_GEN_DECL_ORDER_H
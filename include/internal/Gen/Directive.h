@@ -6,10 +6,35 @@
 
 namespace namec {
 
-class Directive : public Emit {
+/// @brief Kind of Directive, to dispatch on the node class without
+/// dynamic_cast.
+enum class DirectiveKind {
+  Include,
+  Raw,
+  SystemInclude,
+  Define,
+  DefineFuncMacro,
+  Undef,
+  Pragma,
+  If,
+  Ifdef,
+  Ifndef,
+};
+
+class Directive : public ScopeEntry {
+  DirectiveKind Kind;
+
+protected:
+  Directive(DirectiveKind Kind) : ScopeEntry(EmitKind::Directive), Kind(Kind) {}
 
 public:
   virtual ~Directive() = default;
+  DirectiveKind get_kind() { return Kind; }
+  /// @brief #if, #ifdef or #ifndef, which is IfDirectiveBase.
+  bool is_if() {
+    return Kind == DirectiveKind::If || Kind == DirectiveKind::Ifdef ||
+           Kind == DirectiveKind::Ifndef;
+  }
   virtual void emit_impl(std::ostream &SS) = 0;
 };
 
@@ -17,7 +42,8 @@ class Include : public Directive {
   std::string Path;
 
 public:
-  Include(std::string Path) : Path(Path) {}
+  Include(std::string Path)
+      : Directive(DirectiveKind::Include), Path(Path) {}
   std::string get_path() { return Path; }
 
 protected:
@@ -26,10 +52,14 @@ protected:
 
 class RawDirective : public Directive {
   std::string Val;
+  bool IsTrivia;
 
 public:
-  RawDirective(std::string Val) : Val(Val) {}
+  RawDirective(std::string Val, bool IsTrivia = false)
+      : Directive(DirectiveKind::Raw), Val(Val), IsTrivia(IsTrivia) {}
   std::string get_val() { return Val; }
+  /// @brief Whether this is a comment or whitespace by insert_comment() etc.
+  bool is_trivia() { return IsTrivia; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -39,7 +69,8 @@ class SystemInclude : public Directive {
   std::string Path;
 
 public:
-  SystemInclude(std::string Path) : Path(Path) {}
+  SystemInclude(std::string Path)
+      : Directive(DirectiveKind::SystemInclude), Path(Path) {}
   std::string get_path() { return Path; }
 
 protected:
@@ -53,7 +84,8 @@ class Define : public Directive {
   std::string Value;
 
 public:
-  Define(std::string Name, std::string Value) : Name(Name), Value(Value) {}
+  Define(std::string Name, std::string Value)
+      : Directive(DirectiveKind::Define), Name(Name), Value(Value) {}
   std::string get_name() { return Name; }
   std::string get_value() { return Value; }
 
@@ -87,7 +119,7 @@ class Undef : public Directive {
   std::string Name;
 
 public:
-  Undef(std::string Name) : Name(Name) {}
+  Undef(std::string Name) : Directive(DirectiveKind::Undef), Name(Name) {}
   std::string get_name() { return Name; }
 
 protected:
@@ -99,7 +131,8 @@ class Pragma : public Directive {
   std::string Value;
 
 public:
-  Pragma(std::string Value) : Value(Value) {}
+  Pragma(std::string Value)
+      : Directive(DirectiveKind::Pragma), Value(Value) {}
   std::string get_value() { return Value; }
 
 protected:
@@ -117,11 +150,18 @@ protected:
   // TODO: elif
 
 public:
-  IfDirectiveBase(Context &C);
+  IfDirectiveBase(Context &C, DirectiveKind Kind);
+  using elif_iterator = decltype(Elifs)::iterator;
   TopLevel *get_then() { return Then.get(); }
   TopLevel *add_elif(Expr *Cond);
+  IteratorRange<elif_iterator> elifs() {
+    return IteratorRange<elif_iterator>(Elifs.begin(), Elifs.end());
+  }
   bool has_else() { return Else.get() != nullptr; }
+  /// @brief nullptr if no else.
+  TopLevel *get_else() { return Else.get(); }
   TopLevel *get_or_add_else();
+  void materialize() override;
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -136,6 +176,10 @@ public:
   IfDirective(Context &C, Expr *Cond);
   virtual ~IfDirective() = default;
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) {
+    Cond = E;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -145,7 +189,8 @@ class Ifdef : public IfDirectiveBase {
   std::string CondStr;
 
 public:
-  Ifdef(Context &C, std::string Cond) : IfDirectiveBase(C), CondStr(Cond) {}
+  Ifdef(Context &C, std::string Cond)
+      : IfDirectiveBase(C, DirectiveKind::Ifdef), CondStr(Cond) {}
   std::string get_cond() { return CondStr; }
 
 protected:
@@ -156,7 +201,8 @@ class Ifndef : public IfDirectiveBase {
   std::string CondStr;
 
 public:
-  Ifndef(Context &C, std::string Cond) : IfDirectiveBase(C), CondStr(Cond) {}
+  Ifndef(Context &C, std::string Cond)
+      : IfDirectiveBase(C, DirectiveKind::Ifndef), CondStr(Cond) {}
   std::string get_cond() { return CondStr; }
 
 protected:
@@ -1,18 +1,82 @@
 #ifndef NAMEC_GEN_EMIT_H
 #define NAMEC_GEN_EMIT_H
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
 #include "internal/Gen/Forwards.h"
+#include "internal/Util/ChunkStream.h"
 
 namespace namec {
 
+class Emit;
+
+/**
+  @brief ModificationListener is told of each node modified on the thread
+  that constructed it, while it is alive. It must be destroyed on the same
+  thread. The caches over the nodes, such as StructuralHasher, drop the
+  entries of the modified node and of the nodes containing it.
+ */
+class ModificationListener {
+  static std::vector<ModificationListener *> &listeners() {
+    static thread_local std::vector<ModificationListener *> Listeners;
+    return Listeners;
+  }
+
+public:
+  ModificationListener() { listeners().push_back(this); }
+  ModificationListener(const ModificationListener &) : ModificationListener() {}
+  ModificationListener &operator=(const ModificationListener &) {
+    return *this;
+  }
+  virtual ~ModificationListener() {
+    auto &L = listeners();
+    L.erase(std::find(L.begin(), L.end(), this));
+  }
+  virtual void on_modified(const Emit *E) = 0;
+
+  /// @brief Tell the listeners of this thread that E is modified.
+  static void notify(const Emit *E) {
+    for (auto *L : listeners()) {
+      L->on_modified(E);
+    }
+  }
+};
+
+// Source of Emit::Id, in all the contexts.
+inline std::atomic<uint64_t> NextEmitId{0};
+
+/// @brief Kind of the entries of the scopes, to dispatch on them without
+/// dynamic_cast. Other for the rest of the nodes.
+enum class EmitKind : uint8_t {
+  Other,
+  Stmt,
+  Directive,
+  Decl,
+};
+
 class Emit {
+  friend class StructuralHasher;
   std::string CommentBefore;
   std::string CommentAfter;
+  EmitKind Kind = EmitKind::Other;
+  // Unique per node, telling it from a destroyed node of the same address.
+  uint64_t Id = NextEmitId.fetch_add(1, std::memory_order_relaxed);
 
 protected:
+  Emit() = default;
+  Emit(EmitKind Kind) : Kind(Kind) {}
   virtual void emit_impl(std::ostream &SS) = 0;
 
 public:
+  EmitKind get_emit_kind() { return Kind; }
+  /// @brief Called by the mutators of this node, including the insertion and
+  /// the removal of the entries of the scopes. The code storing into the
+  /// ranges of the children, such as CallExpr::args(), calls it on the
+  /// parent.
+  void note_modified() { ModificationListener::notify(this); }
   void set_comment_before(std::string CommentBefore) {
     this->CommentBefore = CommentBefore;
   }
@@ -22,6 +86,14 @@ public:
   }
   std::string get_comment_after() { return CommentAfter; }
 
+  /// @brief Build the lazy parts, such as the bodies of the functions by
+  /// TopLevel::def_func_lazy(). The emission of CFile and TopLevel, as well
+  /// as to_string() and emit_chunks(), calls this first, so the output has
+  /// every body. Other nodes never build them in emit(); a lazy function not
+  /// yet built is emitted alone as its prototype. A sealed region is built
+  /// before its handler, which may emit it on another thread.
+  virtual void materialize() {}
+
   void emit(std::ostream &SS) {
     if (!CommentBefore.empty()) {
       SS << "/* " << CommentBefore << " */";
@@ -33,11 +105,43 @@ public:
   }
 
   std::string to_string() {
+    materialize();
     std::stringstream SS;
     emit(SS);
     return SS.str();
   }
+
+  /// @brief Pull the emitted code in chunks of at most ChunkSize bytes,
+  /// keeping at most NumBuffers chunks in memory. This must not be modified
+  /// until the returned stream is exhausted or destroyed.
+  ChunkStream emit_chunks(size_t ChunkSize = 4096, size_t NumBuffers = 4) {
+    materialize();
+    return ChunkStream([this](std::ostream &SS) { emit(SS); }, ChunkSize,
+                       NumBuffers);
+  }
+};
+
+/**
+  @brief ScopeEntry is a statement or a directive, which is an entry of scopes.
+  In FuncScope, entries are linked in an intrusive doubly-linked list owned by
+  the scope.
+ */
+class ScopeEntry : public Emit {
+  friend class FuncScope;
+  ScopeEntry *Prev = nullptr;
+  ScopeEntry *Next = nullptr;
+
+protected:
+  ScopeEntry(EmitKind Kind) : Emit(Kind) {}
+
+public:
+  virtual ~ScopeEntry() = default;
+  /// @brief The previous entry in the FuncScope. nullptr if first.
+  ScopeEntry *get_prev() { return Prev; }
+  /// @brief The next entry in the FuncScope. nullptr if last.
+  ScopeEntry *get_next() { return Next; }
 };
+
 template <typename OS> OS &operator<<(OS &SS, Emit *E) {
   E->emit(SS);
   return SS;
@@ -4,13 +4,33 @@
 #include "internal/Gen/Decl.h"
 #include "internal/Gen/Emit.h"
 #include "internal/Gen/Forwards.h"
+#include "internal/Gen/IntValue.h"
 
 namespace namec {
 
+/// @brief Kind of Expr, to dispatch on the node class without virtual calls.
+enum class ExprKind {
+  Raw,
+  Variable,
+  Subscript,
+  Call,
+  UnaryOp,
+  BinaryOp,
+  TernaryOp,
+  Cast,
+  Paren,
+  DesignatedInit,
+  InitList,
+  GenericSelection,
+};
+
 class Expr : public Emit {
+  ExprKind Kind;
 
 public:
+  Expr(ExprKind Kind) : Kind(Kind) {}
   virtual ~Expr() = default;
+  ExprKind get_kind() { return Kind; }
   virtual void emit_impl(std::ostream &SS) = 0;
 };
 
@@ -18,18 +38,28 @@ class RawExpr : public Expr {
   std::string Val;
 
 public:
-  RawExpr(std::string Val) : Val(Val) {}
+  RawExpr(std::string Val) : Expr(ExprKind::Raw), Val(Val) {}
   std::string get_val() { return Val; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
 };
 
+/// @brief Integer literal made by Context::expr_int() and so on. It is emitted
+/// as a RawExpr, and keeps the typed value for fold_constants().
+class IntLiteral : public RawExpr {
+  IntValue Value;
+
+public:
+  IntLiteral(IntValue Value) : RawExpr(Value.to_string()), Value(Value) {}
+  IntValue get_value() { return Value; }
+};
+
 class VariableExpr : public Expr {
   VarDecl *D;
 
 public:
-  VariableExpr(VarDecl *D) : D(D) {}
+  VariableExpr(VarDecl *D) : Expr(ExprKind::Variable), D(D) {}
   VarDecl *get_decl() { return D; }
 
 protected:
@@ -41,9 +71,18 @@ class SubscriptExpr : public Expr {
   Expr *Index;
 
 public:
-  SubscriptExpr(Expr *Array, Expr *Index) : Array(Array), Index(Index) {}
+  SubscriptExpr(Expr *Array, Expr *Index)
+      : Expr(ExprKind::Subscript), Array(Array), Index(Index) {}
   Expr *get_array() { return Array; }
   Expr *get_index() { return Index; }
+  void set_array(Expr *E) {
+    Array = E;
+    note_modified();
+  }
+  void set_index(Expr *E) {
+    Index = E;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -56,8 +95,12 @@ class CallExpr : public Expr {
 public:
   using iterator = decltype(Args)::iterator;
   CallExpr(Expr *Callee, std::vector<Expr *> Args)
-      : Callee(Callee), Args(Args) {}
+      : Expr(ExprKind::Call), Callee(Callee), Args(Args) {}
   Expr *get_callee() { return Callee; }
+  void set_callee(Expr *E) {
+    Callee = E;
+    note_modified();
+  }
   IteratorRange<iterator> args() {
     return IteratorRange<iterator>(Args.begin(), Args.end());
   }
@@ -74,8 +117,12 @@ class UnaryOp : public Expr {
 
 public:
   UnaryOp(std::string Op, Expr *Operand, bool IsPrefix)
-      : Operand(Operand), Op(Op), IsPrefix(IsPrefix) {}
+      : Expr(ExprKind::UnaryOp), Operand(Operand), Op(Op), IsPrefix(IsPrefix) {}
   Expr *get_operand() { return Operand; }
+  void set_operand(Expr *E) {
+    Operand = E;
+    note_modified();
+  }
   std::string get_op() { return Op; }
   bool is_prefix() { return IsPrefix; }
 
@@ -89,9 +136,18 @@ class BinaryOp : public Expr {
   std::string Op;
 
 public:
-  BinaryOp(std::string Op, Expr *LHS, Expr *RHS) : LHS(LHS), RHS(RHS), Op(Op) {}
+  BinaryOp(std::string Op, Expr *LHS, Expr *RHS)
+      : Expr(ExprKind::BinaryOp), LHS(LHS), RHS(RHS), Op(Op) {}
   Expr *get_lhs() { return LHS; }
   Expr *get_rhs() { return RHS; }
+  void set_lhs(Expr *E) {
+    LHS = E;
+    note_modified();
+  }
+  void set_rhs(Expr *E) {
+    RHS = E;
+    note_modified();
+  }
   std::string get_op() { return Op; }
 
 protected:
@@ -105,10 +161,22 @@ class TernaryOp : public Expr {
 
 public:
   TernaryOp(Expr *Cond, Expr *Then, Expr *Else)
-      : Cond(Cond), Then(Then), Else(Else) {}
+      : Expr(ExprKind::TernaryOp), Cond(Cond), Then(Then), Else(Else) {}
   Expr *get_cond() { return Cond; }
   Expr *get_then() { return Then; }
   Expr *get_else() { return Else; }
+  void set_cond(Expr *E) {
+    Cond = E;
+    note_modified();
+  }
+  void set_then(Expr *E) {
+    Then = E;
+    note_modified();
+  }
+  void set_else(Expr *E) {
+    Else = E;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -119,9 +187,14 @@ class CastExpr : public Expr {
   Expr *Operand;
 
 public:
-  CastExpr(Type *Ty, Expr *Operand) : Ty(Ty), Operand(Operand) {}
+  CastExpr(Type *Ty, Expr *Operand)
+      : Expr(ExprKind::Cast), Ty(Ty), Operand(Operand) {}
   Type *get_type() { return Ty; }
   Expr *get_operand() { return Operand; }
+  void set_operand(Expr *E) {
+    Operand = E;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -131,8 +204,12 @@ class ParenExpr : public Expr {
   Expr *Inside;
 
 public:
-  ParenExpr(Expr *Inside) : Inside(Inside) {}
+  ParenExpr(Expr *Inside) : Expr(ExprKind::Paren), Inside(Inside) {}
   Expr *get_inside() { return Inside; }
+  void set_inside(Expr *E) {
+    Inside = E;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -144,7 +221,7 @@ class DesignatedInitExpr : public Expr {
 public:
   using iterator = decltype(Designators)::iterator;
   DesignatedInitExpr(std::vector<std::pair<std::string, Expr *>> Designators)
-      : Designators(Designators) {}
+      : Expr(ExprKind::DesignatedInit), Designators(Designators) {}
   IteratorRange<iterator> designators() {
     return IteratorRange<iterator>(Designators.begin(), Designators.end());
   }
@@ -158,7 +235,8 @@ class InitListExpr : public Expr {
 
 public:
   using iterator = decltype(Values)::iterator;
-  InitListExpr(std::vector<Expr *> Values) : Values(Values) {}
+  InitListExpr(std::vector<Expr *> Values)
+      : Expr(ExprKind::InitList), Values(Values) {}
   IteratorRange<iterator> values() {
     return IteratorRange<iterator>(Values.begin(), Values.end());
   }
@@ -174,15 +252,26 @@ class GenericSelection : public Expr {
 
 public:
   using iterator = decltype(AssocList)::iterator;
-  GenericSelection(Expr *ControlExpr) : ControlExpr(ControlExpr) {}
+  GenericSelection(Expr *ControlExpr)
+      : Expr(ExprKind::GenericSelection), ControlExpr(ControlExpr) {}
   Expr *get_control() { return ControlExpr; }
-  void add_assoc(Type *T, Expr *E) { AssocList.push_back({T, E}); }
-  void add_default(Expr *E) { AssocList.push_back({nullptr, E}); }
-
-protected:
+  void set_control(Expr *E) {
+    ControlExpr = E;
+    note_modified();
+  }
+  void add_assoc(Type *T, Expr *E) {
+    AssocList.push_back({T, E});
+    note_modified();
+  }
+  void add_default(Expr *E) {
+    AssocList.push_back({nullptr, E});
+    note_modified();
+  }
   IteratorRange<iterator> assocs() {
     return IteratorRange<iterator>(AssocList.begin(), AssocList.end());
   }
+
+protected:
   void emit_impl(std::ostream &SS) override;
 };
 
@@ -2,6 +2,7 @@
 #define NAMEC_GEN_FILE_H
 
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -10,28 +11,119 @@
 #include "internal/Gen/Directive.h"
 #include "internal/Gen/Emit.h"
 #include "internal/Gen/Forwards.h"
-#include "internal/Gen/Mixins.h"
+#include "internal/Gen/MixIns.h"
 #include "internal/Gen/Stmts.h"
+#include "internal/Util/FileUtil.h"
 
 namespace namec {
 
+/**
+  @brief SealedRegion is a part of CFile sealed in streaming mode. It owns the
+  sealed top-levels and the nodes created for them, and releases them when
+  destroyed.
+ */
+class SealedRegion : public Emit {
+  friend class CFile;
+  // Sealed top-levels and whether each is a split part of a top-level. The
+  // rest of a split part follows it, so it is not ended by a newline.
+  std::vector<std::pair<std::unique_ptr<TopLevel>, bool>> Parts;
+  Context::ArenaRegion Nodes;
+
+public:
+  void materialize() override;
+
+protected:
+  void emit_impl(std::ostream &SS) override;
+};
+
+/**
+  @brief CFile corresponds to a C source or header file.
+
+  ## Streaming mode
+
+  Normally the whole file is kept until emit(). In streaming mode started by
+  start_stream(), the user seals a TopLevel or FuncDecl after building it. It is
+  emitted immediately with all the preceding entries, and they are released
+  together with the nodes created since the previous seal. So the peak memory
+  is bounded by the largest unsealed region instead of the whole file.
+
+  Since releasing is by the creation order, the nodes created after the
+  previous seal must not be used after sealing. A seal is refused if the
+  entries left unsealed use such nodes. Nodes shared between regions,
+  such as parameter VarDecl reused for many functions, must be created before
+  start_stream(). Types are never released. The named types of the released
+  decls keep their names, so a struct sealed earlier can still be used by
+  Context::type_name().
+
+  ```cpp
+  F.start_stream(OS);
+  for (...) {
+    FuncDecl *FD = T->def_func(...);
+    // ... build FD ...
+    F.seal(FD);
+  }
+  F.end_stream();
+  ```
+ */
 class CFile : public Emit {
 
   Context &C;
   std::vector<std::unique_ptr<TopLevel>> TopLevels;
 
+  // Streaming mode states.
+  std::function<void(std::unique_ptr<SealedRegion>)> SealHandler;
+  Context::ArenaMark Mark;
+
+  void seal_until(size_t Index, Emit *Last);
+  bool is_released_used(size_t Index, Emit *Last);
+
 public:
   CFile(Context &C) : C(C) {
     TopLevels.push_back(std::make_unique<TopLevel>(C));
   }
   virtual ~CFile() {}
-  TopLevel *get_first_top_level() { return TopLevels[0].get(); }
+  Context &get_context() { return C; }
+  /// @brief In streaming mode, this is the first unsealed one. nullptr if all
+  /// are sealed.
+  TopLevel *get_first_top_level() {
+    return TopLevels.empty() ? nullptr : TopLevels[0].get();
+  }
+  using top_level_iterator = VUIterator<TopLevel>;
+  IteratorRange<top_level_iterator> top_levels() {
+    return IteratorRange<top_level_iterator>(
+        top_level_iterator(TopLevels, 0),
+        top_level_iterator(TopLevels, TopLevels.size()));
+  }
   // Add a new top level. This is only for convenience of generation.
   TopLevel *add_top_level() {
     TopLevels.push_back(std::make_unique<TopLevel>(C));
     return TopLevels.back().get();
   }
-  void emit_to_file(std::filesystem::path Path);
+  /// @brief Emit this file to Path. With IsSkipUnchanged, the file is left
+  /// untouched when it already has the same content, so its mtime is kept.
+  WriteResult emit_to_file(std::filesystem::path Path,
+                           bool IsSkipUnchanged = false);
+
+  /// @brief Start streaming mode, emitting sealed regions to SS.
+  void start_stream(std::ostream &SS);
+  /// @brief Start streaming mode, passing sealed regions to Handler.
+  void start_stream(std::function<void(std::unique_ptr<SealedRegion>)> Handler);
+  bool is_streaming() { return static_cast<bool>(SealHandler); }
+  /// @brief Seal T with all the preceding unsealed top-levels. Returns false,
+  /// sealing nothing, if not streaming, T is not an unsealed top-level of
+  /// this file, or the following top-levels use the nodes to be released.
+  bool seal(TopLevel *T);
+  /// @brief Seal FD with all the preceding entries. Returns false, sealing
+  /// nothing, if not streaming, FD is not defined directly in an unsealed
+  /// top-level of this file, or the following entries use the nodes to be
+  /// released.
+  bool seal(FuncDecl *FD);
+  /// @brief Seal all the rest and end streaming mode.
+  void end_stream();
+  /// @brief End streaming mode without sealing. The unsealed entries stay in
+  /// this file.
+  void stop_stream() { SealHandler = nullptr; }
+  void materialize() override;
 
 protected:
   void emit_impl(std::ostream &SS) override;
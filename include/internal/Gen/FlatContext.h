@@ -0,0 +1,345 @@
+#ifndef NAMEC_GEN_FLAT_CONTEXT_H
+#define NAMEC_GEN_FLAT_CONTEXT_H
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <unordered_map>
+
+#include "internal/Gen/Forwards.h"
+#include "internal/Gen/Types.h"
+#include "internal/Util/CommonMixins.h"
+
+namespace namec {
+class FlatContext;
+class FlatStmt;
+class FuncDecl;
+class ScopeEntry;
+class VarDecl;
+
+/// @brief Index of a node in FlatContext tables.
+using FlatIndex = uint32_t;
+constexpr FlatIndex FlatNone = UINT32_MAX;
+
+struct FlatExpr {
+  FlatIndex Id = FlatNone;
+};
+
+struct FlatVar {
+  FlatIndex Id = FlatNone;
+};
+
+// The builder handles below are values. They have operator-> returning itself,
+// so generator code written as `S->stmt_return(...)` works with both of the
+// pointer AST and FlatContext.
+
+/// @brief Builder handle of a scope, corresponding to FuncScope.
+class FlatScope {
+  FlatContext *C;
+  FlatIndex Id;
+
+public:
+  FlatScope(FlatContext *C, FlatIndex Id) : C(C), Id(Id) {}
+  FlatScope *operator->() { return this; }
+  FlatIndex get_id() { return Id; }
+
+  FlatVar def_var(std::string Name, Type *T, FlatExpr Init = {});
+  FlatStmt stmt_raw(std::string Val);
+  FlatStmt stmt_decl(FlatVar D);
+  FlatStmt stmt_expr(FlatExpr E);
+  FlatStmt stmt_if(FlatExpr Cond);
+  FlatStmt stmt_while(FlatExpr Cond);
+  FlatStmt stmt_for(FlatVar Init, FlatExpr Cond, FlatExpr Step);
+  FlatStmt stmt_for(FlatExpr Init, FlatExpr Cond, FlatExpr Step);
+  FlatStmt stmt_do(FlatExpr Cond);
+  FlatStmt stmt_block();
+  FlatStmt stmt_return(FlatExpr Val = {});
+  FlatStmt stmt_break();
+  FlatStmt stmt_continue();
+  FlatStmt stmt_switch(FlatExpr Cond);
+  FlatStmt stmt_assign(FlatExpr LHS, FlatExpr RHS);
+  FlatStmt stmt_call(FlatExpr Callee, std::vector<FlatExpr> Args);
+  /// @brief Copy the entries of S, built by the pointer API, to the end of
+  /// this scope, as FlatTopLevel::append().
+  void append(FuncScope *S);
+};
+
+/// @brief Builder handle of a statement. Methods are available only for the
+/// kinds of statement having the same method in the pointer AST.
+class FlatStmt {
+  FlatContext *C;
+  FlatIndex Id;
+
+public:
+  FlatStmt(FlatContext *C, FlatIndex Id) : C(C), Id(Id) {}
+  FlatStmt *operator->() { return this; }
+  FlatIndex get_id() { return Id; }
+
+  // IfStmt
+  FlatScope get_then();
+  FlatScope add_elseif(FlatExpr Cond);
+  FlatScope get_or_add_else();
+  // WhileStmt, ForStmt, DoStmt, CaseStmt
+  FlatScope get_body();
+  // BlockStmt
+  FlatScope get_scope();
+  // SwitchStmt
+  FlatStmt add_case(FlatExpr Val, bool IsFallThrough = false);
+  FlatStmt add_default(bool IsFallThrough = false);
+};
+
+/// @brief Builder handle of a function, corresponding to FuncDecl.
+class FlatFunc {
+  FlatContext *C;
+  FlatIndex Id;
+
+public:
+  FlatFunc(FlatContext *C, FlatIndex Id) : C(C), Id(Id) {}
+  FlatFunc *operator->() { return this; }
+  FlatIndex get_id() { return Id; }
+  FlatScope get_or_add_body();
+};
+
+/// @brief Builder handle of a top-level, corresponding to TopLevel.
+class FlatTopLevel {
+  FlatContext *C;
+  FlatIndex Id;
+
+public:
+  FlatTopLevel(FlatContext *C, FlatIndex Id) : C(C), Id(Id) {}
+  FlatTopLevel *operator->() { return this; }
+  FlatIndex get_id() { return Id; }
+
+  FlatFunc def_func(std::string Name, Type *RetTy,
+                    std::vector<FlatVar> Params);
+  FlatVar def_var(std::string Name, Type *T, FlatExpr Init = {});
+  void directive_raw(std::string Val);
+  void include(std::string Path);
+  void include_sys(std::string Path);
+  /// @brief Copy the entries of T, built by the pointer API, to the end of
+  /// this top-level. See FlatContext.
+  void append(TopLevel *T);
+};
+
+/**
+  @brief FlatContext is a compact alternative of Context and CFile for huge
+  outputs.
+
+  Nodes are stored by kind in struct-of-arrays tables and referenced by 32-bit
+  indices. There are no vtables, comments nor per-node allocations, so a node
+  takes a few tens of bytes instead of more than a hundred. Emission walks the
+  contiguous tables.
+
+  The builder mirrors the method names of Context, TopLevel and FuncScope with
+  handle values (FlatScope, FlatStmt, ...) instead of pointers. The output is
+  the same as the one of CFile built by the same calls.
+
+  It supports a subset of namec: raw/literal, variable, unary, binary,
+  ternary, subscript, call, cast and paren expressions; raw, decl, expr, if,
+  while, for, do, block, return, break, continue and switch statements;
+  functions, variables and raw/include directives in the top-levels. Types
+  are the ones of namec, owned by this.
+
+  append() of FlatTopLevel and FlatScope adapts the builders of the pointer
+  AST: a generator builds into a TopLevel or FuncScope of a scratch Context as
+  usual, and the copy keeps the output, so the scratch one can be dropped
+  after each part. The nodes outside the subset, the ones with comments and
+  the declarations with qualifiers or attributes are copied as their emitted
+  code, and the types by their spelling. The lazy functions of a TopLevel are
+  built first.
+
+  ```cpp
+  FlatContext C;
+  FlatVar X = C.decl_var("x", C.type_int());
+  FlatFunc F = C.get_first_top_level()->def_func("sq", C.type_int(), {X});
+  F->get_or_add_body()->stmt_return(C.EX(X, "*", X));
+  C.emit(OS);
+  ```
+ */
+class FlatContext
+    : public BuiltinTypeAPIMixin<FlatContext, Type, RawType, Void> {
+  friend class FlatScope;
+  friend class FlatStmt;
+  friend class FlatFunc;
+  friend class FlatTopLevel;
+
+public:
+  enum class ExprKind : uint8_t {
+    Raw,       // A: string
+    Var,       // A: var
+    PreUnary,  // A: op string, B: operand
+    PostUnary, // A: op string, B: operand
+    Binary,    // A: op string, B: LHS, C: RHS
+    Ternary,   // A: cond, B: then, C: else
+    Subscript, // A: array, B: index
+    Call,      // A: callee, B: args offset in Extra, C: arg count
+    Cast,      // A: type, B: operand
+    Paren,     // A: inside
+  };
+  enum class StmtKind : uint8_t {
+    Raw,      // A: string
+    Decl,     // A: var
+    Expr,     // A: expr
+    If,       // A: cond, B: then scope, C: first clause
+    ElseIf,   // A: cond, B: scope. Clause of If linked by Next.
+    Else,     // B: scope. The last clause of If.
+    While,    // A: cond, B: body
+    For,      // A: init stmt, B: body, C: cond and step offset in Extra
+    Do,       // A: cond, B: body
+    Block,    // A: scope
+    Return,   // A: expr
+    Break,    //
+    Continue, //
+    Switch,   // A: cond, B: first case, C: last case
+    Case,     // A: val (FlatNone for default), B: body, C: fall through
+  };
+  enum class TopKind : uint8_t {
+    Raw,  // A: string
+    Func, // A: func
+    Var,  // A: var
+  };
+
+private:
+  // Strings and types are interned.
+  std::string Chars;
+  std::vector<uint32_t> StrBegins;
+  std::unordered_map<std::string, FlatIndex> StrMap;
+  std::vector<Type *> TypeTable;
+  std::unordered_map<Type *, FlatIndex> TypeMap;
+  std::vector<std::unique_ptr<Type>> OwnedTypes;
+  std::map<Type *, Pointer *> PointerTypeMap;
+
+  std::vector<ExprKind> ExprKinds;
+  std::vector<FlatIndex> ExprA, ExprB, ExprC;
+
+  std::vector<FlatIndex> VarNames, VarTypes, VarInits;
+
+  std::vector<StmtKind> StmtKinds;
+  std::vector<FlatIndex> StmtA, StmtB, StmtC, StmtNext;
+
+  // Statements in a scope are linked by StmtNext.
+  std::vector<FlatIndex> ScopeFirsts, ScopeLasts;
+
+  std::vector<FlatIndex> FuncNames, FuncRetTypes, FuncParams, FuncParamCounts,
+      FuncBodies;
+
+  // Entries in a top-level are linked by TopNext.
+  std::vector<TopKind> TopKinds;
+  std::vector<FlatIndex> TopA, TopNext;
+  std::vector<FlatIndex> TopLevelFirsts, TopLevelLasts;
+
+  // Variable length operands such as call arguments.
+  std::vector<FlatIndex> Extra;
+
+  FlatIndex add_str(const std::string &S);
+  std::string_view get_str(FlatIndex I);
+  FlatIndex add_type_index(Type *T);
+  FlatExpr add_expr(ExprKind K, FlatIndex A, FlatIndex B = FlatNone,
+                    FlatIndex C = FlatNone);
+  FlatIndex add_stmt(StmtKind K, FlatIndex A = FlatNone,
+                     FlatIndex B = FlatNone, FlatIndex C = FlatNone);
+  FlatStmt append_stmt(FlatIndex Scope, StmtKind K, FlatIndex A = FlatNone,
+                       FlatIndex B = FlatNone, FlatIndex C = FlatNone);
+  FlatIndex add_scope();
+  void append_top(FlatIndex TopLevel, TopKind K, FlatIndex A);
+
+  void emit_expr(std::ostream &SS, FlatIndex I);
+  void emit_var(std::ostream &SS, FlatIndex I);
+  void emit_stmt(std::ostream &SS, FlatIndex I);
+  void emit_scope(std::ostream &SS, FlatIndex I);
+  void emit_func(std::ostream &SS, FlatIndex I);
+
+  // The copies of the variables by append(), cleared after each.
+  std::unordered_map<VarDecl *, FlatIndex> CopiedVars;
+  Type *copy_type(Type *T) { return type_raw(T->to_string()); }
+  FlatExpr copy_expr(Expr *E);
+  FlatVar copy_var_ref(VarDecl *D);
+  std::optional<FlatVar> copy_var_def(Decl *D);
+  void copy_stmt(FlatScope S, ScopeEntry *E);
+  void copy_scope(FlatScope S, FuncScope *From);
+  bool copy_func(FlatTopLevel T, FuncDecl *FD);
+
+protected:
+  void on_add_type(Type *T) override { OwnedTypes.emplace_back(T); }
+
+public:
+  FlatContext() : BuiltinTypeAPIMixin(*this) { add_top_level(); }
+
+  FlatTopLevel get_first_top_level() { return FlatTopLevel(this, 0); }
+  FlatTopLevel add_top_level();
+
+  Pointer *type_ptr(Type *ElmTy);
+
+  FlatVar decl_var(std::string Name, Type *T, FlatExpr Init = {});
+
+  FlatExpr expr_raw(std::string Val);
+  FlatExpr expr_int(int Val) { return expr_raw(std::to_string(Val)); }
+  FlatExpr expr_uint(unsigned int Val) {
+    return expr_raw(std::to_string(Val) + "u");
+  }
+  FlatExpr expr_long(long Val) { return expr_raw(std::to_string(Val) + "l"); }
+  FlatExpr expr_char(char Val) {
+    return expr_raw(std::string("'") + Val + "'");
+  }
+  FlatExpr expr_str(std::string Val) { return expr_raw("\"" + Val + "\""); }
+  FlatExpr expr_true() { return expr_raw("1"); }
+  FlatExpr expr_false() { return expr_raw("0"); }
+  FlatExpr expr_var(FlatVar D) { return add_expr(ExprKind::Var, D.Id); }
+  FlatExpr expr_pre_unary(std::string Op, FlatExpr E) {
+    return add_expr(ExprKind::PreUnary, add_str(Op), E.Id);
+  }
+  FlatExpr expr_post_unary(std::string Op, FlatExpr E) {
+    return add_expr(ExprKind::PostUnary, add_str(Op), E.Id);
+  }
+  FlatExpr expr_binary(std::string Op, FlatExpr LHS, FlatExpr RHS) {
+    return add_expr(ExprKind::Binary, add_str(Op), LHS.Id, RHS.Id);
+  }
+  FlatExpr expr_ternary(FlatExpr Cond, FlatExpr LHS, FlatExpr RHS) {
+    return add_expr(ExprKind::Ternary, Cond.Id, LHS.Id, RHS.Id);
+  }
+  FlatExpr expr_subscr(FlatExpr Base, FlatExpr Index) {
+    return add_expr(ExprKind::Subscript, Base.Id, Index.Id);
+  }
+  FlatExpr expr_call(FlatExpr Callee, std::vector<FlatExpr> Args);
+  FlatExpr expr_cast(Type *Ty, FlatExpr E) {
+    return add_expr(ExprKind::Cast, add_type_index(Ty), E.Id);
+  }
+  FlatExpr expr_paren(FlatExpr E) { return add_expr(ExprKind::Paren, E.Id); }
+  FlatExpr expr_addr(FlatExpr E) { return expr_pre_unary("&", E); }
+  FlatExpr expr_deref(FlatExpr E) { return expr_pre_unary("*", E); }
+  FlatExpr expr_not(FlatExpr E) { return expr_pre_unary("!", E); }
+
+  // Short form factory methods, as ShortFormExprAPIMixin.
+  FlatExpr EX(FlatExpr E) { return expr_paren(E); }
+  FlatExpr EX(FlatVar VD) { return expr_var(VD); }
+  FlatExpr EX(bool Val) { return Val ? expr_true() : expr_false(); }
+  FlatExpr EX(int Val) { return expr_int(Val); }
+  FlatExpr EX(unsigned int Val) { return expr_uint(Val); }
+  FlatExpr EX(long Val) { return expr_long(Val); }
+  FlatExpr EX(char Val) { return expr_char(Val); }
+  FlatExpr EX(const char *Val) { return expr_raw(Val); }
+  FlatExpr EX(std::string Val) { return expr_raw(Val); }
+  template <typename T> FlatExpr EX(std::string Op, T E) {
+    return expr_paren(expr_pre_unary(Op, EX(E)));
+  }
+  template <typename T1, typename T2>
+  FlatExpr EX(T1 LHS, std::string Op, T2 RHS) {
+    return expr_paren(expr_binary(Op, EX(LHS), EX(RHS)));
+  }
+  template <typename CalleeT, typename... T>
+  FlatExpr CALL(CalleeT Callee, T... Args) {
+    return expr_paren(expr_call(EX(Callee), {EX(Args)...}));
+  }
+
+  /// @brief Emit all the top-levels as CFile does.
+  void emit(std::ostream &SS);
+  std::string to_string();
+  /// @brief Bytes allocated by this, including the interning maps and the
+  /// types. The nodes of the maps are estimated as the values with the
+  /// pointers linking them.
+  size_t get_memory_usage();
+};
+
+} // namespace namec
+
+#endif // NAMEC_GEN_FLAT_CONTEXT_H
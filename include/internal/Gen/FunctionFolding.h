@@ -0,0 +1,45 @@
+#ifndef NAMEC_GEN_FUNCTION_FOLDING_H
+#define NAMEC_GEN_FUNCTION_FOLDING_H
+
+#include <cstddef>
+
+#include "internal/Gen/Forwards.h"
+
+namespace namec {
+
+/// @brief How fold_identical_functions() replaces a duplicated function.
+enum class FoldMode {
+  /// Forwarding definition calling the kept one. Skips variadic functions.
+  Forward,
+  /// Declaration with __attribute__((alias)) of the kept one (GCC and Clang
+  /// on ELF targets).
+  Alias,
+  /// #define of the name to the kept one. Only for functions without a
+  /// separate forward declaration, so that no use precedes the macro. Only
+  /// for static functions without the other declarations, since it removes
+  /// the symbol; the others are folded by Forward.
+  Define,
+};
+
+struct FoldStats {
+  size_t Functions = 0; // Function definitions examined.
+  size_t Folded = 0;    // Definitions replaced.
+};
+
+/**
+  @brief Fold the function definitions in the top-levels of F whose bodies are
+  structurally identical apart from the name. The first definition is kept and
+  the later ones are replaced according to Mode.
+
+  Only the functions defined directly in the top-levels are examined, since
+  the ones in #if branches may not be compiled together. Functions are equal
+  when their return types, parameters, and bodies have the same structural
+  hash (StructuralHasher). Functions with static locals are not folded, since
+  the folded ones would share them.
+ */
+FoldStats fold_identical_functions(Context &C, CFile &F,
+                                   FoldMode Mode = FoldMode::Forward);
+
+} // namespace namec
+
+#endif // NAMEC_GEN_FUNCTION_FOLDING_H
@@ -0,0 +1,39 @@
+#ifndef NAMEC_GEN_INCLUDES_H
+#define NAMEC_GEN_INCLUDES_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "internal/Gen/Forwards.h"
+#include "internal/Util/PrecompiledHeader.h"
+
+namespace namec {
+
+/**
+  @brief Remove the Include and SystemInclude directives of F repeating one
+  that is already in effect: an earlier one in the top-levels, or in the same
+  or an enclosing #if branch. Returns the number of the removed ones.
+
+  The headers are assumed to have include guards. The paths in Repeatable,
+  such as X-macro files meant to be included many times, are kept.
+ */
+size_t dedup_includes(CFile &F,
+                      const std::vector<std::string> &Repeatable = {});
+
+/**
+  @brief Make the precompiled header Name.h including the headers included by
+  at least MinFiles of Files.
+
+  Only the leading includes of each file, before any other entry in the
+  top-levels, are candidates, since a later include may depend on the macros
+  or declarations before it. The files whose leading includes lack some of the
+  header's are in get_skipped(), not to be compiled with it.
+ */
+PrecompiledHeader extract_common_includes(const std::vector<CFile *> &Files,
+                                          size_t MinFiles,
+                                          const std::string &Name);
+
+} // namespace namec
+
+#endif // NAMEC_GEN_INCLUDES_H
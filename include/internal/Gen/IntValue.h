@@ -0,0 +1,72 @@
+#ifndef NAMEC_GEN_INT_VALUE_H
+#define NAMEC_GEN_INT_VALUE_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace namec {
+
+/// @brief Type of an integer constant, in the order of the conversion rank.
+/// The target is assumed LP64: int is 32 bits, long and long long are 64 bits.
+enum class IntKind { Int, UInt, Long, ULong, LLong, ULLong };
+
+/// @brief Integer constant of C, holding the bits truncated to its width.
+class IntValue {
+  IntKind Kind;
+  uint64_t Bits;
+
+public:
+  IntValue(IntKind Kind, uint64_t Bits)
+      : Kind(Kind), Bits(width(Kind) == 64 ? Bits : Bits & 0xffffffffu) {}
+  /// @brief The int 1 or 0, as the result of comparisons and logical ops.
+  static IntValue of_bool(bool B) { return IntValue(IntKind::Int, B); }
+
+  static unsigned width(IntKind K) {
+    return K == IntKind::Int || K == IntKind::UInt ? 32 : 64;
+  }
+  static bool is_signed(IntKind K) {
+    return K == IntKind::Int || K == IntKind::Long || K == IntKind::LLong;
+  }
+  /// @brief The type of the usual arithmetic conversions of L and R.
+  static IntKind common_kind(IntKind L, IntKind R);
+
+  IntKind get_kind() const { return Kind; }
+  unsigned width() const { return width(Kind); }
+  bool is_signed() const { return is_signed(Kind); }
+  uint64_t get_bits() const { return Bits; }
+  /// @brief Sign extended value. Only meaningful for signed kinds.
+  int64_t get_signed() const;
+  bool is_zero() const { return Bits == 0; }
+  bool is_negative() const { return is_signed() && get_signed() < 0; }
+  bool is_min() const;
+  /// @brief Conversion to To, wrapping around as C does.
+  IntValue convert(IntKind To) const;
+  /// @brief C literal with the suffix of the kind, such as 42ul.
+  std::string to_string() const;
+
+  bool operator==(const IntValue &O) const {
+    return Kind == O.Kind && Bits == O.Bits;
+  }
+  bool operator!=(const IntValue &O) const { return !(*this == O); }
+};
+
+/// @brief Evaluate the prefix unary operator Op (+, -, ~, !) as C does.
+/// std::nullopt for the other operators and undefined behavior such as
+/// signed overflow.
+std::optional<IntValue> eval_unary(const std::string &Op, IntValue V);
+/// @brief Evaluate the binary operator Op as C does, with the usual
+/// arithmetic conversions. std::nullopt for the assignments, comma and
+/// undefined or implementation-defined behavior such as signed overflow,
+/// division by zero, and out of range or negative shifts.
+std::optional<IntValue> eval_binary(const std::string &Op, IntValue L,
+                                    IntValue R);
+/// @brief Parse the C integer literal Text such as 42, 0x1fu or 010l. The
+/// type is the first one of the suffix that can represent the value, as C
+/// does. std::nullopt if Text is not a literal or the value fits no type.
+std::optional<IntValue> parse_int_literal(std::string_view Text);
+
+} // namespace namec
+
+#endif // NAMEC_GEN_INT_VALUE_H
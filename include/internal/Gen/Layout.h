@@ -0,0 +1,57 @@
+#ifndef NAMEC_GEN_LAYOUT_H
+#define NAMEC_GEN_LAYOUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "internal/Gen/Forwards.h"
+
+namespace namec {
+
+/// @brief Heat of the functions, such as the call counts of a profile.
+using FunctionHeat = std::unordered_map<FuncDecl *, uint64_t>;
+
+struct LayoutOptions {
+  /// The functions with the heat at least this are hot, and the ones with
+  /// the heat 0 are cold.
+  uint64_t HotThreshold = 1;
+  /// Add the hot and cold attributes to the hot and cold functions.
+  bool IsMarkHotCold = false;
+  /// Put the hot and cold functions in these sections if non-empty, such as
+  /// ".text.hot" and ".text.unlikely".
+  std::string HotSection;
+  std::string ColdSection;
+};
+
+struct LayoutStats {
+  size_t Hot = 0;        // Hot functions.
+  size_t Cold = 0;       // Cold functions.
+  size_t Moved = 0;      // Entries placed at a different position.
+  size_t Prototypes = 0; // Prototypes inserted for the moved ones.
+};
+
+/**
+  @brief Reorder the function definitions in the top-levels of F so that the
+  hot functions are contiguous, followed by the cold ones.
+
+  The heat of a function is from Heat, or else from its hot or cold
+  attribute. The hot functions are ordered by the Pettis-Hansen algorithm
+  over the call graph (build_ref_index()), placing the pairs calling each
+  other most closest, where the weight of a call is the lesser heat of the
+  two functions.
+
+  The definitions are only moved later within the runs between the entries
+  other than declarations, such as directives and RawDecl, so that they see
+  the same declarations and macros. A moved function gets a prototype only
+  if an entry after it is now before it, placed just before the first such
+  entry, unless it is declared before. The functions in #if branches are not
+  moved.
+ */
+LayoutStats layout_functions(CFile &F, const FunctionHeat &Heat,
+                             const LayoutOptions &Opts = {});
+
+} // namespace namec
+
+#endif // NAMEC_GEN_LAYOUT_H
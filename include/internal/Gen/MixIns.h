@@ -11,16 +11,15 @@ namespace namec {
 
 class DirectiveDefineMixin {
   Context &C;
-  std::vector<std::unique_ptr<Directive>> Directives;
 
   template <typename T> T *add(T *D) {
-    Directives.push_back(std::unique_ptr<Directive>(D));
-    on_add_directive(D);
+    on_add_directive(std::unique_ptr<Directive>(D));
     return D;
   }
 
 protected:
-  virtual void on_add_directive(Directive *D) = 0;
+  // The derived scope takes the ownership.
+  virtual void on_add_directive(std::unique_ptr<Directive> D) = 0;
 
 public:
   DirectiveDefineMixin(Context &C) : C(C) {}
@@ -55,17 +54,15 @@ public:
 
 class UbiquitousDeclStmtMixin {
   Context &C;
-  std::vector<std::unique_ptr<Stmt>> Stmts;
 
   template <typename T> T *add(T *D) {
-    auto *S = new DeclStmt(C, D);
-    Stmts.push_back(std::unique_ptr<Stmt>(S));
-    on_add_decl_stmt(S);
+    on_add_decl_stmt(std::make_unique<DeclStmt>(C, D));
     return D;
   }
 
 protected:
-  virtual void on_add_decl_stmt(Stmt *S) = 0;
+  // The derived scope takes the ownership.
+  virtual void on_add_decl_stmt(std::unique_ptr<Stmt> S) = 0;
 
 public:
   UbiquitousDeclStmtMixin(Context &C) : C(C) {}
@@ -83,16 +80,15 @@ public:
 
 class InFunctionStmtMixin {
   Context &C;
-  std::vector<std::unique_ptr<Stmt>> Stmts;
 
   template <typename T> T *add(T *D) {
-    Stmts.push_back(std::unique_ptr<Stmt>(D));
-    on_add_stmt(D);
+    on_add_stmt(std::unique_ptr<Stmt>(D));
     return D;
   }
 
 protected:
-  virtual void on_add_stmt(Stmt *S) = 0;
+  // The derived scope takes the ownership.
+  virtual void on_add_stmt(std::unique_ptr<Stmt> S) = 0;
 
 public:
   InFunctionStmtMixin(Context &C) : C(C) {}
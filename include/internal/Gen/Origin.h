@@ -0,0 +1,173 @@
+#ifndef NAMEC_GEN_ORIGIN_H
+#define NAMEC_GEN_ORIGIN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "internal/Gen/Emit.h"
+#include "internal/Gen/Forwards.h"
+
+namespace namec {
+
+/// @brief The index of an origin in the OriginTable of Context. 0 is none.
+using OriginId = uint32_t;
+
+/**
+  @brief The origins of the generated nodes, such as the file and the line of
+  the model element or of the generator call site. The file names are shared
+  by the origins in them.
+ */
+class OriginTable {
+  std::vector<std::string> Files;
+  std::unordered_map<std::string, uint32_t> FileIndex;
+  // The file index and the line of each origin. The first is none.
+  std::vector<std::pair<uint32_t, unsigned>> Origins = {{0, 0}};
+
+public:
+  OriginId add(const std::string &File, unsigned Line);
+  const std::string &get_file(OriginId Id) const {
+    return Files[Origins[Id].first];
+  }
+  unsigned get_line(OriginId Id) const { return Origins[Id].second; }
+};
+
+/**
+  @brief The sidecar of emit_with_origins(): the byte ranges of the generated
+  code mapped to their origins. The ranges of nested nodes nest.
+
+  The text form starts with the line "namec-origins 1", followed by the lines
+  "f <file>" of the file names and "<begin> <end> <file> <line>" of the
+  ranges, where <file> is the index of the file names.
+ */
+class OriginMap {
+  friend class OriginEmitter;
+
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+  struct Range {
+    uint64_t Begin;
+    uint64_t End; // Exclusive.
+    uint32_t File;
+    unsigned Line;
+    /// The index of the innermost range enclosing this. npos if none.
+    size_t Parent;
+  };
+
+private:
+  std::vector<std::string> Files;
+  std::unordered_map<std::string, uint32_t> FileIndex;
+  std::vector<Range> Ranges;
+
+  uint32_t add_file(const std::string &File);
+
+public:
+  /// @brief Add a range. The ranges are added in the order of Begin, and the
+  /// outer first for the same Begin. Returns false, adding nothing, if the
+  /// range is out of the order or overlaps another without nesting.
+  bool add(uint64_t Begin, uint64_t End, const std::string &File,
+           unsigned Line);
+  const std::vector<Range> &ranges() const { return Ranges; }
+  const std::string &get_file(const Range &R) const { return Files[R.File]; }
+  /// @brief The innermost range containing Offset. nullptr if none. This
+  /// takes O(log N + depth) for N ranges.
+  const Range *find(uint64_t Offset) const;
+
+  void write(std::ostream &SS) const;
+  std::string to_string() const;
+  /// @brief Add the ranges of the text form. Returns false if Text is
+  /// malformed or out of order, with the ranges before it added.
+  bool parse(std::string_view Text);
+};
+
+struct OriginOptions {
+  /// The name of the generated file, which the #line directives after the
+  /// nodes with origins return to.
+  std::string FileName;
+  /// Emit the #line directives. Without them, the code is the same as by
+  /// emit() and only the map is made.
+  bool IsLineDirectives = true;
+};
+
+/**
+  @brief Emit F to SS as emit() does, with the origins set by set_origin() of
+  FuncDecl and Stmt. Each such node is preceded by #line of its origin, so
+  that the compiler and the debug info attribute the code to the model, and
+  followed by #line back to the enclosing origin or to the generated file.
+  Returns the byte ranges of the nodes in the output.
+
+  The origins are seen only by the scopes emitting directly into the output.
+  The nodes emitted through a temporary stream, such as the ones in a
+  MacroFuncScope whose newlines are escaped, are emitted without #line and
+  are not in the map, as a part of the enclosing node.
+ */
+OriginMap emit_with_origins(CFile &F, std::ostream &SS,
+                            const OriginOptions &Opts);
+
+/// @brief Emit F to Path by emit_with_origins(), and the map to Path with
+/// ".origins" appended. Returns false if either cannot be written.
+bool emit_to_file_with_origins(CFile &F, const std::filesystem::path &Path);
+
+/**
+  @brief The state of emit_with_origins() for the scopes emitting their
+  entries. Without emit_with_origins(), active() is a thread-local load, so
+  the origins cost nothing to the plain emission.
+ */
+class OriginEmitter {
+  // A streambuf passing through to the output, counting bytes and lines.
+  class CountingBuf : public std::streambuf {
+    std::streambuf *Out;
+
+  public:
+    uint64_t Bytes = 0;
+    uint64_t Lines = 0;
+    CountingBuf(std::streambuf *Out) : Out(Out) {}
+
+  protected:
+    int_type overflow(int_type Ch) override;
+    std::streamsize xsputn(const char *S, std::streamsize N) override;
+    int sync() override { return Out->pubsync(); }
+  };
+
+  static thread_local OriginEmitter *Active;
+
+  // The emitter active when this started, restored when this ends.
+  OriginEmitter *Prev;
+  Context &C;
+  const OriginOptions &Opts;
+  CountingBuf Buf;
+  std::ostream Stream;
+  OriginMap Map;
+  // The origins of the nodes being emitted, and the indices of their ranges.
+  std::vector<std::pair<OriginId, size_t>> Stack;
+
+  void emit_line(OriginId Id);
+
+public:
+  OriginEmitter(Context &C, std::ostream &Out, const OriginOptions &Opts);
+  ~OriginEmitter();
+  OriginEmitter(const OriginEmitter &) = delete;
+  OriginEmitter &operator=(const OriginEmitter &) = delete;
+
+  std::ostream &stream() { return Stream; }
+  OriginMap take_map() { return std::move(Map); }
+
+  /// @brief The emitter of SS, or nullptr if SS is not the stream of the
+  /// active one.
+  static OriginEmitter *active(std::ostream &SS) {
+    return Active && &Active->Stream == &SS ? Active : nullptr;
+  }
+  /// @brief Emit E with its origin if it is FuncDecl or Stmt with one, or
+  /// as it is.
+  void emit(Emit *E);
+};
+
+} // namespace namec
+
+#endif // NAMEC_GEN_ORIGIN_H
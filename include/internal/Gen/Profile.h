@@ -0,0 +1,156 @@
+#ifndef NAMEC_GEN_PROFILE_H
+#define NAMEC_GEN_PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "internal/Gen/Forwards.h"
+#include "internal/Gen/Layout.h"
+
+namespace namec {
+
+enum class ProfileSiteKind {
+  Function,
+  Branch, // A branch of IfStmt.
+  Loop,   // The body of WhileStmt, ForStmt or DoStmt.
+  Case,
+};
+
+/**
+  @brief A region of the generated code counted by a profile: a function
+  body, a branch of IfStmt, the body of a loop, or a case of SwitchStmt.
+ */
+struct ProfileSite {
+  std::string Id;
+  ProfileSiteKind Kind;
+  FuncDecl *Func;
+  /// The IfStmt, WhileStmt, ForStmt, DoStmt or CaseStmt. nullptr for a
+  /// function.
+  Stmt *S;
+  /// The branch of IfStmt: 0 for then, I for the I-th else if, and the
+  /// number of the else ifs + 1 for else.
+  size_t Branch;
+  FuncScope *Body;
+  /// The index of the innermost enclosing site, whose count is the times
+  /// this site is reached. npos for a function.
+  size_t Parent;
+
+  static constexpr size_t npos = static_cast<size_t>(-1);
+};
+
+using ProfileSites = std::vector<ProfileSite>;
+
+/**
+  @brief Assign stable IDs to the function definitions in F and to the
+  branches in them. Lazy definitions are materialized.
+
+  The ID of a function is Prefix and its name, followed by '@' and the
+  number of the preceding functions of the name if any, such as the static
+  ones in the branches of #if. The ID of a branch is the ID of the function,
+  '#' and the pre-order index of the statement among the IfStmt, WhileStmt,
+  ForStmt, DoStmt and SwitchStmt in the function, followed by '.' and the
+  index of the branch or the case for IfStmt and SwitchStmt, such as
+  "parse#2.1". The IDs are the same as long as the generator makes the same
+  structure, so that a profile of a generation applies to the next.
+
+  The IDs are unique in F only. The files generated separately and profiled
+  into the same CSV, such as the ones with static functions of the same
+  name, need distinct Prefix.
+ */
+ProfileSites assign_profile_ids(CFile &F, const std::string &Prefix = "");
+
+struct InstrumentOptions {
+  /// The prefix of the counter array Symbol_counts and the dump function
+  /// Symbol_dump. They have external linkage, so that shard_file() defines
+  /// them once, and the instrumented files linked together need distinct
+  /// ones.
+  std::string Symbol = "namec_profile";
+  /// Increment the counters by relaxed __atomic_fetch_add. The plain
+  /// increments are cheaper but may lose counts when the sites run on
+  /// several threads at once.
+  bool IsAtomic = false;
+};
+
+/**
+  @brief Instrument F to count the Sites of it. Each counted body starts with
+  an increment of its counter, and a destructor function appends the counts
+  to the file Path at exit, as the CSV for Profile::parse_csv().
+ */
+void instrument_profile(CFile &F, const ProfileSites &Sites,
+                        const std::string &Path,
+                        const InstrumentOptions &Opts = {});
+
+/**
+  @brief Execution counts by the IDs of assign_profile_ids(). The counts of
+  the same ID are summed, so that profiles of several runs are merged.
+ */
+class Profile {
+  std::unordered_map<std::string, uint64_t> Counts;
+
+public:
+  void add(const std::string &Id, uint64_t Count);
+  /// @brief std::nullopt if Id is not in the profile.
+  std::optional<uint64_t> get(const std::string &Id) const;
+  size_t size() const { return Counts.size(); }
+
+  /// @brief Add the lines "id,count" of Text, split at the last comma. Empty
+  /// lines and the ones starting with '#' are skipped. Returns false on a
+  /// malformed line, with the lines before it added.
+  bool parse_csv(std::string_view Text);
+  /// @brief Add the execution counts of the functions in the JSON output of
+  /// gcov --json-format, by the IDs of Prefix and the names. gcov counts the
+  /// branches by lines, so the counts of the branches are from the CSV.
+  /// Returns false if Text is not such JSON, adding nothing.
+  bool parse_gcov_json(std::string_view Text, const std::string &Prefix = "");
+};
+
+struct ProfileOptions {
+  /// The prefix of the IDs, as of assign_profile_ids().
+  std::string Prefix;
+  /// The functions with the count at least this ratio of the largest count
+  /// are hot, and the ones with the count 0 are cold.
+  double HotRatio = 0.01;
+  /// A branch taken at least this ratio of the times reached is likely, and
+  /// at most 1 - this ratio is unlikely.
+  double LikelyRatio = 0.9;
+  /// The branches reached fewer times than this are left as they are.
+  uint64_t MinReached = 1;
+  /// Reorder the functions by layout_functions().
+  bool IsLayout = true;
+  /// Add the hot and cold attributes.
+  bool IsMarkHotCold = true;
+  /// The sections of the hot and cold functions with IsLayout.
+  std::string HotSection;
+  std::string ColdSection;
+};
+
+struct ProfileStats {
+  size_t Matched = 0; // Sites with the counts in the profile.
+  size_t Hints = 0;   // Branches marked likely or unlikely.
+  LayoutStats Layout; // With IsLayout.
+};
+
+/**
+  @brief Apply the profile P to the next generation F: mark the functions hot
+  or cold, set the likelihood of the branches and order the functions.
+
+  A branch of IfStmt is reached as many times as its enclosing site, less
+  the preceding branches taken, or the sum of the branches if it has else.
+  A loop continues B / (B + N) of the times, where B and N are the counts of
+  the body and the enclosing site, or (B - N) / B for DoStmt. A case is
+  taken its count out of the count of the enclosing site. The likelihood of
+  the branches reached at least MinReached times is replaced by the measured
+  one, which is None in between the ratios. The sites not in P are left as
+  they are.
+ */
+ProfileStats apply_profile(CFile &F, const Profile &P,
+                           const ProfileOptions &Opts = {});
+
+} // namespace namec
+
+#endif // NAMEC_GEN_PROFILE_H
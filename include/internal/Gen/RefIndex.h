@@ -0,0 +1,26 @@
+#ifndef NAMEC_GEN_REF_INDEX_H
+#define NAMEC_GEN_REF_INDEX_H
+
+#include "internal/Gen/Forwards.h"
+#include "internal/Util/RefIndex.h"
+
+namespace namec {
+
+using RefIndex = namec_util::RefIndexImpl<FuncDecl, VarDecl, Expr>;
+
+/**
+  @brief Build the call graph and the uses of the variables of F in one
+  traversal.
+
+  A CallExpr whose callee is the name of a function in F, as a RawExpr
+  possibly in parentheses, is resolved to its definition, or to the first
+  declaration if it has no definition. Every VariableExpr is a use of its
+  VarDecl. Raw statements and the other raw code are not scanned. Lazy
+  function bodies are built to be traversed, so run eliminate_dead_decls()
+  first.
+ */
+RefIndex build_ref_index(CFile &F);
+
+} // namespace namec
+
+#endif // NAMEC_GEN_REF_INDEX_H
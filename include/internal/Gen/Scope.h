@@ -1,11 +1,13 @@
 #ifndef NAMEC_GEN_SCOPE_H
 #define NAMEC_GEN_SCOPE_H
 
+#include <functional>
+
 #include "internal/Gen/Directive.h"
 #include "internal/Gen/Emit.h"
 #include "internal/Gen/File.h"
 #include "internal/Gen/Forwards.h"
-#include "internal/Gen/Mixins.h"
+#include "internal/Gen/MixIns.h"
 #include "internal/Gen/Stmts.h"
 
 namespace namec {
@@ -19,23 +21,77 @@ class TopLevel : public Emit,
                  public UbiquitousDeclStmtMixin {
   Context &C;
   std::vector<Emit *> Entries;
+  // Directives and decl stmts in Entries, in the same order. Other entries
+  // are decls owned by Context.
+  std::vector<std::unique_ptr<ScopeEntry>> OwnedEntries;
+
+  void add_owned(std::unique_ptr<ScopeEntry> E) {
+    Entries.push_back(E.get());
+    OwnedEntries.push_back(std::move(E));
+    note_modified();
+  }
+  decltype(OwnedEntries)::iterator owned_position(decltype(Entries)::iterator);
 
 protected:
-  void on_add_directive(Directive *D) override { Entries.push_back(D); }
-  void on_add_decl_stmt(Stmt *S) override { Entries.push_back(S); }
+  void on_add_directive(std::unique_ptr<Directive> D) override {
+    add_owned(std::move(D));
+  }
+  void on_add_decl_stmt(std::unique_ptr<Stmt> S) override {
+    add_owned(std::move(S));
+  }
 
 public:
   TopLevel(Context &C)
       : C(C), DirectiveDefineMixin(C), UbiquitousDeclStmtMixin(C) {}
+  using entry_iterator = decltype(Entries)::iterator;
+  IteratorRange<entry_iterator> entries() {
+    return IteratorRange<entry_iterator>(Entries.begin(), Entries.end());
+  }
   /// @brief Only in top level we can define/declare functions
   FuncDecl *def_func(std::string Name, Type *RetTy,
                      std::vector<VarDecl *> Params, bool IsVarArg = false);
+  /// @brief Function whose body is built by Builder only by materialize(),
+  /// which emission calls first, or when found reachable by
+  /// eliminate_dead_decls(). The linkage is as def_func(); make it static by
+  /// set_static() for the pass to remove it. Run the pass before emission so
+  /// that unreachable ones are never built. Builder must not add entries to
+  /// the top-levels.
+  FuncDecl *def_func_lazy(std::string Name, Type *RetTy,
+                          std::vector<VarDecl *> Params,
+                          std::function<void(FuncScope *)> Builder,
+                          bool IsVarArg = false);
   /// @brief This is declaration only, no definition.
   FuncSplitDecl *def_func_declare(std::string Name, Type *RetTy,
                                   std::vector<VarDecl *> Params,
                                   bool IsVarArg = false);
   /// @brief The definition of the function corresponding to the declaration.
   void def_func_define(FuncSplitDecl *Decl);
+  bool contains(Emit *E);
+  /// @brief Replace the entry Old with New, destroying Old if owned. Returns
+  /// false, destroying New, if Old is not an entry of this.
+  bool replace(Emit *Old, std::unique_ptr<ScopeEntry> New);
+  /// @brief Remove the entries satisfying Pred in one pass, destroying the
+  /// owned ones. Returns the number of removed entries.
+  size_t remove_if(const std::function<bool(Emit *)> &Pred);
+  /// @brief Replace the entry At with all the entries of From, moving them
+  /// out of From. At is destroyed if owned, even if it owns From. Returns
+  /// false if At is not an entry of this or From is this.
+  bool splice(Emit *At, TopLevel *From);
+  /// @brief Rearrange the entries into Order, a permutation of them. Returns
+  /// false, leaving the entries as they are, if Order is not.
+  bool reorder(const std::vector<Emit *> &Order);
+  /// @brief Add the forward declaration of the struct S at the end.
+  StructDecl *declare_struct(Struct *S);
+  /// @brief Add the forward declaration of the union U at the end.
+  UnionDecl *declare_union(Union *U);
+  /// @brief Add the prototype of the function FD at the end.
+  FuncDecl *declare_func(FuncDecl *FD);
+  /// @brief Move the entries up to and including Last into a new TopLevel,
+  /// with the comment before. Used to seal a part of TopLevel in streaming.
+  std::unique_ptr<TopLevel> split_until(Emit *Last);
+  /// @brief Build the lazy functions in this, including the ones in the
+  /// branches of directives.
+  void materialize() override;
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -44,6 +100,19 @@ protected:
 /**
   @brief FuncScope is for normal scope, such as function body, if body, etc.
   This can have directives, type declarations, statements.
+
+  The entries are kept in an intrusive doubly-linked list owned by this scope.
+  New entries are inserted at the insertion point, which is the end by
+  default. Entries can be removed, moved and spliced between scopes in O(1),
+  so the code can be generated out of order.
+
+  ```cpp
+  auto *Ret = S->stmt_return(C.EX(X));
+  S->set_insert_point_before(Ret);
+  S->stmt_assign(C.EX(X), C.expr_int(0)); // Inserted before the return.
+  S->set_insert_point_start();
+  auto *X = S->def_var("x", C.type_int()); // Hoisted to the start.
+  ```
  */
 class FuncScope : public Emit,
                   public DirectiveDefineMixin,
@@ -51,19 +120,98 @@ class FuncScope : public Emit,
                   public InFunctionStmtMixin {
   Context &C;
 
-  std::vector<Emit *> Entries;
-  std::vector<std::unique_ptr<Stmt>> Stmts;
+  ScopeEntry *First = nullptr;
+  ScopeEntry *Last = nullptr;
+  // New entries are inserted before this. nullptr for the end.
+  ScopeEntry *InsertPoint = nullptr;
+
+  // Link the chain from Begin to End (inclusive) before Pos.
+  void link(ScopeEntry *Pos, ScopeEntry *Begin, ScopeEntry *End);
+  // Unlink the chain from Begin to End (inclusive) from this scope.
+  void unlink(ScopeEntry *Begin, ScopeEntry *End);
+  void add(std::unique_ptr<ScopeEntry> E) {
+    insert_before(InsertPoint, std::move(E));
+  }
 
 protected:
-  virtual void on_add_directive(Directive *D) override { Entries.push_back(D); }
-  virtual void on_add_decl_stmt(Stmt *S) override { Entries.push_back(S); }
-  virtual void on_add_stmt(Stmt *S) override { Entries.push_back(S); }
+  virtual void on_add_directive(std::unique_ptr<Directive> D) override {
+    add(std::move(D));
+  }
+  virtual void on_add_decl_stmt(std::unique_ptr<Stmt> S) override {
+    add(std::move(S));
+  }
+  virtual void on_add_stmt(std::unique_ptr<Stmt> S) override {
+    add(std::move(S));
+  }
 
 public:
   FuncScope(Context &C)
       : C(C), DirectiveDefineMixin(C), UbiquitousDeclStmtMixin(C),
         InFunctionStmtMixin(C) {}
-  virtual ~FuncScope() {}
+  FuncScope(const FuncScope &) = delete;
+  FuncScope &operator=(const FuncScope &) = delete;
+  virtual ~FuncScope();
+
+  class entry_iterator {
+    ScopeEntry *E;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = ScopeEntry *;
+    using difference_type = std::ptrdiff_t;
+    using pointer = ScopeEntry **;
+    using reference = ScopeEntry *;
+
+    entry_iterator(ScopeEntry *E = nullptr) : E(E) {}
+    ScopeEntry *operator*() const { return E; }
+    entry_iterator &operator++() {
+      E = E->get_next();
+      return *this;
+    }
+    entry_iterator operator++(int) {
+      auto Old = *this;
+      ++*this;
+      return Old;
+    }
+    bool operator==(const entry_iterator &Other) const { return E == Other.E; }
+    bool operator!=(const entry_iterator &Other) const { return E != Other.E; }
+  };
+  IteratorRange<entry_iterator> entries() {
+    return IteratorRange<entry_iterator>(First, nullptr);
+  }
+  ScopeEntry *get_first() { return First; }
+  ScopeEntry *get_last() { return Last; }
+  bool empty() { return First == nullptr; }
+
+  /// @brief Insert new entries before E.
+  void set_insert_point_before(ScopeEntry *E) { InsertPoint = E; }
+  /// @brief Insert new entries after E, in the order of insertion.
+  void set_insert_point_after(ScopeEntry *E) { InsertPoint = E->get_next(); }
+  /// @brief Insert new entries at the start, in the order of insertion.
+  void set_insert_point_start() { InsertPoint = First; }
+  /// @brief Append new entries. This is the default.
+  void set_insert_point_end() { InsertPoint = nullptr; }
+  /// @brief The entry new entries are inserted before. nullptr for the end.
+  ScopeEntry *get_insert_point() { return InsertPoint; }
+
+  /// @brief Insert E before Pos of this scope, or append if Pos is nullptr.
+  void insert_before(ScopeEntry *Pos, std::unique_ptr<ScopeEntry> E);
+  /// @brief Remove E from this scope, returning its ownership.
+  std::unique_ptr<ScopeEntry> remove(ScopeEntry *E);
+  /// @brief Move E of this scope before Pos, or to the end if Pos is nullptr.
+  void move_before(ScopeEntry *Pos, ScopeEntry *E);
+  /// @brief Move E of this scope to the start.
+  void hoist_to_start(ScopeEntry *E) { move_before(First, E); }
+  /// @brief Move the entries from Begin to End (inclusive) of Other before Pos
+  /// of this scope in O(1). The insertion point of Other is kept out of them:
+  /// past a single moved entry, or reset to the end for a longer range. If
+  /// Other is this, Pos inside the range is checked in O(n) and returns
+  /// false, doing nothing.
+  bool splice_before(ScopeEntry *Pos, FuncScope *Other, ScopeEntry *Begin,
+                     ScopeEntry *End);
+  /// @brief Move all the entries of Other before Pos of this scope in O(1).
+  void splice_before(ScopeEntry *Pos, FuncScope *Other);
+
   void emit_impl(std::ostream &SS) override;
 };
 
@@ -75,16 +223,24 @@ class MacroFuncScope : public Emit,
                        public UbiquitousDeclStmtMixin,
                        public InFunctionStmtMixin {
   Context &C;
-  std::vector<Emit *> Entries;
-  std::vector<std::unique_ptr<Stmt>> Stmts;
+  std::vector<std::unique_ptr<Stmt>> Entries;
 
 protected:
-  virtual void on_add_decl_stmt(Stmt *S) override { Entries.push_back(S); }
-  virtual void on_add_stmt(Stmt *S) override { Entries.push_back(S); }
+  virtual void on_add_decl_stmt(std::unique_ptr<Stmt> S) override {
+    Entries.push_back(std::move(S));
+  }
+  virtual void on_add_stmt(std::unique_ptr<Stmt> S) override {
+    Entries.push_back(std::move(S));
+  }
 
 public:
+  using entry_iterator = VUIterator<Stmt>;
   MacroFuncScope(Context &C)
       : C(C), UbiquitousDeclStmtMixin(C), InFunctionStmtMixin(C) {}
+  IteratorRange<entry_iterator> entries() {
+    return IteratorRange<entry_iterator>(
+        entry_iterator(Entries, 0), entry_iterator(Entries, Entries.size()));
+  }
   virtual ~MacroFuncScope() {}
   void emit_impl(std::ostream &SS) override;
 };
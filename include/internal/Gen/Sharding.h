@@ -0,0 +1,53 @@
+#ifndef NAMEC_GEN_SHARDING_H
+#define NAMEC_GEN_SHARDING_H
+
+#include <cstddef>
+#include <string>
+
+#include "internal/Gen/Forwards.h"
+#include "internal/Util/Sharding.h"
+
+namespace namec {
+
+/**
+  @brief Split the top-level definitions of F into the header Stem.h and
+  NumShards sources Stem_<I>.c, so that they can be compiled in parallel.
+  See plan_shards() for the placement and the balancing.
+
+  - Directives, types, RawDecl, other statements and the entries of #if
+    branches go to the header. So #if branches must have only declarations
+    and macros, and a macro applies to the whole file. The functions and
+    variables defined in #if branches are reported by
+    ShardedFile::warnings(), since every source would define them.
+  - Non-static functions and variables are defined in the sources. The header
+    has their prototypes and extern declarations.
+  - Static functions and variables, with their forward declarations, go to
+    the sources referring to them. The references are found conservatively
+    by the identifiers in the emitted code.
+  - An alias function is kept with its target.
+
+  Lazy functions are materialized first.
+
+  ```cpp
+  auto Shards = shard_file(F, 8, "gen");
+  Shards.emit_to_dir("out", true); // out/gen.h, out/gen_0.c ... out/gen_7.c
+  ```
+ */
+ShardedFile shard_file(CFile &F, size_t NumShards, const std::string &Stem);
+
+/**
+  @brief Split F into the header Stem.h and the source Stem.c. The header has
+  the directives, the types and the declarations of the non-static
+  definitions with an include guard, and the source has all the definitions.
+  The same placement as shard_file() with one shard, so that the other
+  translation units can include the small header instead of the whole file.
+
+  The split declarations made by TopLevel::def_func_declare() stay in the
+  header, and their definitions by TopLevel::def_func_define() go to the
+  source. The definitions in #if branches are reported as by shard_file().
+ */
+ShardedFile split_file(CFile &F, const std::string &Stem);
+
+} // namespace namec
+
+#endif // NAMEC_GEN_SHARDING_H
@@ -0,0 +1,80 @@
+#ifndef NAMEC_GEN_SPECIALIZE_H
+#define NAMEC_GEN_SPECIALIZE_H
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "internal/Gen/Forwards.h"
+#include "internal/Gen/IntValue.h"
+
+namespace namec {
+
+/**
+  @brief MacroEnv is the macros known at generation time, such as the
+  configuration of a build. A name not in the environment is unknown, unless
+  it is closed.
+ */
+class MacroEnv {
+  // The defined macros with the integer value of the body, if it has one.
+  std::unordered_map<std::string, std::optional<IntValue>> Defined;
+  std::unordered_set<std::string> Undefined;
+  std::unordered_set<std::string> Unknown;
+  bool IsClosed = false;
+
+public:
+  /// @brief Define Name with the integer value V.
+  void define(const std::string &Name, IntValue V);
+  /// @brief Define Name with the body Value, which has an integer value if it
+  /// is an integer literal.
+  void define(const std::string &Name, const std::string &Value = "");
+  void undefine(const std::string &Name);
+  /// @brief Make Name unknown, which may or may not be defined.
+  void forget(const std::string &Name);
+  /// @brief With IsClosed, the names not in this are taken as undefined,
+  /// instead of unknown.
+  void set_closed(bool IsClosed) { this->IsClosed = IsClosed; }
+
+  /// @brief std::nullopt if unknown.
+  std::optional<bool> is_defined(const std::string &Name) const;
+  /// @brief The value of Name in #if. 0 if undefined, std::nullopt if unknown
+  /// or the body is not an integer literal.
+  std::optional<IntValue> get_value(const std::string &Name) const;
+};
+
+struct SpecializeStats {
+  size_t Resolved = 0; // Conditional directives replaced by the live branch.
+  size_t Kept = 0;     // Conditional directives left undecided.
+};
+
+/**
+  @brief Evaluate the condition of #if or #elif over Env, as the preprocessor
+  does. std::nullopt if it depends on an unknown macro or is not supported.
+
+  Every integer is converted to intmax_t or uintmax_t (long long here) as in
+  #if. IntLiteral, the RawExpr of an identifier, an integer literal or
+  `defined X`, the call `defined(X)`, the unary, binary and ternary operators
+  and the parentheses are evaluated, with eval_unary() and eval_binary(). The
+  operands of && and || not affecting the result may be unknown.
+ */
+std::optional<IntValue> eval_directive_cond(Expr *Cond, const MacroEnv &Env);
+
+/**
+  @brief Specialize the conditional directives (IfDirective, Ifdef and
+  Ifndef) in the top-levels of F for Env. A directive whose live branch is
+  decided is replaced by the entries of the branch, or removed if no branch
+  is live. The spliced entries are specialized in turn.
+
+  The top-level Define, DefineFuncMacro and Undef directives update the
+  environment in order, and a #define or #undef in RawDirective makes the
+  name unknown. The macros changed in the branches of an undecided directive
+  are unknown after it. Directives in function bodies are not looked into, so
+  they must not change the macros used in the conditions.
+ */
+SpecializeStats specialize_directives(CFile &F, MacroEnv Env);
+
+} // namespace namec
+
+#endif // NAMEC_GEN_SPECIALIZE_H
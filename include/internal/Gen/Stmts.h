@@ -6,20 +6,55 @@
 #include "internal/Gen/Forwards.h"
 
 namespace namec {
-class Stmt : public Emit {
+/// @brief Kind of Stmt, to dispatch on the node class without virtual calls.
+enum class StmtKind {
+  Raw,
+  Decl,
+  If,
+  While,
+  For,
+  Do,
+  Block,
+  Expr,
+  Return,
+  Break,
+  Continue,
+  Label,
+  Goto,
+  Case,
+  Switch,
+};
+
+/// @brief Likelihood of a branch taken, emitted by __builtin_expect so that
+/// the compiler lays out the likely path as the fall-through.
+enum class Likelihood {
+  None,
+  Likely,
+  Unlikely,
+};
+
+class Stmt : public ScopeEntry {
+  StmtKind Kind;
+  OriginId Origin = 0;
+
 protected:
   Context &C;
 
 public:
-  Stmt(Context &C) : C(C) {}
+  Stmt(Context &C, StmtKind Kind)
+      : ScopeEntry(EmitKind::Stmt), Kind(Kind), C(C) {}
   virtual ~Stmt() = default;
+  StmtKind get_kind() { return Kind; }
+  /// @brief The origin by Context::add_origin(), for emit_with_origins().
+  void set_origin(OriginId Origin) { this->Origin = Origin; }
+  OriginId get_origin() { return Origin; }
 };
 
 class RawStmt : public Stmt {
   std::string Val;
 
 public:
-  RawStmt(Context &C, std::string Val) : Stmt(C), Val(Val) {}
+  RawStmt(Context &C, std::string Val) : Stmt(C, StmtKind::Raw), Val(Val) {}
   std::string get_val() { return Val; }
 
 protected:
@@ -30,7 +65,7 @@ class DeclStmt : public Stmt {
   Decl *D;
 
 public:
-  DeclStmt(Context &C, Decl *D) : Stmt(C), D(D) {}
+  DeclStmt(Context &C, Decl *D) : Stmt(C, StmtKind::Decl), D(D) {}
   Decl *get_decl() { return D; }
 
 protected:
@@ -42,23 +77,52 @@ class IfStmt : public Stmt {
   FuncScope *Then;
   std::vector<std::pair<Expr *, FuncScope *>> Elseifs;
   FuncScope *Else = nullptr;
+  Likelihood Hint = Likelihood::None;
+  // The likelihood of each of Elseifs.
+  std::vector<Likelihood> ElseifHints;
 
 public:
-  IfStmt(Context &C, Expr *Cond) : Stmt(C), Cond(Cond), Then(C.add_scope()) {}
+  IfStmt(Context &C, Expr *Cond)
+      : Stmt(C, StmtKind::If), Cond(Cond), Then(C.add_scope()) {}
+  using elseif_iterator = decltype(Elseifs)::iterator;
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) {
+    Cond = E;
+    note_modified();
+  }
   FuncScope *get_then() { return Then; }
-  FuncScope *add_elseif(Expr *Cond) {
+  IteratorRange<elseif_iterator> elseifs() {
+    return IteratorRange<elseif_iterator>(Elseifs.begin(), Elseifs.end());
+  }
+  FuncScope *add_elseif(Expr *Cond, Likelihood Hint = Likelihood::None) {
     auto S = C.add_scope();
     Elseifs.push_back({Cond, S});
+    ElseifHints.push_back(Hint);
+    note_modified();
     return S;
   }
   FuncScope *get_or_add_else() {
     if (!Else) {
       Else = C.add_scope();
+      note_modified();
     }
     return Else;
   }
   bool has_else() { return Else != nullptr; }
+  /// @brief nullptr if no else.
+  FuncScope *get_else() { return Else; }
+  /// @brief The likelihood of the then branch.
+  Likelihood get_likelihood() { return Hint; }
+  void set_likelihood(Likelihood Hint) {
+    this->Hint = Hint;
+    note_modified();
+  }
+  /// @brief The likelihood of the I-th else if branch.
+  Likelihood get_elseif_likelihood(size_t I) { return ElseifHints[I]; }
+  void set_elseif_likelihood(size_t I, Likelihood Hint) {
+    ElseifHints[I] = Hint;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -67,12 +131,23 @@ protected:
 class WhileStmt : public Stmt {
   Expr *Cond;
   FuncScope *Body;
+  Likelihood Hint = Likelihood::None;
 
 public:
   WhileStmt(Context &C, Expr *Cond)
-      : Stmt(C), Cond(Cond), Body(C.add_scope()) {}
+      : Stmt(C, StmtKind::While), Cond(Cond), Body(C.add_scope()) {}
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) {
+    Cond = E;
+    note_modified();
+  }
   FuncScope *get_body() { return Body; }
+  /// @brief The likelihood of the loop continuing.
+  Likelihood get_likelihood() { return Hint; }
+  void set_likelihood(Likelihood Hint) {
+    this->Hint = Hint;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -83,16 +158,31 @@ class ForStmt : public Stmt {
   Expr *Cond;
   Expr *Step;
   FuncScope *Body;
+  Likelihood Hint = Likelihood::None;
 
 public:
   ForStmt(Context &C, std::unique_ptr<Stmt> Init, Expr *Cond, Expr *Step)
-      : Stmt(C), Cond(Cond), Step(Step), Body(C.add_scope()) {
+      : Stmt(C, StmtKind::For), Cond(Cond), Step(Step), Body(C.add_scope()) {
     this->Init = std::move(Init);
   }
   Stmt *get_init() { return Init.get(); }
   Expr *get_cond() { return Cond; }
   Expr *get_step() { return Step; }
+  void set_cond(Expr *E) {
+    Cond = E;
+    note_modified();
+  }
+  void set_step(Expr *E) {
+    Step = E;
+    note_modified();
+  }
   FuncScope *get_body() { return Body; }
+  /// @brief The likelihood of the loop continuing. Ignored without Cond.
+  Likelihood get_likelihood() { return Hint; }
+  void set_likelihood(Likelihood Hint) {
+    this->Hint = Hint;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -101,11 +191,23 @@ protected:
 class DoStmt : public Stmt {
   Expr *Cond;
   FuncScope *Body;
+  Likelihood Hint = Likelihood::None;
 
 public:
-  DoStmt(Context &C, Expr *Cond) : Stmt(C), Cond(Cond), Body(C.add_scope()) {}
+  DoStmt(Context &C, Expr *Cond)
+      : Stmt(C, StmtKind::Do), Cond(Cond), Body(C.add_scope()) {}
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) {
+    Cond = E;
+    note_modified();
+  }
   FuncScope *get_body() { return Body; }
+  /// @brief The likelihood of the loop continuing.
+  Likelihood get_likelihood() { return Hint; }
+  void set_likelihood(Likelihood Hint) {
+    this->Hint = Hint;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -115,7 +217,7 @@ class BlockStmt : public Stmt {
   FuncScope *S;
 
 public:
-  BlockStmt(Context &C) : Stmt(C), S(C.add_scope()) {}
+  BlockStmt(Context &C) : Stmt(C, StmtKind::Block), S(C.add_scope()) {}
   FuncScope *get_scope() { return S; }
 
 protected:
@@ -126,8 +228,12 @@ class ExprStmt : public Stmt {
   Expr *E;
 
 public:
-  ExprStmt(Context &C, Expr *E) : Stmt(C), E(E) {}
+  ExprStmt(Context &C, Expr *E) : Stmt(C, StmtKind::Expr), E(E) {}
   Expr *get_expr() { return E; }
+  void set_expr(Expr *E) {
+    this->E = E;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -137,8 +243,12 @@ class ReturnStmt : public Stmt {
   Expr *E;
 
 public:
-  ReturnStmt(Context &C, Expr *E) : Stmt(C), E(E) {}
+  ReturnStmt(Context &C, Expr *E) : Stmt(C, StmtKind::Return), E(E) {}
   Expr *get_expr() { return E; }
+  void set_expr(Expr *E) {
+    this->E = E;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -146,7 +256,7 @@ protected:
 
 class BreakStmt : public Stmt {
 public:
-  BreakStmt(Context &C) : Stmt(C) {}
+  BreakStmt(Context &C) : Stmt(C, StmtKind::Break) {}
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -154,7 +264,7 @@ protected:
 
 class ContinueStmt : public Stmt {
 public:
-  ContinueStmt(Context &C) : Stmt(C) {}
+  ContinueStmt(Context &C) : Stmt(C, StmtKind::Continue) {}
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -166,7 +276,7 @@ class LabelStmt : public Stmt {
 
 public:
   LabelStmt(Context &C, std::string Name, Stmt *S = nullptr)
-      : Stmt(C), Name(Name), S(S) {}
+      : Stmt(C, StmtKind::Label), Name(Name), S(S) {}
   std::string get_name() { return Name; }
   Stmt *get_stmt() { return S; }
 
@@ -178,7 +288,8 @@ class GotoStmt : public Stmt {
   std::string Name;
 
 public:
-  GotoStmt(Context &C, std::string Name) : Stmt(C), Name(Name) {}
+  GotoStmt(Context &C, std::string Name)
+      : Stmt(C, StmtKind::Goto), Name(Name) {}
   std::string get_name() { return Name; }
 
 protected:
@@ -189,14 +300,28 @@ class CaseStmt : public Stmt {
   Expr *Val; //  nullptr for default
   FuncScope *Body;
   bool IsFallThrough;
+  Likelihood Hint = Likelihood::None;
 
 public:
   CaseStmt(Context &C, Expr *Val = nullptr, bool IsFallThrough = false)
-      : Stmt(C), Val(Val), IsFallThrough(IsFallThrough), Body(C.add_scope()) {}
+      : Stmt(C, StmtKind::Case), Val(Val), IsFallThrough(IsFallThrough),
+        Body(C.add_scope()) {}
   Expr *get_val() { return Val; }
+  void set_val(Expr *E) {
+    Val = E;
+    note_modified();
+  }
   bool is_default() { return Val == nullptr; }
   bool is_fall_through() { return IsFallThrough; }
   FuncScope *get_body() { return Body; }
+  /// @brief The likelihood of this case. C has no annotation on cases, and
+  /// __builtin_expect on the condition would convert it to long, changing the
+  /// matching case, so this is recorded but not emitted.
+  Likelihood get_likelihood() { return Hint; }
+  void set_likelihood(Likelihood Hint) {
+    this->Hint = Hint;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -207,8 +332,17 @@ class SwitchStmt : public Stmt {
   std::vector<std::unique_ptr<CaseStmt>> Cases;
 
 public:
-  SwitchStmt(Context &C, Expr *Cond) : Stmt(C), Cond(Cond) {}
+  using case_iterator = VUIterator<CaseStmt>;
+  SwitchStmt(Context &C, Expr *Cond) : Stmt(C, StmtKind::Switch), Cond(Cond) {}
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) {
+    Cond = E;
+    note_modified();
+  }
+  IteratorRange<case_iterator> cases() {
+    return IteratorRange<case_iterator>(case_iterator(Cases, 0),
+                                        case_iterator(Cases, Cases.size()));
+  }
   CaseStmt *add_case(Expr *Val, bool IsFallThrough = false);
   CaseStmt *add_default(bool IsFallThrough = false);
 
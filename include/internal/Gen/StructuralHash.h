@@ -0,0 +1,94 @@
+#ifndef NAMEC_GEN_STRUCTURAL_HASH_H
+#define NAMEC_GEN_STRUCTURAL_HASH_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "internal/Gen/Attribute.h"
+#include "internal/Gen/Emit.h"
+#include "internal/Gen/Forwards.h"
+#include "internal/Util/Hash.h"
+
+namespace namec {
+
+/**
+  @brief StructuralHasher computes stable 128-bit structural hashes of nodes,
+  memoizing them per node.
+
+  The hash depends only on the code the node emits, built from the kinds,
+  names and operators of the node and the hashes of its children. So it is
+  independent of pointer values and much cheaper than hashing to_string().
+  Comments and whitespace inserted by insert_comment(), insert_newline() and
+  so on are ignored, while the text of directive_raw() is always hashed. The
+  hash is identical across processes, so it can be used as an on-disk cache
+  key.
+
+  Declarations and types referred by other nodes are hashed by their names, as
+  they are emitted. Definitions such as FuncDecl and StructDecl are hashed with
+  their whole contents.
+
+  The hasher records the nodes whose hashes read each node: the parents, and
+  the nodes hashing the fields of another such as FuncSplitForwardDecl. When
+  a node is modified on the thread of the hasher (Emit::note_modified()), the
+  memoized hashes of it and of these users are dropped, transitively, and the
+  others are kept. So rehashing after a modification costs the depth of the
+  node, not the whole tree. The nodes modified on other threads are not seen,
+  as the modifications of the nodes are not thread-safe anyway. A destroyed
+  node is told from a new one of the same address by Emit::Id.
+
+  ```cpp
+  StructuralHasher H;
+  if (H.hash(FD1) == H.hash(FD2)) {
+    // FD1 and FD2 emit the same code.
+  }
+  ```
+ */
+class StructuralHasher : public ModificationListener {
+  struct Memo {
+    Hash128 Hash;
+    uint64_t Id;
+  };
+  std::unordered_map<const Emit *, Memo> Cache;
+  // The nodes whose memoized hashes read each node.
+  std::unordered_map<const Emit *, std::vector<const Emit *>> Users;
+  // The nodes being computed, innermost last.
+  std::vector<const Emit *> Computing;
+
+  template <typename T> Hash128 memoize(T *N);
+  // Record that the node being computed reads N.
+  void depend(const Emit *N);
+  Hash128 compute(Expr *E);
+  Hash128 compute(Stmt *S);
+  Hash128 compute(Decl *D);
+  Hash128 compute(Type *T);
+  Hash128 compute(Directive *D);
+  Hash128 compute(FuncScope *S);
+  Hash128 compute(MacroFuncScope *S);
+  Hash128 compute(TopLevel *T);
+  void add_entry(Hash128Builder &B, Emit *E);
+
+public:
+  /// @brief All the overloads return the same fixed hash for nullptr.
+  Hash128 hash(Expr *E) { return memoize(E); }
+  Hash128 hash(Stmt *S) { return memoize(S); }
+  Hash128 hash(Decl *D) { return memoize(D); }
+  Hash128 hash(Type *T) { return memoize(T); }
+  Hash128 hash(Directive *D) { return memoize(D); }
+  Hash128 hash(FuncScope *S) { return memoize(S); }
+  Hash128 hash(MacroFuncScope *S) { return memoize(S); }
+  Hash128 hash(TopLevel *T) { return memoize(T); }
+  /// @brief The hash of the attributes of FuncDecl or VarDecl, which are
+  /// hashed with them. Not memoized.
+  static Hash128 hash_attrs(const Attributed &A);
+
+  void on_modified(const Emit *E) override;
+  void clear() {
+    Cache.clear();
+    Users.clear();
+  }
+  size_t cache_size() { return Cache.size(); }
+};
+
+} // namespace namec
+
+#endif // NAMEC_GEN_STRUCTURAL_HASH_H
@@ -32,10 +32,21 @@ protected:
 
 class Named : public Type {
   Decl *D;
+  // The spelling kept when D is released.
+  std::string Spelling;
 
 public:
   Named(Decl *D) : D(D) {}
+  /// @brief The declaration named, or nullptr after it is released by
+  /// CFile::seal(). The type is still emitted by the name then.
   Decl *get_decl() { return D; }
+  /// @brief Keep the spelling and forget the declaration, which is about to
+  /// be released.
+  void release_decl() {
+    Spelling = to_string();
+    D = nullptr;
+    note_modified();
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -117,6 +128,7 @@ public:
   }
   void def_member(std::string Name, Type *Ty) {
     Members.push_back(std::make_unique<VarDecl>(Name, Ty));
+    note_modified();
   }
 };
 
@@ -150,6 +162,7 @@ public:
   }
   void def_member(std::string Name, Expr *Value) {
     Members.push_back(std::make_pair(Name, Value));
+    note_modified();
   }
 
 protected:
@@ -0,0 +1,815 @@
+#ifndef NAMEC_GEN_VISITOR_H
+#define NAMEC_GEN_VISITOR_H
+
+#include <unordered_map>
+
+#include "internal/Gen/Decl.h"
+#include "internal/Gen/Directive.h"
+#include "internal/Gen/Exprs.h"
+#include "internal/Gen/File.h"
+#include "internal/Gen/Forwards.h"
+#include "internal/Gen/Scope.h"
+#include "internal/Gen/Stmts.h"
+#include "internal/Gen/Types.h"
+
+namespace namec {
+
+/**
+  @brief RecursiveVisitor traverses the nodes in pre-order, in the order of
+  emission.
+
+  Derived is the CRTP derived class, which hides the visit_* hooks it is
+  interested in. For an expression or a statement, visit_expr() or
+  visit_stmt() is called first, then the hook of its kind. A hook returning
+  false stops the whole traversal. Expressions and statements are dispatched
+  by their kinds, so no virtual call is made per node.
+
+  Declarations referred by VariableExpr or Named are not children, so they are
+  not traversed there. Types are shared between nodes, so they are traversed
+  only if Derived hides should_traverse_types() to return true.
+
+  ```cpp
+  struct CallCounter : RecursiveVisitor<CallCounter> {
+    size_t Count = 0;
+    bool visit_call_expr(CallExpr *E) {
+      Count++;
+      return true;
+    }
+  };
+  CallCounter V;
+  V.traverse_file(&F);
+  ```
+ */
+template <typename Derived> class RecursiveVisitor {
+protected:
+  Derived &derived() { return *static_cast<Derived *>(this); }
+
+public:
+  bool should_traverse_types() { return false; }
+
+  // Hooks to be hidden by Derived.
+  bool visit_top_level(TopLevel *) { return true; }
+  bool visit_func_scope(FuncScope *) { return true; }
+  bool visit_macro_func_scope(MacroFuncScope *) { return true; }
+  bool visit_directive(Directive *) { return true; }
+  bool visit_decl(Decl *) { return true; }
+  bool visit_type(Type *) { return true; }
+
+  bool visit_expr(Expr *) { return true; }
+  bool visit_raw_expr(RawExpr *) { return true; }
+  bool visit_variable_expr(VariableExpr *) { return true; }
+  bool visit_subscript_expr(SubscriptExpr *) { return true; }
+  bool visit_call_expr(CallExpr *) { return true; }
+  bool visit_unary_op(UnaryOp *) { return true; }
+  bool visit_binary_op(BinaryOp *) { return true; }
+  bool visit_ternary_op(TernaryOp *) { return true; }
+  bool visit_cast_expr(CastExpr *) { return true; }
+  bool visit_paren_expr(ParenExpr *) { return true; }
+  bool visit_designated_init_expr(DesignatedInitExpr *) { return true; }
+  bool visit_init_list_expr(InitListExpr *) { return true; }
+  bool visit_generic_selection(GenericSelection *) { return true; }
+
+  bool visit_stmt(Stmt *) { return true; }
+  bool visit_raw_stmt(RawStmt *) { return true; }
+  bool visit_decl_stmt(DeclStmt *) { return true; }
+  bool visit_if_stmt(IfStmt *) { return true; }
+  bool visit_while_stmt(WhileStmt *) { return true; }
+  bool visit_for_stmt(ForStmt *) { return true; }
+  bool visit_do_stmt(DoStmt *) { return true; }
+  bool visit_block_stmt(BlockStmt *) { return true; }
+  bool visit_expr_stmt(ExprStmt *) { return true; }
+  bool visit_return_stmt(ReturnStmt *) { return true; }
+  bool visit_break_stmt(BreakStmt *) { return true; }
+  bool visit_continue_stmt(ContinueStmt *) { return true; }
+  bool visit_label_stmt(LabelStmt *) { return true; }
+  bool visit_goto_stmt(GotoStmt *) { return true; }
+  bool visit_case_stmt(CaseStmt *) { return true; }
+  bool visit_switch_stmt(SwitchStmt *) { return true; }
+
+  // Traversal.
+  bool traverse_file(CFile *F) {
+    for (auto &T : F->top_levels()) {
+      if (!derived().traverse_top_level(&T)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool traverse_top_level(TopLevel *T) {
+    if (!T || !derived().visit_top_level(T)) {
+      return !T;
+    }
+    for (auto *E : T->entries()) {
+      if (!derived().traverse_entry(E)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool traverse_func_scope(FuncScope *S) {
+    if (!S || !derived().visit_func_scope(S)) {
+      return !S;
+    }
+    for (auto *E : S->entries()) {
+      if (!derived().traverse_entry(E)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool traverse_macro_func_scope(MacroFuncScope *S) {
+    if (!derived().visit_macro_func_scope(S)) {
+      return false;
+    }
+    for (auto &E : S->entries()) {
+      if (!derived().traverse_stmt(&E)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /// @brief Traverse an entry of TopLevel or FuncScope.
+  bool traverse_entry(Emit *E) {
+    switch (E->get_emit_kind()) {
+    case EmitKind::Stmt:
+      return derived().traverse_stmt(static_cast<Stmt *>(E));
+    case EmitKind::Directive:
+      return derived().traverse_directive(static_cast<Directive *>(E));
+    case EmitKind::Decl:
+      return derived().traverse_decl(static_cast<Decl *>(E));
+    case EmitKind::Other:
+      break;
+    }
+    return true;
+  }
+
+  bool traverse_directive(Directive *D) {
+    if (!derived().visit_directive(D)) {
+      return false;
+    }
+    if (D->get_kind() == DirectiveKind::DefineFuncMacro) {
+      return derived().traverse_macro_func_scope(
+          static_cast<DefineFuncMacro *>(D)->get_body());
+    }
+    if (!D->is_if()) {
+      return true;
+    }
+    auto *If = static_cast<IfDirectiveBase *>(D);
+    if (D->get_kind() == DirectiveKind::If &&
+        !derived().traverse_expr(static_cast<IfDirective *>(D)->get_cond())) {
+      return false;
+    }
+    if (!derived().traverse_top_level(If->get_then())) {
+      return false;
+    }
+    for (auto &[Cond, T] : If->elifs()) {
+      if (!derived().traverse_expr(Cond) ||
+          !derived().traverse_top_level(T.get())) {
+        return false;
+      }
+    }
+    return derived().traverse_top_level(If->get_else());
+  }
+
+  bool traverse_decl(Decl *D) {
+    if (!derived().visit_decl(D)) {
+      return false;
+    }
+    switch (D->get_kind()) {
+    case DeclKind::Var:
+    case DeclKind::ArrayVar: {
+      auto *V = static_cast<VarDecl *>(D);
+      if (!traverse_type_if_enabled(V->get_type())) {
+        return false;
+      }
+      if (D->get_kind() == DeclKind::ArrayVar) {
+        for (auto *Size : static_cast<ArrayVarDecl *>(D)->sizes()) {
+          if (!derived().traverse_expr(Size)) {
+            return false;
+          }
+        }
+      }
+      return derived().traverse_expr(V->get_init());
+    }
+    case DeclKind::Func:
+    case DeclKind::FuncSplit: {
+      auto *F = static_cast<FuncDecl *>(D);
+      if (!traverse_type_if_enabled(F->get_ret_type())) {
+        return false;
+      }
+      for (auto *P : F->params()) {
+        if (!derived().traverse_decl(P)) {
+          return false;
+        }
+      }
+      return derived().traverse_func_scope(F->get_body());
+    }
+    case DeclKind::Typedef:
+      return traverse_type_if_enabled(
+          static_cast<TypedefDecl *>(D)->get_type_alias()->get_type());
+    // The members of struct, union and enum are emitted with the definition.
+    case DeclKind::Struct: {
+      auto *S = static_cast<StructDecl *>(D);
+      return S->is_forward() || traverse_members(S->get_struct());
+    }
+    case DeclKind::Union: {
+      auto *U = static_cast<UnionDecl *>(D);
+      return U->is_forward() || traverse_members(U->get_union());
+    }
+    case DeclKind::Enum: {
+      auto *E = static_cast<EnumDecl *>(D);
+      return E->is_forward() || traverse_members(E->get_enum());
+    }
+    case DeclKind::Raw:
+    case DeclKind::FuncSplitForward:
+      break;
+    }
+    return true;
+  }
+
+  bool traverse_type(Type *T) {
+    if (!T || !derived().visit_type(T)) {
+      return !T;
+    }
+    if (auto *P = dynamic_cast<Pointer *>(T)) {
+      return derived().traverse_type(P->get_elm_type());
+    }
+    if (auto *A = dynamic_cast<Array *>(T)) {
+      for (auto *Size : A->sizes()) {
+        if (!derived().traverse_expr(Size)) {
+          return false;
+        }
+      }
+      return derived().traverse_type(A->get_elm_type());
+    }
+    if (auto *F = dynamic_cast<Function *>(T)) {
+      if (!derived().traverse_type(F->get_ret_type())) {
+        return false;
+      }
+      for (auto *P : F->params()) {
+        if (!derived().traverse_type(P)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    if (auto *A = dynamic_cast<TypeAlias *>(T)) {
+      return derived().traverse_type(A->get_type());
+    }
+    if (auto *M = dynamic_cast<MembersType *>(T)) {
+      return traverse_members(M);
+    }
+    if (auto *E = dynamic_cast<Enum *>(T)) {
+      return traverse_members(E);
+    }
+    return true;
+  }
+
+  bool traverse_stmt(Stmt *S) {
+    if (!S || !derived().visit_stmt(S)) {
+      return !S;
+    }
+    switch (S->get_kind()) {
+    case StmtKind::Raw:
+      return derived().visit_raw_stmt(static_cast<RawStmt *>(S));
+    case StmtKind::Decl: {
+      auto *D = static_cast<DeclStmt *>(S);
+      return derived().visit_decl_stmt(D) &&
+             derived().traverse_decl(D->get_decl());
+    }
+    case StmtKind::If: {
+      auto *If = static_cast<IfStmt *>(S);
+      if (!derived().visit_if_stmt(If) ||
+          !derived().traverse_expr(If->get_cond()) ||
+          !derived().traverse_func_scope(If->get_then())) {
+        return false;
+      }
+      for (auto &[Cond, Body] : If->elseifs()) {
+        if (!derived().traverse_expr(Cond) ||
+            !derived().traverse_func_scope(Body)) {
+          return false;
+        }
+      }
+      return derived().traverse_func_scope(If->get_else());
+    }
+    case StmtKind::While: {
+      auto *W = static_cast<WhileStmt *>(S);
+      return derived().visit_while_stmt(W) &&
+             derived().traverse_expr(W->get_cond()) &&
+             derived().traverse_func_scope(W->get_body());
+    }
+    case StmtKind::For: {
+      auto *F = static_cast<ForStmt *>(S);
+      return derived().visit_for_stmt(F) &&
+             derived().traverse_stmt(F->get_init()) &&
+             derived().traverse_expr(F->get_cond()) &&
+             derived().traverse_expr(F->get_step()) &&
+             derived().traverse_func_scope(F->get_body());
+    }
+    case StmtKind::Do: {
+      auto *D = static_cast<DoStmt *>(S);
+      return derived().visit_do_stmt(D) &&
+             derived().traverse_func_scope(D->get_body()) &&
+             derived().traverse_expr(D->get_cond());
+    }
+    case StmtKind::Block: {
+      auto *B = static_cast<BlockStmt *>(S);
+      return derived().visit_block_stmt(B) &&
+             derived().traverse_func_scope(B->get_scope());
+    }
+    case StmtKind::Expr: {
+      auto *E = static_cast<ExprStmt *>(S);
+      return derived().visit_expr_stmt(E) &&
+             derived().traverse_expr(E->get_expr());
+    }
+    case StmtKind::Return: {
+      auto *R = static_cast<ReturnStmt *>(S);
+      return derived().visit_return_stmt(R) &&
+             derived().traverse_expr(R->get_expr());
+    }
+    case StmtKind::Break:
+      return derived().visit_break_stmt(static_cast<BreakStmt *>(S));
+    case StmtKind::Continue:
+      return derived().visit_continue_stmt(static_cast<ContinueStmt *>(S));
+    case StmtKind::Label: {
+      auto *L = static_cast<LabelStmt *>(S);
+      return derived().visit_label_stmt(L) &&
+             derived().traverse_stmt(L->get_stmt());
+    }
+    case StmtKind::Goto:
+      return derived().visit_goto_stmt(static_cast<GotoStmt *>(S));
+    case StmtKind::Case: {
+      auto *C = static_cast<CaseStmt *>(S);
+      return derived().visit_case_stmt(C) &&
+             derived().traverse_expr(C->get_val()) &&
+             derived().traverse_func_scope(C->get_body());
+    }
+    case StmtKind::Switch: {
+      auto *Sw = static_cast<SwitchStmt *>(S);
+      if (!derived().visit_switch_stmt(Sw) ||
+          !derived().traverse_expr(Sw->get_cond())) {
+        return false;
+      }
+      for (auto &C : Sw->cases()) {
+        if (!derived().traverse_stmt(&C)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    }
+    return true;
+  }
+
+  bool traverse_expr(Expr *E) {
+    if (!E || !derived().visit_expr(E)) {
+      return !E;
+    }
+    switch (E->get_kind()) {
+    case ExprKind::Raw:
+      return derived().visit_raw_expr(static_cast<RawExpr *>(E));
+    case ExprKind::Variable:
+      return derived().visit_variable_expr(static_cast<VariableExpr *>(E));
+    case ExprKind::Subscript: {
+      auto *S = static_cast<SubscriptExpr *>(E);
+      return derived().visit_subscript_expr(S) &&
+             derived().traverse_expr(S->get_array()) &&
+             derived().traverse_expr(S->get_index());
+    }
+    case ExprKind::Call: {
+      auto *C = static_cast<CallExpr *>(E);
+      if (!derived().visit_call_expr(C) ||
+          !derived().traverse_expr(C->get_callee())) {
+        return false;
+      }
+      for (auto *A : C->args()) {
+        if (!derived().traverse_expr(A)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case ExprKind::UnaryOp: {
+      auto *U = static_cast<UnaryOp *>(E);
+      return derived().visit_unary_op(U) &&
+             derived().traverse_expr(U->get_operand());
+    }
+    case ExprKind::BinaryOp: {
+      auto *B = static_cast<BinaryOp *>(E);
+      return derived().visit_binary_op(B) &&
+             derived().traverse_expr(B->get_lhs()) &&
+             derived().traverse_expr(B->get_rhs());
+    }
+    case ExprKind::TernaryOp: {
+      auto *T = static_cast<TernaryOp *>(E);
+      return derived().visit_ternary_op(T) &&
+             derived().traverse_expr(T->get_cond()) &&
+             derived().traverse_expr(T->get_then()) &&
+             derived().traverse_expr(T->get_else());
+    }
+    case ExprKind::Cast: {
+      auto *C = static_cast<CastExpr *>(E);
+      return derived().visit_cast_expr(C) &&
+             traverse_type_if_enabled(C->get_type()) &&
+             derived().traverse_expr(C->get_operand());
+    }
+    case ExprKind::Paren: {
+      auto *P = static_cast<ParenExpr *>(E);
+      return derived().visit_paren_expr(P) &&
+             derived().traverse_expr(P->get_inside());
+    }
+    case ExprKind::DesignatedInit: {
+      auto *D = static_cast<DesignatedInitExpr *>(E);
+      if (!derived().visit_designated_init_expr(D)) {
+        return false;
+      }
+      for (auto &[Name, Value] : D->designators()) {
+        if (!derived().traverse_expr(Value)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case ExprKind::InitList: {
+      auto *I = static_cast<InitListExpr *>(E);
+      if (!derived().visit_init_list_expr(I)) {
+        return false;
+      }
+      for (auto *Value : I->values()) {
+        if (!derived().traverse_expr(Value)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case ExprKind::GenericSelection: {
+      auto *G = static_cast<GenericSelection *>(E);
+      if (!derived().visit_generic_selection(G) ||
+          !derived().traverse_expr(G->get_control())) {
+        return false;
+      }
+      for (auto &[T, Value] : G->assocs()) {
+        if (!traverse_type_if_enabled(T) || !derived().traverse_expr(Value)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    }
+    return true;
+  }
+
+private:
+  bool traverse_type_if_enabled(Type *T) {
+    return !derived().should_traverse_types() || derived().traverse_type(T);
+  }
+  bool traverse_members(MembersType *M) {
+    for (auto &V : M->members()) {
+      if (!derived().traverse_decl(&V)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool traverse_members(Enum *E) {
+    for (auto &[Name, Value] : E->members()) {
+      if (!derived().traverse_expr(Value)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/**
+  @brief Rewriter rewrites the nodes in post-order, replacing children.
+
+  Derived is the CRTP derived class, which hides the hooks:
+  @li transform_expr() returns the replacement of an expression after its
+  children are rewritten. Returning the argument keeps it.
+  @li transform_entry() is called for each entry of FuncScope after its
+  children are rewritten. It may replace, move or remove the entry through
+  the editing methods of FuncScope. The next entry is fixed before the call.
+
+  Every expression slot of statements, declarations, directives and nested
+  expressions is replaced. Types are shared between nodes, so the expressions
+  in them are not rewritten. An expression shared by several slots is
+  rewritten once, and all of them get the same replacement; the replacements
+  are remembered until the next rewrite_file(). The recursion goes through
+  Derived, so that it may also hide the rewrite_* methods.
+
+  ```cpp
+  struct ParenRemover : Rewriter<ParenRemover> {
+    Expr *transform_expr(Expr *E) {
+      if (auto *P = dynamic_cast<ParenExpr *>(E)) {
+        return P->get_inside();
+      }
+      return E;
+    }
+  };
+  ParenRemover().rewrite_file(&F);
+  ```
+ */
+template <typename Derived> class Rewriter {
+  // The replacements of the expressions rewritten so far.
+  std::unordered_map<Expr *, Expr *> Rewritten;
+
+protected:
+  Derived &derived() { return *static_cast<Derived *>(this); }
+
+public:
+  Expr *transform_expr(Expr *E) { return E; }
+  void transform_entry(FuncScope *, ScopeEntry *) {}
+
+  void rewrite_file(CFile *F) {
+    Rewritten.clear();
+    for (auto &T : F->top_levels()) {
+      derived().rewrite_top_level(&T);
+    }
+  }
+
+  void rewrite_top_level(TopLevel *T) {
+    if (!T) {
+      return;
+    }
+    for (auto *E : T->entries()) {
+      derived().rewrite_entry(E);
+    }
+  }
+
+  void rewrite_func_scope(FuncScope *S) {
+    if (!S) {
+      return;
+    }
+    for (auto *E = S->get_first(); E;) {
+      auto *Next = E->get_next();
+      derived().rewrite_entry(E);
+      derived().transform_entry(S, E);
+      E = Next;
+    }
+  }
+
+  void rewrite_entry(Emit *E) {
+    switch (E->get_emit_kind()) {
+    case EmitKind::Stmt:
+      derived().rewrite_stmt(static_cast<Stmt *>(E));
+      break;
+    case EmitKind::Directive:
+      derived().rewrite_directive(static_cast<Directive *>(E));
+      break;
+    case EmitKind::Decl:
+      derived().rewrite_decl(static_cast<Decl *>(E));
+      break;
+    case EmitKind::Other:
+      break;
+    }
+  }
+
+  void rewrite_directive(Directive *D) {
+    if (D->get_kind() == DirectiveKind::DefineFuncMacro) {
+      for (auto &S : static_cast<DefineFuncMacro *>(D)->get_body()->entries()) {
+        derived().rewrite_stmt(&S);
+      }
+      return;
+    }
+    if (!D->is_if()) {
+      return;
+    }
+    auto *If = static_cast<IfDirectiveBase *>(D);
+    if (D->get_kind() == DirectiveKind::If) {
+      auto *I = static_cast<IfDirective *>(D);
+      I->set_cond(derived().rewrite_expr(I->get_cond()));
+    }
+    derived().rewrite_top_level(If->get_then());
+    for (auto &[Cond, T] : If->elifs()) {
+      rewrite_child(D, Cond);
+      derived().rewrite_top_level(T.get());
+    }
+    derived().rewrite_top_level(If->get_else());
+  }
+
+  void rewrite_decl(Decl *D) {
+    switch (D->get_kind()) {
+    case DeclKind::Var:
+    case DeclKind::ArrayVar: {
+      if (D->get_kind() == DeclKind::ArrayVar) {
+        for (auto &Size : static_cast<ArrayVarDecl *>(D)->sizes()) {
+          rewrite_child(D, Size);
+        }
+      }
+      auto *V = static_cast<VarDecl *>(D);
+      V->set_init(derived().rewrite_expr(V->get_init()));
+      break;
+    }
+    case DeclKind::Func:
+    case DeclKind::FuncSplit: {
+      auto *F = static_cast<FuncDecl *>(D);
+      for (auto *P : F->params()) {
+        derived().rewrite_decl(P);
+      }
+      derived().rewrite_func_scope(F->get_body());
+      break;
+    }
+    case DeclKind::Struct:
+      if (auto *S = static_cast<StructDecl *>(D); !S->is_forward()) {
+        rewrite_members(S->get_struct());
+      }
+      break;
+    case DeclKind::Union:
+      if (auto *U = static_cast<UnionDecl *>(D); !U->is_forward()) {
+        rewrite_members(U->get_union());
+      }
+      break;
+    case DeclKind::Enum:
+      if (auto *E = static_cast<EnumDecl *>(D); !E->is_forward()) {
+        for (auto &[Name, Value] : E->get_enum()->members()) {
+          rewrite_child(E->get_enum(), Value);
+        }
+      }
+      break;
+    case DeclKind::Raw:
+    case DeclKind::Typedef:
+    case DeclKind::FuncSplitForward:
+      break;
+    }
+  }
+
+  void rewrite_stmt(Stmt *S) {
+    if (!S) {
+      return;
+    }
+    switch (S->get_kind()) {
+    case StmtKind::Raw:
+    case StmtKind::Break:
+    case StmtKind::Continue:
+    case StmtKind::Goto:
+      return;
+    case StmtKind::Decl:
+      derived().rewrite_decl(static_cast<DeclStmt *>(S)->get_decl());
+      return;
+    case StmtKind::If: {
+      auto *If = static_cast<IfStmt *>(S);
+      If->set_cond(derived().rewrite_expr(If->get_cond()));
+      derived().rewrite_func_scope(If->get_then());
+      for (auto &[Cond, Body] : If->elseifs()) {
+        rewrite_child(If, Cond);
+        derived().rewrite_func_scope(Body);
+      }
+      derived().rewrite_func_scope(If->get_else());
+      return;
+    }
+    case StmtKind::While: {
+      auto *W = static_cast<WhileStmt *>(S);
+      W->set_cond(derived().rewrite_expr(W->get_cond()));
+      derived().rewrite_func_scope(W->get_body());
+      return;
+    }
+    case StmtKind::For: {
+      auto *F = static_cast<ForStmt *>(S);
+      derived().rewrite_stmt(F->get_init());
+      F->set_cond(derived().rewrite_expr(F->get_cond()));
+      F->set_step(derived().rewrite_expr(F->get_step()));
+      derived().rewrite_func_scope(F->get_body());
+      return;
+    }
+    case StmtKind::Do: {
+      auto *D = static_cast<DoStmt *>(S);
+      derived().rewrite_func_scope(D->get_body());
+      D->set_cond(derived().rewrite_expr(D->get_cond()));
+      return;
+    }
+    case StmtKind::Block:
+      derived().rewrite_func_scope(static_cast<BlockStmt *>(S)->get_scope());
+      return;
+    case StmtKind::Expr: {
+      auto *E = static_cast<ExprStmt *>(S);
+      E->set_expr(derived().rewrite_expr(E->get_expr()));
+      return;
+    }
+    case StmtKind::Return: {
+      auto *R = static_cast<ReturnStmt *>(S);
+      R->set_expr(derived().rewrite_expr(R->get_expr()));
+      return;
+    }
+    case StmtKind::Label:
+      derived().rewrite_stmt(static_cast<LabelStmt *>(S)->get_stmt());
+      return;
+    case StmtKind::Case: {
+      auto *C = static_cast<CaseStmt *>(S);
+      C->set_val(derived().rewrite_expr(C->get_val()));
+      derived().rewrite_func_scope(C->get_body());
+      return;
+    }
+    case StmtKind::Switch: {
+      auto *Sw = static_cast<SwitchStmt *>(S);
+      Sw->set_cond(derived().rewrite_expr(Sw->get_cond()));
+      for (auto &C : Sw->cases()) {
+        derived().rewrite_stmt(&C);
+      }
+      return;
+    }
+    }
+  }
+
+  /// @brief Returns the rewritten E. nullptr for nullptr.
+  Expr *rewrite_expr(Expr *E) {
+    if (!E) {
+      return nullptr;
+    }
+    if (auto It = Rewritten.find(E); It != Rewritten.end()) {
+      return It->second;
+    }
+    switch (E->get_kind()) {
+    case ExprKind::Raw:
+    case ExprKind::Variable:
+      break;
+    case ExprKind::Subscript: {
+      auto *S = static_cast<SubscriptExpr *>(E);
+      S->set_array(derived().rewrite_expr(S->get_array()));
+      S->set_index(derived().rewrite_expr(S->get_index()));
+      break;
+    }
+    case ExprKind::Call: {
+      auto *C = static_cast<CallExpr *>(E);
+      C->set_callee(derived().rewrite_expr(C->get_callee()));
+      for (auto &A : C->args()) {
+        rewrite_child(C, A);
+      }
+      break;
+    }
+    case ExprKind::UnaryOp: {
+      auto *U = static_cast<UnaryOp *>(E);
+      U->set_operand(derived().rewrite_expr(U->get_operand()));
+      break;
+    }
+    case ExprKind::BinaryOp: {
+      auto *B = static_cast<BinaryOp *>(E);
+      B->set_lhs(derived().rewrite_expr(B->get_lhs()));
+      B->set_rhs(derived().rewrite_expr(B->get_rhs()));
+      break;
+    }
+    case ExprKind::TernaryOp: {
+      auto *T = static_cast<TernaryOp *>(E);
+      T->set_cond(derived().rewrite_expr(T->get_cond()));
+      T->set_then(derived().rewrite_expr(T->get_then()));
+      T->set_else(derived().rewrite_expr(T->get_else()));
+      break;
+    }
+    case ExprKind::Cast: {
+      auto *C = static_cast<CastExpr *>(E);
+      C->set_operand(derived().rewrite_expr(C->get_operand()));
+      break;
+    }
+    case ExprKind::Paren: {
+      auto *P = static_cast<ParenExpr *>(E);
+      P->set_inside(derived().rewrite_expr(P->get_inside()));
+      break;
+    }
+    case ExprKind::DesignatedInit:
+      for (auto &[Name, Value] :
+           static_cast<DesignatedInitExpr *>(E)->designators()) {
+        rewrite_child(E, Value);
+      }
+      break;
+    case ExprKind::InitList:
+      for (auto &Value : static_cast<InitListExpr *>(E)->values()) {
+        rewrite_child(E, Value);
+      }
+      break;
+    case ExprKind::GenericSelection: {
+      auto *G = static_cast<GenericSelection *>(E);
+      G->set_control(derived().rewrite_expr(G->get_control()));
+      for (auto &[T, Value] : G->assocs()) {
+        rewrite_child(G, Value);
+      }
+      break;
+    }
+    }
+    auto *Result = derived().transform_expr(E);
+    Rewritten[E] = Result;
+    return Result;
+  }
+
+private:
+  // Rewrite Child of Parent, stored through a range, not by a setter.
+  void rewrite_child(Emit *Parent, Expr *&Child) {
+    if (auto *New = derived().rewrite_expr(Child); New != Child) {
+      Child = New;
+      Parent->note_modified();
+    }
+  }
+
+  void rewrite_members(MembersType *M) {
+    for (auto &V : M->members()) {
+      derived().rewrite_decl(&V);
+    }
+  }
+};
+
+} // namespace namec
+
+#endif // NAMEC_GEN_VISITOR_H
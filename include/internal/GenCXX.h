@@ -7,9 +7,15 @@
 #include "internal/GenCXX/CXXExprs.h"
 #include "internal/GenCXX/CXXFile.h"
 #include "internal/GenCXX/CXXForwards.h"
+#include "internal/GenCXX/CXXFunctionFolding.h"
+#include "internal/GenCXX/CXXIncludes.h"
+#include "internal/GenCXX/CXXRefIndex.h"
 #include "internal/GenCXX/CXXScope.h"
+#include "internal/GenCXX/CXXSharding.h"
 #include "internal/GenCXX/CXXStmts.h"
+#include "internal/GenCXX/CXXStructuralHash.h"
 #include "internal/GenCXX/CXXTypes.h"
+#include "internal/GenCXX/CXXVisitor.h"
 
 namespace namecxx {
 // standard way to cast a pointer
@@ -2,18 +2,32 @@
 #define NAMEC_GENCXX_COMMON_H
 
 #include "internal/GenCXX/CXXForwards.h"
+#include "internal/Util/ChunkStream.h"
 
 namespace namecxx {
 
+/// @brief Kind of the entries of the scopes, to dispatch on them without
+/// dynamic_cast. Other for the rest of the nodes.
+enum class EmitKind : uint8_t {
+  Other,
+  Stmt,
+  Directive,
+  Decl,
+};
+
 class Emit {
   std::string CommentBefore;
   std::string CommentAfter;
+  EmitKind Kind = EmitKind::Other;
 
 protected:
+  Emit() = default;
+  Emit(EmitKind Kind) : Kind(Kind) {}
   virtual void emit_impl(std::ostream &SS) = 0;
 
 public:
   virtual ~Emit() {}
+  EmitKind get_emit_kind() { return Kind; }
   void set_comment_before(std::string CommentBefore) {
     this->CommentBefore = CommentBefore;
   }
@@ -38,6 +52,14 @@ public:
     emit(SS);
     return SS.str();
   }
+
+  /// @brief Pull the emitted code in chunks of at most ChunkSize bytes,
+  /// keeping at most NumBuffers chunks in memory. This must not be modified
+  /// until the returned stream is exhausted or destroyed.
+  ChunkStream emit_chunks(size_t ChunkSize = 4096, size_t NumBuffers = 4) {
+    return ChunkStream([this](std::ostream &SS) { emit(SS); }, ChunkSize,
+                       NumBuffers);
+  }
 };
 
 class AttrEmit : public Emit {
@@ -9,11 +9,52 @@
 #include "internal/GenCXX/CXXForwards.h"
 
 namespace namecxx {
+/// @brief Kind of Decl, to dispatch on the node class without dynamic_cast.
+/// The kinds of a class and the classes derived from it are contiguous.
+enum class DeclKind {
+  Raw,
+  Var,
+  ArrayVar,
+  VarInitialize,
+  Typedef,
+  Using,
+  Func,
+  FuncSplit,
+  Method,
+  MethodSplit,
+  Ctor,
+  CtorSplit,
+  FuncSplitForward,
+  MethodSplitForward,
+  CtorSplitForward,
+  Class,
+  Union,
+  Enum,
+  Template,
+};
+
 class Decl : public Emit {
+  DeclKind Kind;
   std::vector<Attribute *> Attrs;
 
+protected:
+  Decl(DeclKind Kind) : Emit(EmitKind::Decl), Kind(Kind) {}
+
 public:
   virtual ~Decl() = default;
+  DeclKind get_kind() { return Kind; }
+  /// @brief VarDecl or derived from it.
+  bool is_var() {
+    return DeclKind::Var <= Kind && Kind <= DeclKind::VarInitialize;
+  }
+  /// @brief FuncDecl or derived from it.
+  bool is_func() {
+    return DeclKind::Func <= Kind && Kind <= DeclKind::CtorSplit;
+  }
+  /// @brief CtorDecl or derived from it.
+  bool is_ctor() {
+    return Kind == DeclKind::Ctor || Kind == DeclKind::CtorSplit;
+  }
   virtual void emit_impl(std::ostream &SS) = 0;
   virtual QualName get_name() = 0;
   std::string get_name_str() { return get_name().to_string(); }
@@ -24,7 +65,7 @@ class RawDecl : public Decl {
   std::string Val;
 
 public:
-  RawDecl(std::string Val) : Val(Val) {}
+  RawDecl(std::string Val) : Decl(DeclKind::Raw), Val(Val) {}
   std::string get_val() { return Val; }
   QualName get_name() override { return Val; }
 
@@ -44,12 +85,18 @@ class VarDecl : public Decl {
   bool IsRestrict = false;
   bool IsInline = false;
 
+protected:
+  VarDecl(DeclKind Kind, QualName Name, Type *Ty, Expr *Init)
+      : Decl(Kind), Ty(Ty), Name(Name), Init(Init) {}
+
 public:
-  VarDecl(QualName Name, Type *Ty) : Ty(Ty), Name(Name) {}
+  VarDecl(QualName Name, Type *Ty)
+      : VarDecl(DeclKind::Var, Name, Ty, nullptr) {}
   VarDecl(QualName Name, Type *Ty, Expr *Init)
-      : Ty(Ty), Name(Name), Init(Init) {}
+      : VarDecl(DeclKind::Var, Name, Ty, Init) {}
   Type *get_type() { return Ty; }
   Expr *get_init() { return Init; }
+  void set_init(Expr *E) { Init = E; }
   void set_const(bool IsConst) { this->IsConst = IsConst; }
   bool is_const() { return IsConst; }
   void set_extern(bool IsExtern) { this->IsExtern = IsExtern; }
@@ -62,6 +109,9 @@ public:
   bool is_restrict() { return IsRestrict; }
   bool is_inline() { return IsInline; }
   QualName get_name() override { return Name; }
+  /// @brief Emit the extern declaration of this variable, without the
+  /// initializer.
+  virtual void emit_extern(std::ostream &SS);
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -73,13 +123,14 @@ class ArrayVarDecl : public VarDecl {
 public:
   using size_iterator = decltype(Size)::iterator;
   ArrayVarDecl(QualName Name, Type *Ty, std::vector<Expr *> Size)
-      : VarDecl(Name, Ty), Size(Size) {}
+      : VarDecl(DeclKind::ArrayVar, Name, Ty, nullptr), Size(Size) {}
   ArrayVarDecl(QualName Name, Type *Ty, std::vector<Expr *> Size, Expr *Init)
-      : VarDecl(Name, Ty, Init), Size(Size) {}
+      : VarDecl(DeclKind::ArrayVar, Name, Ty, Init), Size(Size) {}
   std::vector<Expr *> get_size() { return Size; }
   IteratorRange<size_iterator> sizes() {
     return IteratorRange<size_iterator>(Size.begin(), Size.end());
   }
+  void emit_extern(std::ostream &SS) override;
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -93,7 +144,8 @@ public:
   using arg_iterator = decltype(Args)::iterator;
   VarInitializeDecl(QualName Name, Type *Ty, std::vector<Expr *> Args,
                     bool IsListInit)
-      : VarDecl(Name, Ty), Args(Args), IsListInit(IsListInit) {}
+      : VarDecl(DeclKind::VarInitialize, Name, Ty, nullptr), Args(Args),
+        IsListInit(IsListInit) {}
   IteratorRange<arg_iterator> args() {
     return IteratorRange<arg_iterator>(Args.begin(), Args.end());
   }
@@ -107,7 +159,7 @@ class TypedefDecl : public Decl {
   TypeAlias *TA;
 
 public:
-  TypedefDecl(TypeAlias *TA) : TA(TA) {}
+  TypedefDecl(TypeAlias *TA) : Decl(DeclKind::Typedef), TA(TA) {}
   TypeAlias *get_type_alias() { return TA; }
   QualName get_name() override;
 
@@ -120,7 +172,7 @@ class UsingDecl : public Decl {
   TypeAlias *TA;
 
 public:
-  UsingDecl(TypeAlias *TA) : TA(TA) {}
+  UsingDecl(TypeAlias *TA) : Decl(DeclKind::Using), TA(TA) {}
   TypeAlias *get_type_alias() { return TA; }
   QualName get_name() override;
 
@@ -147,17 +199,26 @@ protected:
   bool IsConstExpr = false;
   bool IsInline = false;
 
+  FuncDecl(DeclKind Kind, Context &C, QualName Name, Type *RetTy,
+           std::vector<VarDecl *> Params, bool IsVarArg)
+      : Decl(Kind), C(C), RetTy(RetTy), Name(Name), Params(Params),
+        IsVarArg(IsVarArg) {}
+
 public:
   using param_iterator = decltype(Params)::iterator;
   FuncDecl(Context &C, QualName Name, Type *RetTy,
            std::vector<VarDecl *> Params, bool IsVarArg)
-      : C(C), RetTy(RetTy), Name(Name), Params(Params), IsVarArg(IsVarArg) {}
+      : FuncDecl(DeclKind::Func, C, Name, RetTy, Params, IsVarArg) {}
   Type *get_ret_type() { return RetTy; }
   IteratorRange<param_iterator> params() {
     return IteratorRange<param_iterator>(Params.begin(), Params.end());
   }
   std::vector<VarDecl *> get_params() { return Params; }
   FuncScope *get_or_add_body();
+  /// @brief Discard the body and start a new empty one.
+  FuncScope *replace_body();
+  /// @brief nullptr for declaration.
+  FuncScope *get_body() { return Body; }
   void set_extern(bool IsExtern) { this->IsExtern = IsExtern; }
   bool is_extern() { return IsExtern; }
   void set_static(bool IsStatic) { this->IsStatic = IsStatic; }
@@ -170,6 +231,8 @@ public:
   bool is_vararg() { return IsVarArg; }
   QualName get_name() override { return Name; }
   virtual bool is_split_definition() { return false; }
+  /// @brief Emit the prototype of this function.
+  void emit_forward(std::ostream &SS) { emit_impl_impl(SS, true, false); }
 
 protected:
   virtual void emit_impl_impl(std::ostream &SS, bool IsForward,
@@ -182,11 +245,10 @@ class FuncSplitDecl : public FuncDecl {
 public:
   FuncSplitDecl(Context &C, QualName Name, Type *RetTy,
                 std::vector<VarDecl *> Params, bool IsVarArg)
-      : FuncDecl(C, Name, RetTy, Params, IsVarArg) {
+      : FuncDecl(DeclKind::FuncSplit, C, Name, RetTy, Params, IsVarArg) {
     get_or_add_body();
   }
   bool is_split_definition() override { return true; }
-  FuncScope *get_body() { return get_or_add_body(); }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -198,7 +260,8 @@ protected:
   FuncSplitDecl *FD;
 
 public:
-  FuncSplitForwardDecl(FuncSplitDecl *FD) : FD(FD) {}
+  FuncSplitForwardDecl(FuncSplitDecl *FD)
+      : Decl(DeclKind::FuncSplitForward), FD(FD) {}
   FuncDecl *get_func_decl() { return FD; }
   QualName get_name() override { return FD->get_name(); }
 
@@ -211,7 +274,8 @@ class ClassDecl : public Decl {
   bool IsForward;
 
 public:
-  ClassDecl(Class *C, bool IsForward) : C(C), IsForward(IsForward) {}
+  ClassDecl(Class *C, bool IsForward)
+      : Decl(DeclKind::Class), C(C), IsForward(IsForward) {}
   Class *get_class() { return C; }
   bool is_forward() { return IsForward; }
   QualName get_name() override;
@@ -225,7 +289,8 @@ class UnionDecl : public Decl {
   bool IsForward = false;
 
 public:
-  UnionDecl(Union *U, bool IsForward) : U(U), IsForward(IsForward) {}
+  UnionDecl(Union *U, bool IsForward)
+      : Decl(DeclKind::Union), U(U), IsForward(IsForward) {}
   Union *get_union() { return U; }
   bool is_forward() { return IsForward; }
   QualName get_name() override;
@@ -247,10 +312,14 @@ protected:
   bool IsConst = false;
   bool IsFinal = false;
 
+  MethodDecl(DeclKind Kind, Context &C, QualName Name, Type *RetTy,
+             std::vector<VarDecl *> Params, bool IsVarArg)
+      : FuncDecl(Kind, C, Name, RetTy, Params, IsVarArg) {}
+
 public:
   MethodDecl(Context &C, QualName Name, Type *RetTy,
              std::vector<VarDecl *> Params, bool IsVarArg)
-      : FuncDecl(C, Name, RetTy, Params, IsVarArg) {}
+      : MethodDecl(DeclKind::Method, C, Name, RetTy, Params, IsVarArg) {}
   void set_override(bool IsOverride = true) { this->IsOverride = IsOverride; }
   bool is_override() { return IsOverride; }
   void set_virtual(bool IsVirtual = true) { this->IsVirtual = IsVirtual; }
@@ -282,7 +351,6 @@ public:
   MethodSplitDecl(Context &C, ClassOrUnion *Parent, QualName Name, Type *RetTy,
                   std::vector<VarDecl *> Params, bool IsVarArg);
   ClassOrUnion *get_parent() { return Parent; }
-  FuncScope *get_body() { return get_or_add_body(); }
 
 protected:
   bool is_split_definition() override { return true; }
@@ -293,7 +361,8 @@ class MethodSplitForwardDecl : public Decl {
   MethodSplitDecl *MD;
 
 public:
-  MethodSplitForwardDecl(MethodSplitDecl *MD) : MD(MD) {}
+  MethodSplitForwardDecl(MethodSplitDecl *MD)
+      : Decl(DeclKind::MethodSplitForward), MD(MD) {}
   MethodDecl *get_method_decl() { return MD; }
   QualName get_name() override { return MD->get_name(); }
 
@@ -306,6 +375,11 @@ class CtorDecl : public MethodDecl {
   friend class CtorSplitForwardDecl;
   std::vector<std::pair<QualName, Expr *>> Inits;
 
+protected:
+  CtorDecl(DeclKind Kind, Context &C, QualName Name,
+           std::vector<VarDecl *> Params, bool IsVarArg)
+      : MethodDecl(Kind, C, Name, nullptr, Params, IsVarArg) {}
+
 public:
   using init_iterator = decltype(Inits)::iterator;
   CtorDecl(Context &C, QualName Name, std::vector<VarDecl *> Params,
@@ -337,7 +411,8 @@ class CtorSplitForwardDecl : public Decl {
   CtorSplitDecl *CD;
 
 public:
-  CtorSplitForwardDecl(CtorSplitDecl *CD) : CD(CD) {}
+  CtorSplitForwardDecl(CtorSplitDecl *CD)
+      : Decl(DeclKind::CtorSplitForward), CD(CD) {}
   CtorDecl *get_ctor_decl() { return CD; }
   QualName get_name() override { return CD->get_name(); }
 
@@ -350,7 +425,8 @@ class EnumDecl : public Decl {
   bool IsForward = false;
 
 public:
-  EnumDecl(Enum *E, bool IsForward) : E(E), IsForward(IsForward) {}
+  EnumDecl(Enum *E, bool IsForward)
+      : Decl(DeclKind::Enum), E(E), IsForward(IsForward) {}
   Enum *get_enum() { return E; }
   bool is_forward() { return IsForward; }
   QualName get_name() override;
@@ -367,7 +443,8 @@ class TemplateDecl : public Decl {
 public:
   using iterator = decltype(Params)::iterator;
   TemplateDecl(Context &C, Decl *D, std::vector<VarDecl *> Params)
-      : C(C), D(D), Params(Params) {}
+      : Decl(DeclKind::Template), C(C), D(D), Params(Params) {}
+  Decl *get_decl() { return D; }
   IteratorRange<iterator> params() {
     return IteratorRange<iterator>(Params.begin(), Params.end());
   }
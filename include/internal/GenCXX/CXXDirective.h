@@ -10,10 +10,37 @@ static_assert(false, "Cyclic include detected of " __FILE__);
 
 namespace namecxx {
 
+/// @brief Kind of Directive, to dispatch on the node class without
+/// dynamic_cast.
+enum class DirectiveKind {
+  Include,
+  Raw,
+  SystemInclude,
+  Define,
+  DefineFuncMacro,
+  Undef,
+  Pragma,
+  If,
+  Ifdef,
+  Ifndef,
+  Namespace,
+  Using,
+};
+
 class Directive : public Emit {
+  DirectiveKind Kind;
+
+protected:
+  Directive(DirectiveKind Kind) : Emit(EmitKind::Directive), Kind(Kind) {}
 
 public:
   virtual ~Directive() {}
+  DirectiveKind get_kind() { return Kind; }
+  /// @brief #if, #ifdef or #ifndef, which is IfDirectiveBase.
+  bool is_if() {
+    return Kind == DirectiveKind::If || Kind == DirectiveKind::Ifdef ||
+           Kind == DirectiveKind::Ifndef;
+  }
   virtual void emit_impl(std::ostream &SS) = 0;
 };
 
@@ -21,7 +48,8 @@ class Include : public Directive {
   std::string Path;
 
 public:
-  Include(std::string Path) : Path(Path) {}
+  Include(std::string Path)
+      : Directive(DirectiveKind::Include), Path(Path) {}
   std::string get_path() { return Path; }
 
 protected:
@@ -32,7 +60,7 @@ class RawDirective : public Directive {
   std::string Val;
 
 public:
-  RawDirective(std::string Val) : Val(Val) {}
+  RawDirective(std::string Val) : Directive(DirectiveKind::Raw), Val(Val) {}
   std::string get_val() { return Val; }
 
 protected:
@@ -43,7 +71,8 @@ class SystemInclude : public Directive {
   std::string Path;
 
 public:
-  SystemInclude(std::string Path) : Path(Path) {}
+  SystemInclude(std::string Path)
+      : Directive(DirectiveKind::SystemInclude), Path(Path) {}
   std::string get_path() { return Path; }
 
 protected:
@@ -57,7 +86,8 @@ class Define : public Directive {
   std::string Value;
 
 public:
-  Define(std::string Name, std::string Value) : Name(Name), Value(Value) {}
+  Define(std::string Name, std::string Value)
+      : Directive(DirectiveKind::Define), Name(Name), Value(Value) {}
   std::string get_name() { return Name; }
   std::string get_value() { return Value; }
 
@@ -91,7 +121,7 @@ class Undef : public Directive {
   std::string Name;
 
 public:
-  Undef(std::string Name) : Name(Name) {}
+  Undef(std::string Name) : Directive(DirectiveKind::Undef), Name(Name) {}
   std::string get_name() { return Name; }
 
 protected:
@@ -103,7 +133,8 @@ class Pragma : public Directive {
   std::string Value;
 
 public:
-  Pragma(std::string Value) : Value(Value) {}
+  Pragma(std::string Value)
+      : Directive(DirectiveKind::Pragma), Value(Value) {}
   std::string get_value() { return Value; }
 
 protected:
@@ -121,10 +152,17 @@ protected:
   // TODO: elif
 
 public:
-  IfDirectiveBase(Context &C) : C(C), Then(C.add_top_level()) {}
+  using elif_iterator = decltype(Elifs)::iterator;
+  IfDirectiveBase(Context &C, DirectiveKind Kind)
+      : Directive(Kind), C(C), Then(C.add_top_level()) {}
   TopLevel *get_then() { return Then; }
   TopLevel *add_elif(Expr *Cond);
+  IteratorRange<elif_iterator> elifs() {
+    return IteratorRange<elif_iterator>(Elifs.begin(), Elifs.end());
+  }
   bool has_else() { return Else != nullptr; }
+  /// @brief nullptr if no else.
+  TopLevel *get_else() { return Else; }
   TopLevel *get_or_add_else();
 
 protected:
@@ -140,6 +178,7 @@ public:
   IfDirective(Context &C, Expr *Cond);
   virtual ~IfDirective() = default;
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) { Cond = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -149,7 +188,8 @@ class Ifdef : public IfDirectiveBase {
   std::string CondStr;
 
 public:
-  Ifdef(Context &C, std::string Cond) : IfDirectiveBase(C), CondStr(Cond) {}
+  Ifdef(Context &C, std::string Cond)
+      : IfDirectiveBase(C, DirectiveKind::Ifdef), CondStr(Cond) {}
   std::string get_cond() { return CondStr; }
 
 protected:
@@ -160,7 +200,8 @@ class Ifndef : public IfDirectiveBase {
   std::string CondStr;
 
 public:
-  Ifndef(Context &C, std::string Cond) : IfDirectiveBase(C), CondStr(Cond) {}
+  Ifndef(Context &C, std::string Cond)
+      : IfDirectiveBase(C, DirectiveKind::Ifndef), CondStr(Cond) {}
   std::string get_cond() { return CondStr; }
 
 protected:
@@ -173,7 +214,9 @@ class Namespace : public Directive {
   TopLevel *Body;
 
 public:
-  Namespace(Context &C, QualName Name) : Name(Name), Body(C.add_top_level()) {}
+  Namespace(Context &C, QualName Name)
+      : Directive(DirectiveKind::Namespace), Name(Name),
+        Body(C.add_top_level()) {}
   QualName get_name() { return Name; }
   std::string get_name_str() { return Name.to_string(); }
   TopLevel *get_body() { return Body; }
@@ -187,7 +230,8 @@ class UsingDirective : public Directive {
   QualName Name;
 
 public:
-  UsingDirective(QualName Name) : Name(Name) {}
+  UsingDirective(QualName Name)
+      : Directive(DirectiveKind::Using), Name(Name) {}
   QualName get_name() { return Name; }
   std::string get_name_str() { return Name.to_string(); }
 
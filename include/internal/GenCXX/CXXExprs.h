@@ -10,10 +10,35 @@ static_assert(false, "Cyclic include detected of " __FILE__);
 
 namespace namecxx {
 
+/// @brief Kind of Expr, to dispatch on the node class without virtual calls.
+enum class ExprKind {
+  Raw,
+  Variable,
+  Subscript,
+  Call,
+  UnaryOp,
+  BinaryOp,
+  TernaryOp,
+  Cast,
+  Paren,
+  InitList,
+  New,
+  Delete,
+  UserDefinedLiteral,
+  QualName,
+  Lambda,
+  Instantiate,
+  PackExpansion,
+  Fold,
+};
+
 class Expr : public TypeOrExpr {
+  ExprKind Kind;
 
 public:
+  Expr(ExprKind Kind) : Kind(Kind) {}
   virtual ~Expr() = default;
+  ExprKind get_kind() { return Kind; }
 
 protected:
   virtual void emit_impl(std::ostream &SS) = 0;
@@ -23,7 +48,7 @@ class RawExpr : public Expr {
   std::string Val;
 
 public:
-  RawExpr(std::string Val) : Val(Val) {}
+  RawExpr(std::string Val) : Expr(ExprKind::Raw), Val(Val) {}
   std::string get_val() { return Val; }
 
 protected:
@@ -34,7 +59,7 @@ class VariableExpr : public Expr {
   VarDecl *D;
 
 public:
-  VariableExpr(VarDecl *D) : D(D) {}
+  VariableExpr(VarDecl *D) : Expr(ExprKind::Variable), D(D) {}
   VarDecl *get_decl() { return D; }
 
 protected:
@@ -46,9 +71,12 @@ class SubscriptExpr : public Expr {
   Expr *Index;
 
 public:
-  SubscriptExpr(Expr *Array, Expr *Index) : Array(Array), Index(Index) {}
+  SubscriptExpr(Expr *Array, Expr *Index)
+      : Expr(ExprKind::Subscript), Array(Array), Index(Index) {}
   Expr *get_array() { return Array; }
   Expr *get_index() { return Index; }
+  void set_array(Expr *E) { Array = E; }
+  void set_index(Expr *E) { Index = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -61,8 +89,9 @@ class CallExpr : public Expr {
 public:
   using arg_iterator = decltype(Args)::iterator;
   CallExpr(Expr *Callee, std::vector<Expr *> Args)
-      : Callee(Callee), Args(Args) {}
+      : Expr(ExprKind::Call), Callee(Callee), Args(Args) {}
   Expr *get_callee() { return Callee; }
+  void set_callee(Expr *E) { Callee = E; }
   IteratorRange<arg_iterator> args() {
     return IteratorRange<arg_iterator>(Args.begin(), Args.end());
   }
@@ -78,8 +107,9 @@ class UnaryOp : public Expr {
 
 public:
   UnaryOp(std::string Op, Expr *Operand, bool IsPrefix)
-      : Operand(Operand), Op(Op), IsPrefix(IsPrefix) {}
+      : Expr(ExprKind::UnaryOp), Operand(Operand), Op(Op), IsPrefix(IsPrefix) {}
   Expr *get_operand() { return Operand; }
+  void set_operand(Expr *E) { Operand = E; }
   std::string get_op() { return Op; }
   bool is_prefix() { return IsPrefix; }
 
@@ -93,9 +123,12 @@ class BinaryOp : public Expr {
   std::string Op;
 
 public:
-  BinaryOp(std::string Op, Expr *LHS, Expr *RHS) : LHS(LHS), RHS(RHS), Op(Op) {}
+  BinaryOp(std::string Op, Expr *LHS, Expr *RHS)
+      : Expr(ExprKind::BinaryOp), LHS(LHS), RHS(RHS), Op(Op) {}
   Expr *get_lhs() { return LHS; }
   Expr *get_rhs() { return RHS; }
+  void set_lhs(Expr *E) { LHS = E; }
+  void set_rhs(Expr *E) { RHS = E; }
   std::string get_op() { return Op; }
 
 protected:
@@ -109,10 +142,13 @@ class TernaryOp : public Expr {
 
 public:
   TernaryOp(Expr *Cond, Expr *Then, Expr *Else)
-      : Cond(Cond), Then(Then), Else(Else) {}
+      : Expr(ExprKind::TernaryOp), Cond(Cond), Then(Then), Else(Else) {}
   Expr *get_cond() { return Cond; }
   Expr *get_then() { return Then; }
   Expr *get_else() { return Else; }
+  void set_cond(Expr *E) { Cond = E; }
+  void set_then(Expr *E) { Then = E; }
+  void set_else(Expr *E) { Else = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -123,9 +159,11 @@ class CastExpr : public Expr {
   Expr *Operand;
 
 public:
-  CastExpr(Type *Ty, Expr *Operand) : Ty(Ty), Operand(Operand) {}
+  CastExpr(Type *Ty, Expr *Operand)
+      : Expr(ExprKind::Cast), Ty(Ty), Operand(Operand) {}
   Type *get_type() { return Ty; }
   Expr *get_operand() { return Operand; }
+  void set_operand(Expr *E) { Operand = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -135,8 +173,9 @@ class ParenExpr : public Expr {
   Expr *Inside;
 
 public:
-  ParenExpr(Expr *Inside) : Inside(Inside) {}
+  ParenExpr(Expr *Inside) : Expr(ExprKind::Paren), Inside(Inside) {}
   Expr *get_inside() { return Inside; }
+  void set_inside(Expr *E) { Inside = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -147,7 +186,8 @@ class InitListExpr : public Expr {
 
 public:
   using iterator = decltype(Values)::iterator;
-  InitListExpr(std::vector<Expr *> Values) : Values(Values) {}
+  InitListExpr(std::vector<Expr *> Values)
+      : Expr(ExprKind::InitList), Values(Values) {}
   IteratorRange<iterator> values() {
     return IteratorRange<iterator>(Values.begin(), Values.end());
   }
@@ -166,11 +206,12 @@ class NewExpr : public Expr {
 public:
   using iterator = decltype(Args)::iterator;
   NewExpr(Type *Ty, std::vector<Expr *> Args, bool IsListInit)
-      : Ty(Ty), Args(Args), IsListInit(IsListInit) {}
+      : Expr(ExprKind::New), Ty(Ty), Args(Args), IsListInit(IsListInit) {}
   Type *get_type() { return Ty; }
   IteratorRange<iterator> args() {
     return IteratorRange<iterator>(Args.begin(), Args.end());
   }
+  bool is_list_init() { return IsListInit; }
   void set_array_size(Expr *ArraySize) { this->ArraySize = ArraySize; }
   Expr *get_array_size() { return ArraySize; }
   void set_placement(Expr *Placement) { this->Placement = Placement; }
@@ -185,8 +226,10 @@ class DeleteExpr : public Expr {
   bool IsArray;
 
 public:
-  DeleteExpr(Expr *E, bool IsArray) : E(E), IsArray(IsArray) {}
+  DeleteExpr(Expr *E, bool IsArray)
+      : Expr(ExprKind::Delete), E(E), IsArray(IsArray) {}
   Expr *get_expr() { return E; }
+  void set_expr(Expr *E) { this->E = E; }
   bool is_array() { return IsArray; }
 
 protected:
@@ -198,9 +241,11 @@ class UserDefinedLiteral : public Expr {
   std::string Postfix;
 
 public:
-  UserDefinedLiteral(Expr *E, std::string Postfix) : E(E), Postfix(Postfix) {}
+  UserDefinedLiteral(Expr *E, std::string Postfix)
+      : Expr(ExprKind::UserDefinedLiteral), E(E), Postfix(Postfix) {}
   std::string get_postfix() { return Postfix; }
   Expr *get_expr() { return E; }
+  void set_expr(Expr *E) { this->E = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -211,7 +256,7 @@ class QualNameExpr : public Expr {
 
 public:
   using iterator = QualName::iterator;
-  QualNameExpr(QualName QN) : QN(QN) {}
+  QualNameExpr(QualName QN) : Expr(ExprKind::QualName), QN(QN) {}
   QualName get_name() { return QN; }
   IteratorRange<iterator> names() { return QN.names(); }
 
@@ -241,6 +286,7 @@ public:
     return IteratorRange<param_iterator>(Params.begin(), Params.end());
   }
   size_t size() { return Params.size(); }
+  bool is_vararg() { return IsVarArgs; }
   FuncScope *get_body() { return Body; }
   IteratorRange<decltype(Attrs)::iterator> attrs() {
     return IteratorRange<decltype(Attrs)::iterator>(Attrs.begin(), Attrs.end());
@@ -258,7 +304,7 @@ class InstantiateExpr : public Expr {
 public:
   using iterator = decltype(Args)::iterator;
   InstantiateExpr(TemplateDecl *TD, std::vector<TypeOrExpr *> Args)
-      : TD(TD), Args(Args) {}
+      : Expr(ExprKind::Instantiate), TD(TD), Args(Args) {}
   TemplateDecl *get_template_decl() { return TD; }
   IteratorRange<iterator> args() {
     return IteratorRange<iterator>(Args.begin(), Args.end());
@@ -272,8 +318,9 @@ class PackExpansionExpr : public Expr {
   Expr *E;
 
 public:
-  PackExpansionExpr(Expr *E) : E(E) {}
+  PackExpansionExpr(Expr *E) : Expr(ExprKind::PackExpansion), E(E) {}
   Expr *get_expr() { return E; }
+  void set_expr(Expr *E) { this->E = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -288,10 +335,13 @@ class FoldExpr : public Expr {
 
 public:
   FoldExpr(std::string Op, Expr *Pack, Expr *Init, bool IsLeftFold)
-      : Op(Op), Pack(Pack), Init(Init), IsLeftFold(IsLeftFold) {}
+      : Expr(ExprKind::Fold), Op(Op), Pack(Pack), Init(Init),
+        IsLeftFold(IsLeftFold) {}
   std::string get_op() { return Op; }
   Expr *get_pack() { return Pack; }
   Expr *get_init() { return Init; }
+  void set_pack(Expr *E) { Pack = E; }
+  void set_init(Expr *E) { Init = E; }
   bool is_left_fold() { return IsLeftFold; }
 
 protected:
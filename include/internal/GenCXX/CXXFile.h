@@ -13,6 +13,7 @@ static_assert(false, "Cyclic include detected of " __FILE__);
 
 #include "internal/GenCXX/CXXCommon.h"
 #include "internal/GenCXX/CXXForwards.h"
+#include "internal/Util/FileUtil.h"
 
 namespace namecxx {
 
@@ -25,9 +26,17 @@ public:
   CXXFile(Context &C);
   virtual ~CXXFile() {}
   TopLevel *get_first_top_level() { return TopLevels[0]; }
+  using top_level_iterator = decltype(TopLevels)::iterator;
+  IteratorRange<top_level_iterator> top_levels() {
+    return IteratorRange<top_level_iterator>(TopLevels.begin(),
+                                             TopLevels.end());
+  }
   // Add a new top level. This is only for convenience of generation.
   TopLevel *add_top_level();
-  void emit_to_file(std::filesystem::path Path);
+  /// @brief Emit this file to Path. With IsSkipUnchanged, the file is left
+  /// untouched when it already has the same content, so its mtime is kept.
+  WriteResult emit_to_file(std::filesystem::path Path,
+                           bool IsSkipUnchanged = false);
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -0,0 +1,38 @@
+#ifdef NAMEC_GENCXX_FUNCTION_FOLDING_H_CYCLIC
+static_assert(false, "Cyclic include detected of " __FILE__);
+#endif
+#define NAMEC_GENCXX_FUNCTION_FOLDING_H_CYCLIC
+
+#ifndef NAMEC_GENCXX_FUNCTION_FOLDING_H
+#define NAMEC_GENCXX_FUNCTION_FOLDING_H
+
+#include <cstddef>
+
+#include "internal/GenCXX/CXXForwards.h"
+
+namespace namecxx {
+
+struct FoldStats {
+  size_t Functions = 0; // Function definitions examined.
+  size_t Folded = 0;    // Definitions replaced.
+};
+
+/**
+  @brief Fold the function definitions of F whose bodies are identical apart
+  from the name. The first definition is kept and the bodies of the later
+  ones are replaced by the calls forwarding to it. The linkage and the
+  inline-ness of the folded functions are kept, so that the other
+  translation units seeing only their prototypes still link.
+
+  Functions are compared within the same top-level, or namespace body, where
+  the names in the bodies are looked up identically. Methods, templates,
+  variadic functions, functions taking rvalue references or packs and
+  functions with static locals are not folded. The bodies are compared by
+  StructuralHasher.
+ */
+FoldStats fold_identical_functions(Context &C, CXXFile &F);
+
+} // namespace namecxx
+
+#endif // NAMEC_GENCXX_FUNCTION_FOLDING_H
+#undef NAMEC_GENCXX_FUNCTION_FOLDING_H_CYCLIC
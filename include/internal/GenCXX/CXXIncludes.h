@@ -0,0 +1,35 @@
+#ifdef NAMEC_GENCXX_INCLUDES_H_CYCLIC
+static_assert(false, "Cyclic include detected of " __FILE__);
+#endif
+#define NAMEC_GENCXX_INCLUDES_H_CYCLIC
+
+#ifndef NAMEC_GENCXX_INCLUDES_H
+#define NAMEC_GENCXX_INCLUDES_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "internal/GenCXX/CXXForwards.h"
+#include "internal/Util/PrecompiledHeader.h"
+
+namespace namecxx {
+
+/**
+  @brief Remove the repeated Include and SystemInclude directives of F, like
+  namec::dedup_includes(). The includes in namespace bodies are left as they
+  are, since they declare into the namespaces.
+ */
+size_t dedup_includes(CXXFile &F,
+                      const std::vector<std::string> &Repeatable = {});
+
+/// @brief Make the precompiled header Name.hpp, like
+/// namec::extract_common_includes().
+PrecompiledHeader extract_common_includes(const std::vector<CXXFile *> &Files,
+                                          size_t MinFiles,
+                                          const std::string &Name);
+
+} // namespace namecxx
+
+#endif // NAMEC_GENCXX_INCLUDES_H
+#undef NAMEC_GENCXX_INCLUDES_H_CYCLIC
@@ -0,0 +1,33 @@
+#ifdef NAMEC_GENCXX_REF_INDEX_H_CYCLIC
+static_assert(false, "Cyclic include detected of " __FILE__);
+#endif
+#define NAMEC_GENCXX_REF_INDEX_H_CYCLIC
+
+#ifndef NAMEC_GENCXX_REF_INDEX_H
+#define NAMEC_GENCXX_REF_INDEX_H
+
+#include "internal/GenCXX/CXXForwards.h"
+#include "internal/Util/RefIndex.h"
+
+namespace namecxx {
+
+using RefIndex = namec_util::RefIndexImpl<FuncDecl, VarDecl, Expr>;
+
+/**
+  @brief Build the call graph and the uses of the variables of F in one
+  traversal, like namec::build_ref_index().
+
+  The callee of a CallExpr is resolved from its name, a RawExpr or a
+  QualNameExpr such as ns::f, by looking it up in the namespaces and classes
+  enclosing the call from the innermost outwards, stopping at the first one
+  declaring it. The overloads are told apart only by the number of
+  arguments, with the default arguments and variadic parameters, so an
+  ambiguous call is unresolved. Member calls through objects, and the names
+  brought by using directives or argument-dependent lookup, are unresolved.
+ */
+RefIndex build_ref_index(CXXFile &F);
+
+} // namespace namecxx
+
+#endif // NAMEC_GENCXX_REF_INDEX_H
+#undef NAMEC_GENCXX_REF_INDEX_H_CYCLIC
@@ -34,6 +34,10 @@ public:
   TopLevel(Context &C)
       : C(C), DirectiveDefineMixin(C), UbiquitousDeclStmtMixin(C),
         ClassMemberDeclMixin(C) {}
+  using entry_iterator = decltype(Entries)::iterator;
+  IteratorRange<entry_iterator> entries() {
+    return IteratorRange<entry_iterator>(Entries.begin(), Entries.end());
+  }
   // Only in top level we can define/declare functions
   FuncDecl *def_func(QualName Name, Type *RetTy, std::vector<VarDecl *> Params,
                      bool IsVarArg = false);
@@ -48,6 +52,9 @@ public:
                                       bool IsVarArg = false);
   TopLevel *def_namespace(QualName Name);
   UsingNamespaceStmt *stmt_using_namespace(QualName Name);
+  /// @brief Remove the entries satisfying Pred. Returns the number of removed
+  /// entries.
+  size_t remove_if(const std::function<bool(Emit *)> &Pred);
 
   // TopLevel Member definition API
   void def_method_define(MethodSplitDecl *Decl);
@@ -82,6 +89,10 @@ public:
   FuncScope(Context &C)
       : C(C), DirectiveDefineMixin(C), UbiquitousDeclStmtMixin(C),
         InFunctionStmtMixin(C) {}
+  using entry_iterator = decltype(Entries)::iterator;
+  IteratorRange<entry_iterator> entries() {
+    return IteratorRange<entry_iterator>(Entries.begin(), Entries.end());
+  }
   UsingNamespaceStmt *stmt_using_namespace(QualName Name);
   virtual ~FuncScope() {}
 
@@ -107,6 +118,10 @@ public:
   MacroFuncScope(Context &C)
       : C(C), UbiquitousDeclStmtMixin(C), InFunctionStmtMixin(C) {}
   virtual ~MacroFuncScope() {}
+  using entry_iterator = decltype(Entries)::iterator;
+  IteratorRange<entry_iterator> entries() {
+    return IteratorRange<entry_iterator>(Entries.begin(), Entries.end());
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -137,6 +152,10 @@ public:
       : C(C), Cls(Cls), DirectiveDefineMixin(C), UbiquitousDeclStmtMixin(C),
         ClassMemberDeclMixin(C) {}
   virtual ~ClassTopLevel() {}
+  using entry_iterator = decltype(Entries)::iterator;
+  IteratorRange<entry_iterator> entries() {
+    return IteratorRange<entry_iterator>(Entries.begin(), Entries.end());
+  }
 
   MethodSplitDecl *def_method_declare(QualName Name, Type *RetTy,
                                       std::vector<VarDecl *> Params,
@@ -154,4 +173,4 @@ protected:
 } // namespace namecxx
 
 #endif // NAMEC_GENCXX_SCOPE_H
-#undef NAMEC_GEN_SCOPE_H_CYCLIC
+#undef NAMEC_GENCXX_SCOPE_H_CYCLIC
@@ -0,0 +1,46 @@
+#ifdef NAMEC_GENCXX_SHARDING_H_CYCLIC
+static_assert(false, "Cyclic include detected of " __FILE__);
+#endif
+#define NAMEC_GENCXX_SHARDING_H_CYCLIC
+
+#ifndef NAMEC_GENCXX_SHARDING_H
+#define NAMEC_GENCXX_SHARDING_H
+
+#include <cstddef>
+#include <string>
+
+#include "internal/GenCXX/CXXForwards.h"
+#include "internal/Util/Sharding.h"
+
+namespace namecxx {
+
+/**
+  @brief Split the top-level definitions of F into the header Stem.hpp and
+  NumShards sources Stem_<I>.cpp, so that they can be compiled in parallel.
+  The same as namec::shard_file(), with the C++ entries.
+
+  The namespaces are reopened in each file around the entries in them.
+  Classes, templates, inline and constexpr functions and const variables go
+  to the header. Out-of-line definitions of methods, constructors, static
+  members and qualified functions go to the sources without a declaration in
+  the header, since they are declared in their classes or namespaces.
+  Functions and variables in anonymous namespaces are kept with their users
+  like the static ones.
+ */
+ShardedFile shard_file(CXXFile &F, size_t NumShards, const std::string &Stem);
+
+/**
+  @brief Split F into the header Stem.hpp and the source Stem.cpp, like
+  namec::split_file().
+
+  A class has the declarations of its MethodSplitDecl and CtorSplitDecl in
+  the header, and their out-of-line definitions by def_method_define() and
+  def_ctor_define() go to the source. The ones of class templates stay in the
+  header, since they are instantiated by the users.
+ */
+ShardedFile split_file(CXXFile &F, const std::string &Stem);
+
+} // namespace namecxx
+
+#endif // NAMEC_GENCXX_SHARDING_H
+#undef NAMEC_GENCXX_SHARDING_H_CYCLIC
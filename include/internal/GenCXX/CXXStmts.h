@@ -8,15 +8,50 @@ static_assert(false, "Cyclic include detected of " __FILE__);
 #include "internal/GenCXX/CXXForwards.h"
 
 namespace namecxx {
+/// @brief Kind of Stmt, to dispatch on the node class without virtual calls.
+enum class StmtKind {
+  Raw,
+  Decl,
+  If,
+  While,
+  For,
+  ForRange,
+  Do,
+  Block,
+  Expr,
+  Return,
+  Break,
+  Continue,
+  Label,
+  Goto,
+  Case,
+  Switch,
+  Throw,
+  Try,
+  UsingNamespace,
+};
+
+/// @brief Likelihood of a branch taken, emitted as [[likely]] or
+/// [[unlikely]] on the branch so that the compiler lays out the likely path as
+/// the fall-through.
+enum class Likelihood {
+  None,
+  Likely,
+  Unlikely,
+};
+
 class Stmt : public Emit {
+  StmtKind Kind;
+
 protected:
   Context &C;
   std::vector<Attribute *> Attrs;
   virtual void emit_impl(std::ostream &SS) = 0;
 
 public:
-  Stmt(Context &C) : C(C) {}
+  Stmt(Context &C, StmtKind Kind) : Emit(EmitKind::Stmt), Kind(Kind), C(C) {}
   virtual ~Stmt() = default;
+  StmtKind get_kind() { return Kind; }
   void add_attr(Attribute *Attr) { Attrs.push_back(Attr); }
 };
 
@@ -24,7 +59,7 @@ class RawStmt : public Stmt {
   std::string Val;
 
 public:
-  RawStmt(Context &C, std::string Val) : Stmt(C), Val(Val) {}
+  RawStmt(Context &C, std::string Val) : Stmt(C, StmtKind::Raw), Val(Val) {}
   std::string get_val() { return Val; }
 
 protected:
@@ -35,7 +70,7 @@ class DeclStmt : public Stmt {
   Decl *D;
 
 public:
-  DeclStmt(Context &C, Decl *D) : Stmt(C), D(D) {}
+  DeclStmt(Context &C, Decl *D) : Stmt(C, StmtKind::Decl), D(D) {}
   Decl *get_decl() { return D; }
 
 protected:
@@ -49,18 +84,28 @@ class IfStmt : public Stmt {
   std::vector<std::tuple<Expr *, FuncScope *, VarDecl *>> Elseifs;
   FuncScope *Else = nullptr;
   bool IsConstExpr;
+  Likelihood Hint = Likelihood::None;
+  // The likelihood of each of Elseifs.
+  std::vector<Likelihood> ElseifHints;
 
 public:
   IfStmt(Context &C, Expr *Cond, VarDecl *Init = nullptr,
          bool IsConstExpr = false)
-      : Stmt(C), Cond(Cond), Then(C.add_func_scope()), Init(Init),
+      : Stmt(C, StmtKind::If), Cond(Cond), Then(C.add_func_scope()), Init(Init),
         IsConstExpr(IsConstExpr) {}
+  using elseif_iterator = decltype(Elseifs)::iterator;
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) { Cond = E; }
   VarDecl *get_init() { return Init; }
   FuncScope *get_then() { return Then; }
-  FuncScope *add_elseif(Expr *Cond, VarDecl *Init = nullptr) {
+  IteratorRange<elseif_iterator> elseifs() {
+    return IteratorRange<elseif_iterator>(Elseifs.begin(), Elseifs.end());
+  }
+  FuncScope *add_elseif(Expr *Cond, VarDecl *Init = nullptr,
+                        Likelihood Hint = Likelihood::None) {
     auto S = C.add_func_scope();
     Elseifs.push_back({Cond, S, Init});
+    ElseifHints.push_back(Hint);
     return S;
   }
   FuncScope *get_or_add_else() {
@@ -70,7 +115,17 @@ public:
     return Else;
   }
   bool has_else() { return Else != nullptr; }
+  /// @brief nullptr if no else.
+  FuncScope *get_else() { return Else; }
   bool is_constexpr() { return IsConstExpr; }
+  /// @brief The likelihood of the then branch.
+  Likelihood get_likelihood() { return Hint; }
+  void set_likelihood(Likelihood Hint) { this->Hint = Hint; }
+  /// @brief The likelihood of the I-th else if branch.
+  Likelihood get_elseif_likelihood(size_t I) { return ElseifHints[I]; }
+  void set_elseif_likelihood(size_t I, Likelihood Hint) {
+    ElseifHints[I] = Hint;
+  }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -79,12 +134,17 @@ protected:
 class WhileStmt : public Stmt {
   Expr *Cond;
   FuncScope *Body;
+  Likelihood Hint = Likelihood::None;
 
 public:
   WhileStmt(Context &C, Expr *Cond)
-      : Stmt(C), Cond(Cond), Body(C.add_func_scope()) {}
+      : Stmt(C, StmtKind::While), Cond(Cond), Body(C.add_func_scope()) {}
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) { Cond = E; }
   FuncScope *get_body() { return Body; }
+  /// @brief The likelihood of the loop continuing.
+  Likelihood get_likelihood() { return Hint; }
+  void set_likelihood(Likelihood Hint) { this->Hint = Hint; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -95,16 +155,23 @@ class ForStmt : public Stmt {
   Expr *Cond;
   Expr *Step;
   FuncScope *Body;
+  Likelihood Hint = Likelihood::None;
 
 public:
   ForStmt(Context &C, std::unique_ptr<Stmt> Init, Expr *Cond, Expr *Step)
-      : Stmt(C), Cond(Cond), Step(Step), Body(C.add_func_scope()) {
+      : Stmt(C, StmtKind::For), Cond(Cond), Step(Step),
+        Body(C.add_func_scope()) {
     this->Init = std::move(Init);
   }
   Stmt *get_init() { return Init.get(); }
   Expr *get_cond() { return Cond; }
   Expr *get_step() { return Step; }
+  void set_cond(Expr *E) { Cond = E; }
+  void set_step(Expr *E) { Step = E; }
   FuncScope *get_body() { return Body; }
+  /// @brief The likelihood of the loop continuing.
+  Likelihood get_likelihood() { return Hint; }
+  void set_likelihood(Likelihood Hint) { this->Hint = Hint; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -117,9 +184,11 @@ class ForRangeStmt : public Stmt {
 
 public:
   ForRangeStmt(Context &C, Decl *D, Expr *Range)
-      : Stmt(C), D(D), Range(Range), Body(C.add_func_scope()) {}
+      : Stmt(C, StmtKind::ForRange), D(D), Range(Range),
+        Body(C.add_func_scope()) {}
   Decl *get_decl() { return D; }
   Expr *get_range() { return Range; }
+  void set_range(Expr *E) { Range = E; }
   FuncScope *get_body() { return Body; }
 
 protected:
@@ -132,8 +201,9 @@ class DoStmt : public Stmt {
 
 public:
   DoStmt(Context &C, Expr *Cond)
-      : Stmt(C), Cond(Cond), Body(C.add_func_scope()) {}
+      : Stmt(C, StmtKind::Do), Cond(Cond), Body(C.add_func_scope()) {}
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) { Cond = E; }
   FuncScope *get_body() { return Body; }
 
 protected:
@@ -144,7 +214,7 @@ class BlockStmt : public Stmt {
   FuncScope *S;
 
 public:
-  BlockStmt(Context &C) : Stmt(C), S(C.add_func_scope()) {}
+  BlockStmt(Context &C) : Stmt(C, StmtKind::Block), S(C.add_func_scope()) {}
   FuncScope *get_scope() { return S; }
 
 protected:
@@ -155,8 +225,9 @@ class ExprStmt : public Stmt {
   Expr *E;
 
 public:
-  ExprStmt(Context &C, Expr *E) : Stmt(C), E(E) {}
+  ExprStmt(Context &C, Expr *E) : Stmt(C, StmtKind::Expr), E(E) {}
   Expr *get_expr() { return E; }
+  void set_expr(Expr *E) { this->E = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -166,8 +237,9 @@ class ReturnStmt : public Stmt {
   Expr *E;
 
 public:
-  ReturnStmt(Context &C, Expr *E) : Stmt(C), E(E) {}
+  ReturnStmt(Context &C, Expr *E) : Stmt(C, StmtKind::Return), E(E) {}
   Expr *get_expr() { return E; }
+  void set_expr(Expr *E) { this->E = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -175,7 +247,7 @@ protected:
 
 class BreakStmt : public Stmt {
 public:
-  BreakStmt(Context &C) : Stmt(C) {}
+  BreakStmt(Context &C) : Stmt(C, StmtKind::Break) {}
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -183,7 +255,7 @@ protected:
 
 class ContinueStmt : public Stmt {
 public:
-  ContinueStmt(Context &C) : Stmt(C) {}
+  ContinueStmt(Context &C) : Stmt(C, StmtKind::Continue) {}
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -195,7 +267,7 @@ class LabelStmt : public Stmt {
 
 public:
   LabelStmt(Context &C, std::string Name, Stmt *S = nullptr)
-      : Stmt(C), Name(Name), S(S) {}
+      : Stmt(C, StmtKind::Label), Name(Name), S(S) {}
   std::string get_label_name() { return Name; }
   Stmt *get_stmt() { return S; }
 
@@ -207,7 +279,8 @@ class GotoStmt : public Stmt {
   std::string Name;
 
 public:
-  GotoStmt(Context &C, std::string Name) : Stmt(C), Name(Name) {}
+  GotoStmt(Context &C, std::string Name)
+      : Stmt(C, StmtKind::Goto), Name(Name) {}
   std::string get_label_name() { return Name; }
 
 protected:
@@ -218,15 +291,20 @@ class CaseStmt : public Stmt {
   Expr *Val; //  nullptr for default
   FuncScope *Body;
   bool IsFallThrough;
+  Likelihood Hint = Likelihood::None;
 
 public:
   CaseStmt(Context &C, Expr *Val = nullptr, bool IsFallThrough = false)
-      : Stmt(C), Val(Val), IsFallThrough(IsFallThrough),
+      : Stmt(C, StmtKind::Case), Val(Val), IsFallThrough(IsFallThrough),
         Body(C.add_func_scope()) {}
   Expr *get_val() { return Val; }
+  void set_val(Expr *E) { Val = E; }
   bool is_default() { return Val == nullptr; }
   bool is_fall_through() { return IsFallThrough; }
   FuncScope *get_body() { return Body; }
+  /// @brief The likelihood of this case, emitted on the label.
+  Likelihood get_likelihood() { return Hint; }
+  void set_likelihood(Likelihood Hint) { this->Hint = Hint; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -239,9 +317,15 @@ class SwitchStmt : public Stmt {
 
 public:
   SwitchStmt(Context &C, Expr *Cond, VarDecl *Init = nullptr)
-      : Stmt(C), Cond(Cond), Init(Init) {}
+      : Stmt(C, StmtKind::Switch), Cond(Cond), Init(Init) {}
+  using case_iterator = VUIterator<CaseStmt>;
   Expr *get_cond() { return Cond; }
+  void set_cond(Expr *E) { Cond = E; }
   VarDecl *get_init() { return Init; }
+  IteratorRange<case_iterator> cases() {
+    return IteratorRange<case_iterator>(case_iterator(Cases, 0),
+                                        case_iterator(Cases, Cases.size()));
+  }
   CaseStmt *add_case(Expr *Val, bool IsFallThrough = false);
   CaseStmt *add_default(bool IsFallThrough = false);
 
@@ -253,8 +337,9 @@ class ThrowStmt : public Stmt {
   Expr *E; // nullptr for rethrow
 
 public:
-  ThrowStmt(Context &C, Expr *E) : Stmt(C), E(E) {}
+  ThrowStmt(Context &C, Expr *E) : Stmt(C, StmtKind::Throw), E(E) {}
   Expr *get_expr() { return E; }
+  void set_expr(Expr *E) { this->E = E; }
 
 protected:
   void emit_impl(std::ostream &SS) override;
@@ -265,8 +350,12 @@ class TryStmt : public Stmt {
   std::vector<std::pair<VarDecl *, FuncScope *>> Handlers;
 
 public:
-  TryStmt(Context &C) : Stmt(C), Body(C.add_func_scope()) {}
+  TryStmt(Context &C) : Stmt(C, StmtKind::Try), Body(C.add_func_scope()) {}
+  using handler_iterator = decltype(Handlers)::iterator;
   FuncScope *get_body() { return Body; }
+  IteratorRange<handler_iterator> handlers() {
+    return IteratorRange<handler_iterator>(Handlers.begin(), Handlers.end());
+  }
   // nullptr  for catch(...)
   FuncScope *add_catch(VarDecl *D = nullptr) {
     auto S = C.add_func_scope();
@@ -283,7 +372,8 @@ class UsingNamespaceStmt : public Stmt {
   QualName Name;
 
 public:
-  UsingNamespaceStmt(Context &C, QualName Name) : Stmt(C), Name(Name) {}
+  UsingNamespaceStmt(Context &C, QualName Name)
+      : Stmt(C, StmtKind::UsingNamespace), Name(Name) {}
   QualName get_name() { return Name; }
   std::string get_name_str() { return Name.to_string(); }
 
@@ -0,0 +1,47 @@
+#ifdef NAMEC_GENCXX_STRUCTURAL_HASH_H_CYCLIC
+static_assert(false, "Cyclic include detected of " __FILE__);
+#endif
+#define NAMEC_GENCXX_STRUCTURAL_HASH_H_CYCLIC
+
+#ifndef NAMEC_GENCXX_STRUCTURAL_HASH_H
+#define NAMEC_GENCXX_STRUCTURAL_HASH_H
+
+#include "internal/GenCXX/CXXCommon.h"
+#include "internal/GenCXX/CXXForwards.h"
+#include "internal/Util/Hash.h"
+
+namespace namecxx {
+
+/**
+  @brief StructuralHasher computes stable 128-bit hashes of the statements,
+  expressions and scopes by their structure, as namec::StructuralHasher.
+
+  They are hashed by their kinds, names and operators and the hashes of
+  their children, without emitting them. The declarations, types and
+  directives in them are hashed by their emitted code, streamed into the
+  hash through HashStreamBuf without building the string. The comments of
+  the statements and the expressions are ignored.
+
+  Not memoized, since the passes such as fold_identical_functions() hash
+  each node once.
+ */
+class StructuralHasher {
+  void add(Hash128Builder &B, Expr *E);
+  void add(Hash128Builder &B, Stmt *S);
+  void add(Hash128Builder &B, FuncScope *S);
+  void add_entry(Hash128Builder &B, Emit *E);
+  void add_emitted(Hash128Builder &B, Emit *E);
+
+public:
+  /// @brief All the overloads return the same fixed hash for nullptr.
+  Hash128 hash(Expr *E);
+  Hash128 hash(Stmt *S);
+  Hash128 hash(FuncScope *S);
+  /// @brief The hash of the code emitted by E, such as a declaration.
+  Hash128 hash_emitted(Emit *E);
+};
+
+} // namespace namecxx
+
+#endif // NAMEC_GENCXX_STRUCTURAL_HASH_H
+#undef NAMEC_GENCXX_STRUCTURAL_HASH_H_CYCLIC
@@ -0,0 +1,942 @@
+#ifdef NAMEC_GENCXX_VISITOR_H_CYCLIC
+static_assert(false, "Cyclic include detected of " __FILE__);
+#endif
+#define NAMEC_GENCXX_VISITOR_H_CYCLIC
+
+#ifndef NAMEC_GENCXX_VISITOR_H
+#define NAMEC_GENCXX_VISITOR_H
+
+#include <unordered_map>
+
+#include "internal/GenCXX/CXXDecl.h"
+#include "internal/GenCXX/CXXDirective.h"
+#include "internal/GenCXX/CXXExprs.h"
+#include "internal/GenCXX/CXXFile.h"
+#include "internal/GenCXX/CXXForwards.h"
+#include "internal/GenCXX/CXXScope.h"
+#include "internal/GenCXX/CXXStmts.h"
+#include "internal/GenCXX/CXXTypes.h"
+
+namespace namecxx {
+
+/**
+  @brief RecursiveVisitor traverses the nodes in pre-order, in the order of
+  emission. The same as namec::RecursiveVisitor, with the C++ nodes.
+
+  Class definitions are traversed into their member scopes, and templates into
+  their parameters and the templated declarations. Types are traversed only if
+  Derived hides should_traverse_types() to return true.
+ */
+template <typename Derived> class RecursiveVisitor {
+protected:
+  Derived &derived() { return *static_cast<Derived *>(this); }
+
+public:
+  bool should_traverse_types() { return false; }
+
+  // Hooks to be hidden by Derived.
+  bool visit_top_level(TopLevel *) { return true; }
+  bool visit_class_top_level(ClassTopLevel *) { return true; }
+  bool visit_func_scope(FuncScope *) { return true; }
+  bool visit_macro_func_scope(MacroFuncScope *) { return true; }
+  bool visit_directive(Directive *) { return true; }
+  bool visit_decl(Decl *) { return true; }
+  bool visit_type(Type *) { return true; }
+
+  bool visit_expr(Expr *) { return true; }
+  bool visit_raw_expr(RawExpr *) { return true; }
+  bool visit_variable_expr(VariableExpr *) { return true; }
+  bool visit_subscript_expr(SubscriptExpr *) { return true; }
+  bool visit_call_expr(CallExpr *) { return true; }
+  bool visit_unary_op(UnaryOp *) { return true; }
+  bool visit_binary_op(BinaryOp *) { return true; }
+  bool visit_ternary_op(TernaryOp *) { return true; }
+  bool visit_cast_expr(CastExpr *) { return true; }
+  bool visit_paren_expr(ParenExpr *) { return true; }
+  bool visit_init_list_expr(InitListExpr *) { return true; }
+  bool visit_new_expr(NewExpr *) { return true; }
+  bool visit_delete_expr(DeleteExpr *) { return true; }
+  bool visit_user_defined_literal(UserDefinedLiteral *) { return true; }
+  bool visit_qual_name_expr(QualNameExpr *) { return true; }
+  bool visit_lambda_expr(LambdaExpr *) { return true; }
+  bool visit_instantiate_expr(InstantiateExpr *) { return true; }
+  bool visit_pack_expansion_expr(PackExpansionExpr *) { return true; }
+  bool visit_fold_expr(FoldExpr *) { return true; }
+
+  bool visit_stmt(Stmt *) { return true; }
+  bool visit_raw_stmt(RawStmt *) { return true; }
+  bool visit_decl_stmt(DeclStmt *) { return true; }
+  bool visit_if_stmt(IfStmt *) { return true; }
+  bool visit_while_stmt(WhileStmt *) { return true; }
+  bool visit_for_stmt(ForStmt *) { return true; }
+  bool visit_for_range_stmt(ForRangeStmt *) { return true; }
+  bool visit_do_stmt(DoStmt *) { return true; }
+  bool visit_block_stmt(BlockStmt *) { return true; }
+  bool visit_expr_stmt(ExprStmt *) { return true; }
+  bool visit_return_stmt(ReturnStmt *) { return true; }
+  bool visit_break_stmt(BreakStmt *) { return true; }
+  bool visit_continue_stmt(ContinueStmt *) { return true; }
+  bool visit_label_stmt(LabelStmt *) { return true; }
+  bool visit_goto_stmt(GotoStmt *) { return true; }
+  bool visit_case_stmt(CaseStmt *) { return true; }
+  bool visit_switch_stmt(SwitchStmt *) { return true; }
+  bool visit_throw_stmt(ThrowStmt *) { return true; }
+  bool visit_try_stmt(TryStmt *) { return true; }
+  bool visit_using_namespace_stmt(UsingNamespaceStmt *) { return true; }
+
+  // Traversal.
+  bool traverse_file(CXXFile *F) {
+    for (auto *T : F->top_levels()) {
+      if (!derived().traverse_top_level(T)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool traverse_top_level(TopLevel *T) {
+    if (!T || !derived().visit_top_level(T)) {
+      return !T;
+    }
+    return traverse_entries(T);
+  }
+
+  bool traverse_class_top_level(ClassTopLevel *T) {
+    if (!derived().visit_class_top_level(T)) {
+      return false;
+    }
+    return traverse_entries(T);
+  }
+
+  bool traverse_func_scope(FuncScope *S) {
+    if (!S || !derived().visit_func_scope(S)) {
+      return !S;
+    }
+    return traverse_entries(S);
+  }
+
+  bool traverse_macro_func_scope(MacroFuncScope *S) {
+    if (!derived().visit_macro_func_scope(S)) {
+      return false;
+    }
+    return traverse_entries(S);
+  }
+
+  /// @brief Traverse an entry of the scopes.
+  bool traverse_entry(Emit *E) {
+    switch (E->get_emit_kind()) {
+    case EmitKind::Stmt:
+      return derived().traverse_stmt(static_cast<Stmt *>(E));
+    case EmitKind::Directive:
+      return derived().traverse_directive(static_cast<Directive *>(E));
+    case EmitKind::Decl:
+      return derived().traverse_decl(static_cast<Decl *>(E));
+    case EmitKind::Other:
+      break;
+    }
+    return true;
+  }
+
+  bool traverse_directive(Directive *D) {
+    if (!derived().visit_directive(D)) {
+      return false;
+    }
+    switch (D->get_kind()) {
+    case DirectiveKind::DefineFuncMacro:
+      return derived().traverse_macro_func_scope(
+          static_cast<DefineFuncMacro *>(D)->get_body());
+    case DirectiveKind::Namespace:
+      return derived().traverse_top_level(
+          static_cast<Namespace *>(D)->get_body());
+    default:
+      break;
+    }
+    if (!D->is_if()) {
+      return true;
+    }
+    auto *If = static_cast<IfDirectiveBase *>(D);
+    if (D->get_kind() == DirectiveKind::If &&
+        !derived().traverse_expr(static_cast<IfDirective *>(D)->get_cond())) {
+      return false;
+    }
+    if (!derived().traverse_top_level(If->get_then())) {
+      return false;
+    }
+    for (auto &[Cond, T] : If->elifs()) {
+      if (!derived().traverse_expr(Cond) || !derived().traverse_top_level(T)) {
+        return false;
+      }
+    }
+    return derived().traverse_top_level(If->get_else());
+  }
+
+  bool traverse_decl(Decl *D) {
+    if (!D || !derived().visit_decl(D)) {
+      return !D;
+    }
+    if (D->is_var()) {
+      auto *V = static_cast<VarDecl *>(D);
+      if (!traverse_type_if_enabled(V->get_type())) {
+        return false;
+      }
+      if (D->get_kind() == DeclKind::ArrayVar &&
+          !traverse_exprs(static_cast<ArrayVarDecl *>(D)->sizes())) {
+        return false;
+      }
+      if (D->get_kind() == DeclKind::VarInitialize &&
+          !traverse_exprs(static_cast<VarInitializeDecl *>(D)->args())) {
+        return false;
+      }
+      return derived().traverse_expr(V->get_init());
+    }
+    if (D->is_func()) {
+      auto *F = static_cast<FuncDecl *>(D);
+      if (!traverse_type_if_enabled(F->get_ret_type())) {
+        return false;
+      }
+      for (auto *P : F->params()) {
+        if (!derived().traverse_decl(P)) {
+          return false;
+        }
+      }
+      if (D->is_ctor()) {
+        for (auto &[Name, Init] : static_cast<CtorDecl *>(D)->inits()) {
+          if (!derived().traverse_expr(Init)) {
+            return false;
+          }
+        }
+      }
+      return derived().traverse_func_scope(F->get_body());
+    }
+    switch (D->get_kind()) {
+    case DeclKind::Template: {
+      auto *T = static_cast<TemplateDecl *>(D);
+      for (auto *P : T->params()) {
+        if (!derived().traverse_decl(P)) {
+          return false;
+        }
+      }
+      return derived().traverse_decl(T->get_decl());
+    }
+    case DeclKind::Typedef:
+      return traverse_type_if_enabled(
+          static_cast<TypedefDecl *>(D)->get_type_alias()->get_type());
+    case DeclKind::Using:
+      return traverse_type_if_enabled(
+          static_cast<UsingDecl *>(D)->get_type_alias()->get_type());
+    // The members of class, union and enum are emitted with the definition.
+    case DeclKind::Class: {
+      auto *C = static_cast<ClassDecl *>(D);
+      return C->is_forward() || traverse_members(C->get_class());
+    }
+    case DeclKind::Union: {
+      auto *U = static_cast<UnionDecl *>(D);
+      return U->is_forward() || traverse_members(U->get_union());
+    }
+    case DeclKind::Enum: {
+      auto *E = static_cast<EnumDecl *>(D);
+      return E->is_forward() || traverse_members(E->get_enum());
+    }
+    default:
+      return true;
+    }
+  }
+
+  bool traverse_type(Type *T) {
+    if (!T || !derived().visit_type(T)) {
+      return !T;
+    }
+    if (auto *P = dynamic_cast<Pointer *>(T)) {
+      return derived().traverse_type(P->get_elm_type());
+    }
+    if (auto *R = dynamic_cast<Reference *>(T)) {
+      return derived().traverse_type(R->get_elm_type());
+    }
+    if (auto *A = dynamic_cast<Array *>(T)) {
+      return traverse_exprs(A->size()) &&
+             derived().traverse_type(A->get_elm_type());
+    }
+    if (auto *F = dynamic_cast<Function *>(T)) {
+      if (!derived().traverse_type(F->get_ret_type())) {
+        return false;
+      }
+      for (auto *P : F->params()) {
+        if (!derived().traverse_type(P)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    if (auto *A = dynamic_cast<TypeAlias *>(T)) {
+      return derived().traverse_type(A->get_type());
+    }
+    if (auto *P = dynamic_cast<PackedType *>(T)) {
+      return derived().traverse_type(P->get_type());
+    }
+    if (auto *I = dynamic_cast<Instantiation *>(T)) {
+      return traverse_template_args(I->args());
+    }
+    if (auto *C = dynamic_cast<Class *>(T)) {
+      for (auto &[AS, Base] : C->bases()) {
+        if (!derived().traverse_type(Base)) {
+          return false;
+        }
+      }
+      return traverse_members(C);
+    }
+    if (auto *U = dynamic_cast<ClassOrUnion *>(T)) {
+      return traverse_members(U);
+    }
+    if (auto *E = dynamic_cast<Enum *>(T)) {
+      return derived().traverse_type(E->get_base_type()) &&
+             traverse_members(E);
+    }
+    return true;
+  }
+
+  bool traverse_stmt(Stmt *S) {
+    if (!S || !derived().visit_stmt(S)) {
+      return !S;
+    }
+    switch (S->get_kind()) {
+    case StmtKind::Raw:
+      return derived().visit_raw_stmt(static_cast<RawStmt *>(S));
+    case StmtKind::Decl: {
+      auto *D = static_cast<DeclStmt *>(S);
+      return derived().visit_decl_stmt(D) &&
+             derived().traverse_decl(D->get_decl());
+    }
+    case StmtKind::If: {
+      auto *If = static_cast<IfStmt *>(S);
+      if (!derived().visit_if_stmt(If) ||
+          !derived().traverse_decl(If->get_init()) ||
+          !derived().traverse_expr(If->get_cond()) ||
+          !derived().traverse_func_scope(If->get_then())) {
+        return false;
+      }
+      for (auto &[Cond, Body, Init] : If->elseifs()) {
+        if (!derived().traverse_decl(Init) || !derived().traverse_expr(Cond) ||
+            !derived().traverse_func_scope(Body)) {
+          return false;
+        }
+      }
+      return derived().traverse_func_scope(If->get_else());
+    }
+    case StmtKind::While: {
+      auto *W = static_cast<WhileStmt *>(S);
+      return derived().visit_while_stmt(W) &&
+             derived().traverse_expr(W->get_cond()) &&
+             derived().traverse_func_scope(W->get_body());
+    }
+    case StmtKind::For: {
+      auto *F = static_cast<ForStmt *>(S);
+      return derived().visit_for_stmt(F) &&
+             derived().traverse_stmt(F->get_init()) &&
+             derived().traverse_expr(F->get_cond()) &&
+             derived().traverse_expr(F->get_step()) &&
+             derived().traverse_func_scope(F->get_body());
+    }
+    case StmtKind::ForRange: {
+      auto *F = static_cast<ForRangeStmt *>(S);
+      return derived().visit_for_range_stmt(F) &&
+             derived().traverse_decl(F->get_decl()) &&
+             derived().traverse_expr(F->get_range()) &&
+             derived().traverse_func_scope(F->get_body());
+    }
+    case StmtKind::Do: {
+      auto *D = static_cast<DoStmt *>(S);
+      return derived().visit_do_stmt(D) &&
+             derived().traverse_func_scope(D->get_body()) &&
+             derived().traverse_expr(D->get_cond());
+    }
+    case StmtKind::Block: {
+      auto *B = static_cast<BlockStmt *>(S);
+      return derived().visit_block_stmt(B) &&
+             derived().traverse_func_scope(B->get_scope());
+    }
+    case StmtKind::Expr: {
+      auto *E = static_cast<ExprStmt *>(S);
+      return derived().visit_expr_stmt(E) &&
+             derived().traverse_expr(E->get_expr());
+    }
+    case StmtKind::Return: {
+      auto *R = static_cast<ReturnStmt *>(S);
+      return derived().visit_return_stmt(R) &&
+             derived().traverse_expr(R->get_expr());
+    }
+    case StmtKind::Break:
+      return derived().visit_break_stmt(static_cast<BreakStmt *>(S));
+    case StmtKind::Continue:
+      return derived().visit_continue_stmt(static_cast<ContinueStmt *>(S));
+    case StmtKind::Label: {
+      auto *L = static_cast<LabelStmt *>(S);
+      return derived().visit_label_stmt(L) &&
+             derived().traverse_stmt(L->get_stmt());
+    }
+    case StmtKind::Goto:
+      return derived().visit_goto_stmt(static_cast<GotoStmt *>(S));
+    case StmtKind::Case: {
+      auto *C = static_cast<CaseStmt *>(S);
+      return derived().visit_case_stmt(C) &&
+             derived().traverse_expr(C->get_val()) &&
+             derived().traverse_func_scope(C->get_body());
+    }
+    case StmtKind::Switch: {
+      auto *Sw = static_cast<SwitchStmt *>(S);
+      if (!derived().visit_switch_stmt(Sw) ||
+          !derived().traverse_decl(Sw->get_init()) ||
+          !derived().traverse_expr(Sw->get_cond())) {
+        return false;
+      }
+      for (auto &C : Sw->cases()) {
+        if (!derived().traverse_stmt(&C)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case StmtKind::Throw: {
+      auto *T = static_cast<ThrowStmt *>(S);
+      return derived().visit_throw_stmt(T) &&
+             derived().traverse_expr(T->get_expr());
+    }
+    case StmtKind::Try: {
+      auto *T = static_cast<TryStmt *>(S);
+      if (!derived().visit_try_stmt(T) ||
+          !derived().traverse_func_scope(T->get_body())) {
+        return false;
+      }
+      for (auto &[D, Body] : T->handlers()) {
+        if (!derived().traverse_decl(D) ||
+            !derived().traverse_func_scope(Body)) {
+          return false;
+        }
+      }
+      return true;
+    }
+    case StmtKind::UsingNamespace:
+      return derived().visit_using_namespace_stmt(
+          static_cast<UsingNamespaceStmt *>(S));
+    }
+    return true;
+  }
+
+  bool traverse_expr(Expr *E) {
+    if (!E || !derived().visit_expr(E)) {
+      return !E;
+    }
+    switch (E->get_kind()) {
+    case ExprKind::Raw:
+      return derived().visit_raw_expr(static_cast<RawExpr *>(E));
+    case ExprKind::Variable:
+      return derived().visit_variable_expr(static_cast<VariableExpr *>(E));
+    case ExprKind::Subscript: {
+      auto *S = static_cast<SubscriptExpr *>(E);
+      return derived().visit_subscript_expr(S) &&
+             derived().traverse_expr(S->get_array()) &&
+             derived().traverse_expr(S->get_index());
+    }
+    case ExprKind::Call: {
+      auto *C = static_cast<CallExpr *>(E);
+      return derived().visit_call_expr(C) &&
+             derived().traverse_expr(C->get_callee()) &&
+             traverse_exprs(C->args());
+    }
+    case ExprKind::UnaryOp: {
+      auto *U = static_cast<UnaryOp *>(E);
+      return derived().visit_unary_op(U) &&
+             derived().traverse_expr(U->get_operand());
+    }
+    case ExprKind::BinaryOp: {
+      auto *B = static_cast<BinaryOp *>(E);
+      return derived().visit_binary_op(B) &&
+             derived().traverse_expr(B->get_lhs()) &&
+             derived().traverse_expr(B->get_rhs());
+    }
+    case ExprKind::TernaryOp: {
+      auto *T = static_cast<TernaryOp *>(E);
+      return derived().visit_ternary_op(T) &&
+             derived().traverse_expr(T->get_cond()) &&
+             derived().traverse_expr(T->get_then()) &&
+             derived().traverse_expr(T->get_else());
+    }
+    case ExprKind::Cast: {
+      auto *C = static_cast<CastExpr *>(E);
+      return derived().visit_cast_expr(C) &&
+             traverse_type_if_enabled(C->get_type()) &&
+             derived().traverse_expr(C->get_operand());
+    }
+    case ExprKind::Paren: {
+      auto *P = static_cast<ParenExpr *>(E);
+      return derived().visit_paren_expr(P) &&
+             derived().traverse_expr(P->get_inside());
+    }
+    case ExprKind::InitList: {
+      auto *I = static_cast<InitListExpr *>(E);
+      return derived().visit_init_list_expr(I) && traverse_exprs(I->values());
+    }
+    case ExprKind::New: {
+      auto *N = static_cast<NewExpr *>(E);
+      return derived().visit_new_expr(N) &&
+             derived().traverse_expr(N->get_placement()) &&
+             traverse_type_if_enabled(N->get_type()) &&
+             derived().traverse_expr(N->get_array_size()) &&
+             traverse_exprs(N->args());
+    }
+    case ExprKind::Delete: {
+      auto *D = static_cast<DeleteExpr *>(E);
+      return derived().visit_delete_expr(D) &&
+             derived().traverse_expr(D->get_expr());
+    }
+    case ExprKind::UserDefinedLiteral: {
+      auto *U = static_cast<UserDefinedLiteral *>(E);
+      return derived().visit_user_defined_literal(U) &&
+             derived().traverse_expr(U->get_expr());
+    }
+    case ExprKind::QualName:
+      return derived().visit_qual_name_expr(static_cast<QualNameExpr *>(E));
+    case ExprKind::Lambda: {
+      auto *L = static_cast<LambdaExpr *>(E);
+      if (!derived().visit_lambda_expr(L) || !traverse_exprs(L->captures())) {
+        return false;
+      }
+      for (auto *P : L->params()) {
+        if (!derived().traverse_decl(P)) {
+          return false;
+        }
+      }
+      return traverse_type_if_enabled(L->get_ret_type()) &&
+             derived().traverse_func_scope(L->get_body());
+    }
+    case ExprKind::Instantiate: {
+      auto *I = static_cast<InstantiateExpr *>(E);
+      return derived().visit_instantiate_expr(I) &&
+             traverse_template_args(I->args());
+    }
+    case ExprKind::PackExpansion: {
+      auto *P = static_cast<PackExpansionExpr *>(E);
+      return derived().visit_pack_expansion_expr(P) &&
+             derived().traverse_expr(P->get_expr());
+    }
+    case ExprKind::Fold: {
+      auto *F = static_cast<FoldExpr *>(E);
+      return derived().visit_fold_expr(F) &&
+             derived().traverse_expr(F->get_pack()) &&
+             derived().traverse_expr(F->get_init());
+    }
+    }
+    return true;
+  }
+
+private:
+  bool traverse_type_if_enabled(Type *T) {
+    return !derived().should_traverse_types() || derived().traverse_type(T);
+  }
+  template <typename ScopeT> bool traverse_entries(ScopeT *S) {
+    for (auto *E : S->entries()) {
+      if (!derived().traverse_entry(E)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  template <typename RangeT> bool traverse_exprs(RangeT Range) {
+    for (auto *E : Range) {
+      if (!derived().traverse_expr(E)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  template <typename RangeT> bool traverse_template_args(RangeT Range) {
+    for (auto *A : Range) {
+      if (auto *E = dynamic_cast<Expr *>(A)) {
+        if (!derived().traverse_expr(E)) {
+          return false;
+        }
+      } else if (!traverse_type_if_enabled(dynamic_cast<Type *>(A))) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool traverse_members(ClassOrUnion *C) {
+    for (auto &[AS, T] : C->visibility_scopes()) {
+      if (!derived().traverse_class_top_level(T)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool traverse_members(Enum *E) {
+    for (auto &[Name, Value] : E->members()) {
+      if (!derived().traverse_expr(Value)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/**
+  @brief Rewriter rewrites the nodes in post-order, replacing children. The
+  same as namec::Rewriter, with the C++ nodes.
+
+  Since the scopes of namecxx do not own their entries, transform_entry()
+  returns the replacement of an entry of a scope instead of editing the scope.
+  The replacement must be owned by the Context or another scope.
+ */
+template <typename Derived> class Rewriter {
+  // The replacements of the expressions rewritten so far.
+  std::unordered_map<Expr *, Expr *> Rewritten;
+
+protected:
+  Derived &derived() { return *static_cast<Derived *>(this); }
+
+public:
+  Expr *transform_expr(Expr *E) { return E; }
+  Emit *transform_entry(Emit *E) { return E; }
+
+  void rewrite_file(CXXFile *F) {
+    Rewritten.clear();
+    for (auto *T : F->top_levels()) {
+      derived().rewrite_entries(T);
+    }
+  }
+
+  template <typename ScopeT> void rewrite_entries(ScopeT *S) {
+    if (!S) {
+      return;
+    }
+    for (auto &E : S->entries()) {
+      derived().rewrite_entry(E);
+      E = derived().transform_entry(E);
+    }
+  }
+
+  void rewrite_entry(Emit *E) {
+    switch (E->get_emit_kind()) {
+    case EmitKind::Stmt:
+      derived().rewrite_stmt(static_cast<Stmt *>(E));
+      break;
+    case EmitKind::Directive:
+      derived().rewrite_directive(static_cast<Directive *>(E));
+      break;
+    case EmitKind::Decl:
+      derived().rewrite_decl(static_cast<Decl *>(E));
+      break;
+    case EmitKind::Other:
+      break;
+    }
+  }
+
+  void rewrite_directive(Directive *D) {
+    switch (D->get_kind()) {
+    case DirectiveKind::DefineFuncMacro:
+      derived().rewrite_entries(static_cast<DefineFuncMacro *>(D)->get_body());
+      return;
+    case DirectiveKind::Namespace:
+      derived().rewrite_entries(static_cast<Namespace *>(D)->get_body());
+      return;
+    default:
+      break;
+    }
+    if (!D->is_if()) {
+      return;
+    }
+    auto *If = static_cast<IfDirectiveBase *>(D);
+    if (D->get_kind() == DirectiveKind::If) {
+      auto *I = static_cast<IfDirective *>(D);
+      I->set_cond(derived().rewrite_expr(I->get_cond()));
+    }
+    derived().rewrite_entries(If->get_then());
+    for (auto &[Cond, T] : If->elifs()) {
+      Cond = derived().rewrite_expr(Cond);
+      derived().rewrite_entries(T);
+    }
+    derived().rewrite_entries(If->get_else());
+  }
+
+  void rewrite_decl(Decl *D) {
+    if (!D) {
+      return;
+    }
+    if (D->is_var()) {
+      if (D->get_kind() == DeclKind::ArrayVar) {
+        rewrite_exprs(static_cast<ArrayVarDecl *>(D)->sizes());
+      } else if (D->get_kind() == DeclKind::VarInitialize) {
+        rewrite_exprs(static_cast<VarInitializeDecl *>(D)->args());
+      }
+      auto *V = static_cast<VarDecl *>(D);
+      V->set_init(derived().rewrite_expr(V->get_init()));
+      return;
+    }
+    if (D->is_func()) {
+      auto *F = static_cast<FuncDecl *>(D);
+      for (auto *P : F->params()) {
+        derived().rewrite_decl(P);
+      }
+      if (D->is_ctor()) {
+        for (auto &[Name, Init] : static_cast<CtorDecl *>(D)->inits()) {
+          Init = derived().rewrite_expr(Init);
+        }
+      }
+      derived().rewrite_entries(F->get_body());
+      return;
+    }
+    switch (D->get_kind()) {
+    case DeclKind::Template: {
+      auto *T = static_cast<TemplateDecl *>(D);
+      for (auto *P : T->params()) {
+        derived().rewrite_decl(P);
+      }
+      derived().rewrite_decl(T->get_decl());
+      break;
+    }
+    case DeclKind::Class:
+      if (auto *C = static_cast<ClassDecl *>(D); !C->is_forward()) {
+        rewrite_members(C->get_class());
+      }
+      break;
+    case DeclKind::Union:
+      if (auto *U = static_cast<UnionDecl *>(D); !U->is_forward()) {
+        rewrite_members(U->get_union());
+      }
+      break;
+    case DeclKind::Enum:
+      if (auto *E = static_cast<EnumDecl *>(D); !E->is_forward()) {
+        for (auto &[Name, Value] : E->get_enum()->members()) {
+          Value = derived().rewrite_expr(Value);
+        }
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  void rewrite_stmt(Stmt *S) {
+    if (!S) {
+      return;
+    }
+    switch (S->get_kind()) {
+    case StmtKind::Raw:
+    case StmtKind::Break:
+    case StmtKind::Continue:
+    case StmtKind::Goto:
+    case StmtKind::UsingNamespace:
+      return;
+    case StmtKind::Decl:
+      derived().rewrite_decl(static_cast<DeclStmt *>(S)->get_decl());
+      return;
+    case StmtKind::If: {
+      auto *If = static_cast<IfStmt *>(S);
+      derived().rewrite_decl(If->get_init());
+      If->set_cond(derived().rewrite_expr(If->get_cond()));
+      derived().rewrite_entries(If->get_then());
+      for (auto &[Cond, Body, Init] : If->elseifs()) {
+        derived().rewrite_decl(Init);
+        Cond = derived().rewrite_expr(Cond);
+        derived().rewrite_entries(Body);
+      }
+      derived().rewrite_entries(If->get_else());
+      return;
+    }
+    case StmtKind::While: {
+      auto *W = static_cast<WhileStmt *>(S);
+      W->set_cond(derived().rewrite_expr(W->get_cond()));
+      derived().rewrite_entries(W->get_body());
+      return;
+    }
+    case StmtKind::For: {
+      auto *F = static_cast<ForStmt *>(S);
+      derived().rewrite_stmt(F->get_init());
+      F->set_cond(derived().rewrite_expr(F->get_cond()));
+      F->set_step(derived().rewrite_expr(F->get_step()));
+      derived().rewrite_entries(F->get_body());
+      return;
+    }
+    case StmtKind::ForRange: {
+      auto *F = static_cast<ForRangeStmt *>(S);
+      derived().rewrite_decl(F->get_decl());
+      F->set_range(derived().rewrite_expr(F->get_range()));
+      derived().rewrite_entries(F->get_body());
+      return;
+    }
+    case StmtKind::Do: {
+      auto *D = static_cast<DoStmt *>(S);
+      derived().rewrite_entries(D->get_body());
+      D->set_cond(derived().rewrite_expr(D->get_cond()));
+      return;
+    }
+    case StmtKind::Block:
+      derived().rewrite_entries(static_cast<BlockStmt *>(S)->get_scope());
+      return;
+    case StmtKind::Expr: {
+      auto *E = static_cast<ExprStmt *>(S);
+      E->set_expr(derived().rewrite_expr(E->get_expr()));
+      return;
+    }
+    case StmtKind::Return: {
+      auto *R = static_cast<ReturnStmt *>(S);
+      R->set_expr(derived().rewrite_expr(R->get_expr()));
+      return;
+    }
+    case StmtKind::Label:
+      derived().rewrite_stmt(static_cast<LabelStmt *>(S)->get_stmt());
+      return;
+    case StmtKind::Case: {
+      auto *C = static_cast<CaseStmt *>(S);
+      C->set_val(derived().rewrite_expr(C->get_val()));
+      derived().rewrite_entries(C->get_body());
+      return;
+    }
+    case StmtKind::Switch: {
+      auto *Sw = static_cast<SwitchStmt *>(S);
+      derived().rewrite_decl(Sw->get_init());
+      Sw->set_cond(derived().rewrite_expr(Sw->get_cond()));
+      for (auto &C : Sw->cases()) {
+        derived().rewrite_stmt(&C);
+      }
+      return;
+    }
+    case StmtKind::Throw: {
+      auto *T = static_cast<ThrowStmt *>(S);
+      T->set_expr(derived().rewrite_expr(T->get_expr()));
+      return;
+    }
+    case StmtKind::Try: {
+      auto *T = static_cast<TryStmt *>(S);
+      derived().rewrite_entries(T->get_body());
+      for (auto &[D, Body] : T->handlers()) {
+        derived().rewrite_decl(D);
+        derived().rewrite_entries(Body);
+      }
+      return;
+    }
+    }
+  }
+
+  /// @brief Returns the rewritten E. nullptr for nullptr.
+  Expr *rewrite_expr(Expr *E) {
+    if (!E) {
+      return nullptr;
+    }
+    if (auto It = Rewritten.find(E); It != Rewritten.end()) {
+      return It->second;
+    }
+    switch (E->get_kind()) {
+    case ExprKind::Raw:
+    case ExprKind::Variable:
+    case ExprKind::QualName:
+      break;
+    case ExprKind::Subscript: {
+      auto *S = static_cast<SubscriptExpr *>(E);
+      S->set_array(derived().rewrite_expr(S->get_array()));
+      S->set_index(derived().rewrite_expr(S->get_index()));
+      break;
+    }
+    case ExprKind::Call: {
+      auto *C = static_cast<CallExpr *>(E);
+      C->set_callee(derived().rewrite_expr(C->get_callee()));
+      rewrite_exprs(C->args());
+      break;
+    }
+    case ExprKind::UnaryOp: {
+      auto *U = static_cast<UnaryOp *>(E);
+      U->set_operand(derived().rewrite_expr(U->get_operand()));
+      break;
+    }
+    case ExprKind::BinaryOp: {
+      auto *B = static_cast<BinaryOp *>(E);
+      B->set_lhs(derived().rewrite_expr(B->get_lhs()));
+      B->set_rhs(derived().rewrite_expr(B->get_rhs()));
+      break;
+    }
+    case ExprKind::TernaryOp: {
+      auto *T = static_cast<TernaryOp *>(E);
+      T->set_cond(derived().rewrite_expr(T->get_cond()));
+      T->set_then(derived().rewrite_expr(T->get_then()));
+      T->set_else(derived().rewrite_expr(T->get_else()));
+      break;
+    }
+    case ExprKind::Cast: {
+      auto *C = static_cast<CastExpr *>(E);
+      C->set_operand(derived().rewrite_expr(C->get_operand()));
+      break;
+    }
+    case ExprKind::Paren: {
+      auto *P = static_cast<ParenExpr *>(E);
+      P->set_inside(derived().rewrite_expr(P->get_inside()));
+      break;
+    }
+    case ExprKind::InitList:
+      rewrite_exprs(static_cast<InitListExpr *>(E)->values());
+      break;
+    case ExprKind::New: {
+      auto *N = static_cast<NewExpr *>(E);
+      N->set_placement(derived().rewrite_expr(N->get_placement()));
+      N->set_array_size(derived().rewrite_expr(N->get_array_size()));
+      rewrite_exprs(N->args());
+      break;
+    }
+    case ExprKind::Delete: {
+      auto *D = static_cast<DeleteExpr *>(E);
+      D->set_expr(derived().rewrite_expr(D->get_expr()));
+      break;
+    }
+    case ExprKind::UserDefinedLiteral: {
+      auto *U = static_cast<UserDefinedLiteral *>(E);
+      U->set_expr(derived().rewrite_expr(U->get_expr()));
+      break;
+    }
+    case ExprKind::Lambda: {
+      auto *L = static_cast<LambdaExpr *>(E);
+      rewrite_exprs(L->captures());
+      for (auto *P : L->params()) {
+        derived().rewrite_decl(P);
+      }
+      derived().rewrite_entries(L->get_body());
+      break;
+    }
+    case ExprKind::Instantiate:
+      for (auto &A : static_cast<InstantiateExpr *>(E)->args()) {
+        if (auto *AE = dynamic_cast<Expr *>(A)) {
+          A = derived().rewrite_expr(AE);
+        }
+      }
+      break;
+    case ExprKind::PackExpansion: {
+      auto *P = static_cast<PackExpansionExpr *>(E);
+      P->set_expr(derived().rewrite_expr(P->get_expr()));
+      break;
+    }
+    case ExprKind::Fold: {
+      auto *F = static_cast<FoldExpr *>(E);
+      F->set_pack(derived().rewrite_expr(F->get_pack()));
+      F->set_init(derived().rewrite_expr(F->get_init()));
+      break;
+    }
+    }
+    auto *Result = derived().transform_expr(E);
+    Rewritten[E] = Result;
+    return Result;
+  }
+
+private:
+  template <typename RangeT> void rewrite_exprs(RangeT Range) {
+    for (auto &E : Range) {
+      E = derived().rewrite_expr(E);
+    }
+  }
+  void rewrite_members(ClassOrUnion *C) {
+    for (auto &[AS, T] : C->visibility_scopes()) {
+      derived().rewrite_entries(T);
+    }
+  }
+};
+
+} // namespace namecxx
+
+#endif // NAMEC_GENCXX_VISITOR_H
+#undef NAMEC_GENCXX_VISITOR_H_CYCLIC
@@ -0,0 +1,108 @@
+#ifndef NAMEC_UTIL_CHUNK_STREAM_H
+#define NAMEC_UTIL_CHUNK_STREAM_H
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace namec_util {
+
+/**
+  @brief ChunkStream pulls the output of a producer in chunks, without
+  materializing the whole of it.
+
+  The producer writes to an ostream on a background thread, taken from the
+  threads kept for the producers of the previous streams. The stream is
+  backed by a small ring of fixed size buffers, and each filled buffer is
+  handed to the consumer as a string_view without copying. The producer waits
+  while all the buffers are in use, so the memory is bounded by
+  ChunkSize * NumBuffers.
+
+  A chunk is valid until the next chunk is pulled. Destroying the stream
+  before the end unwinds the producer by an exception thrown from the
+  ostream, so it stops instead of running to the end; the producer must let
+  the exception propagate. An exception thrown by the producer is rethrown
+  by next() after the chunks written before it.
+
+  ```cpp
+  for (std::string_view Chunk : F.emit_chunks()) {
+    fwrite(Chunk.data(), 1, Chunk.size(), Pipe);
+  }
+  ```
+ */
+class ChunkStream {
+public:
+  using Producer = std::function<void(std::ostream &)>;
+
+  class iterator {
+    ChunkStream *S = nullptr;
+    std::string_view Chunk;
+
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const std::string_view *;
+    using reference = const std::string_view &;
+
+    iterator() = default;
+    iterator(ChunkStream *S) : S(S) { ++*this; }
+    reference operator*() const { return Chunk; }
+    pointer operator->() const { return &Chunk; }
+    iterator &operator++() {
+      Chunk = S->next();
+      if (Chunk.empty()) {
+        S = nullptr;
+      }
+      return *this;
+    }
+    bool operator==(const iterator &Other) const { return S == Other.S; }
+    bool operator!=(const iterator &Other) const { return S != Other.S; }
+  };
+
+  ChunkStream(Producer P, size_t ChunkSize = 4096, size_t NumBuffers = 4);
+  ChunkStream(const ChunkStream &) = delete;
+  ChunkStream &operator=(const ChunkStream &) = delete;
+  ~ChunkStream();
+
+  /// @brief Pull the next chunk, releasing the previous one. An empty view at
+  /// the end. Rethrows the exception of the producer at the end, if any.
+  std::string_view next();
+  iterator begin() { return iterator(this); }
+  iterator end() { return iterator(); }
+
+private:
+  class RingBuf;
+  friend class RingBuf;
+
+  size_t ChunkSize;
+  std::vector<std::unique_ptr<char[]>> Buffers;
+  std::vector<size_t> Sizes;
+  // Counts of buffers published by the producer and released by the
+  // consumer. Buffer Filled % N is being written and Consumed % N is being
+  // read.
+  size_t Filled = 0;
+  size_t Consumed = 0;
+  bool IsReading = false;
+  bool IsDone = false;
+  bool IsCancelled = false;
+  // The exception thrown by the producer, rethrown by next().
+  std::exception_ptr Error;
+  std::mutex Mutex;
+  std::condition_variable CV;
+
+  // Producer side. Publish the current buffer of Size bytes and wait for a
+  // free one. Returns false if cancelled.
+  bool publish(size_t Size);
+  char *current_buffer() { return Buffers[Filled % Buffers.size()].get(); }
+};
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_CHUNK_STREAM_H
@@ -26,18 +26,22 @@ public:
     on_add_raw_expr(Raw);
     return Raw;
   }
-  RawExpr *expr_int(int Val) { return expr_raw(std::to_string(Val)); }
-  RawExpr *expr_uint(unsigned int Val) {
+  // Integer literals. Virtual so that a Context making typed literals
+  // overrides them for the calls through this mixin too.
+  virtual RawExpr *expr_int(int Val) { return expr_raw(std::to_string(Val)); }
+  virtual RawExpr *expr_uint(unsigned int Val) {
     return expr_raw(std::to_string(Val) + "u");
   }
-  RawExpr *expr_long(long Val) { return expr_raw(std::to_string(Val) + "l"); }
-  RawExpr *expr_ulong(unsigned long Val) {
+  virtual RawExpr *expr_long(long Val) {
+    return expr_raw(std::to_string(Val) + "l");
+  }
+  virtual RawExpr *expr_ulong(unsigned long Val) {
     return expr_raw(std::to_string(Val) + "ul");
   }
-  RawExpr *expr_llong(long long Val) {
+  virtual RawExpr *expr_llong(long long Val) {
     return expr_raw(std::to_string(Val) + "ll");
   }
-  RawExpr *expr_ullong(unsigned long long Val) {
+  virtual RawExpr *expr_ullong(unsigned long long Val) {
     return expr_raw(std::to_string(Val) + "ull");
   }
   RawExpr *expr_float(float Val) { return expr_raw(std::to_string(Val) + "f"); }
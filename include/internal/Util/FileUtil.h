@@ -0,0 +1,188 @@
+#ifndef NAMEC_UTIL_FILE_UTIL_H
+#define NAMEC_UTIL_FILE_UTIL_H
+
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace namec_util {
+
+/// @brief A path next to Path for a temporary file. The name has the process
+/// id and a counter, so writers to the same Path do not collide.
+inline std::filesystem::path
+unique_tmp_path(const std::filesystem::path &Path) {
+  static std::atomic<unsigned long> Counter{0};
+#ifdef _WIN32
+  auto Pid = _getpid();
+#else
+  auto Pid = getpid();
+#endif
+  auto TmpPath = Path;
+  TmpPath += "." + std::to_string(Pid) + "." + std::to_string(Counter++) +
+             ".tmp";
+  return TmpPath;
+}
+
+/// @brief The outcome of writing a file.
+enum class WriteResult {
+  /// The file already had the content and was left untouched.
+  Unchanged,
+  Written,
+  /// The file could not be opened, written or replaced.
+  Failed,
+};
+
+/**
+  @brief A streambuf writing to the file at Path in text mode.
+
+  With IsSkipUnchanged and an existing file, the bytes go to a temporary file
+  next to Path and are compared with the existing one while streaming, so the
+  content is never held in memory. commit() removes the temporary file if
+  they are identical, keeping the mtime, and renames it over Path otherwise.
+  The temporary file is removed on destruction if commit() was not called.
+ */
+class FileWriteBuf : public std::streambuf {
+  static constexpr size_t BufSize = 64 * 1024;
+
+  std::filesystem::path Path;
+  // Empty if writing to Path directly.
+  std::filesystem::path TmpPath;
+  std::ofstream Out;
+  std::ifstream Old;
+  // Whether the bytes so far are the same as the ones of Old.
+  bool IsSame = false;
+  bool IsFailed = false;
+  bool IsCommitted = false;
+  std::vector<char> Buf;
+  std::vector<char> OldBuf;
+
+  bool flush_buf() {
+    size_t Len = pptr() - pbase();
+    if (IsFailed || !Len) {
+      setp(Buf.data(), Buf.data() + Buf.size());
+      return !IsFailed;
+    }
+    if (!Out.write(pbase(), Len)) {
+      IsFailed = true;
+    }
+    if (IsSame && (!Old.read(OldBuf.data(), Len) ||
+                   std::memcmp(OldBuf.data(), pbase(), Len) != 0)) {
+      IsSame = false;
+    }
+    setp(Buf.data(), Buf.data() + Buf.size());
+    return !IsFailed;
+  }
+
+protected:
+  int_type overflow(int_type Ch) override {
+    if (!flush_buf()) {
+      return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(Ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(Ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(Ch);
+  }
+  int sync() override { return flush_buf() ? 0 : -1; }
+
+public:
+  FileWriteBuf(std::filesystem::path P, bool IsSkipUnchanged)
+      : Path(std::move(P)), Buf(BufSize) {
+    if (IsSkipUnchanged) {
+      Old.open(Path);
+    }
+    if (Old.is_open()) {
+      IsSame = true;
+      OldBuf.resize(BufSize);
+      TmpPath = unique_tmp_path(Path);
+    }
+    Out.open(TmpPath.empty() ? Path : TmpPath);
+    IsFailed = !Out.is_open();
+    setp(Buf.data(), Buf.data() + Buf.size());
+  }
+  FileWriteBuf(const FileWriteBuf &) = delete;
+  FileWriteBuf &operator=(const FileWriteBuf &) = delete;
+  ~FileWriteBuf() override {
+    // Such as the output threw.
+    if (!IsCommitted && !TmpPath.empty()) {
+      Out.close();
+      std::error_code EC;
+      std::filesystem::remove(TmpPath, EC);
+    }
+  }
+
+  /// @brief Finish writing. Call once, after the last output.
+  WriteResult commit() {
+    IsCommitted = true;
+    flush_buf();
+    Out.close();
+    IsFailed |= Out.fail();
+    IsSame = IsSame && Old.peek() == std::ifstream::traits_type::eof();
+    Old.close();
+    std::error_code EC;
+    if (TmpPath.empty()) {
+      return IsFailed ? WriteResult::Failed : WriteResult::Written;
+    }
+    if (IsFailed || IsSame) {
+      std::filesystem::remove(TmpPath, EC);
+      return IsFailed ? WriteResult::Failed : WriteResult::Unchanged;
+    }
+    std::filesystem::rename(TmpPath, Path, EC);
+    if (EC) {
+      std::filesystem::remove(TmpPath, EC);
+      return WriteResult::Failed;
+    }
+    return WriteResult::Written;
+  }
+};
+
+/// @brief Write what Emit writes to its std::ostream & argument to Path. With
+/// IsSkipUnchanged, the file already having the same content is left
+/// untouched, so build tools do not see it as changed.
+template <typename EmitT>
+WriteResult write_file(const std::filesystem::path &Path,
+                       bool IsSkipUnchanged, EmitT Emit) {
+  FileWriteBuf Buf(Path, IsSkipUnchanged);
+  std::ostream OS(&Buf);
+  Emit(OS);
+  return Buf.commit();
+}
+
+/// @brief Write Content to Path, as the above.
+inline WriteResult write_file(const std::filesystem::path &Path,
+                              const std::string &Content,
+                              bool IsSkipUnchanged) {
+  return write_file(Path, IsSkipUnchanged, [&](std::ostream &OS) {
+    OS.write(Content.data(), Content.size());
+  });
+}
+
+/// @brief The number of the files written, or std::nullopt if any failed.
+inline std::optional<size_t>
+count_written(const std::vector<WriteResult> &Results) {
+  size_t Written = 0;
+  for (auto R : Results) {
+    if (R == WriteResult::Failed) {
+      return std::nullopt;
+    }
+    Written += R == WriteResult::Written;
+  }
+  return Written;
+}
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_FILE_UTIL_H
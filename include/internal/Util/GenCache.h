@@ -0,0 +1,97 @@
+#ifndef NAMEC_UTIL_GEN_CACHE_H
+#define NAMEC_UTIL_GEN_CACHE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "internal/Util/FileUtil.h"
+
+namespace namec_util {
+
+/// @brief Statistics of GenCache since its construction.
+struct GenCacheStats {
+  size_t Hits = 0;
+  size_t Misses = 0;
+  size_t Evictions = 0;
+  uintmax_t EvictedBytes = 0;
+};
+
+/**
+  @brief GenCache is a persistent on-disk cache of emitted code, keyed by a
+  fingerprint of the generator inputs supplied by the user.
+
+  On a hit, the previously emitted bytes are streamed from the cache directory
+  and the generator callback is not called. So no Context, file or nodes are
+  constructed at all. On a miss the callback emits the code, which is stored
+  in the cache and written to the output.
+
+  When the total size of the entries exceeds the limit, the least recently
+  used entries are evicted. The entries are indexed in memory when
+  constructed, so a store takes O(log N) instead of scanning the directory.
+  The entries added by other instances sharing the directory afterwards are
+  indexed when they are hit.
+
+  ```cpp
+  GenCache Cache("gen_cache", 64 * 1024 * 1024);
+  Cache.emit_to_file(Fingerprint, "out.c", [](std::ostream &SS) {
+    Context C;
+    CFile F(C);
+    // ... build F ...
+    F.emit(SS);
+  });
+  ```
+ */
+class GenCache {
+  struct EntryInfo {
+    uintmax_t Size;
+    uint64_t LastUse;
+  };
+
+  std::filesystem::path Dir;
+  uintmax_t MaxBytes;
+  GenCacheStats Stats;
+  // The entries by file name, and the names by the last uses, least recently
+  // used first.
+  std::unordered_map<std::string, EntryInfo> Entries;
+  std::map<uint64_t, std::string> ByUse;
+  uint64_t UseCount = 0;
+  uintmax_t TotalBytes = 0;
+
+  std::filesystem::path entry_path(const std::string &Fingerprint);
+  // Open the entry and skip its header. Fails on a missing entry or a
+  // fingerprint mismatch (hash collision).
+  bool open_entry(const std::string &Fingerprint, std::ifstream &IS);
+  // Index the entry at Path as the most recently used one.
+  void use_entry(const std::filesystem::path &Path);
+  void forget_entry(const std::string &Name);
+  void evict();
+
+public:
+  using Generator = std::function<void(std::ostream &)>;
+
+  /// @brief MaxBytes is the size limit of the cache directory. 0 for no limit.
+  GenCache(std::filesystem::path Dir, uintmax_t MaxBytes = 0);
+
+  /// @brief Emit the code for Fingerprint to SS, calling Gen only on a miss.
+  /// Returns whether it was a hit.
+  bool emit(const std::string &Fingerprint, std::ostream &SS, Generator Gen);
+  /// @brief Emit the code for Fingerprint to the file at Path, calling Gen only
+  /// on a miss. IsSkipUnchanged works as CFile::emit_to_file.
+  WriteResult emit_to_file(const std::string &Fingerprint,
+                           std::filesystem::path Path, Generator Gen,
+                           bool IsSkipUnchanged = true);
+  bool contains(const std::string &Fingerprint);
+  /// @brief Total size in bytes of the indexed entries.
+  uintmax_t size_bytes();
+  void clear();
+  GenCacheStats get_stats() { return Stats; }
+};
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_GEN_CACHE_H
@@ -0,0 +1,159 @@
+#ifndef NAMEC_UTIL_HASH_H
+#define NAMEC_UTIL_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace namec_util {
+
+/// @brief 64 bit FNV-1a hash. Stable across processes and platforms.
+inline uint64_t hash_fnv1a(std::string_view Data,
+                           uint64_t Seed = 0xcbf29ce484222325ull) {
+  uint64_t H = Seed;
+  for (unsigned char Ch : Data) {
+    H ^= Ch;
+    H *= 0x100000001b3ull;
+  }
+  return H;
+}
+
+/// @brief Fixed width lower case hex representation of a 64 bit value.
+inline std::string to_hex(uint64_t Val) {
+  static const char Digits[] = "0123456789abcdef";
+  std::string Ret(16, '0');
+  for (int I = 15; I >= 0; --I) {
+    Ret[I] = Digits[Val & 0xf];
+    Val >>= 4;
+  }
+  return Ret;
+}
+
+/// @brief 128 bit hash value.
+struct Hash128 {
+  uint64_t Lo = 0;
+  uint64_t Hi = 0;
+  bool operator==(const Hash128 &Other) const {
+    return Lo == Other.Lo && Hi == Other.Hi;
+  }
+  bool operator!=(const Hash128 &Other) const { return !(*this == Other); }
+  std::string to_hex() const {
+    return namec_util::to_hex(Hi) + namec_util::to_hex(Lo);
+  }
+};
+
+/// @brief For std::unordered_map keyed by Hash128.
+struct Hash128Hash {
+  size_t operator()(const Hash128 &H) const { return H.Lo; }
+};
+
+/**
+  @brief Hash128Builder combines 64 bit words and strings into a Hash128.
+  Strings are read by 8 bytes in little-endian order, so the result is stable
+  across processes and platforms. Not for cryptographic use.
+ */
+class Hash128Builder {
+  uint64_t A;
+  uint64_t B;
+
+  static uint64_t rotl(uint64_t V, int R) { return (V << R) | (V >> (64 - R)); }
+  // The finalizer of MurmurHash3.
+  static uint64_t fmix(uint64_t K) {
+    K ^= K >> 33;
+    K *= 0xff51afd7ed558ccdull;
+    K ^= K >> 33;
+    K *= 0xc4ceb9fe1a85ec53ull;
+    K ^= K >> 33;
+    return K;
+  }
+
+public:
+  Hash128Builder(uint64_t Seed = 0)
+      : A(0x9e3779b97f4a7c15ull ^ Seed), B(0xc2b2ae3d27d4eb4full + Seed) {}
+
+  Hash128Builder &add(uint64_t V) {
+    A = rotl(A ^ (V * 0x87c37b91114253d5ull), 31) * 0x4cf5ad432745937full;
+    B = rotl(B ^ (V * 0x4cf5ad432745937full), 33) * 0x87c37b91114253d5ull + A;
+    return *this;
+  }
+  Hash128Builder &add(std::string_view Data) {
+    add(static_cast<uint64_t>(Data.size()));
+    size_t I = 0;
+    for (; I + 8 <= Data.size(); I += 8) {
+      uint64_t V = 0;
+      for (int J = 7; J >= 0; --J) {
+        V = (V << 8) | static_cast<unsigned char>(Data[I + J]);
+      }
+      add(V);
+    }
+    if (I < Data.size()) {
+      uint64_t V = 0;
+      for (size_t J = Data.size(); J > I; --J) {
+        V = (V << 8) | static_cast<unsigned char>(Data[J - 1]);
+      }
+      add(V);
+    }
+    return *this;
+  }
+  Hash128Builder &add(const Hash128 &H) { return add(H.Lo).add(H.Hi); }
+
+  Hash128 get() const { return {fmix(A + rotl(B, 17)), fmix(B ^ A)}; }
+};
+
+/**
+  @brief HashStreamBuf hashes the bytes written to it by 8 bytes words, so
+  the result depends only on the bytes, not on how they are split into
+  writes. An emission is hashed through it without building the string.
+
+  ```cpp
+  HashStreamBuf Buf;
+  std::ostream OS(&Buf);
+  E->emit(OS);
+  Hash128 H = Buf.get();
+  ```
+ */
+class HashStreamBuf : public std::streambuf {
+  Hash128Builder B;
+  uint64_t Word = 0;
+  uint64_t Size = 0;
+
+  void put(unsigned char Ch) {
+    Word |= static_cast<uint64_t>(Ch) << (8 * (Size % 8));
+    if (++Size % 8 == 0) {
+      B.add(Word);
+      Word = 0;
+    }
+  }
+
+protected:
+  int_type overflow(int_type Ch) override {
+    if (!traits_type::eq_int_type(Ch, traits_type::eof())) {
+      put(static_cast<unsigned char>(traits_type::to_char_type(Ch)));
+    }
+    return traits_type::not_eof(Ch);
+  }
+  std::streamsize xsputn(const char *S, std::streamsize N) override {
+    for (std::streamsize I = 0; I < N; ++I) {
+      put(static_cast<unsigned char>(S[I]));
+    }
+    return N;
+  }
+
+public:
+  /// @brief The number of the bytes written.
+  uint64_t size() const { return Size; }
+  /// @brief The hash of the bytes written so far, with the size.
+  Hash128 get() const {
+    Hash128Builder Ret = B;
+    if (Size % 8) {
+      Ret.add(Word);
+    }
+    return Ret.add(Size).get();
+  }
+};
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_HASH_H
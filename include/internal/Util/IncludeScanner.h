@@ -0,0 +1,95 @@
+#ifndef NAMEC_UTIL_INCLUDE_SCANNER_H
+#define NAMEC_UTIL_INCLUDE_SCANNER_H
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace namec_util {
+
+/**
+  @brief The includes of the files of namec and namecxx, for their
+  dedup_includes() and extract_common_includes().
+
+  TopLevelT, IfT, IncludeT and SystemIncludeT are the TopLevel,
+  IfDirectiveBase, Include and SystemInclude of the language.
+ */
+template <typename TopLevelT, typename IfT, typename IncludeT,
+          typename SystemIncludeT>
+class IncludeScanner {
+  std::unordered_set<std::string> Repeatable;
+
+  // The includes in a branch are not in effect after the #if.
+  size_t dedup_branches(IfT *If, const std::unordered_set<std::string> &Seen) {
+    size_t Removed = 0;
+    auto Dedup = [&](TopLevelT *Branch) {
+      auto Inner = Seen;
+      Removed += dedup(Branch, Inner);
+    };
+    Dedup(If->get_then());
+    for (auto &Elif : If->elifs()) {
+      Dedup(&*Elif.second);
+    }
+    if (If->has_else()) {
+      Dedup(If->get_else());
+    }
+    return Removed;
+  }
+
+public:
+  /// @brief The paths in Repeatable, without the delimiters, are never
+  /// removed by dedup().
+  IncludeScanner(const std::vector<std::string> &Repeatable = {})
+      : Repeatable(Repeatable.begin(), Repeatable.end()) {}
+
+  /// @brief The path of E spelled as in #include, such as <stdio.h>, or ""
+  /// if E is not an include.
+  template <typename EmitT> static std::string spell(EmitT *E) {
+    if (auto *I = dynamic_cast<IncludeT *>(E)) {
+      return "\"" + I->get_path() + "\"";
+    }
+    if (auto *I = dynamic_cast<SystemIncludeT *>(E)) {
+      return "<" + I->get_path() + ">";
+    }
+    return "";
+  }
+
+  /// @brief Remove the includes of T in Seen, the ones in effect before T,
+  /// adding the rest to Seen. Returns the number of the removed ones.
+  size_t dedup(TopLevelT *T, std::unordered_set<std::string> &Seen) {
+    size_t Removed = 0;
+    Removed += T->remove_if([&](auto *E) {
+      auto Spelled = spell(E);
+      if (Spelled.empty()) {
+        if (auto *If = dynamic_cast<IfT *>(E)) {
+          Removed += dedup_branches(If, Seen);
+        }
+        return false;
+      }
+      // Without the delimiters.
+      if (Repeatable.count(Spelled.substr(1, Spelled.size() - 2))) {
+        return false;
+      }
+      return !Seen.insert(Spelled).second;
+    });
+    return Removed;
+  }
+
+  /// @brief Add the includes of T before any other entry to Includes.
+  /// Returns false if T has such an entry, after which the includes are not
+  /// leading.
+  static bool add_leading(TopLevelT *T, std::vector<std::string> &Includes) {
+    for (auto *E : T->entries()) {
+      auto Spelled = spell(E);
+      if (Spelled.empty()) {
+        return false;
+      }
+      Includes.push_back(Spelled);
+    }
+    return true;
+  }
+};
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_INCLUDE_SCANNER_H
@@ -0,0 +1,33 @@
+#ifndef NAMEC_UTIL_JSON_H
+#define NAMEC_UTIL_JSON_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace namec_util {
+
+/// @brief A JSON value, such as of the tool outputs read by the passes. The
+/// numbers are kept as their text, so that 64-bit counts are not rounded.
+struct JsonValue {
+  enum class Kind { Null, Bool, Number, String, Array, Object };
+  Kind K = Kind::Null;
+  /// The string in UTF-8, or the text of the number or the boolean.
+  std::string Text;
+  std::vector<JsonValue> Items;
+  /// The members of an object in order. Duplicated keys are kept.
+  std::vector<std::pair<std::string, JsonValue>> Members;
+
+  /// @brief The first member of Key. nullptr if none or not an object.
+  const JsonValue *get(std::string_view Key) const;
+};
+
+/// @brief Parse the JSON Text. std::nullopt if malformed, including the
+/// unpaired UTF-16 surrogates of \u escapes and the nesting deeper than 256.
+std::optional<JsonValue> parse_json(std::string_view Text);
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_JSON_H
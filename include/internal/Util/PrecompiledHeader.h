@@ -0,0 +1,87 @@
+#ifndef NAMEC_UTIL_PRECOMPILED_HEADER_H
+#define NAMEC_UTIL_PRECOMPILED_HEADER_H
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace namec_util {
+
+/**
+  @brief PrecompiledHeader is a generated header including the headers common
+  to many generated files, to be compiled once as a precompiled header. Made
+  by extract_common_includes() of namec and namecxx.
+
+  The files keep their own includes, which are skipped by the include guards
+  after the precompiled header, so they still compile without it.
+
+  The header is included before the whole file, so it is used only by the
+  files whose leading includes have all of its includes. The others, such as
+  the ones defining feature macros like _POSIX_C_SOURCE before the includes,
+  are skipped.
+
+  ```cpp
+  auto PCH = extract_common_includes({&F1, &F2, &F3}, 2, "gen_pch");
+  PCH.emit_to_dir("out");
+  std::cout << PCH.cmake_snippet("gen_lib", {"f1.c", "f2.c", "f3.c"});
+  ```
+ */
+class PrecompiledHeader {
+  std::string Name;
+  std::string HeaderExt;
+  std::string SourceExt;
+  // The included paths spelled as in #include, such as <stdio.h>.
+  std::vector<std::string> Includes;
+  // The indices of the files not using the header.
+  std::vector<size_t> Skipped;
+
+public:
+  PrecompiledHeader(std::string Name, std::string HeaderExt,
+                    std::string SourceExt, std::vector<std::string> Includes,
+                    std::vector<size_t> Skipped = {})
+      : Name(std::move(Name)), HeaderExt(std::move(HeaderExt)),
+        SourceExt(std::move(SourceExt)), Includes(std::move(Includes)),
+        Skipped(std::move(Skipped)) {}
+  const std::vector<std::string> &get_includes() const { return Includes; }
+  /// @brief The indices of the files, given to extract_common_includes(),
+  /// which must be compiled without the header.
+  const std::vector<size_t> &get_skipped() const { return Skipped; }
+  bool empty() const { return Includes.empty(); }
+  std::string get_header_name() const { return Name + HeaderExt; }
+  /// @brief The source compiled to make the precompiled header, since CMake
+  /// needs a target with a source.
+  std::string get_source_name() const { return Name + SourceExt; }
+  std::string get_header() const;
+  std::string get_source() const;
+  /// @brief CMake code compiling the header once as the target Name, and
+  /// reusing it for Target which compiles the generated sources. Sources are
+  /// the paths of the files in the order given to extract_common_includes(),
+  /// so that the skipped ones are compiled without the header. They may be
+  /// omitted only if get_skipped() is empty.
+  std::string cmake_snippet(const std::string &Target,
+                            const std::vector<std::string> &Sources = {}) const;
+  /// @brief Write the header and the source to Dir. Returns the number of
+  /// files written, or std::nullopt if either cannot be written.
+  std::optional<size_t> emit_to_dir(const std::filesystem::path &Dir,
+                                    bool IsSkipUnchanged = false) const;
+};
+
+/**
+  @brief Select the includes appearing in at least MinFiles of PerFile, the
+  includes of each file spelled as in #include. They are in the order of the
+  first appearance in PerFile.
+ */
+std::vector<std::string>
+select_common_includes(const std::vector<std::vector<std::string>> &PerFile,
+                       size_t MinFiles);
+
+/// @brief The indices of PerFile lacking some of Common, which must not use
+/// the precompiled header of Common.
+std::vector<size_t>
+select_skipped_files(const std::vector<std::vector<std::string>> &PerFile,
+                     const std::vector<std::string> &Common);
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_PRECOMPILED_HEADER_H
@@ -0,0 +1,83 @@
+#ifndef NAMEC_UTIL_REF_INDEX_H
+#define NAMEC_UTIL_REF_INDEX_H
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace namec_util {
+
+/**
+  @brief RefIndexImpl is the call graph and the uses of the variables of a
+  file, built by namec::build_ref_index() and namecxx::build_ref_index().
+
+  FuncT, VarT and ExprT are the FuncDecl, VarDecl and Expr of the language.
+  Each list is in the order of the traversal, which is the order of emission.
+  The edges of the call graph are unique, while call_sites() has every call.
+ */
+template <typename FuncT, typename VarT, typename ExprT> class RefIndexImpl {
+public:
+  /// @brief A call or a use of a variable. User is the function whose body
+  /// has E, or nullptr outside the functions such as in a global initializer.
+  struct Use {
+    FuncT *User;
+    ExprT *E;
+  };
+
+private:
+  std::vector<FuncT *> Functions;
+  std::unordered_map<FuncT *, std::vector<FuncT *>> Callees, Callers;
+  std::unordered_map<FuncT *, std::unordered_set<FuncT *>> Edges;
+  std::unordered_map<FuncT *, std::vector<Use>> Calls;
+  std::unordered_map<VarT *, std::vector<Use>> VarUses;
+  std::vector<Use> Unresolved;
+
+  template <typename KeyT, typename ValT>
+  static const std::vector<ValT> &
+  lookup(const std::unordered_map<KeyT *, std::vector<ValT>> &Map,
+         KeyT *Key) {
+    static const std::vector<ValT> Empty;
+    auto It = Map.find(Key);
+    return It == Map.end() ? Empty : It->second;
+  }
+
+public:
+  void add_function(FuncT *F) { Functions.push_back(F); }
+  void add_call(FuncT *Caller, FuncT *Callee, ExprT *Call) {
+    Calls[Callee].push_back({Caller, Call});
+    if (Caller && Edges[Caller].insert(Callee).second) {
+      Callees[Caller].push_back(Callee);
+      Callers[Callee].push_back(Caller);
+    }
+  }
+  void add_unresolved_call(FuncT *Caller, ExprT *Call) {
+    Unresolved.push_back({Caller, Call});
+  }
+  void add_use(VarT *V, FuncT *User, ExprT *E) {
+    VarUses[V].push_back({User, E});
+  }
+
+  /// @brief The functions with bodies.
+  const std::vector<FuncT *> &functions() const { return Functions; }
+  /// @brief The functions called by F.
+  const std::vector<FuncT *> &callees(FuncT *F) const {
+    return lookup(Callees, F);
+  }
+  /// @brief The functions calling F.
+  const std::vector<FuncT *> &callers(FuncT *F) const {
+    return lookup(Callers, F);
+  }
+  /// @brief The calls of F, including the ones outside the functions.
+  const std::vector<Use> &call_sites(FuncT *F) const {
+    return lookup(Calls, F);
+  }
+  /// @brief The expressions referring to V.
+  const std::vector<Use> &uses(VarT *V) const { return lookup(VarUses, V); }
+  /// @brief The calls whose callees are not resolved, such as the calls
+  /// through pointers and the calls of the functions not in the file.
+  const std::vector<Use> &unresolved_calls() const { return Unresolved; }
+};
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_REF_INDEX_H
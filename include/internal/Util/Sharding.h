@@ -0,0 +1,112 @@
+#ifndef NAMEC_UTIL_SHARDING_H
+#define NAMEC_UTIL_SHARDING_H
+
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace namec_util {
+
+/// @brief Where plan_shards() places a top-level unit of code.
+enum class ShardUnitKind {
+  /// Included by all the shards, such as directives, types and declarations.
+  Header,
+  /// External definition placed in one of the shards. Its Declaration, if
+  /// any, is put in the header at its place instead.
+  Definition,
+  /// Definition with internal linkage. Placed in the same shard as all the
+  /// units referring to its Names.
+  Local,
+};
+
+/// @brief One top-level entry of a file, emitted and classified by the
+/// language-specific sharding (namec::shard_file(), namecxx::shard_file()).
+struct ShardUnit {
+  ShardUnitKind Kind = ShardUnitKind::Header;
+  /// The emitted code of the entry.
+  std::string Text;
+  /// Declaration put in the header for a Definition, such as the prototype
+  /// of a function. Empty if it is declared elsewhere.
+  std::string Declaration;
+  /// Names defined by a Local or Definition unit.
+  std::vector<std::string> Names;
+  /// Names of the definitions that must be in the same shard, such as the
+  /// target of an alias.
+  std::vector<std::string> Anchors;
+  /// Enclosing namespaces, outermost first. "" for an anonymous one.
+  std::vector<std::string> Namespaces;
+};
+
+/**
+  @brief ShardedFile is the header and the source files split from one
+  generated file.
+ */
+class ShardedFile {
+  std::string HeaderName;
+  std::string Header;
+  // Pairs of the file name and the content.
+  std::vector<std::pair<std::string, std::string>> Sources;
+  std::vector<std::string> Warnings;
+
+public:
+  ShardedFile(std::string HeaderName, std::string Header)
+      : HeaderName(std::move(HeaderName)), Header(std::move(Header)) {}
+  void add_source(std::string Name, std::string Content) {
+    Sources.emplace_back(std::move(Name), std::move(Content));
+  }
+  const std::string &get_header_name() const { return HeaderName; }
+  const std::string &get_header() const { return Header; }
+  size_t source_count() const { return Sources.size(); }
+  const std::string &get_source_name(size_t I) const {
+    return Sources[I].first;
+  }
+  const std::string &get_source(size_t I) const { return Sources[I].second; }
+  void add_warning(std::string Message) {
+    Warnings.push_back(std::move(Message));
+  }
+  /// @brief The problems of the split found by the language-specific
+  /// sharding, such as a definition that every source would define.
+  const std::vector<std::string> &warnings() const { return Warnings; }
+
+  /// @brief Write the header and the sources to Dir. With IsSkipUnchanged,
+  /// the files already having the same contents are left untouched, so that
+  /// only the changed shards are recompiled. Returns the number of files
+  /// written, or std::nullopt if any of them cannot be written.
+  std::optional<size_t> emit_to_dir(const std::filesystem::path &Dir,
+                                    bool IsSkipUnchanged = false) const;
+};
+
+/**
+  @brief Split Units, the top-level entries of a file in order, into the
+  header Stem + HeaderExt and NumShards sources Stem_<I> + SourceExt.
+
+  The header has an include guard and keeps the Header units and the
+  declarations of the Definition units in the original order. Each source
+  includes the header and has a part of the Definition and Local units, in
+  the original order.
+
+  A Local unit is kept in the same source as the units whose code has an
+  identifier of its Names, so the units are grouped into connected
+  components. The components are balanced by emitted size, by assigning the
+  largest one first to the least loaded source. All NumShards sources are
+  made even if some are empty, so that the build can list them statically.
+ */
+ShardedFile plan_shards(const std::vector<ShardUnit> &Units, size_t NumShards,
+                        const std::string &Stem, const std::string &HeaderExt,
+                        const std::string &SourceExt);
+
+/**
+  @brief Split Units into the header Stem + HeaderExt and the source Stem +
+  SourceExt. The same as plan_shards() with one shard, so the header has the
+  declarations for the other translation units and the source has all the
+  definitions.
+ */
+ShardedFile plan_split(const std::vector<ShardUnit> &Units,
+                       const std::string &Stem, const std::string &HeaderExt,
+                       const std::string &SourceExt);
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_SHARDING_H
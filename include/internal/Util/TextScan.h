@@ -0,0 +1,34 @@
+#ifndef NAMEC_UTIL_TEXT_SCAN_H
+#define NAMEC_UTIL_TEXT_SCAN_H
+
+#include <cctype>
+#include <string_view>
+
+namespace namec_util {
+
+/// @brief Call Fn with each identifier in the code Text, in order. Numbers
+/// such as 0x1f are skipped. Identifiers in string literals and comments are
+/// not distinguished, so this is for conservative reference scanning.
+template <typename FnT>
+void for_each_identifier(std::string_view Text, FnT Fn) {
+  auto IsIdent = [](char C) {
+    return std::isalnum(static_cast<unsigned char>(C)) || C == '_';
+  };
+  for (size_t I = 0; I < Text.size();) {
+    if (!IsIdent(Text[I])) {
+      ++I;
+      continue;
+    }
+    size_t Begin = I;
+    while (I < Text.size() && IsIdent(Text[I])) {
+      ++I;
+    }
+    if (!std::isdigit(static_cast<unsigned char>(Text[Begin]))) {
+      Fn(Text.substr(Begin, I - Begin));
+    }
+  }
+}
+
+} // namespace namec_util
+
+#endif // NAMEC_UTIL_TEXT_SCAN_H
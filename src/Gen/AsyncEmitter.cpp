@@ -0,0 +1,85 @@
+#include "internal/Gen.h"
+
+using namespace namec;
+
+AsyncEmitter::AsyncEmitter(std::ostream &OS, size_t MaxRegions)
+    : OS(OS), MaxRegions(MaxRegions ? MaxRegions : 1) {
+  Worker = std::thread([this] { run(); });
+}
+
+AsyncEmitter::~AsyncEmitter() {
+  if (Attached && Attached->is_streaming()) {
+    Attached->stop_stream();
+  }
+  // The error is dropped, since a destructor cannot throw.
+  stop();
+}
+
+void AsyncEmitter::attach(CFile &F) {
+  Attached = &F;
+  F.start_stream(
+      [this](std::unique_ptr<SealedRegion> R) { push(std::move(R)); });
+}
+
+void AsyncEmitter::push(std::unique_ptr<SealedRegion> R) {
+  std::unique_lock<std::mutex> Lock(Mutex);
+  Stats.Regions++;
+  if (Error) {
+    // Destroyed here, since the emitter has stopped.
+    return;
+  }
+  if (Queue.size() == MaxRegions) {
+    Stats.Stalls++;
+    CV.wait(Lock, [this] { return Queue.size() < MaxRegions || Error; });
+    if (Error) {
+      return;
+    }
+  }
+  Queue.push_back(std::move(R));
+  CV.notify_all();
+}
+
+void AsyncEmitter::run() {
+  std::unique_lock<std::mutex> Lock(Mutex);
+  while (true) {
+    CV.wait(Lock, [this] { return IsDone || !Queue.empty(); });
+    if (Queue.empty()) {
+      return;
+    }
+    auto R = std::move(Queue.front());
+    Queue.pop_front();
+    CV.notify_all();
+    Lock.unlock();
+    try {
+      R->emit(OS);
+      R.reset();
+    } catch (...) {
+      R.reset();
+      Lock.lock();
+      Error = std::current_exception();
+      Queue.clear();
+      CV.notify_all();
+      return;
+    }
+    Lock.lock();
+  }
+}
+
+void AsyncEmitter::stop() {
+  if (!Worker.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    IsDone = true;
+    CV.notify_all();
+  }
+  Worker.join();
+}
+
+void AsyncEmitter::finish() {
+  stop();
+  if (Error) {
+    std::rethrow_exception(Error);
+  }
+}
@@ -0,0 +1,75 @@
+#include "internal/Gen.h"
+
+#include <algorithm>
+
+using namespace namec;
+
+std::string Attribute::to_string() const {
+  switch (Kind) {
+  case AttributeKind::Hot:
+    return "hot";
+  case AttributeKind::Cold:
+    return "cold";
+  case AttributeKind::AlwaysInline:
+    return "always_inline";
+  case AttributeKind::NoInline:
+    return "noinline";
+  case AttributeKind::Pure:
+    return "pure";
+  case AttributeKind::Const:
+    return "const";
+  case AttributeKind::Flatten:
+    return "flatten";
+  case AttributeKind::Aligned:
+    return Arg.empty() ? "aligned" : "aligned(" + Arg + ")";
+  case AttributeKind::Visibility:
+    return "visibility(\"" + Arg + "\")";
+  case AttributeKind::Target:
+    return "target(\"" + Arg + "\")";
+  case AttributeKind::Section:
+    return "section(\"" + Arg + "\")";
+  case AttributeKind::Destructor:
+    return "destructor";
+  }
+  return "";
+}
+
+void namec::emit_attributes(std::ostream &SS,
+                            const std::vector<Attribute> &Attrs) {
+  if (Attrs.empty()) {
+    return;
+  }
+  SS << "__attribute__((";
+  for (size_t I = 0; I < Attrs.size(); ++I) {
+    SS << (I ? "," : "") << Attrs[I].to_string();
+  }
+  SS << ")) ";
+}
+
+void Attributed::add_attr(Attribute A) {
+  remove_attr(A.get_kind());
+  Attrs.push_back(std::move(A));
+  note_attrs_modified();
+}
+
+void Attributed::remove_attr(AttributeKind Kind) {
+  Attrs.erase(std::remove_if(Attrs.begin(), Attrs.end(),
+                             [&](auto &A) { return A.get_kind() == Kind; }),
+              Attrs.end());
+  note_attrs_modified();
+}
+
+const Attribute *Attributed::get_attr(AttributeKind Kind) const {
+  for (auto &A : Attrs) {
+    if (A.get_kind() == Kind) {
+      return &A;
+    }
+  }
+  return nullptr;
+}
+
+void Attributed::copy_attrs(const Attributed &Other) {
+  for (auto &A : Other.attrs()) {
+    add_attr(A);
+  }
+}
@@ -0,0 +1,495 @@
+#include "internal/Gen.h"
+
+#include <algorithm>
+#include <cctype>
+#include <unordered_map>
+
+using namespace namec;
+
+namespace {
+bool is_assignment(const std::string &Op) {
+  return Op.back() == '=' && Op != "==" && Op != "!=" && Op != "<=" &&
+         Op != ">=";
+}
+
+// The right operand is evaluated after the left, or not at all.
+bool is_sequencing(const std::string &Op) {
+  return Op == "&&" || Op == "||" || Op == ",";
+}
+
+// Identifier or number in a RawExpr, which is read without side effects.
+bool is_plain_raw(RawExpr *E) {
+  auto Val = E->get_val();
+  return !Val.empty() && std::all_of(Val.begin(), Val.end(), [](char C) {
+    return std::isalnum(static_cast<unsigned char>(C)) || C == '_';
+  });
+}
+
+std::optional<IntKind> infer_int_kind(Expr *E) {
+  switch (E->get_kind()) {
+  case ExprKind::Raw:
+    return get_int_constant(E) ? std::optional(get_int_constant(E)->get_kind())
+                               : std::nullopt;
+  case ExprKind::Variable: {
+    auto *D = static_cast<VariableExpr *>(E)->get_decl();
+    // An array decays to a pointer, whatever the element type.
+    if (D->get_kind() == DeclKind::ArrayVar) {
+      return std::nullopt;
+    }
+    return get_int_kind(D->get_type());
+  }
+  case ExprKind::Paren:
+    return infer_int_kind(static_cast<ParenExpr *>(E)->get_inside());
+  case ExprKind::Cast:
+    return get_int_kind(static_cast<CastExpr *>(E)->get_type());
+  case ExprKind::UnaryOp: {
+    auto *U = static_cast<UnaryOp *>(E);
+    auto Op = U->get_op();
+    if (Op == "!") {
+      return IntKind::Int;
+    }
+    if (Op == "+" || Op == "-" || Op == "~") {
+      return infer_int_kind(U->get_operand());
+    }
+    return std::nullopt;
+  }
+  case ExprKind::BinaryOp: {
+    auto *B = static_cast<BinaryOp *>(E);
+    auto Op = B->get_op();
+    if (Op == "==" || Op == "!=" || Op == "<" || Op == ">" || Op == "<=" ||
+        Op == ">=" || Op == "&&" || Op == "||") {
+      return IntKind::Int;
+    }
+    auto L = infer_int_kind(B->get_lhs());
+    if (Op == "<<" || Op == ">>") {
+      return L;
+    }
+    auto R = infer_int_kind(B->get_rhs());
+    if (!L || !R || Op == ",") {
+      return std::nullopt;
+    }
+    return IntValue::common_kind(*L, *R);
+  }
+  default:
+    return std::nullopt;
+  }
+}
+
+// The type of E spelled without __typeof__, or nullptr if unknown. These are
+// the integer arithmetic of the builtin types, and pointer plus or minus an
+// integer over the variables and the casts.
+Type *infer_type(Context &C, Expr *E) {
+  if (auto Kind = infer_int_kind(E)) {
+    return get_int_type(C, *Kind);
+  }
+  switch (E->get_kind()) {
+  case ExprKind::Variable: {
+    auto *D = static_cast<VariableExpr *>(E)->get_decl();
+    auto *A = cast<ArrayVarDecl>(D);
+    if (!A) {
+      return D->get_type();
+    }
+    // The pointer to an array of the other dimensions is not spelled.
+    return A->get_size().size() == 1 ? C.type_ptr(A->get_type()) : nullptr;
+  }
+  case ExprKind::Paren:
+    return infer_type(C, static_cast<ParenExpr *>(E)->get_inside());
+  case ExprKind::Cast:
+    return static_cast<CastExpr *>(E)->get_type();
+  case ExprKind::BinaryOp: {
+    auto *B = static_cast<BinaryOp *>(E);
+    auto Op = B->get_op();
+    if (Op != "+" && Op != "-") {
+      return nullptr;
+    }
+    auto *L = infer_type(C, B->get_lhs());
+    if (cast<Pointer>(L) && infer_int_kind(B->get_rhs())) {
+      return L;
+    }
+    auto *R = infer_type(C, B->get_rhs());
+    if (Op == "+" && cast<Pointer>(R) && infer_int_kind(B->get_lhs())) {
+      return R;
+    }
+    return nullptr;
+  }
+  default:
+    return nullptr;
+  }
+}
+
+class Hoister {
+  Context &C;
+  const std::string &Prefix;
+  size_t Count = 0;
+  StructuralHasher H;
+  std::unordered_map<Expr *, bool> Pure;
+  std::unordered_map<Expr *, size_t> Sizes;
+
+  struct Occurrences {
+    Expr *First;
+    size_t Count;
+  };
+  std::unordered_map<Hash128, Occurrences, Hash128Hash> Counts;
+  // Hash of the first occurrences, in the order found.
+  std::vector<Hash128> Order;
+  // Replacing the occurrences of Target by Var if Var is set.
+  Hash128 Target;
+  VarDecl *Var = nullptr;
+
+  bool is_pure(Expr *E) {
+    if (auto It = Pure.find(E); It != Pure.end()) {
+      return It->second;
+    }
+    bool Result = false;
+    switch (E->get_kind()) {
+    case ExprKind::Raw:
+      Result = is_plain_raw(static_cast<RawExpr *>(E));
+      break;
+    case ExprKind::Variable:
+      // Each read of a volatile is a side effect.
+      Result = !static_cast<VariableExpr *>(E)->get_decl()->is_volatile();
+      break;
+    case ExprKind::Paren:
+      Result = is_pure(static_cast<ParenExpr *>(E)->get_inside());
+      break;
+    case ExprKind::Cast:
+      Result = is_pure(static_cast<CastExpr *>(E)->get_operand());
+      break;
+    case ExprKind::UnaryOp: {
+      auto *U = static_cast<UnaryOp *>(E);
+      auto Op = U->get_op();
+      Result = U->is_prefix() &&
+               (Op == "+" || Op == "-" || Op == "~" || Op == "!" ||
+                Op == "*") &&
+               is_pure(U->get_operand());
+      break;
+    }
+    case ExprKind::BinaryOp: {
+      auto *B = static_cast<BinaryOp *>(E);
+      Result = !is_assignment(B->get_op()) && B->get_op() != "," &&
+               is_pure(B->get_lhs()) && is_pure(B->get_rhs());
+      break;
+    }
+    case ExprKind::TernaryOp: {
+      auto *T = static_cast<TernaryOp *>(E);
+      Result = is_pure(T->get_cond()) && is_pure(T->get_then()) &&
+               is_pure(T->get_else());
+      break;
+    }
+    case ExprKind::Subscript: {
+      auto *S = static_cast<SubscriptExpr *>(E);
+      Result = is_pure(S->get_array()) && is_pure(S->get_index());
+      break;
+    }
+    default:
+      break;
+    }
+    return Pure[E] = Result;
+  }
+
+  // Rvalues of pure operators. Dereferences and subscripts are not, since
+  // they may be arrays.
+  bool is_candidate(Expr *E) {
+    auto Kind = E->get_kind();
+    if (Kind != ExprKind::UnaryOp && Kind != ExprKind::BinaryOp &&
+        Kind != ExprKind::Cast) {
+      return false;
+    }
+    if (auto *U = cast<UnaryOp>(E); U && U->get_op() == "*") {
+      return false;
+    }
+    return is_pure(E) && size(E) >= 3;
+  }
+
+  size_t size(Expr *E) {
+    if (auto It = Sizes.find(E); It != Sizes.end()) {
+      return It->second;
+    }
+    size_t Result = 1;
+    switch (E->get_kind()) {
+    case ExprKind::Paren:
+      // Parentheses are not worth a local by themselves.
+      Result = size(static_cast<ParenExpr *>(E)->get_inside());
+      break;
+    case ExprKind::Cast:
+      Result += size(static_cast<CastExpr *>(E)->get_operand());
+      break;
+    case ExprKind::UnaryOp:
+      Result += size(static_cast<UnaryOp *>(E)->get_operand());
+      break;
+    case ExprKind::BinaryOp: {
+      auto *B = static_cast<BinaryOp *>(E);
+      Result += size(B->get_lhs()) + size(B->get_rhs());
+      break;
+    }
+    case ExprKind::TernaryOp: {
+      auto *T = static_cast<TernaryOp *>(E);
+      Result += size(T->get_cond()) + size(T->get_then()) +
+                size(T->get_else());
+      break;
+    }
+    case ExprKind::Subscript: {
+      auto *S = static_cast<SubscriptExpr *>(E);
+      Result += size(S->get_array()) + size(S->get_index());
+      break;
+    }
+    default:
+      break;
+    }
+    return Sizes[E] = Result;
+  }
+
+  // Count or replace the occurrences in E, which is evaluated
+  // unconditionally. Returns the replacement of E.
+  Expr *walk(Expr *E) {
+    if (!E) {
+      return E;
+    }
+    // The parentheses around an occurrence are replaced together.
+    auto *Inner = E;
+    while (auto *P = cast<ParenExpr>(Inner)) {
+      Inner = P->get_inside();
+    }
+    if (!is_candidate(Inner)) {
+      walk_children(E);
+      return E;
+    }
+    auto Hash = H.hash(Inner);
+    if (Var && Hash == Target) {
+      return C.expr_var(Var);
+    }
+    if (!Var) {
+      auto [It, IsNew] = Counts.try_emplace(Hash, Occurrences{Inner, 0});
+      It->second.Count++;
+      if (IsNew) {
+        Order.push_back(Hash);
+      }
+    }
+    walk_children(Inner);
+    return E;
+  }
+
+  // Walk Child of N, setting it by Set only if replaced: each set marks N
+  // modified.
+  template <typename NodeT>
+  void walk_child(NodeT *N, Expr *Child, void (NodeT::*Set)(Expr *)) {
+    if (auto *New = walk(Child); New != Child) {
+      (N->*Set)(New);
+    }
+  }
+
+  void walk_children(Expr *E) {
+    switch (E->get_kind()) {
+    case ExprKind::Paren: {
+      auto *P = static_cast<ParenExpr *>(E);
+      walk_child(P, P->get_inside(), &ParenExpr::set_inside);
+      break;
+    }
+    case ExprKind::Cast: {
+      auto *Cast = static_cast<CastExpr *>(E);
+      walk_child(Cast, Cast->get_operand(), &CastExpr::set_operand);
+      break;
+    }
+    case ExprKind::UnaryOp: {
+      auto *U = static_cast<UnaryOp *>(E);
+      walk_child(U, U->get_operand(), &UnaryOp::set_operand);
+      break;
+    }
+    case ExprKind::BinaryOp: {
+      auto *B = static_cast<BinaryOp *>(E);
+      walk_child(B, B->get_lhs(), &BinaryOp::set_lhs);
+      if (!is_sequencing(B->get_op())) {
+        walk_child(B, B->get_rhs(), &BinaryOp::set_rhs);
+      }
+      break;
+    }
+    case ExprKind::TernaryOp: {
+      auto *T = static_cast<TernaryOp *>(E);
+      walk_child(T, T->get_cond(), &TernaryOp::set_cond);
+      break;
+    }
+    case ExprKind::Subscript: {
+      auto *S = static_cast<SubscriptExpr *>(E);
+      walk_child(S, S->get_array(), &SubscriptExpr::set_array);
+      walk_child(S, S->get_index(), &SubscriptExpr::set_index);
+      break;
+    }
+    case ExprKind::Call: {
+      auto *Call = static_cast<CallExpr *>(E);
+      walk_child(Call, Call->get_callee(), &CallExpr::set_callee);
+      for (auto &Arg : Call->args()) {
+        if (auto *New = walk(Arg); New != Arg) {
+          Arg = New;
+          Call->note_modified();
+        }
+      }
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  // Walk the expressions of St evaluated once before its nested scopes.
+  void walk_stmt(Stmt *St) {
+    switch (St->get_kind()) {
+    case StmtKind::Expr: {
+      auto *E = static_cast<ExprStmt *>(St);
+      walk_child(E, E->get_expr(), &ExprStmt::set_expr);
+      break;
+    }
+    case StmtKind::Return: {
+      auto *R = static_cast<ReturnStmt *>(St);
+      walk_child(R, R->get_expr(), &ReturnStmt::set_expr);
+      break;
+    }
+    case StmtKind::Decl: {
+      // The initializer of a static or extern local is a constant
+      // expression, evaluated before any local is defined.
+      auto *V = cast<VarDecl>(static_cast<DeclStmt *>(St)->get_decl());
+      if (V && !V->is_static() && !V->is_extern()) {
+        walk_child(V, V->get_init(), &VarDecl::set_init);
+      }
+      break;
+    }
+    case StmtKind::If: {
+      auto *If = static_cast<IfStmt *>(St);
+      walk_child(If, If->get_cond(), &IfStmt::set_cond);
+      break;
+    }
+    case StmtKind::Switch: {
+      auto *Sw = static_cast<SwitchStmt *>(St);
+      walk_child(Sw, Sw->get_cond(), &SwitchStmt::set_cond);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  // Hoist the repeated subexpressions of St in S. IsCase is whether St is
+  // the first statement of the body of a case, following the label.
+  void hoist_stmt(FuncScope *S, Stmt *St, bool IsCase) {
+    while (true) {
+      Counts.clear();
+      Order.clear();
+      walk_stmt(St);
+      Expr *Best = nullptr;
+      Type *Ty = nullptr;
+      for (auto &Hash : Order) {
+        auto &Occ = Counts[Hash];
+        if (Occ.Count < 2 || (Best && size(Occ.First) <= size(Best))) {
+          continue;
+        }
+        // Not hoisted if the type of the local cannot be spelled.
+        if (auto *T = infer_type(C, Occ.First)) {
+          Best = Occ.First;
+          Ty = T;
+          Target = Hash;
+        }
+      }
+      if (!Best) {
+        return;
+      }
+      auto *Saved = S->get_insert_point();
+      if (IsCase) {
+        // A declaration cannot follow a label before C23, so St goes into a
+        // block with the locals.
+        S->set_insert_point_before(St);
+        auto *Block = S->stmt_block();
+        Block->get_scope()->splice_before(nullptr, S, St, St);
+        S->set_insert_point_before(Saved == St ? Block : Saved);
+        S = Block->get_scope();
+        Saved = S->get_insert_point();
+        IsCase = false;
+      }
+      S->set_insert_point_before(St);
+      // Best is detached from St by the replacement below.
+      Var = S->def_var(Prefix + std::to_string(Count++), Ty, Best);
+      // const of a pointer VarDecl would qualify the pointee.
+      Var->set_const(!cast<Pointer>(Ty));
+      S->set_insert_point_before(Saved);
+      Stats.Hoisted++;
+      walk_stmt(St);
+      Var = nullptr;
+      Stats.Replaced += Counts[Target].Count;
+      // The sizes of the ancestors are stale. The setters drop their hashes.
+      Sizes.clear();
+      // The initializer may have repeated subexpressions in turn.
+      hoist_stmt(S, static_cast<Stmt *>(St->get_prev()), false);
+    }
+  }
+
+public:
+  CSEStats Stats;
+
+  Hoister(Context &C, const std::string &Prefix) : C(C), Prefix(Prefix) {}
+
+  void hoist_scope(FuncScope *S, bool IsCase = false) {
+    if (!S) {
+      return;
+    }
+    // Taken before hoisting, which may move the entry into a block.
+    for (auto *E = S->get_first(), *Next = E; E; E = Next) {
+      Next = E->get_next();
+      auto *St = cast<Stmt>(E);
+      if (!St) {
+        continue;
+      }
+      hoist_stmt(S, St, IsCase && E == S->get_first());
+      switch (St->get_kind()) {
+      case StmtKind::If: {
+        auto *If = static_cast<IfStmt *>(St);
+        hoist_scope(If->get_then());
+        for (auto &[Cond, Body] : If->elseifs()) {
+          hoist_scope(Body);
+        }
+        hoist_scope(If->get_else());
+        break;
+      }
+      case StmtKind::While:
+        hoist_scope(static_cast<WhileStmt *>(St)->get_body());
+        break;
+      case StmtKind::For:
+        hoist_scope(static_cast<ForStmt *>(St)->get_body());
+        break;
+      case StmtKind::Do:
+        hoist_scope(static_cast<DoStmt *>(St)->get_body());
+        break;
+      case StmtKind::Block:
+        hoist_scope(static_cast<BlockStmt *>(St)->get_scope());
+        break;
+      case StmtKind::Switch:
+        for (auto &Case : static_cast<SwitchStmt *>(St)->cases()) {
+          hoist_scope(Case.get_body(), true);
+        }
+        break;
+      default:
+        break;
+      }
+    }
+  }
+};
+} // namespace
+
+CSEStats namec::hoist_common_subexprs(Context &C, FuncScope *S,
+                                      const std::string &Prefix) {
+  Hoister Hoist(C, Prefix);
+  Hoist.hoist_scope(S);
+  return Hoist.Stats;
+}
+
+CSEStats namec::hoist_common_subexprs(Context &C, CFile &F,
+                                      const std::string &Prefix) {
+  CSEStats Stats;
+  for (auto &T : F.top_levels()) {
+    for (auto *E : T.entries()) {
+      if (auto *FD = cast<FuncDecl>(E); FD && FD->get_body()) {
+        auto Result = hoist_common_subexprs(C, FD->get_body(), Prefix);
+        Stats.Hoisted += Result.Hoisted;
+        Stats.Replaced += Result.Replaced;
+      }
+    }
+  }
+  return Stats;
+}
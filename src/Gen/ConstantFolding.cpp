@@ -0,0 +1,190 @@
+#include "internal/Gen.h"
+
+using namespace namec;
+
+namespace {
+Expr *skip_parens(Expr *E) {
+  while (auto *P = cast<ParenExpr>(E)) {
+    E = P->get_inside();
+  }
+  return E;
+}
+
+// The integer type of a literal or variable E.
+std::optional<IntKind> get_atom_int_kind(Expr *E) {
+  E = skip_parens(E);
+  if (auto *L = cast<IntLiteral>(E)) {
+    return L->get_value().get_kind();
+  }
+  auto *V = cast<VariableExpr>(E);
+  // An array of integers decays to a pointer.
+  if (!V || V->get_decl()->get_kind() == DeclKind::ArrayVar) {
+    return std::nullopt;
+  }
+  return get_int_kind(V->get_decl()->get_type());
+}
+
+// Negative literals are parenthesized, not to be joined with the operators.
+bool needs_parens(IntValue V) { return V.to_string()[0] == '-'; }
+
+bool is_identity(const std::string &Op, bool IsRight, IntValue V) {
+  if (Op == "*" || Op == "/") {
+    return (IsRight || Op == "*") && V.get_bits() == 1;
+  }
+  if (Op == "+" || Op == "|" || Op == "^") {
+    return V.is_zero();
+  }
+  return IsRight && V.is_zero() && (Op == "-" || Op == "<<" || Op == ">>");
+}
+
+class ConstantFolder : public Rewriter<ConstantFolder> {
+  Context &C;
+
+  Expr *make(IntValue V) {
+    Folded++;
+    auto *L = C.expr_int_value(V);
+    if (needs_parens(V)) {
+      return C.expr_paren(L);
+    }
+    return L;
+  }
+
+  // x op c or c op x to x, if it keeps the type.
+  Expr *fold_identity(BinaryOp *B) {
+    auto Op = B->get_op();
+    for (bool IsRight : {true, false}) {
+      auto *X = IsRight ? B->get_lhs() : B->get_rhs();
+      auto V = get_int_constant(IsRight ? B->get_rhs() : B->get_lhs());
+      auto XKind = get_atom_int_kind(X);
+      if (!V || !XKind || !is_identity(Op, IsRight, *V)) {
+        continue;
+      }
+      // The shift count does not take part in the conversions.
+      bool IsShift = Op == "<<" || Op == ">>";
+      if (IsShift || *XKind == V->get_kind()) {
+        Folded++;
+        return skip_parens(X);
+      }
+    }
+    return B;
+  }
+
+  Expr *fold_ternary(TernaryOp *T) {
+    auto Cond = get_int_constant(T->get_cond());
+    if (!Cond) {
+      return T;
+    }
+    auto *Chosen = Cond->is_zero() ? T->get_else() : T->get_then();
+    auto Then = get_int_constant(T->get_then());
+    auto Else = get_int_constant(T->get_else());
+    if (Then && Else) {
+      auto K = IntValue::common_kind(Then->get_kind(), Else->get_kind());
+      return make(get_int_constant(Chosen)->convert(K));
+    }
+    auto ThenKind = get_atom_int_kind(T->get_then());
+    auto ElseKind = get_atom_int_kind(T->get_else());
+    if (ThenKind && ThenKind == ElseKind) {
+      Folded++;
+      return skip_parens(Chosen);
+    }
+    return T;
+  }
+
+public:
+  size_t Folded = 0;
+
+  ConstantFolder(Context &C) : C(C) {}
+
+  Expr *transform_expr(Expr *E) {
+    switch (E->get_kind()) {
+    case ExprKind::Paren: {
+      // Drop the parentheses around the atoms and the doubled ones.
+      auto *Inside = static_cast<ParenExpr *>(E)->get_inside();
+      auto V = get_int_constant(Inside);
+      if ((V && !needs_parens(*V)) || cast<VariableExpr>(Inside) ||
+          cast<ParenExpr>(Inside)) {
+        Folded++;
+        return Inside;
+      }
+      return E;
+    }
+    case ExprKind::UnaryOp: {
+      auto *U = static_cast<UnaryOp *>(E);
+      auto V = get_int_constant(U->get_operand());
+      if (U->is_prefix() && V) {
+        if (auto R = eval_unary(U->get_op(), *V)) {
+          return make(*R);
+        }
+      }
+      return E;
+    }
+    case ExprKind::BinaryOp: {
+      auto *B = static_cast<BinaryOp *>(E);
+      auto L = get_int_constant(B->get_lhs());
+      auto R = get_int_constant(B->get_rhs());
+      if (L && R) {
+        if (auto V = eval_binary(B->get_op(), *L, *R)) {
+          return make(*V);
+        }
+        return E;
+      }
+      return fold_identity(B);
+    }
+    case ExprKind::TernaryOp:
+      return fold_ternary(static_cast<TernaryOp *>(E));
+    default:
+      return E;
+    }
+  }
+};
+} // namespace
+
+namespace {
+const std::pair<const char *, IntKind> IntTypeNames[] = {
+    {"int", IntKind::Int},
+    {"unsigned int", IntKind::UInt},
+    {"long", IntKind::Long},
+    {"unsigned long", IntKind::ULong},
+    {"long long", IntKind::LLong},
+    {"unsigned long long", IntKind::ULLong},
+};
+} // namespace
+
+std::optional<IntKind> namec::get_int_kind(Type *T) {
+  auto *Raw = cast<RawType>(T);
+  if (!Raw) {
+    return std::nullopt;
+  }
+  for (auto [Name, Kind] : IntTypeNames) {
+    if (Raw->get_val() == Name) {
+      return Kind;
+    }
+  }
+  return std::nullopt;
+}
+
+Type *namec::get_int_type(Context &C, IntKind K) {
+  for (auto [Name, Kind] : IntTypeNames) {
+    if (Kind == K) {
+      return C.type_raw(Name);
+    }
+  }
+  return nullptr;
+}
+
+std::optional<IntValue> namec::get_int_constant(Expr *E) {
+  if (auto *L = cast<IntLiteral>(skip_parens(E))) {
+    return L->get_value();
+  }
+  return std::nullopt;
+}
+
+Expr *namec::fold_constants(Context &C, Expr *E) {
+  return ConstantFolder(C).rewrite_expr(E);
+}
+
+size_t namec::fold_constants(Context &C, CFile &F) {
+  ConstantFolder Folder(C);
+  Folder.rewrite_file(&F);
+  return Folder.Folded;
+}
@@ -1,5 +1,7 @@
 #include "internal/Gen.h"
 
+#include <iterator>
+
 using namespace namec;
 
 FuncScope *Context::add_scope() {
@@ -7,3 +9,45 @@ FuncScope *Context::add_scope() {
   Scopes.push_back(std::unique_ptr<FuncScope>(S));
   return S;
 }
+
+template <typename T>
+static std::vector<std::unique_ptr<T>>
+take_since(std::vector<std::unique_ptr<T>> &Vec, size_t Pos) {
+  std::vector<std::unique_ptr<T>> Ret;
+  if (Pos < Vec.size()) {
+    Ret.reserve(Vec.size() - Pos);
+    std::move(Vec.begin() + Pos, Vec.end(), std::back_inserter(Ret));
+    Vec.erase(Vec.begin() + Pos, Vec.end());
+  }
+  return Ret;
+}
+
+std::unordered_set<const void *> Context::get_arena_since(ArenaMark M) {
+  std::unordered_set<const void *> Nodes;
+  for (size_t I = M.Scopes; I < Scopes.size(); ++I) {
+    Nodes.insert(Scopes[I].get());
+  }
+  for (size_t I = M.Decls; I < Decls.size(); ++I) {
+    Nodes.insert(Decls[I].get());
+  }
+  for (size_t I = M.Exprs; I < Exprs.size(); ++I) {
+    Nodes.insert(Exprs[I].get());
+  }
+  return Nodes;
+}
+
+Context::ArenaRegion Context::take_arena_since(ArenaMark M) {
+  ArenaRegion R;
+  R.Scopes = take_since(Scopes, M.Scopes);
+  R.Decls = take_since(Decls, M.Decls);
+  R.Exprs = take_since(Exprs, M.Exprs);
+  // The named types outlive the decls, and are cached by the decl address,
+  // which may be reused.
+  for (auto &D : R.Decls) {
+    if (auto It = NamedTypeMap.find(D.get()); It != NamedTypeMap.end()) {
+      It->second->release_decl();
+      NamedTypeMap.erase(It);
+    }
+  }
+  return R;
+}
@@ -0,0 +1,239 @@
+#include "internal/Gen.h"
+#include "internal/Util/TextScan.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace namec;
+
+namespace {
+// The declaration of the top-level entry E, or nullptr if none.
+Decl *get_entry_decl(Emit *E) {
+  switch (E->get_emit_kind()) {
+  case EmitKind::Decl:
+    return static_cast<Decl *>(E);
+  case EmitKind::Stmt:
+    if (auto *S = static_cast<Stmt *>(E); S->get_kind() == StmtKind::Decl) {
+      return static_cast<DeclStmt *>(S)->get_decl();
+    }
+    return nullptr;
+  default:
+    return nullptr;
+  }
+}
+
+bool is_func_decl(Decl *D) {
+  auto Kind = D->get_kind();
+  return Kind == DeclKind::Func || Kind == DeclKind::FuncSplit;
+}
+
+// Marks the candidate declarations reachable from the traversed entries.
+class Liveness : public RecursiveVisitor<Liveness> {
+  struct Candidate {
+    std::vector<Emit *> Entries;
+    bool IsLive = false;
+  };
+  // Candidates by key. Struct, union and enum are keyed with the tag, since
+  // they are in a separate namespace from the ordinary identifiers.
+  std::unordered_map<std::string, Candidate> Candidates;
+  // The keys of the candidate decls and type aliases.
+  std::unordered_map<const Emit *, std::string> Keys;
+  // The keys named by the identifiers.
+  std::unordered_multimap<std::string, std::string> Names;
+  std::vector<std::string> Worklist;
+
+  void add(const std::string &Key, Emit *Entry, const std::string &Name) {
+    Candidates[Key].Entries.push_back(Entry);
+    Names.emplace(Name, Key);
+  }
+  void mark(const std::string &Key) {
+    auto It = Candidates.find(Key);
+    if (It != Candidates.end() && !It->second.IsLive) {
+      It->second.IsLive = true;
+      Worklist.push_back(Key);
+    }
+  }
+  void mark_decl(const Emit *D) {
+    if (auto It = Keys.find(D); It != Keys.end()) {
+      mark(It->second);
+    }
+  }
+
+public:
+  bool should_traverse_types() { return true; }
+
+  /// Register E if it is a removable declaration.
+  bool add_candidate(Emit *E) {
+    auto *D = get_entry_decl(E);
+    if (!D) {
+      return false;
+    }
+    if (D->get_kind() == DeclKind::FuncSplitForward) {
+      D = static_cast<FuncSplitForwardDecl *>(D)->get_func_decl();
+    }
+    std::string Name = D->get_name(), Key = Name;
+    switch (D->get_kind()) {
+    case DeclKind::Func:
+    case DeclKind::FuncSplit:
+      if (!static_cast<FuncDecl *>(D)->is_static()) {
+        return false;
+      }
+      break;
+    case DeclKind::Var:
+    case DeclKind::ArrayVar: {
+      auto *V = static_cast<VarDecl *>(D);
+      if (!V->is_static() || V->is_extern()) {
+        return false;
+      }
+      break;
+    }
+    case DeclKind::Typedef:
+      Keys[static_cast<TypedefDecl *>(D)->get_type_alias()] = Key;
+      break;
+    case DeclKind::Struct:
+      Key = "struct " + Name;
+      break;
+    case DeclKind::Union:
+      Key = "union " + Name;
+      break;
+    case DeclKind::Enum:
+      Key = "enum " + Name;
+      for (auto &[Member, Value] :
+           static_cast<EnumDecl *>(D)->get_enum()->members()) {
+        Names.emplace(Member, Key);
+      }
+      break;
+    default:
+      return false;
+    }
+    Keys[D] = Key;
+    add(Key, E, Name);
+    return true;
+  }
+
+  void mark_name(const std::string &Name) {
+    auto [Begin, End] = Names.equal_range(Name);
+    for (auto It = Begin; It != End; ++It) {
+      mark(It->second);
+    }
+  }
+  /// Mark all the identifiers in the raw code.
+  void mark_text(const std::string &Text) {
+    for_each_identifier(Text, [&](std::string_view Name) {
+      mark_name(std::string(Name));
+    });
+  }
+
+  /// Traverse the live candidates until no more are found.
+  void propagate() {
+    while (!Worklist.empty()) {
+      auto Key = Worklist.back();
+      Worklist.pop_back();
+      for (auto *E : Candidates[Key].Entries) {
+        traverse_entry(E);
+      }
+    }
+  }
+
+  std::unordered_set<Emit *> dead_entries() {
+    std::unordered_set<Emit *> Dead;
+    for (auto &[Key, Cand] : Candidates) {
+      if (!Cand.IsLive) {
+        Dead.insert(Cand.Entries.begin(), Cand.Entries.end());
+      }
+    }
+    return Dead;
+  }
+
+  bool visit_variable_expr(VariableExpr *E) {
+    mark_decl(E->get_decl());
+    return true;
+  }
+  bool visit_raw_expr(RawExpr *E) {
+    mark_text(E->get_val());
+    return true;
+  }
+  bool visit_raw_stmt(RawStmt *S) {
+    mark_text(S->get_val());
+    return true;
+  }
+  bool visit_decl(Decl *D) {
+    if (D->get_kind() == DeclKind::Raw) {
+      mark_text(static_cast<RawDecl *>(D)->get_val());
+    } else if (is_func_decl(D)) {
+      auto *FD = static_cast<FuncDecl *>(D);
+      // Reached, so build the body to be traversed next.
+      FD->materialize();
+      mark_name(FD->get_alias());
+    }
+    return true;
+  }
+  bool visit_type(Type *T) {
+    if (auto *N = cast<Named>(T)) {
+      if (N->get_decl()) {
+        mark_decl(N->get_decl());
+      }
+    } else if (auto *R = cast<RawType>(T)) {
+      mark_text(R->get_val());
+    } else {
+      mark_decl(T);
+    }
+    return true;
+  }
+  bool visit_directive(Directive *D) {
+    // The contents of the others are traversed.
+    switch (D->get_kind()) {
+    case DirectiveKind::If:
+    case DirectiveKind::Ifdef:
+    case DirectiveKind::Ifndef:
+    case DirectiveKind::DefineFuncMacro:
+      break;
+    default:
+      mark_text(D->to_string());
+      break;
+    }
+    return true;
+  }
+};
+} // namespace
+
+DeadDeclStats
+namec::eliminate_dead_decls(CFile &F,
+                            const std::vector<std::string> &ExtraRoots) {
+  Liveness L;
+  std::vector<Emit *> Roots;
+  for (auto &T : F.top_levels()) {
+    for (auto *E : T.entries()) {
+      if (!L.add_candidate(E)) {
+        Roots.push_back(E);
+      }
+    }
+  }
+  for (auto &Name : ExtraRoots) {
+    L.mark_name(Name);
+  }
+  for (auto *E : Roots) {
+    L.traverse_entry(E);
+  }
+  L.propagate();
+
+  auto Dead = L.dead_entries();
+  DeadDeclStats Stats;
+  for (auto &T : F.top_levels()) {
+    Stats.Removed += T.remove_if([&](Emit *E) {
+      if (!Dead.count(E)) {
+        return false;
+      }
+      // Emitting an unbuilt lazy function would build it.
+      auto *D = get_entry_decl(E);
+      if (D && is_func_decl(D) && static_cast<FuncDecl *>(D)->is_lazy()) {
+        Stats.Unbuilt++;
+        return true;
+      }
+      // With the newline after each entry.
+      Stats.Bytes += E->to_string().size() + 1;
+      return true;
+    });
+  }
+  return Stats;
+}
@@ -5,6 +5,7 @@ using namespace namec;
 void RawDecl::emit_impl(std::ostream &SS) { SS << get_val(); }
 
 void VarDecl::emit_impl(std::ostream &SS) {
+  emit_attrs(SS);
   if (is_const()) {
     SS << "const ";
   }
@@ -31,7 +32,30 @@ void VarDecl::emit_impl(std::ostream &SS) {
   }
 }
 
+void VarDecl::emit_extern(std::ostream &SS) {
+  emit_attrs(SS);
+  if (is_const()) {
+    SS << "const ";
+  }
+  SS << "extern ";
+  if (is_volatile()) {
+    SS << "volatile ";
+  }
+  SS << get_type() << " ";
+  if (is_restrict()) {
+    SS << "restrict ";
+  }
+  SS << get_name();
+}
+
+void ArrayVarDecl::emit_extern(std::ostream &SS) {
+  emit_attrs(SS);
+  SS << "extern " << get_type() << " " << get_name();
+  SS << "[" << join(sizes(), "][") << "]";
+}
+
 void ArrayVarDecl::emit_impl(std::ostream &SS) {
+  emit_attrs(SS);
   SS << get_type() << " " << get_name();
   SS << "[" << join(sizes(), "][") << "]";
   if (get_init()) {
@@ -52,7 +76,6 @@ void TypedefDecl::emit_impl(std::ostream &SS) {
     }
     SS << ")";
   } else {
-    T->emit(SS);
     SS << T << " " << get_type_alias()->get_name();
   }
 }
@@ -60,18 +83,44 @@ void TypedefDecl::emit_impl(std::ostream &SS) {
 FuncScope *FuncDecl::get_or_add_body() {
   if (!Body) {
     Body = C.add_scope();
+    note_modified();
   }
   return Body;
 }
 
+FuncScope *FuncDecl::replace_body() {
+  Builder = nullptr;
+  Body = C.add_scope();
+  note_modified();
+  return Body;
+}
+
+void FuncDecl::materialize() {
+  if (Builder) {
+    // Moved out first, since the builder may emit or refer to this function.
+    auto Build = std::move(Builder);
+    Builder = nullptr;
+    Build(get_or_add_body());
+  }
+}
+
 void FuncDecl::emit_impl_impl(std::ostream &SS, bool IsForward,
                               bool IsSplitDefinition) {
+  emit_attrs(SS);
+  if (is_extern()) {
+    SS << "extern ";
+  }
+  if (is_static()) {
+    SS << "static ";
+  }
   SS << get_ret_type() << " " << get_name() << "(" << join(params());
   if (is_vararg()) {
     SS << ",...";
   }
   SS << ")";
-  if (!IsForward) {
+  if (!IsForward && !Alias.empty()) {
+    SS << " __attribute__((alias(\"" << Alias << "\")));";
+  } else if (!IsForward) {
     SS << "{" << Body << "}";
   } else {
     // Forward declaration
@@ -80,7 +129,8 @@ void FuncDecl::emit_impl_impl(std::ostream &SS, bool IsForward,
 }
 
 void FuncDecl::emit_impl(std::ostream &SS) {
-  return emit_impl_impl(SS, !Body, false);
+  // A lazy definition not yet built is emitted as the prototype.
+  return emit_impl_impl(SS, !Body && Alias.empty(), false);
 }
 
 void FuncSplitForwardDecl::emit_impl(std::ostream &SS) {
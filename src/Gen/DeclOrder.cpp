@@ -0,0 +1,397 @@
+#include "internal/Gen.h"
+#include "internal/Util/TextScan.h"
+
+#include <algorithm>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+
+using namespace namec;
+
+namespace {
+// A declaration entry of a top-level.
+struct Node {
+  Emit *Entry;
+  Decl *D;
+  // The declared entity: Struct, Union, Enum, TypeAlias, FuncDecl or VarDecl.
+  const void *Key;
+  bool IsDefinition;
+  // A lazy definition whose body is not built, taken to use everything.
+  bool IsOpaque;
+  // The entities whose definitions or declarations must precede this.
+  std::unordered_set<const void *> Strong, Weak;
+};
+
+class DeclOrderer {
+  std::vector<Node> Nodes;
+  // The nodes of each top-level in order, -1 for the other entries.
+  std::vector<std::pair<TopLevel *, std::vector<int>>> TopLevels;
+  std::unordered_map<const void *, size_t> Definitions, FirstDecls;
+  // The first declarations of the functions, for the opaque ones.
+  std::vector<size_t> FirstFuncDecls;
+  bool IsAllFuncsDeclared = false;
+  // Identifiers in raw code naming functions and variables.
+  std::unordered_map<std::string, const void *> Names;
+  std::unordered_set<const void *> Declared;
+  DeclOrderStats Stats;
+
+  friend class BodyRefs;
+
+  static const void *key_of(Decl *D) {
+    if (auto *S = cast<StructDecl>(D)) {
+      return S->get_struct();
+    }
+    if (auto *U = cast<UnionDecl>(D)) {
+      return U->get_union();
+    }
+    if (auto *E = cast<EnumDecl>(D)) {
+      return E->get_enum();
+    }
+    if (auto *T = cast<TypedefDecl>(D)) {
+      return T->get_type_alias();
+    }
+    if (auto *FF = cast<FuncSplitForwardDecl>(D)) {
+      return FF->get_func_decl();
+    }
+    return D;
+  }
+
+  void add_node(Emit *E);
+  void collect_body(Node &N, FuncDecl *FD);
+  void collect_expr(Node &N, Expr *E);
+  std::vector<int> order_run(const std::vector<int> &Run);
+  Emit *declare(TopLevel *T, Node &N);
+
+public:
+  /// Whether a use needs only a declaration of the type or its definition.
+  enum class TypeNeed { Declaration, Complete };
+  static void collect(Node &N, Type *T, TypeNeed Need);
+
+  void add_top_level(TopLevel *T) {
+    TopLevels.emplace_back(T, std::vector<int>());
+    for (auto *E : T->entries()) {
+      add_node(E);
+    }
+  }
+  DeclOrderStats run();
+};
+
+// Collects the references in function bodies and initializers.
+class BodyRefs : public RecursiveVisitor<BodyRefs> {
+  DeclOrderer &O;
+  Node &N;
+
+  void add_name(const std::string &Name) {
+    if (auto It = O.Names.find(Name); It != O.Names.end()) {
+      add_decl(It->second);
+    }
+  }
+  void add_names(std::string_view Text) {
+    for_each_identifier(
+        Text, [&](std::string_view Name) { add_name(std::string(Name)); });
+  }
+  void add_decl(const void *Key) {
+    if (Key == N.Key) {
+      return;
+    }
+    // A prototype is enough for a call.
+    bool IsFunc = O.Definitions.count(Key) &&
+                  cast<FuncDecl>(O.Nodes[O.Definitions[Key]].D);
+    (IsFunc ? N.Weak : N.Strong).insert(Key);
+  }
+
+public:
+  BodyRefs(DeclOrderer &O, Node &N) : O(O), N(N) {}
+  bool should_traverse_types() { return true; }
+  bool visit_type(Type *T) {
+    DeclOrderer::collect(N, T, DeclOrderer::TypeNeed::Complete);
+    return true;
+  }
+  bool visit_variable_expr(VariableExpr *E) {
+    add_decl(E->get_decl());
+    return true;
+  }
+  bool visit_raw_expr(RawExpr *E) {
+    add_names(E->get_val());
+    return true;
+  }
+  bool visit_raw_stmt(RawStmt *S) {
+    add_names(S->get_val());
+    return true;
+  }
+};
+} // namespace
+
+void DeclOrderer::collect(Node &N, Type *T, TypeNeed Need) {
+  if (!T) {
+    return;
+  }
+  if (auto *Nm = cast<Named>(T)) {
+    // Released by sealing, so emitted before.
+    auto *D = Nm->get_decl();
+    if (!D) {
+      return;
+    }
+    bool IsTag = cast<StructDecl>(D) || cast<UnionDecl>(D);
+    bool IsWeak = IsTag && Need == TypeNeed::Declaration;
+    (IsWeak ? N.Weak : N.Strong).insert(key_of(D));
+  } else if (auto *A = cast<TypeAlias>(T)) {
+    N.Strong.insert(A);
+    // The aliased type must be complete where the alias is used so.
+    if (Need == TypeNeed::Complete) {
+      collect(N, A->get_type(), TypeNeed::Complete);
+    }
+  } else if (auto *P = cast<Pointer>(T)) {
+    collect(N, P->get_elm_type(), TypeNeed::Declaration);
+  } else if (auto *Ar = cast<Array>(T)) {
+    collect(N, Ar->get_elm_type(), TypeNeed::Complete);
+  } else if (auto *F = cast<Function>(T)) {
+    collect(N, F->get_ret_type(), TypeNeed::Declaration);
+    for (auto *P : F->params()) {
+      collect(N, P, TypeNeed::Declaration);
+    }
+  }
+}
+
+void DeclOrderer::add_node(Emit *E) {
+  auto &Indexes = TopLevels.back().second;
+  auto *D = cast<Decl>(E);
+  if (auto *S = cast<DeclStmt>(E)) {
+    D = S->get_decl();
+  }
+  Node N{E, D, nullptr, true, false, {}, {}};
+  if (auto *S = cast<StructDecl>(D)) {
+    N.IsDefinition = !S->is_forward();
+  } else if (auto *U = cast<UnionDecl>(D)) {
+    N.IsDefinition = !U->is_forward();
+  } else if (auto *En = cast<EnumDecl>(D)) {
+    N.IsDefinition = !En->is_forward();
+  } else if (cast<TypedefDecl>(D)) {
+  } else if (cast<FuncSplitForwardDecl>(D)) {
+    N.IsDefinition = false;
+  } else if (auto *FD = cast<FuncDecl>(D)) {
+    N.IsDefinition = !FD->is_forward() && FD->get_alias().empty();
+    Names.emplace(FD->get_name(), FD);
+  } else if (auto *V = cast<VarDecl>(D)) {
+    N.IsDefinition = !V->is_extern();
+    Names.emplace(V->get_name(), V);
+  } else {
+    Indexes.push_back(-1);
+    return;
+  }
+  N.Key = key_of(D);
+  auto Index = Nodes.size();
+  if (N.IsDefinition) {
+    Definitions.emplace(N.Key, Index);
+  }
+  if (FirstDecls.emplace(N.Key, Index).second && cast<FuncDecl>(D)) {
+    FirstFuncDecls.push_back(Index);
+  }
+  Nodes.push_back(std::move(N));
+  Indexes.push_back(Index);
+}
+
+void DeclOrderer::collect_body(Node &N, FuncDecl *FD) {
+  // Building the body only for its references would defeat the laziness.
+  if (FD->is_lazy()) {
+    N.IsOpaque = true;
+    return;
+  }
+  BodyRefs(*this, N).traverse_func_scope(FD->get_body());
+}
+
+void DeclOrderer::collect_expr(Node &N, Expr *E) {
+  BodyRefs(*this, N).traverse_expr(E);
+}
+
+std::vector<int> DeclOrderer::order_run(const std::vector<int> &Run) {
+  std::unordered_map<int, size_t> Position;
+  for (size_t I = 0; I < Run.size(); ++I) {
+    Position[Run[I]] = I;
+  }
+  // The opaque nodes follow the definitions of the types and the variables
+  // through a barrier at Run.size(), instead of an edge from each of them.
+  size_t Barrier = Run.size();
+  std::vector<std::vector<size_t>> Users(Run.size() + 1);
+  std::vector<size_t> Deps(Run.size() + 1, 0);
+  for (size_t I = 0; I < Run.size(); ++I) {
+    std::unordered_set<size_t> Preds;
+    for (auto *Key : Nodes[Run[I]].Strong) {
+      auto It = Definitions.find(Key);
+      if (It == Definitions.end()) {
+        continue;
+      }
+      auto P = Position.find(It->second);
+      if (P != Position.end() && P->second != I &&
+          Preds.insert(P->second).second) {
+        Users[P->second].push_back(I);
+        Deps[I]++;
+      }
+    }
+    auto &N = Nodes[Run[I]];
+    if (N.IsOpaque) {
+      Users[Barrier].push_back(I);
+      Deps[I]++;
+    } else if (N.IsDefinition && !cast<FuncDecl>(N.D)) {
+      Users[I].push_back(Barrier);
+      Deps[Barrier]++;
+    }
+  }
+  // Kahn's algorithm taking the earliest ready one, to keep the order.
+  std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> Ready;
+  for (size_t I = 0; I <= Barrier; ++I) {
+    if (Deps[I] == 0) {
+      Ready.push(I);
+    }
+  }
+  std::vector<int> Order;
+  std::vector<bool> Done(Run.size() + 1, false);
+  while (!Ready.empty()) {
+    auto I = Ready.top();
+    Ready.pop();
+    if (I != Barrier) {
+      Order.push_back(Run[I]);
+    }
+    Done[I] = true;
+    for (auto U : Users[I]) {
+      if (--Deps[U] == 0) {
+        Ready.push(U);
+      }
+    }
+  }
+  if (Order.size() < Run.size()) {
+    Stats.Cycles++;
+    for (size_t I = 0; I < Run.size(); ++I) {
+      if (!Done[I]) {
+        Order.push_back(Run[I]);
+      }
+    }
+  }
+  return Order;
+}
+
+Emit *DeclOrderer::declare(TopLevel *T, Node &N) {
+  Stats.Forwards++;
+  if (auto *S = cast<StructDecl>(N.D)) {
+    T->declare_struct(S->get_struct());
+  } else if (auto *U = cast<UnionDecl>(N.D)) {
+    T->declare_union(U->get_union());
+  } else if (auto *FF = cast<FuncSplitForwardDecl>(N.D)) {
+    T->declare_func(FF->get_func_decl());
+  } else {
+    T->declare_func(cast<FuncDecl>(N.D));
+  }
+  // The added one is the last entry.
+  return *(T->entries().end() - 1);
+}
+
+DeclOrderStats DeclOrderer::run() {
+  for (auto &N : Nodes) {
+    if (auto *S = cast<StructDecl>(N.D); S && N.IsDefinition) {
+      for (auto &M : S->get_struct()->members()) {
+        collect(N, M.get_type(), TypeNeed::Complete);
+      }
+    } else if (auto *U = cast<UnionDecl>(N.D); U && N.IsDefinition) {
+      for (auto &M : U->get_union()->members()) {
+        collect(N, M.get_type(), TypeNeed::Complete);
+      }
+    } else if (auto *TD = cast<TypedefDecl>(N.D)) {
+      collect(N, TD->get_type_alias()->get_type(), TypeNeed::Declaration);
+    } else if (auto *FD = cast<FuncDecl>(N.Key == N.D ? N.D : nullptr)) {
+      auto Need = N.IsDefinition ? TypeNeed::Complete : TypeNeed::Declaration;
+      collect(N, FD->get_ret_type(), Need);
+      for (auto *P : FD->params()) {
+        collect(N, P->get_type(), Need);
+      }
+      if (N.IsDefinition) {
+        collect_body(N, FD);
+      }
+    } else if (auto *FF = cast<FuncSplitForwardDecl>(N.D)) {
+      auto *FD = FF->get_func_decl();
+      collect(N, FD->get_ret_type(), TypeNeed::Declaration);
+      for (auto *P : FD->params()) {
+        collect(N, P->get_type(), TypeNeed::Declaration);
+      }
+    } else if (auto *V = cast<VarDecl>(N.D)) {
+      auto Need = N.IsDefinition ? TypeNeed::Complete : TypeNeed::Declaration;
+      collect(N, V->get_type(), Need);
+      collect_expr(N, V->get_init());
+    }
+  }
+
+  for (auto &[T, Indexes] : TopLevels) {
+    std::vector<int> Order;
+    std::vector<int> Run;
+    auto Flush = [&] {
+      auto Sorted = order_run(Run);
+      Order.insert(Order.end(), Sorted.begin(), Sorted.end());
+      Run.clear();
+    };
+    for (auto I : Indexes) {
+      if (I < 0) {
+        Flush();
+        Order.push_back(-1);
+      } else {
+        Run.push_back(I);
+      }
+    }
+    Flush();
+
+    // Map back to the entries, with the forward declarations.
+    std::vector<Emit *> Old(T->entries().begin(), T->entries().end());
+    std::vector<Emit *> New, Kept;
+    size_t Other = 0;
+    auto next_other = [&] {
+      while (Indexes[Other] >= 0) {
+        ++Other;
+      }
+      return Old[Other++];
+    };
+    for (auto I : Order) {
+      if (I < 0) {
+        New.push_back(next_other());
+        Kept.push_back(New.back());
+        continue;
+      }
+      auto &N = Nodes[I];
+      // A struct is declared in its own definition.
+      Declared.insert(N.Key);
+      std::vector<size_t> Needed;
+      if (N.IsOpaque && !IsAllFuncsDeclared) {
+        Needed = FirstFuncDecls;
+        IsAllFuncsDeclared = true;
+      }
+      for (auto *Key : N.Weak) {
+        auto It = FirstDecls.find(Key);
+        if (It != FirstDecls.end() && !N.Strong.count(Key)) {
+          Needed.push_back(It->second);
+        }
+      }
+      // In the original order, independent of the hashing.
+      std::sort(Needed.begin(), Needed.end());
+      Needed.erase(std::unique(Needed.begin(), Needed.end()), Needed.end());
+      for (auto J : Needed) {
+        if (Declared.count(Nodes[J].Key)) {
+          continue;
+        }
+        New.push_back(declare(T, Nodes[J]));
+        Declared.insert(Nodes[J].Key);
+      }
+      New.push_back(N.Entry);
+      Kept.push_back(N.Entry);
+    }
+    for (size_t I = 0; I < Old.size(); ++I) {
+      Stats.Moved += Old[I] != Kept[I];
+    }
+    T->reorder(New);
+  }
+  return Stats;
+}
+
+DeclOrderStats namec::order_declarations(CFile &F) {
+  DeclOrderer O;
+  for (auto &T : F.top_levels()) {
+    O.add_top_level(&T);
+  }
+  return O.run();
+}
@@ -28,7 +28,8 @@ void Define::emit_impl(std::ostream &SS) {
 
 DefineFuncMacro::DefineFuncMacro(Context &C, std::string Name,
                                  std::vector<std::string> Args, bool IsVarArg)
-    : C(C), Name(Name), Args(Args), IsVarArg(IsVarArg) {
+    : Directive(DirectiveKind::DefineFuncMacro), C(C), Name(Name), Args(Args),
+      IsVarArg(IsVarArg) {
   Body.reset(new MacroFuncScope(C));
 }
 
@@ -55,7 +56,8 @@ void Pragma::emit_impl(std::ostream &SS) {
   SS << "\n";
 }
 
-IfDirectiveBase::IfDirectiveBase(Context &C) : C(C) {
+IfDirectiveBase::IfDirectiveBase(Context &C, DirectiveKind Kind)
+    : Directive(Kind), C(C) {
   Then.reset(new TopLevel(C));
 }
 
@@ -63,16 +65,28 @@ TopLevel *IfDirectiveBase::add_elif(Expr *Cond) {
   auto E = std::make_unique<TopLevel>(C);
   auto *Ret = E.get();
   Elifs.push_back({Cond, std::move(E)});
+  note_modified();
   return Ret;
 }
 
 TopLevel *IfDirectiveBase::get_or_add_else() {
   if (!Else) {
     Else.reset(new TopLevel(C));
+    note_modified();
   }
   return Else.get();
 }
 
+void IfDirectiveBase::materialize() {
+  Then->materialize();
+  for (auto &[Cond, T] : Elifs) {
+    T->materialize();
+  }
+  if (Else) {
+    Else->materialize();
+  }
+}
+
 void IfDirectiveBase::emit_impl(std::ostream &SS) {
   // Other part than #if, #ifdef, #ifndef
   SS << "\n";
@@ -80,7 +94,7 @@ void IfDirectiveBase::emit_impl(std::ostream &SS) {
   for (auto &[ElifCond, ElifThen] : Elifs) {
     SS << "\n";
     SS << "#elif " << ElifCond << "\n";
-    SS << ElifThen;
+    SS << ElifThen.get();
   }
   SS << "\n";
   if (has_else()) {
@@ -92,7 +106,7 @@ void IfDirectiveBase::emit_impl(std::ostream &SS) {
 }
 
 IfDirective::IfDirective(Context &C, Expr *Cond)
-    : IfDirectiveBase(C), Cond(Cond) {}
+    : IfDirectiveBase(C, DirectiveKind::If), Cond(Cond) {}
 
 void IfDirective::emit_impl(std::ostream &SS) {
   SS << "\n";
@@ -1,17 +1,151 @@
 #include "internal/Gen.h"
 
-#include <fstream>
-
 using namespace namec;
 
-void CFile::emit_to_file(std::filesystem::path Path) {
-  std::ofstream OS(Path);
-  emit(OS);
+WriteResult CFile::emit_to_file(std::filesystem::path Path,
+                               bool IsSkipUnchanged) {
+  materialize();
+  return write_file(Path, IsSkipUnchanged,
+                    [this](std::ostream &OS) { emit(OS); });
 }
 
 void CFile::emit_impl(std::ostream &SS) {
+  materialize();
   for (auto &T : TopLevels) {
     T->emit(SS);
     SS << "\n";
   }
 }
+
+void CFile::materialize() {
+  for (auto &T : TopLevels) {
+    T->materialize();
+  }
+}
+
+void SealedRegion::materialize() {
+  for (auto &Part : Parts) {
+    Part.first->materialize();
+  }
+}
+
+void SealedRegion::emit_impl(std::ostream &SS) {
+  for (auto &[T, IsSplit] : Parts) {
+    T->emit(SS);
+    if (!IsSplit) {
+      SS << "\n";
+    }
+  }
+}
+
+void CFile::start_stream(std::ostream &SS) {
+  start_stream([&SS](std::unique_ptr<SealedRegion> R) { R->emit(SS); });
+}
+
+void CFile::start_stream(
+    std::function<void(std::unique_ptr<SealedRegion>)> Handler) {
+  SealHandler = Handler;
+  Mark = C.get_arena_mark();
+}
+
+namespace {
+// Finds a use of the nodes to be released by sealing.
+class ReleasedUseFinder : public RecursiveVisitor<ReleasedUseFinder> {
+  std::unordered_set<const void *> Released;
+
+public:
+  ReleasedUseFinder(std::unordered_set<const void *> Released)
+      : Released(std::move(Released)) {}
+  bool visit_func_scope(FuncScope *S) { return !Released.count(S); }
+  bool visit_expr(Expr *E) { return !Released.count(E); }
+  // The referred decls are not children.
+  bool visit_variable_expr(VariableExpr *E) {
+    return !Released.count(E->get_decl());
+  }
+  bool visit_decl(Decl *D) {
+    if (auto *FF = cast<FuncSplitForwardDecl>(D)) {
+      return !Released.count(FF->get_func_decl());
+    }
+    return !Released.count(D);
+  }
+};
+} // namespace
+
+// Whether the entries left unsealed by seal_until(Index, Last) use the nodes
+// created since the previous seal, which it releases.
+bool CFile::is_released_used(size_t Index, Emit *Last) {
+  std::vector<Emit *> Rest;
+  if (Last) {
+    auto Entries = TopLevels[Index]->entries();
+    auto It = std::find(Entries.begin(), Entries.end(), Last);
+    Rest.assign(++It, Entries.end());
+  }
+  for (size_t I = Index + 1; I < TopLevels.size(); ++I) {
+    auto Entries = TopLevels[I]->entries();
+    Rest.insert(Rest.end(), Entries.begin(), Entries.end());
+  }
+  if (Rest.empty()) {
+    return false;
+  }
+  ReleasedUseFinder Finder(C.get_arena_since(Mark));
+  for (auto *E : Rest) {
+    if (!Finder.traverse_entry(E)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Seal the top-levels before Index. Then the one at Index is sealed wholly if
+// Last is nullptr, or its entries up to and including Last otherwise.
+void CFile::seal_until(size_t Index, Emit *Last) {
+  auto R = std::make_unique<SealedRegion>();
+  for (size_t I = 0; I < Index; ++I) {
+    R->Parts.push_back({std::move(TopLevels[I]), false});
+  }
+  if (Last) {
+    R->Parts.push_back({TopLevels[Index]->split_until(Last), true});
+    TopLevels.erase(TopLevels.begin(), TopLevels.begin() + Index);
+  } else {
+    R->Parts.push_back({std::move(TopLevels[Index]), false});
+    TopLevels.erase(TopLevels.begin(), TopLevels.begin() + Index + 1);
+  }
+  // Built here, since the handler may emit R on another thread.
+  R->materialize();
+  R->Nodes = C.take_arena_since(Mark);
+  Mark = C.get_arena_mark();
+  SealHandler(std::move(R));
+}
+
+bool CFile::seal(TopLevel *T) {
+  for (size_t I = 0; is_streaming() && I < TopLevels.size(); ++I) {
+    if (TopLevels[I].get() == T) {
+      if (is_released_used(I, nullptr)) {
+        return false;
+      }
+      seal_until(I, nullptr);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool CFile::seal(FuncDecl *FD) {
+  for (size_t I = 0; is_streaming() && I < TopLevels.size(); ++I) {
+    if (TopLevels[I]->contains(FD)) {
+      if (is_released_used(I, FD)) {
+        return false;
+      }
+      seal_until(I, FD);
+      return true;
+    }
+  }
+  return false;
+}
+
+void CFile::end_stream() {
+  if (!TopLevels.empty()) {
+    seal_until(TopLevels.size() - 1, nullptr);
+  }
+  SealHandler = nullptr;
+}
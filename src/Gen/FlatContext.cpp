@@ -0,0 +1,850 @@
+#include "internal/Gen.h"
+
+#include <cassert>
+#include <iterator>
+
+using namespace namec;
+
+FlatIndex FlatContext::add_str(const std::string &S) {
+  if (auto P = StrMap.find(S); P != StrMap.end()) {
+    return P->second;
+  }
+  FlatIndex I = StrBegins.size();
+  StrBegins.push_back(Chars.size());
+  Chars += S;
+  StrMap[S] = I;
+  return I;
+}
+
+std::string_view FlatContext::get_str(FlatIndex I) {
+  size_t End = I + 1 < StrBegins.size() ? StrBegins[I + 1] : Chars.size();
+  return std::string_view(Chars).substr(StrBegins[I], End - StrBegins[I]);
+}
+
+FlatIndex FlatContext::add_type_index(Type *T) {
+  if (auto P = TypeMap.find(T); P != TypeMap.end()) {
+    return P->second;
+  }
+  FlatIndex I = TypeTable.size();
+  TypeTable.push_back(T);
+  TypeMap[T] = I;
+  return I;
+}
+
+FlatExpr FlatContext::add_expr(ExprKind K, FlatIndex A, FlatIndex B,
+                               FlatIndex C) {
+  ExprKinds.push_back(K);
+  ExprA.push_back(A);
+  ExprB.push_back(B);
+  ExprC.push_back(C);
+  return {FlatIndex(ExprKinds.size() - 1)};
+}
+
+FlatIndex FlatContext::add_stmt(StmtKind K, FlatIndex A, FlatIndex B,
+                                FlatIndex C) {
+  StmtKinds.push_back(K);
+  StmtA.push_back(A);
+  StmtB.push_back(B);
+  StmtC.push_back(C);
+  StmtNext.push_back(FlatNone);
+  return StmtKinds.size() - 1;
+}
+
+FlatStmt FlatContext::append_stmt(FlatIndex Scope, StmtKind K, FlatIndex A,
+                                  FlatIndex B, FlatIndex C) {
+  FlatIndex I = add_stmt(K, A, B, C);
+  if (ScopeLasts[Scope] == FlatNone) {
+    ScopeFirsts[Scope] = I;
+  } else {
+    StmtNext[ScopeLasts[Scope]] = I;
+  }
+  ScopeLasts[Scope] = I;
+  return FlatStmt(this, I);
+}
+
+FlatIndex FlatContext::add_scope() {
+  ScopeFirsts.push_back(FlatNone);
+  ScopeLasts.push_back(FlatNone);
+  return ScopeFirsts.size() - 1;
+}
+
+void FlatContext::append_top(FlatIndex TopLevel, TopKind K, FlatIndex A) {
+  TopKinds.push_back(K);
+  TopA.push_back(A);
+  TopNext.push_back(FlatNone);
+  FlatIndex I = TopKinds.size() - 1;
+  if (TopLevelLasts[TopLevel] == FlatNone) {
+    TopLevelFirsts[TopLevel] = I;
+  } else {
+    TopNext[TopLevelLasts[TopLevel]] = I;
+  }
+  TopLevelLasts[TopLevel] = I;
+}
+
+FlatTopLevel FlatContext::add_top_level() {
+  TopLevelFirsts.push_back(FlatNone);
+  TopLevelLasts.push_back(FlatNone);
+  return FlatTopLevel(this, TopLevelFirsts.size() - 1);
+}
+
+Pointer *FlatContext::type_ptr(Type *ElmTy) {
+  if (auto P = PointerTypeMap.find(ElmTy); P != PointerTypeMap.end()) {
+    return P->second;
+  }
+  auto *Ty = new Pointer(ElmTy);
+  on_add_type(Ty);
+  PointerTypeMap[ElmTy] = Ty;
+  return Ty;
+}
+
+FlatVar FlatContext::decl_var(std::string Name, Type *T, FlatExpr Init) {
+  VarNames.push_back(add_str(Name));
+  VarTypes.push_back(add_type_index(T));
+  VarInits.push_back(Init.Id);
+  return {FlatIndex(VarNames.size() - 1)};
+}
+
+FlatExpr FlatContext::expr_raw(std::string Val) {
+  return add_expr(ExprKind::Raw, add_str(Val));
+}
+
+FlatExpr FlatContext::expr_call(FlatExpr Callee, std::vector<FlatExpr> Args) {
+  FlatIndex Offset = Extra.size();
+  for (auto A : Args) {
+    Extra.push_back(A.Id);
+  }
+  return add_expr(ExprKind::Call, Callee.Id, Offset, Args.size());
+}
+
+FlatVar FlatScope::def_var(std::string Name, Type *T, FlatExpr Init) {
+  auto D = C->decl_var(Name, T, Init);
+  stmt_decl(D);
+  return D;
+}
+
+FlatStmt FlatScope::stmt_raw(std::string Val) {
+  return C->append_stmt(Id, FlatContext::StmtKind::Raw, C->add_str(Val));
+}
+
+FlatStmt FlatScope::stmt_decl(FlatVar D) {
+  return C->append_stmt(Id, FlatContext::StmtKind::Decl, D.Id);
+}
+
+FlatStmt FlatScope::stmt_expr(FlatExpr E) {
+  return C->append_stmt(Id, FlatContext::StmtKind::Expr, E.Id);
+}
+
+FlatStmt FlatScope::stmt_if(FlatExpr Cond) {
+  return C->append_stmt(Id, FlatContext::StmtKind::If, Cond.Id,
+                        C->add_scope());
+}
+
+FlatStmt FlatScope::stmt_while(FlatExpr Cond) {
+  return C->append_stmt(Id, FlatContext::StmtKind::While, Cond.Id,
+                        C->add_scope());
+}
+
+FlatStmt FlatScope::stmt_for(FlatVar Init, FlatExpr Cond, FlatExpr Step) {
+  FlatIndex InitStmt = C->add_stmt(FlatContext::StmtKind::Decl, Init.Id);
+  FlatIndex Offset = C->Extra.size();
+  C->Extra.push_back(Cond.Id);
+  C->Extra.push_back(Step.Id);
+  return C->append_stmt(Id, FlatContext::StmtKind::For, InitStmt,
+                        C->add_scope(), Offset);
+}
+
+FlatStmt FlatScope::stmt_for(FlatExpr Init, FlatExpr Cond, FlatExpr Step) {
+  FlatIndex InitStmt = C->add_stmt(FlatContext::StmtKind::Expr, Init.Id);
+  FlatIndex Offset = C->Extra.size();
+  C->Extra.push_back(Cond.Id);
+  C->Extra.push_back(Step.Id);
+  return C->append_stmt(Id, FlatContext::StmtKind::For, InitStmt,
+                        C->add_scope(), Offset);
+}
+
+FlatStmt FlatScope::stmt_do(FlatExpr Cond) {
+  return C->append_stmt(Id, FlatContext::StmtKind::Do, Cond.Id,
+                        C->add_scope());
+}
+
+FlatStmt FlatScope::stmt_block() {
+  return C->append_stmt(Id, FlatContext::StmtKind::Block, C->add_scope());
+}
+
+FlatStmt FlatScope::stmt_return(FlatExpr Val) {
+  return C->append_stmt(Id, FlatContext::StmtKind::Return, Val.Id);
+}
+
+FlatStmt FlatScope::stmt_break() {
+  return C->append_stmt(Id, FlatContext::StmtKind::Break);
+}
+
+FlatStmt FlatScope::stmt_continue() {
+  return C->append_stmt(Id, FlatContext::StmtKind::Continue);
+}
+
+FlatStmt FlatScope::stmt_switch(FlatExpr Cond) {
+  return C->append_stmt(Id, FlatContext::StmtKind::Switch, Cond.Id);
+}
+
+FlatStmt FlatScope::stmt_assign(FlatExpr LHS, FlatExpr RHS) {
+  return stmt_expr(C->expr_binary("=", LHS, RHS));
+}
+
+FlatStmt FlatScope::stmt_call(FlatExpr Callee, std::vector<FlatExpr> Args) {
+  return stmt_expr(C->expr_call(Callee, Args));
+}
+
+FlatScope FlatStmt::get_then() {
+  assert(C->StmtKinds[Id] == FlatContext::StmtKind::If);
+  return FlatScope(C, C->StmtB[Id]);
+}
+
+FlatScope FlatStmt::add_elseif(FlatExpr Cond) {
+  assert(C->StmtKinds[Id] == FlatContext::StmtKind::If);
+  FlatIndex Scope = C->add_scope();
+  FlatIndex Clause =
+      C->add_stmt(FlatContext::StmtKind::ElseIf, Cond.Id, Scope);
+  // Insert before the else clause if any, which must be the last.
+  FlatIndex *Link = &C->StmtC[Id];
+  while (*Link != FlatNone &&
+         C->StmtKinds[*Link] != FlatContext::StmtKind::Else) {
+    Link = &C->StmtNext[*Link];
+  }
+  C->StmtNext[Clause] = *Link;
+  *Link = Clause;
+  return FlatScope(C, Scope);
+}
+
+FlatScope FlatStmt::get_or_add_else() {
+  assert(C->StmtKinds[Id] == FlatContext::StmtKind::If);
+  FlatIndex *Link = &C->StmtC[Id];
+  while (*Link != FlatNone) {
+    if (C->StmtKinds[*Link] == FlatContext::StmtKind::Else) {
+      return FlatScope(C, C->StmtB[*Link]);
+    }
+    Link = &C->StmtNext[*Link];
+  }
+  FlatIndex Scope = C->add_scope();
+  *Link = C->add_stmt(FlatContext::StmtKind::Else, FlatNone, Scope);
+  return FlatScope(C, Scope);
+}
+
+FlatScope FlatStmt::get_body() {
+  assert(C->StmtKinds[Id] == FlatContext::StmtKind::While ||
+         C->StmtKinds[Id] == FlatContext::StmtKind::For ||
+         C->StmtKinds[Id] == FlatContext::StmtKind::Do ||
+         C->StmtKinds[Id] == FlatContext::StmtKind::Case);
+  return FlatScope(C, C->StmtB[Id]);
+}
+
+FlatScope FlatStmt::get_scope() {
+  assert(C->StmtKinds[Id] == FlatContext::StmtKind::Block);
+  return FlatScope(C, C->StmtA[Id]);
+}
+
+FlatStmt FlatStmt::add_case(FlatExpr Val, bool IsFallThrough) {
+  assert(C->StmtKinds[Id] == FlatContext::StmtKind::Switch);
+  FlatIndex Case = C->add_stmt(FlatContext::StmtKind::Case, Val.Id,
+                               C->add_scope(), IsFallThrough);
+  if (C->StmtC[Id] == FlatNone) {
+    C->StmtB[Id] = Case;
+  } else {
+    C->StmtNext[C->StmtC[Id]] = Case;
+  }
+  C->StmtC[Id] = Case;
+  return FlatStmt(C, Case);
+}
+
+FlatStmt FlatStmt::add_default(bool IsFallThrough) {
+  return add_case({}, IsFallThrough);
+}
+
+FlatScope FlatFunc::get_or_add_body() {
+  if (C->FuncBodies[Id] == FlatNone) {
+    C->FuncBodies[Id] = C->add_scope();
+  }
+  return FlatScope(C, C->FuncBodies[Id]);
+}
+
+FlatFunc FlatTopLevel::def_func(std::string Name, Type *RetTy,
+                                std::vector<FlatVar> Params) {
+  C->FuncNames.push_back(C->add_str(Name));
+  C->FuncRetTypes.push_back(C->add_type_index(RetTy));
+  C->FuncParams.push_back(C->Extra.size());
+  C->FuncParamCounts.push_back(Params.size());
+  for (auto P : Params) {
+    C->Extra.push_back(P.Id);
+  }
+  C->FuncBodies.push_back(FlatNone);
+  FlatIndex I = C->FuncNames.size() - 1;
+  C->append_top(Id, FlatContext::TopKind::Func, I);
+  return FlatFunc(C, I);
+}
+
+FlatVar FlatTopLevel::def_var(std::string Name, Type *T, FlatExpr Init) {
+  auto D = C->decl_var(Name, T, Init);
+  C->append_top(Id, FlatContext::TopKind::Var, D.Id);
+  return D;
+}
+
+void FlatTopLevel::directive_raw(std::string Val) {
+  C->append_top(Id, FlatContext::TopKind::Raw, C->add_str(Val));
+}
+
+void FlatTopLevel::include(std::string Path) {
+  directive_raw("\n#include \"" + Path + "\"\n");
+}
+
+void FlatTopLevel::include_sys(std::string Path) {
+  directive_raw("\n#include <" + Path + ">\n");
+}
+
+namespace {
+bool has_comments(Emit *E) {
+  return !E->get_comment_before().empty() || !E->get_comment_after().empty();
+}
+} // namespace
+
+void FlatScope::append(FuncScope *S) {
+  C->copy_scope(*this, S);
+  C->CopiedVars = {};
+}
+
+void FlatTopLevel::append(TopLevel *T) {
+  T->materialize();
+  for (auto *E : T->entries()) {
+    if (auto *FD = cast<FuncDecl>(E); FD && C->copy_func(*this, FD)) {
+      continue;
+    }
+    std::optional<FlatVar> V;
+    if (auto *S = cast<DeclStmt>(E); S && !has_comments(S)) {
+      V = C->copy_var_def(S->get_decl());
+    }
+    if (V) {
+      C->append_top(Id, FlatContext::TopKind::Var, V->Id);
+      continue;
+    }
+    directive_raw(E->to_string());
+  }
+  C->CopiedVars = {};
+}
+
+FlatExpr FlatContext::copy_expr(Expr *E) {
+  if (!E) {
+    return {};
+  }
+  if (has_comments(E)) {
+    return expr_raw(E->to_string());
+  }
+  switch (E->get_kind()) {
+  case namec::ExprKind::Variable:
+    return expr_var(copy_var_ref(static_cast<VariableExpr *>(E)->get_decl()));
+  case namec::ExprKind::UnaryOp: {
+    auto *U = static_cast<UnaryOp *>(E);
+    auto Operand = copy_expr(U->get_operand());
+    return U->is_prefix() ? expr_pre_unary(U->get_op(), Operand)
+                          : expr_post_unary(U->get_op(), Operand);
+  }
+  case namec::ExprKind::BinaryOp: {
+    auto *B = static_cast<BinaryOp *>(E);
+    auto LHS = copy_expr(B->get_lhs());
+    return expr_binary(B->get_op(), LHS, copy_expr(B->get_rhs()));
+  }
+  case namec::ExprKind::TernaryOp: {
+    auto *T = static_cast<TernaryOp *>(E);
+    auto Cond = copy_expr(T->get_cond());
+    auto Then = copy_expr(T->get_then());
+    return expr_ternary(Cond, Then, copy_expr(T->get_else()));
+  }
+  case namec::ExprKind::Subscript: {
+    auto *S = static_cast<SubscriptExpr *>(E);
+    auto Array = copy_expr(S->get_array());
+    return expr_subscr(Array, copy_expr(S->get_index()));
+  }
+  case namec::ExprKind::Call: {
+    auto *Call = static_cast<CallExpr *>(E);
+    auto Callee = copy_expr(Call->get_callee());
+    std::vector<FlatExpr> Args;
+    for (auto *A : Call->args()) {
+      Args.push_back(copy_expr(A));
+    }
+    return expr_call(Callee, Args);
+  }
+  case namec::ExprKind::Cast: {
+    auto *Cast = static_cast<CastExpr *>(E);
+    return expr_cast(copy_type(Cast->get_type()),
+                     copy_expr(Cast->get_operand()));
+  }
+  case namec::ExprKind::Paren:
+    return expr_paren(copy_expr(static_cast<ParenExpr *>(E)->get_inside()));
+  default:
+    // Raw and literals, and the ones not in the subset.
+    return expr_raw(E->to_string());
+  }
+}
+
+// The variable referred by a VariableExpr, whose name is all emitted.
+FlatVar FlatContext::copy_var_ref(VarDecl *D) {
+  if (auto It = CopiedVars.find(D); It != CopiedVars.end()) {
+    return {It->second};
+  }
+  auto V = decl_var(D->get_name(), copy_type(D->get_type()));
+  CopiedVars[D] = V.Id;
+  return V;
+}
+
+// The copy of D if it is a variable without qualifiers nor attributes.
+std::optional<FlatVar> FlatContext::copy_var_def(Decl *D) {
+  if (D->get_kind() != DeclKind::Var || has_comments(D)) {
+    return std::nullopt;
+  }
+  auto *V = static_cast<VarDecl *>(D);
+  if (V->is_const() || V->is_extern() || V->is_static() || V->is_volatile() ||
+      V->is_restrict() || !V->attrs().empty()) {
+    return std::nullopt;
+  }
+  auto Init = copy_expr(V->get_init());
+  auto Copy = decl_var(V->get_name(), copy_type(V->get_type()), Init);
+  CopiedVars[V] = Copy.Id;
+  return Copy;
+}
+
+void FlatContext::copy_stmt(FlatScope S, ScopeEntry *E) {
+  auto *St = cast<Stmt>(E);
+  if (!St || has_comments(St)) {
+    S.stmt_raw(E->to_string());
+    return;
+  }
+  switch (St->get_kind()) {
+  case namec::StmtKind::Decl:
+    if (auto V = copy_var_def(static_cast<DeclStmt *>(St)->get_decl())) {
+      S.stmt_decl(*V);
+      return;
+    }
+    break;
+  case namec::StmtKind::Expr:
+    S.stmt_expr(copy_expr(static_cast<ExprStmt *>(St)->get_expr()));
+    return;
+  case namec::StmtKind::Return:
+    S.stmt_return(copy_expr(static_cast<ReturnStmt *>(St)->get_expr()));
+    return;
+  case namec::StmtKind::Break:
+    S.stmt_break();
+    return;
+  case namec::StmtKind::Continue:
+    S.stmt_continue();
+    return;
+  case namec::StmtKind::Block: {
+    auto Block = S.stmt_block();
+    copy_scope(Block.get_scope(), static_cast<BlockStmt *>(St)->get_scope());
+    return;
+  }
+  case namec::StmtKind::If: {
+    auto *If = static_cast<IfStmt *>(St);
+    bool IsPlain = If->get_likelihood() == Likelihood::None;
+    auto Elseifs = If->elseifs();
+    size_t Size = std::distance(Elseifs.begin(), Elseifs.end());
+    for (size_t I = 0; I < Size; ++I) {
+      IsPlain &= If->get_elseif_likelihood(I) == Likelihood::None;
+    }
+    if (!IsPlain) {
+      break;
+    }
+    auto Copy = S.stmt_if(copy_expr(If->get_cond()));
+    copy_scope(Copy.get_then(), If->get_then());
+    for (auto &[Cond, Body] : If->elseifs()) {
+      copy_scope(Copy.add_elseif(copy_expr(Cond)), Body);
+    }
+    if (If->has_else()) {
+      copy_scope(Copy.get_or_add_else(), If->get_else());
+    }
+    return;
+  }
+  case namec::StmtKind::While: {
+    auto *W = static_cast<WhileStmt *>(St);
+    if (W->get_likelihood() != Likelihood::None) {
+      break;
+    }
+    copy_scope(S.stmt_while(copy_expr(W->get_cond())).get_body(),
+               W->get_body());
+    return;
+  }
+  case namec::StmtKind::Do: {
+    auto *D = static_cast<DoStmt *>(St);
+    if (D->get_likelihood() != Likelihood::None) {
+      break;
+    }
+    copy_scope(S.stmt_do(copy_expr(D->get_cond())).get_body(), D->get_body());
+    return;
+  }
+  case namec::StmtKind::For: {
+    auto *F = static_cast<ForStmt *>(St);
+    auto *Init = F->get_init();
+    if (F->get_likelihood() != Likelihood::None || !Init ||
+        has_comments(Init)) {
+      break;
+    }
+    std::optional<FlatStmt> Copy;
+    if (Init->get_kind() == namec::StmtKind::Expr) {
+      auto InitExpr = copy_expr(static_cast<ExprStmt *>(Init)->get_expr());
+      auto Cond = copy_expr(F->get_cond());
+      Copy = S.stmt_for(InitExpr, Cond, copy_expr(F->get_step()));
+    } else if (Init->get_kind() == namec::StmtKind::Decl) {
+      auto V = copy_var_def(static_cast<DeclStmt *>(Init)->get_decl());
+      if (!V) {
+        break;
+      }
+      auto Cond = copy_expr(F->get_cond());
+      Copy = S.stmt_for(*V, Cond, copy_expr(F->get_step()));
+    } else {
+      break;
+    }
+    copy_scope(Copy->get_body(), F->get_body());
+    return;
+  }
+  case namec::StmtKind::Switch: {
+    auto *Sw = static_cast<SwitchStmt *>(St);
+    bool IsPlain = true;
+    for (auto &Case : Sw->cases()) {
+      IsPlain &= Case.get_likelihood() == Likelihood::None &&
+                 !has_comments(&Case);
+    }
+    if (!IsPlain) {
+      break;
+    }
+    auto Copy = S.stmt_switch(copy_expr(Sw->get_cond()));
+    for (auto &Case : Sw->cases()) {
+      auto CaseCopy =
+          Copy.add_case(copy_expr(Case.get_val()), Case.is_fall_through());
+      copy_scope(CaseCopy.get_body(), Case.get_body());
+    }
+    return;
+  }
+  default:
+    break;
+  }
+  S.stmt_raw(St->to_string());
+}
+
+void FlatContext::copy_scope(FlatScope S, FuncScope *From) {
+  for (auto *E : From->entries()) {
+    copy_stmt(S, E);
+  }
+}
+
+// Copy FD if it is a plain function. Returns false otherwise.
+bool FlatContext::copy_func(FlatTopLevel T, FuncDecl *FD) {
+  if (FD->get_kind() != DeclKind::Func || has_comments(FD) ||
+      FD->is_static() || FD->is_extern() || FD->is_vararg() ||
+      !FD->get_alias().empty() || !FD->attrs().empty()) {
+    return false;
+  }
+  for (auto *P : FD->params()) {
+    if (P->get_kind() != DeclKind::Var || has_comments(P) || P->get_init() ||
+        P->is_const() || P->is_volatile() || P->is_restrict() ||
+        P->is_static() || P->is_extern() || !P->attrs().empty()) {
+      return false;
+    }
+  }
+  std::vector<FlatVar> Params;
+  for (auto *P : FD->params()) {
+    auto Param = copy_var_def(P);
+    if (!Param) {
+      return false;
+    }
+    Params.push_back(*Param);
+  }
+  auto Copy = T.def_func(FD->get_name(), copy_type(FD->get_ret_type()),
+                         Params);
+  if (FD->get_body()) {
+    copy_scope(Copy.get_or_add_body(), FD->get_body());
+  }
+  return true;
+}
+
+void FlatContext::emit_expr(std::ostream &SS, FlatIndex I) {
+  switch (ExprKinds[I]) {
+  case ExprKind::Raw:
+    SS << get_str(ExprA[I]);
+    break;
+  case ExprKind::Var:
+    SS << get_str(VarNames[ExprA[I]]);
+    break;
+  case ExprKind::PreUnary:
+    SS << get_str(ExprA[I]);
+    emit_expr(SS, ExprB[I]);
+    break;
+  case ExprKind::PostUnary:
+    emit_expr(SS, ExprB[I]);
+    SS << get_str(ExprA[I]);
+    break;
+  case ExprKind::Binary:
+    emit_expr(SS, ExprB[I]);
+    SS << get_str(ExprA[I]);
+    emit_expr(SS, ExprC[I]);
+    break;
+  case ExprKind::Ternary:
+    emit_expr(SS, ExprA[I]);
+    SS << "?";
+    emit_expr(SS, ExprB[I]);
+    SS << ":";
+    emit_expr(SS, ExprC[I]);
+    break;
+  case ExprKind::Subscript:
+    emit_expr(SS, ExprA[I]);
+    SS << "[";
+    emit_expr(SS, ExprB[I]);
+    SS << "]";
+    break;
+  case ExprKind::Call:
+    emit_expr(SS, ExprA[I]);
+    SS << "(";
+    for (FlatIndex J = 0; J < ExprC[I]; ++J) {
+      if (J) {
+        SS << ",";
+      }
+      emit_expr(SS, Extra[ExprB[I] + J]);
+    }
+    SS << ")";
+    break;
+  case ExprKind::Cast:
+    SS << "(" << TypeTable[ExprA[I]] << ")";
+    emit_expr(SS, ExprB[I]);
+    break;
+  case ExprKind::Paren:
+    SS << "(";
+    emit_expr(SS, ExprA[I]);
+    SS << ")";
+    break;
+  }
+}
+
+void FlatContext::emit_var(std::ostream &SS, FlatIndex I) {
+  SS << TypeTable[VarTypes[I]];
+  auto Name = get_str(VarNames[I]);
+  if (Name.size() > 0) {
+    SS << " " << Name;
+  }
+  if (VarInits[I] != FlatNone) {
+    SS << "=";
+    emit_expr(SS, VarInits[I]);
+  }
+}
+
+void FlatContext::emit_stmt(std::ostream &SS, FlatIndex I) {
+  switch (StmtKinds[I]) {
+  case StmtKind::Raw:
+    SS << get_str(StmtA[I]);
+    break;
+  case StmtKind::Decl:
+    emit_var(SS, StmtA[I]);
+    SS << ";";
+    break;
+  case StmtKind::Expr:
+    emit_expr(SS, StmtA[I]);
+    SS << ";";
+    break;
+  case StmtKind::If:
+    SS << "if(";
+    emit_expr(SS, StmtA[I]);
+    SS << "){";
+    emit_scope(SS, StmtB[I]);
+    SS << "}";
+    for (FlatIndex J = StmtC[I]; J != FlatNone; J = StmtNext[J]) {
+      emit_stmt(SS, J);
+    }
+    break;
+  case StmtKind::ElseIf:
+    SS << "else if(";
+    emit_expr(SS, StmtA[I]);
+    SS << "){";
+    emit_scope(SS, StmtB[I]);
+    SS << "}";
+    break;
+  case StmtKind::Else:
+    SS << "else{";
+    emit_scope(SS, StmtB[I]);
+    SS << "}";
+    break;
+  case StmtKind::While:
+    SS << "while(";
+    emit_expr(SS, StmtA[I]);
+    SS << "){";
+    emit_scope(SS, StmtB[I]);
+    SS << "}";
+    break;
+  case StmtKind::For: {
+    SS << "for(";
+    if (StmtA[I] != FlatNone) {
+      emit_stmt(SS, StmtA[I]);
+    } else {
+      SS << ";";
+    }
+    FlatIndex Cond = Extra[StmtC[I]], Step = Extra[StmtC[I] + 1];
+    if (Cond != FlatNone) {
+      emit_expr(SS, Cond);
+    }
+    SS << ";";
+    if (Step != FlatNone) {
+      emit_expr(SS, Step);
+    }
+    SS << "){";
+    emit_scope(SS, StmtB[I]);
+    SS << "}";
+    break;
+  }
+  case StmtKind::Do:
+    SS << "do{";
+    emit_scope(SS, StmtB[I]);
+    SS << "}while(";
+    emit_expr(SS, StmtA[I]);
+    SS << ")";
+    break;
+  case StmtKind::Block:
+    SS << "{";
+    emit_scope(SS, StmtA[I]);
+    SS << "}";
+    break;
+  case StmtKind::Return:
+    SS << "return";
+    if (StmtA[I] != FlatNone) {
+      SS << " ";
+      emit_expr(SS, StmtA[I]);
+    }
+    SS << ";";
+    break;
+  case StmtKind::Break:
+    SS << "break;";
+    break;
+  case StmtKind::Continue:
+    SS << "continue;";
+    break;
+  case StmtKind::Switch:
+    SS << "switch(";
+    emit_expr(SS, StmtA[I]);
+    SS << "){";
+    for (FlatIndex J = StmtB[I]; J != FlatNone; J = StmtNext[J]) {
+      emit_stmt(SS, J);
+    }
+    SS << "}";
+    break;
+  case StmtKind::Case:
+    if (StmtA[I] != FlatNone) {
+      SS << "case ";
+      emit_expr(SS, StmtA[I]);
+      SS << ":";
+    } else {
+      SS << "default:";
+    }
+    emit_scope(SS, StmtB[I]);
+    if (!StmtC[I]) {
+      SS << "break;";
+    }
+    break;
+  }
+}
+
+void FlatContext::emit_scope(std::ostream &SS, FlatIndex I) {
+  for (FlatIndex J = ScopeFirsts[I]; J != FlatNone; J = StmtNext[J]) {
+    emit_stmt(SS, J);
+  }
+}
+
+void FlatContext::emit_func(std::ostream &SS, FlatIndex I) {
+  SS << TypeTable[FuncRetTypes[I]] << " " << get_str(FuncNames[I]) << "(";
+  for (FlatIndex J = 0; J < FuncParamCounts[I]; ++J) {
+    if (J) {
+      SS << ",";
+    }
+    emit_var(SS, Extra[FuncParams[I] + J]);
+  }
+  SS << ")";
+  if (FuncBodies[I] != FlatNone) {
+    SS << "{";
+    emit_scope(SS, FuncBodies[I]);
+    SS << "}";
+  } else {
+    SS << ";";
+  }
+}
+
+void FlatContext::emit(std::ostream &SS) {
+  for (FlatIndex T = 0; T < TopLevelFirsts.size(); ++T) {
+    for (FlatIndex J = TopLevelFirsts[T]; J != FlatNone; J = TopNext[J]) {
+      switch (TopKinds[J]) {
+      case TopKind::Raw:
+        SS << get_str(TopA[J]);
+        break;
+      case TopKind::Func:
+        emit_func(SS, TopA[J]);
+        break;
+      case TopKind::Var:
+        emit_var(SS, TopA[J]);
+        SS << ";";
+        break;
+      }
+      SS << "\n";
+    }
+    SS << "\n";
+  }
+}
+
+std::string FlatContext::to_string() {
+  std::stringstream SS;
+  emit(SS);
+  return SS.str();
+}
+
+template <typename T> static size_t bytes_of(const std::vector<T> &V) {
+  return V.capacity() * sizeof(T);
+}
+
+// The bytes beyond the small string buffer.
+static size_t bytes_of(const std::string &S) {
+  return S.capacity() > std::string().capacity() ? S.capacity() + 1 : 0;
+}
+
+// A node of std::unordered_map has the next pointer and the hash, and the
+// bucket array has a pointer per bucket.
+template <typename K, typename V>
+static size_t bytes_of(const std::unordered_map<K, V> &M) {
+  using Value = typename std::unordered_map<K, V>::value_type;
+  return M.size() * (sizeof(Value) + 2 * sizeof(void *)) +
+         M.bucket_count() * sizeof(void *);
+}
+
+// A node of std::map has the parent, the children and the color, padded.
+template <typename V>
+constexpr size_t TreeNodeBytes = sizeof(V) + 4 * sizeof(void *);
+
+size_t FlatContext::get_memory_usage() {
+  size_t Bytes = bytes_of(StrMap) + bytes_of(TypeMap) + bytes_of(OwnedTypes) +
+                 PointerTypeMap.size() *
+                     TreeNodeBytes<decltype(PointerTypeMap)::value_type>;
+  for (auto &[S, I] : StrMap) {
+    Bytes += bytes_of(S);
+  }
+  for (auto &T : OwnedTypes) {
+    if (auto *R = cast<RawType>(T.get())) {
+      // With the entry of the map interning it.
+      auto Val = R->get_val();
+      Bytes += sizeof(RawType) + 2 * bytes_of(Val) +
+               TreeNodeBytes<std::pair<const std::string, RawType *>>;
+    } else {
+      // Only the pointers are made other than the raw types.
+      Bytes += sizeof(Pointer);
+    }
+  }
+  return Bytes + Chars.capacity() + bytes_of(StrBegins) + bytes_of(TypeTable) +
+         bytes_of(ExprKinds) + bytes_of(ExprA) + bytes_of(ExprB) +
+         bytes_of(ExprC) + bytes_of(VarNames) + bytes_of(VarTypes) +
+         bytes_of(VarInits) + bytes_of(StmtKinds) + bytes_of(StmtA) +
+         bytes_of(StmtB) + bytes_of(StmtC) + bytes_of(StmtNext) +
+         bytes_of(ScopeFirsts) + bytes_of(ScopeLasts) + bytes_of(FuncNames) +
+         bytes_of(FuncRetTypes) + bytes_of(FuncParams) +
+         bytes_of(FuncParamCounts) + bytes_of(FuncBodies) +
+         bytes_of(TopKinds) + bytes_of(TopA) + bytes_of(TopNext) +
+         bytes_of(TopLevelFirsts) + bytes_of(TopLevelLasts) +
+         bytes_of(Extra);
+}
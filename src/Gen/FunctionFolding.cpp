@@ -0,0 +1,124 @@
+#include "internal/Gen.h"
+
+#include <unordered_map>
+
+using namespace namec;
+
+namespace {
+// Hash of the function except its name. The attributes are included, since
+// such as target or section makes a different function from the same body.
+Hash128 hash_definition(StructuralHasher &H, FuncDecl *FD) {
+  Hash128Builder B;
+  B.add(H.hash(FD->get_ret_type())).add(FD->is_vararg());
+  B.add(StructuralHasher::hash_attrs(*FD));
+  for (auto *P : FD->params()) {
+    B.add(H.hash(P));
+  }
+  return B.add(H.hash(FD->get_body())).get();
+}
+
+// Finds a static local, which the folded functions would share.
+class StaticLocalFinder : public RecursiveVisitor<StaticLocalFinder> {
+public:
+  bool visit_decl(Decl *D) {
+    auto *V = cast<VarDecl>(D);
+    return !V || !V->is_static();
+  }
+};
+
+bool has_static_local(FuncDecl *FD) {
+  return !StaticLocalFinder().traverse_func_scope(FD->get_body());
+}
+
+// Counts the declarations of each function name, including the prototypes.
+class FuncDeclCounter : public RecursiveVisitor<FuncDeclCounter> {
+public:
+  std::unordered_map<std::string, size_t> Counts;
+  bool visit_decl(Decl *D) {
+    if (cast<FuncDecl>(D) || cast<FuncSplitForwardDecl>(D)) {
+      Counts[D->get_name()]++;
+    }
+    return true;
+  }
+};
+
+// The arguments to forward the parameters, or false if not possible.
+bool forwarding_args(Context &C, FuncDecl *FD, std::vector<Expr *> &Args) {
+  if (FD->is_vararg()) {
+    return false;
+  }
+  for (auto *P : FD->params()) {
+    if (P->get_name().empty()) {
+      // Only f(void) is allowed without the names.
+      if (!cast<Void>(P->get_type()) || FD->get_params().size() != 1) {
+        return false;
+      }
+      continue;
+    }
+    Args.push_back(C.expr_var(P));
+  }
+  return true;
+}
+
+bool fold(Context &C, TopLevel &T, FuncDecl *FD, FuncDecl *Kept,
+          FoldMode Mode, const FuncDeclCounter &Decls) {
+  switch (Mode) {
+  case FoldMode::Forward: {
+    std::vector<Expr *> Args;
+    if (!forwarding_args(C, FD, Args)) {
+      return false;
+    }
+    auto *Call = C.expr_call(C.expr_raw(Kept->get_name()), Args);
+    auto *Body = FD->replace_body();
+    if (cast<Void>(FD->get_ret_type())) {
+      Body->stmt_expr(Call);
+    } else {
+      Body->stmt_return(Call);
+    }
+    return true;
+  }
+  case FoldMode::Alias:
+    FD->set_alias(Kept->get_name());
+    return true;
+  case FoldMode::Define:
+    if (FD->is_split_definition()) {
+      return false;
+    }
+    // The macro removes the external symbol other files may call, and leaves
+    // the other declarations without the definition.
+    if (!FD->is_static() || Decls.Counts.at(FD->get_name()) != 1) {
+      return fold(C, T, FD, Kept, FoldMode::Forward, Decls);
+    }
+    return T.replace(FD,
+                     std::make_unique<Define>(FD->get_name(), Kept->get_name()));
+  }
+  return false;
+}
+} // namespace
+
+FoldStats namec::fold_identical_functions(Context &C, CFile &F,
+                                          FoldMode Mode) {
+  FoldStats Stats;
+  StructuralHasher H;
+  std::unordered_map<Hash128, FuncDecl *, Hash128Hash> Kept;
+  FuncDeclCounter Decls;
+  if (Mode == FoldMode::Define) {
+    Decls.traverse_file(&F);
+  }
+  for (auto &T : F.top_levels()) {
+    // Copied since folding may replace the entries.
+    std::vector<Emit *> Entries(T.entries().begin(), T.entries().end());
+    for (auto *E : Entries) {
+      auto *FD = cast<FuncDecl>(E);
+      if (!FD || !FD->get_body() || has_static_local(FD)) {
+        continue;
+      }
+      Stats.Functions++;
+      auto [It, IsNew] = Kept.emplace(hash_definition(H, FD), FD);
+      if (!IsNew && fold(C, T, FD, It->second, Mode, Decls)) {
+        Stats.Folded++;
+      }
+    }
+  }
+  return Stats;
+}
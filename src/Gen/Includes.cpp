@@ -0,0 +1,39 @@
+#include "internal/Gen.h"
+#include "internal/Util/IncludeScanner.h"
+
+using namespace namec;
+
+namespace {
+using Scanner =
+    IncludeScanner<TopLevel, IfDirectiveBase, Include, SystemInclude>;
+} // namespace
+
+size_t namec::dedup_includes(CFile &F,
+                             const std::vector<std::string> &Repeatable) {
+  Scanner S(Repeatable);
+  std::unordered_set<std::string> Seen;
+  size_t Removed = 0;
+  for (auto &T : F.top_levels()) {
+    Removed += S.dedup(&T, Seen);
+  }
+  return Removed;
+}
+
+PrecompiledHeader namec::extract_common_includes(
+    const std::vector<CFile *> &Files, size_t MinFiles,
+    const std::string &Name) {
+  std::vector<std::vector<std::string>> PerFile;
+  for (auto *F : Files) {
+    // The includes before any other entry in the top-levels of F.
+    auto &Includes = PerFile.emplace_back();
+    for (auto &T : F->top_levels()) {
+      if (!Scanner::add_leading(&T, Includes)) {
+        break;
+      }
+    }
+  }
+  auto Common = select_common_includes(PerFile, MinFiles);
+  auto Skipped = select_skipped_files(PerFile, Common);
+  return PrecompiledHeader(Name, ".h", ".c", std::move(Common),
+                           std::move(Skipped));
+}
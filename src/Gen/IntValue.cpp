@@ -0,0 +1,294 @@
+#include "internal/Gen.h"
+
+#include <cctype>
+#include <iterator>
+#include <limits>
+
+using namespace namec;
+
+namespace {
+unsigned rank(IntKind K) {
+  switch (K) {
+  case IntKind::Int:
+  case IntKind::UInt:
+    return 0;
+  case IntKind::Long:
+  case IntKind::ULong:
+    return 1;
+  default:
+    return 2;
+  }
+}
+
+IntKind to_unsigned(IntKind K) {
+  switch (K) {
+  case IntKind::Int:
+    return IntKind::UInt;
+  case IntKind::Long:
+    return IntKind::ULong;
+  case IntKind::LLong:
+    return IntKind::ULLong;
+  default:
+    return K;
+  }
+}
+
+const char *suffix(IntKind K) {
+  switch (K) {
+  case IntKind::Int:
+    return "";
+  case IntKind::UInt:
+    return "u";
+  case IntKind::Long:
+    return "l";
+  case IntKind::ULong:
+    return "ul";
+  case IntKind::LLong:
+    return "ll";
+  default:
+    return "ull";
+  }
+}
+
+// Signed arithmetic in the width of K, failing on overflow. The operands are
+// checked against the limits before the operation, so nothing overflows.
+template <typename T>
+std::optional<IntValue> eval_signed(const std::string &Op, IntKind K, T L,
+                                    T R) {
+  constexpr T Min = std::numeric_limits<T>::min();
+  constexpr T Max = std::numeric_limits<T>::max();
+  bool Overflow;
+  if (Op == "+") {
+    Overflow = R > 0 ? L > Max - R : L < Min - R;
+  } else if (Op == "-") {
+    Overflow = R < 0 ? L > Max + R : L < Min + R;
+  } else if (Op == "*") {
+    if (L == 0 || R == 0) {
+      Overflow = false;
+    } else if (L > 0) {
+      Overflow = R > 0 ? L > Max / R : R < Min / L;
+    } else {
+      Overflow = R > 0 ? L < Min / R : L < Max / R;
+    }
+  } else {
+    // Division by zero is checked by the caller.
+    Overflow = R == -1 && L == Min;
+  }
+  if (Overflow) {
+    return std::nullopt;
+  }
+  T Result = Op == "+"   ? L + R
+             : Op == "-" ? L - R
+             : Op == "*" ? L * R
+             : Op == "/" ? L / R
+                         : L % R;
+  return IntValue(K, static_cast<uint64_t>(static_cast<int64_t>(Result)));
+}
+
+std::optional<IntValue> eval_shift(const std::string &Op, IntValue L,
+                                   IntValue R) {
+  // The result has the type of the left operand, which needs no promotion.
+  if (R.is_negative() || R.get_bits() >= L.width()) {
+    return std::nullopt;
+  }
+  unsigned N = static_cast<unsigned>(R.get_bits());
+  if (!L.is_signed()) {
+    return IntValue(L.get_kind(),
+                    Op == "<<" ? L.get_bits() << N : L.get_bits() >> N);
+  }
+  // Shifting negative values is undefined or implementation-defined, and
+  // so is shifting a bit into the sign bit.
+  if (L.is_negative() ||
+      (Op == "<<" && (L.get_bits() >> (L.width() - 1 - N)) != 0)) {
+    return std::nullopt;
+  }
+  return IntValue(L.get_kind(),
+                  Op == "<<" ? L.get_bits() << N : L.get_bits() >> N);
+}
+} // namespace
+
+IntKind IntValue::common_kind(IntKind L, IntKind R) {
+  if (is_signed(L) == is_signed(R)) {
+    return rank(L) >= rank(R) ? L : R;
+  }
+  IntKind S = is_signed(L) ? L : R;
+  IntKind U = is_signed(L) ? R : L;
+  if (rank(U) >= rank(S)) {
+    return U;
+  }
+  // The signed type can represent all the values of the unsigned type.
+  if (width(S) > width(U)) {
+    return S;
+  }
+  return to_unsigned(S);
+}
+
+int64_t IntValue::get_signed() const {
+  if (width() == 32) {
+    return static_cast<int32_t>(static_cast<uint32_t>(Bits));
+  }
+  return static_cast<int64_t>(Bits);
+}
+
+bool IntValue::is_min() const {
+  return is_signed() && Bits == uint64_t(1) << (width() - 1);
+}
+
+IntValue IntValue::convert(IntKind To) const {
+  return IntValue(To, is_signed() ? static_cast<uint64_t>(get_signed()) : Bits);
+}
+
+std::string IntValue::to_string() const {
+  if (!is_signed()) {
+    return std::to_string(Bits) + suffix(Kind);
+  }
+  // -2147483648 is the negation of the long 2147483648, not an int.
+  if (is_min()) {
+    return "(-" + std::to_string(-(get_signed() + 1)) + suffix(Kind) + "-1)";
+  }
+  return std::to_string(get_signed()) + suffix(Kind);
+}
+
+std::optional<IntValue> namec::eval_unary(const std::string &Op, IntValue V) {
+  // Every kind has the rank of int or more, so no promotion is needed.
+  if (Op == "+") {
+    return V;
+  }
+  if (Op == "-") {
+    if (V.is_min()) {
+      return std::nullopt;
+    }
+    return IntValue(V.get_kind(), 0 - V.get_bits());
+  }
+  if (Op == "~") {
+    return IntValue(V.get_kind(), ~V.get_bits());
+  }
+  if (Op == "!") {
+    return IntValue::of_bool(V.is_zero());
+  }
+  return std::nullopt;
+}
+
+std::optional<IntValue> namec::eval_binary(const std::string &Op, IntValue L,
+                                           IntValue R) {
+  if (Op == "&&") {
+    return IntValue::of_bool(!L.is_zero() && !R.is_zero());
+  }
+  if (Op == "||") {
+    return IntValue::of_bool(!L.is_zero() || !R.is_zero());
+  }
+  if (Op == "<<" || Op == ">>") {
+    return eval_shift(Op, L, R);
+  }
+  IntKind K = IntValue::common_kind(L.get_kind(), R.get_kind());
+  L = L.convert(K);
+  R = R.convert(K);
+  bool IsSigned = L.is_signed();
+  uint64_t A = L.get_bits(), B = R.get_bits();
+  if (Op == "==" || Op == "!=") {
+    return IntValue::of_bool((A == B) == (Op == "=="));
+  }
+  if (Op == "<" || Op == ">" || Op == "<=" || Op == ">=") {
+    int Cmp = IsSigned ? (L.get_signed() > R.get_signed()) -
+                             (L.get_signed() < R.get_signed())
+                       : (A > B) - (A < B);
+    bool Result = Op == "<"    ? Cmp < 0
+                  : Op == ">"  ? Cmp > 0
+                  : Op == "<=" ? Cmp <= 0
+                               : Cmp >= 0;
+    return IntValue::of_bool(Result);
+  }
+  if (Op == "&") {
+    return IntValue(K, A & B);
+  }
+  if (Op == "|") {
+    return IntValue(K, A | B);
+  }
+  if (Op == "^") {
+    return IntValue(K, A ^ B);
+  }
+  bool IsDiv = Op == "/" || Op == "%";
+  if (!IsDiv && Op != "+" && Op != "-" && Op != "*") {
+    return std::nullopt;
+  }
+  if (IsDiv && B == 0) {
+    return std::nullopt;
+  }
+  if (IsSigned) {
+    if (L.width() == 32) {
+      return eval_signed<int32_t>(Op, K, L.get_signed(), R.get_signed());
+    }
+    return eval_signed<int64_t>(Op, K, L.get_signed(), R.get_signed());
+  }
+  // Unsigned arithmetic wraps around.
+  if (Op == "+") {
+    return IntValue(K, A + B);
+  }
+  if (Op == "-") {
+    return IntValue(K, A - B);
+  }
+  if (Op == "*") {
+    return IntValue(K, A * B);
+  }
+  return IntValue(K, Op == "/" ? A / B : A % B);
+}
+
+std::optional<IntValue> namec::parse_int_literal(std::string_view Text) {
+  unsigned Base = 10;
+  size_t I = 0;
+  if (Text.size() > 1 && Text[0] == '0') {
+    bool IsHex = Text[1] == 'x' || Text[1] == 'X';
+    Base = IsHex ? 16 : 8;
+    I = IsHex ? 2 : 1;
+  }
+  size_t Begin = I;
+  uint64_t Value = 0;
+  for (; I < Text.size(); ++I) {
+    auto C = static_cast<unsigned char>(Text[I]);
+    unsigned Digit;
+    if (std::isdigit(C)) {
+      Digit = C - '0';
+    } else if (Base == 16 && std::isxdigit(C)) {
+      Digit = std::tolower(C) - 'a' + 10;
+    } else {
+      break;
+    }
+    if (Digit >= Base || Value > (UINT64_MAX - Digit) / Base) {
+      return std::nullopt;
+    }
+    Value = Value * Base + Digit;
+  }
+  if (I == Begin && Base != 8) {
+    return std::nullopt;
+  }
+
+  std::string Suffix;
+  for (char C : Text.substr(I)) {
+    Suffix += std::tolower(static_cast<unsigned char>(C));
+  }
+  bool IsUnsigned = false;
+  if (!Suffix.empty() && Suffix.front() == 'u') {
+    IsUnsigned = true;
+    Suffix.erase(0, 1);
+  } else if (!Suffix.empty() && Suffix.back() == 'u') {
+    IsUnsigned = true;
+    Suffix.pop_back();
+  }
+  if (Suffix != "" && Suffix != "l" && Suffix != "ll") {
+    return std::nullopt;
+  }
+  const IntKind Kinds[] = {IntKind::Int,  IntKind::UInt,  IntKind::Long,
+                           IntKind::ULong, IntKind::LLong, IntKind::ULLong};
+  // Decimal literals without u never become unsigned.
+  for (size_t K = Suffix.size() * 2; K < std::size(Kinds); ++K) {
+    bool IsSigned = IntValue::is_signed(Kinds[K]);
+    if ((IsUnsigned && IsSigned) || (!IsUnsigned && !IsSigned && Base == 10)) {
+      continue;
+    }
+    unsigned Bits = IntValue::width(Kinds[K]) - IsSigned;
+    if (Bits == 64 || Value >> Bits == 0) {
+      return IntValue(Kinds[K], Value);
+    }
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,258 @@
+#include "internal/Gen.h"
+
+#include <algorithm>
+#include <map>
+#include <unordered_set>
+
+using namespace namec;
+
+namespace {
+enum class Temperature { Neutral, Hot, Cold };
+
+// The entries other than declarations may change the meaning of the code
+// after them.
+bool is_barrier(Emit *E) {
+  if (cast<DeclStmt>(E)) {
+    return false;
+  }
+  auto *D = cast<Decl>(E);
+  return !D || cast<RawDecl>(D);
+}
+
+bool is_definition(FuncDecl *FD) {
+  return !FD->is_forward() && FD->get_alias().empty();
+}
+
+class FunctionLayout {
+  const FunctionHeat &Heat;
+  const LayoutOptions &Opts;
+  // The definitions in the order of the top-levels.
+  std::vector<FuncDecl *> Functions;
+  std::unordered_map<FuncDecl *, size_t> Rank;
+  std::unordered_map<FuncDecl *, Temperature> Temperatures;
+  // The position of each hot function in the layout.
+  std::unordered_map<FuncDecl *, size_t> HotOrder;
+
+  uint64_t heat_of(FuncDecl *FD) {
+    if (auto It = Heat.find(FD); It != Heat.end()) {
+      return It->second;
+    }
+    return Temperatures[FD] == Temperature::Hot ? Opts.HotThreshold : 0;
+  }
+
+  Temperature classify(FuncDecl *FD) {
+    if (auto It = Heat.find(FD); It != Heat.end()) {
+      if (It->second >= Opts.HotThreshold) {
+        return Temperature::Hot;
+      }
+      return It->second == 0 ? Temperature::Cold : Temperature::Neutral;
+    }
+    if (FD->get_attr(AttributeKind::Hot)) {
+      return Temperature::Hot;
+    }
+    if (FD->get_attr(AttributeKind::Cold)) {
+      return Temperature::Cold;
+    }
+    return Temperature::Neutral;
+  }
+
+  void mark(FuncDecl *FD, Temperature T) {
+    bool IsHot = T == Temperature::Hot;
+    if (Opts.IsMarkHotCold) {
+      FD->remove_attr(IsHot ? AttributeKind::Cold : AttributeKind::Hot);
+      FD->add_attr(IsHot ? Attribute::hot() : Attribute::cold());
+    }
+    auto &Section = IsHot ? Opts.HotSection : Opts.ColdSection;
+    if (!Section.empty()) {
+      FD->add_attr(Attribute::section(Section));
+    }
+  }
+
+  // Pettis-Hansen: merge the chains of the heaviest edges first, joining the
+  // ends nearest to the two functions.
+  void order_hot(CFile &F) {
+    std::vector<FuncDecl *> Hot;
+    for (auto *FD : Functions) {
+      if (Temperatures[FD] == Temperature::Hot) {
+        Hot.push_back(FD);
+      }
+    }
+    auto Index = build_ref_index(F);
+    // Keyed by the ranks, so that the order is deterministic.
+    std::map<std::pair<size_t, size_t>, uint64_t> Weights;
+    for (auto *Callee : Hot) {
+      for (auto &Use : Index.call_sites(Callee)) {
+        auto *Caller = Use.User;
+        if (!Caller || Caller == Callee || !Rank.count(Caller) ||
+            Temperatures[Caller] != Temperature::Hot) {
+          continue;
+        }
+        auto Key = std::minmax(Rank[Caller], Rank[Callee]);
+        Weights[Key] += std::min(heat_of(Caller), heat_of(Callee));
+      }
+    }
+    std::vector<std::pair<std::pair<size_t, size_t>, uint64_t>> Edges(
+        Weights.begin(), Weights.end());
+    std::stable_sort(Edges.begin(), Edges.end(), [](auto &L, auto &R) {
+      return L.second > R.second;
+    });
+
+    std::vector<std::vector<FuncDecl *>> Chains;
+    std::unordered_map<FuncDecl *, size_t> ChainOf;
+    for (auto *FD : Hot) {
+      ChainOf[FD] = Chains.size();
+      Chains.push_back({FD});
+    }
+    for (auto &[Key, Weight] : Edges) {
+      auto *A = Functions[Key.first], *B = Functions[Key.second];
+      auto CA = ChainOf[A], CB = ChainOf[B];
+      if (CA == CB) {
+        continue;
+      }
+      auto &L = Chains[CA], &R = Chains[CB];
+      size_t PosA = std::find(L.begin(), L.end(), A) - L.begin();
+      size_t PosB = std::find(R.begin(), R.end(), B) - R.begin();
+      // A to the end of L, and B to the start of R.
+      if (PosA < L.size() - 1 - PosA) {
+        std::reverse(L.begin(), L.end());
+      }
+      if (PosB > R.size() - 1 - PosB) {
+        std::reverse(R.begin(), R.end());
+      }
+      for (auto *FD : R) {
+        ChainOf[FD] = CA;
+      }
+      L.insert(L.end(), R.begin(), R.end());
+      R.clear();
+    }
+
+    // The hottest chains first.
+    std::vector<std::pair<uint64_t, size_t>> ChainHeat;
+    for (size_t I = 0; I < Chains.size(); ++I) {
+      uint64_t Sum = 0;
+      for (auto *FD : Chains[I]) {
+        Sum += heat_of(FD);
+      }
+      if (!Chains[I].empty()) {
+        ChainHeat.emplace_back(Sum, I);
+      }
+    }
+    std::stable_sort(ChainHeat.begin(), ChainHeat.end(),
+                     [](auto &L, auto &R) { return L.first > R.first; });
+    for (auto &[Sum, I] : ChainHeat) {
+      for (auto *FD : Chains[I]) {
+        HotOrder.emplace(FD, HotOrder.size());
+      }
+    }
+  }
+
+  // Insert the prototypes into Kept, the new order of the entries of Old.
+  // A moved function needs one if an entry after it in Old is now before
+  // it, and it is put just before the first such entry.
+  std::vector<Emit *> add_prototypes(TopLevel *T,
+                                     const std::vector<Emit *> &Old,
+                                     const std::vector<Emit *> &Kept,
+                                     std::unordered_set<std::string> &Declared,
+                                     LayoutStats &Stats) {
+    std::unordered_map<Emit *, size_t> OldIndex;
+    // The hot and cold ones, in the order of Old.
+    std::vector<FuncDecl *> Moved;
+    for (size_t I = 0; I < Old.size(); ++I) {
+      OldIndex[Old[I]] = I;
+      auto *FD = cast<FuncDecl>(Old[I]);
+      auto It = FD ? Temperatures.find(FD) : Temperatures.end();
+      if (It != Temperatures.end() && It->second != Temperature::Neutral) {
+        Moved.push_back(FD);
+      }
+    }
+    std::vector<Emit *> New;
+    std::unordered_set<Emit *> Placed;
+    size_t Next = 0;
+    for (auto *E : Kept) {
+      for (; Next < Moved.size() && OldIndex[Moved[Next]] < OldIndex[E];
+           ++Next) {
+        auto *FD = Moved[Next];
+        if (!Placed.count(FD) && Declared.insert(FD->get_name()).second) {
+          New.push_back(T->declare_func(FD));
+          Stats.Prototypes++;
+        }
+      }
+      if (auto *FD = cast<FuncDecl>(E)) {
+        Declared.insert(FD->get_name());
+      } else if (auto *FF = cast<FuncSplitForwardDecl>(E)) {
+        Declared.insert(FF->get_name());
+      }
+      Placed.insert(E);
+      New.push_back(E);
+    }
+    return New;
+  }
+
+  void layout(TopLevel *T, std::unordered_set<std::string> &Declared,
+              LayoutStats &Stats) {
+    std::vector<Emit *> Old(T->entries().begin(), T->entries().end());
+    std::vector<Emit *> Kept, Hot, Cold;
+    auto Flush = [&] {
+      std::stable_sort(Hot.begin(), Hot.end(), [&](Emit *L, Emit *R) {
+        return HotOrder[cast<FuncDecl>(L)] < HotOrder[cast<FuncDecl>(R)];
+      });
+      for (auto *List : {&Hot, &Cold}) {
+        Kept.insert(Kept.end(), List->begin(), List->end());
+        List->clear();
+      }
+    };
+    for (auto *E : Old) {
+      auto *FD = cast<FuncDecl>(E);
+      if (is_barrier(E)) {
+        Flush();
+      }
+      auto It = FD ? Temperatures.find(FD) : Temperatures.end();
+      if (It == Temperatures.end() || It->second == Temperature::Neutral) {
+        Kept.push_back(E);
+        continue;
+      }
+      (It->second == Temperature::Hot ? Hot : Cold).push_back(E);
+    }
+    Flush();
+    for (size_t I = 0; I < Old.size(); ++I) {
+      Stats.Moved += Old[I] != Kept[I];
+    }
+    T->reorder(add_prototypes(T, Old, Kept, Declared, Stats));
+  }
+
+public:
+  FunctionLayout(const FunctionHeat &Heat, const LayoutOptions &Opts)
+      : Heat(Heat), Opts(Opts) {}
+
+  LayoutStats run(CFile &F) {
+    LayoutStats Stats;
+    for (auto &T : F.top_levels()) {
+      for (auto *E : T.entries()) {
+        if (auto *FD = cast<FuncDecl>(E); FD && is_definition(FD)) {
+          Rank.emplace(FD, Functions.size());
+          Functions.push_back(FD);
+        }
+      }
+    }
+    for (auto *FD : Functions) {
+      auto Temp = classify(FD);
+      Temperatures[FD] = Temp;
+      if (Temp != Temperature::Neutral) {
+        (Temp == Temperature::Hot ? Stats.Hot : Stats.Cold)++;
+        mark(FD, Temp);
+      }
+    }
+    order_hot(F);
+    std::unordered_set<std::string> Declared;
+    for (auto &T : F.top_levels()) {
+      layout(&T, Declared, Stats);
+    }
+    return Stats;
+  }
+};
+} // namespace
+
+LayoutStats namec::layout_functions(CFile &F, const FunctionHeat &Heat,
+                                    const LayoutOptions &Opts) {
+  return FunctionLayout(Heat, Opts).run(F);
+}
@@ -50,23 +50,23 @@ Ifndef *DirectiveDefineMixin::directive_ifndef(std::string Cond) {
 }
 
 RawDirective *DirectiveDefineMixin::insert_newline(size_t Count) {
-  return directive_raw(std::string(Count, '\n'));
+  return add(new RawDirective(std::string(Count, '\n'), true));
 }
 
 RawDirective *DirectiveDefineMixin::insert_space(size_t Count) {
-  return directive_raw(std::string(Count, ' '));
+  return add(new RawDirective(std::string(Count, ' '), true));
 }
 
 RawDirective *DirectiveDefineMixin::insert_tab(size_t Count) {
-  return directive_raw(std::string(Count, '\t'));
+  return add(new RawDirective(std::string(Count, '\t'), true));
 }
 
 RawDirective *DirectiveDefineMixin::insert_comment(std::string Comment) {
-  return directive_raw("/* " + Comment + " */");
+  return add(new RawDirective("/* " + Comment + " */", true));
 }
 
 RawDirective *DirectiveDefineMixin::insert_line_comment(std::string Comment) {
-  return directive_raw("// " + Comment + "\n");
+  return add(new RawDirective("// " + Comment + "\n", true));
 }
 
 // Definitions for UbiquitousDeclStmtMixin methods
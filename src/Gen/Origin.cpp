@@ -0,0 +1,228 @@
+#include "internal/Gen.h"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+
+using namespace namec;
+
+namespace {
+const char *const Header = "namec-origins 1";
+
+// Parse the next unsigned integer of Line and the following space.
+template <typename T> bool parse_field(std::string_view &Line, T &Val) {
+  auto *End = Line.data() + Line.size();
+  auto [Ptr, Ec] = std::from_chars(Line.data(), End, Val);
+  if (Ec != std::errc() || (Ptr != End && *Ptr != ' ')) {
+    return false;
+  }
+  Line.remove_prefix(std::min<size_t>(Ptr - Line.data() + 1, Line.size()));
+  return true;
+}
+
+void emit_string_literal(std::ostream &SS, const std::string &S) {
+  SS << '"';
+  for (char Ch : S) {
+    if (Ch == '"' || Ch == '\\') {
+      SS << '\\';
+    }
+    SS << Ch;
+  }
+  SS << '"';
+}
+} // namespace
+
+OriginId OriginTable::add(const std::string &File, unsigned Line) {
+  auto [It, IsNew] = FileIndex.try_emplace(File, Files.size());
+  if (IsNew) {
+    Files.push_back(File);
+  }
+  Origins.emplace_back(It->second, Line);
+  return static_cast<OriginId>(Origins.size() - 1);
+}
+
+uint32_t OriginMap::add_file(const std::string &File) {
+  auto [It, IsNew] = FileIndex.try_emplace(File, Files.size());
+  if (IsNew) {
+    Files.push_back(File);
+  }
+  return It->second;
+}
+
+bool OriginMap::add(uint64_t Begin, uint64_t End, const std::string &File,
+                    unsigned Line) {
+  if (End < Begin) {
+    return false;
+  }
+  if (!Ranges.empty() && (Begin < Ranges.back().Begin ||
+                          (Begin == Ranges.back().Begin &&
+                           End > Ranges.back().End))) {
+    return false;
+  }
+  // The enclosing ranges of the last one are the candidates. The ones
+  // skipped here end before the next ranges too, so this is amortized O(1).
+  size_t Parent = Ranges.empty() ? npos : Ranges.size() - 1;
+  while (Parent != npos && Ranges[Parent].End <= Begin) {
+    Parent = Ranges[Parent].Parent;
+  }
+  if (Parent != npos && End > Ranges[Parent].End) {
+    return false;
+  }
+  Ranges.push_back({Begin, End, add_file(File), Line, Parent});
+  return true;
+}
+
+const OriginMap::Range *OriginMap::find(uint64_t Offset) const {
+  // The ranges containing Offset begin at or before it, so they are the
+  // enclosing ones of the last such range since the ranges nest.
+  auto It = std::upper_bound(
+      Ranges.begin(), Ranges.end(), Offset,
+      [](uint64_t Offset, const Range &R) { return Offset < R.Begin; });
+  size_t I = It == Ranges.begin() ? npos : It - Ranges.begin() - 1;
+  while (I != npos && Ranges[I].End <= Offset) {
+    I = Ranges[I].Parent;
+  }
+  return I == npos ? nullptr : &Ranges[I];
+}
+
+void OriginMap::write(std::ostream &SS) const {
+  SS << Header << "\n";
+  for (auto &File : Files) {
+    SS << "f " << File << "\n";
+  }
+  for (auto &R : Ranges) {
+    SS << R.Begin << " " << R.End << " " << R.File << " " << R.Line << "\n";
+  }
+}
+
+std::string OriginMap::to_string() const {
+  std::stringstream SS;
+  write(SS);
+  return SS.str();
+}
+
+bool OriginMap::parse(std::string_view Text) {
+  auto Eol = std::min(Text.find('\n'), Text.size());
+  if (Text.substr(0, Eol) != Header) {
+    return false;
+  }
+  Text.remove_prefix(std::min(Eol + 1, Text.size()));
+  // The indices in Text to the ones in this.
+  std::vector<uint32_t> FileMap;
+  while (!Text.empty()) {
+    Eol = std::min(Text.find('\n'), Text.size());
+    auto Fields = Text.substr(0, Eol);
+    Text.remove_prefix(std::min(Eol + 1, Text.size()));
+    if (Fields.substr(0, 2) == "f ") {
+      FileMap.push_back(add_file(std::string(Fields.substr(2))));
+      continue;
+    }
+    uint64_t Begin, End;
+    uint32_t File;
+    unsigned Line;
+    if (!parse_field(Fields, Begin) || !parse_field(Fields, End) ||
+        !parse_field(Fields, File) || !parse_field(Fields, Line) ||
+        !Fields.empty() || File >= FileMap.size() ||
+        !add(Begin, End, Files[FileMap[File]], Line)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+OriginEmitter::CountingBuf::int_type
+OriginEmitter::CountingBuf::overflow(int_type Ch) {
+  if (traits_type::eq_int_type(Ch, traits_type::eof())) {
+    return traits_type::not_eof(Ch);
+  }
+  ++Bytes;
+  Lines += traits_type::to_char_type(Ch) == '\n';
+  return Out->sputc(traits_type::to_char_type(Ch));
+}
+
+std::streamsize OriginEmitter::CountingBuf::xsputn(const char *S,
+                                                   std::streamsize N) {
+  auto Written = Out->sputn(S, N);
+  Bytes += Written;
+  Lines += std::count(S, S + Written, '\n');
+  return Written;
+}
+
+thread_local OriginEmitter *OriginEmitter::Active = nullptr;
+
+OriginEmitter::OriginEmitter(Context &C, std::ostream &Out,
+                             const OriginOptions &Opts)
+    : Prev(Active), C(C), Opts(Opts), Buf(Out.rdbuf()), Stream(&Buf) {
+  Active = this;
+}
+
+OriginEmitter::~OriginEmitter() { Active = Prev; }
+
+void OriginEmitter::emit_line(OriginId Id) {
+  auto &Origins = C.get_origins();
+  Stream << "#line " << Origins.get_line(Id) << " ";
+  emit_string_literal(Stream, Origins.get_file(Id));
+  Stream << "\n";
+}
+
+void OriginEmitter::emit(Emit *E) {
+  OriginId Id = 0;
+  if (auto *S = cast<Stmt>(E)) {
+    Id = S->get_origin();
+  } else if (auto *FD = cast<FuncDecl>(E)) {
+    Id = FD->get_origin();
+  }
+  if (!Id) {
+    E->emit(Stream);
+    return;
+  }
+  // #line must start a line.
+  if (Opts.IsLineDirectives) {
+    Stream << "\n";
+    emit_line(Id);
+  }
+  // The end is set after emitting E, so the parent is by the stack instead
+  // of OriginMap::add().
+  auto &Origins = C.get_origins();
+  size_t Parent = Stack.empty() ? OriginMap::npos : Stack.back().second;
+  Stack.emplace_back(Id, Map.Ranges.size());
+  Map.Ranges.push_back({Buf.Bytes, Buf.Bytes,
+                        Map.add_file(Origins.get_file(Id)),
+                        Origins.get_line(Id), Parent});
+  E->emit(Stream);
+  Map.Ranges[Stack.back().second].End = Buf.Bytes;
+  Stack.pop_back();
+  if (!Opts.IsLineDirectives) {
+    return;
+  }
+  Stream << "\n";
+  if (!Stack.empty()) {
+    emit_line(Stack.back().first);
+    return;
+  }
+  // The line after the directive, counting from 1.
+  Stream << "#line " << Buf.Lines + 2 << " ";
+  emit_string_literal(Stream, Opts.FileName);
+  Stream << "\n";
+}
+
+OriginMap namec::emit_with_origins(CFile &F, std::ostream &SS,
+                                   const OriginOptions &Opts) {
+  F.materialize();
+  OriginEmitter OE(F.get_context(), SS, Opts);
+  F.emit(OE.stream());
+  return OE.take_map();
+}
+
+bool namec::emit_to_file_with_origins(CFile &F,
+                                      const std::filesystem::path &Path) {
+  std::ofstream OS(Path);
+  OriginOptions Opts;
+  Opts.FileName = Path.string();
+  auto Map = emit_with_origins(F, OS, Opts);
+  std::filesystem::path MapPath = Path;
+  MapPath += ".origins";
+  std::ofstream MapOS(MapPath);
+  Map.write(MapOS);
+  return OS.good() && MapOS.good();
+}
@@ -0,0 +1,442 @@
+#include "internal/Gen.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+
+#include "internal/Util/Json.h"
+
+using namespace namec;
+
+namespace {
+std::string_view trim(std::string_view S) {
+  while (!S.empty() && std::isspace(static_cast<unsigned char>(S.front()))) {
+    S.remove_prefix(1);
+  }
+  while (!S.empty() && std::isspace(static_cast<unsigned char>(S.back()))) {
+    S.remove_suffix(1);
+  }
+  return S;
+}
+
+std::optional<uint64_t> parse_count(std::string_view S) {
+  uint64_t V = 0;
+  auto [End, EC] = std::from_chars(S.data(), S.data() + S.size(), V);
+  if (EC != std::errc() || End != S.data() + S.size()) {
+    return std::nullopt;
+  }
+  return V;
+}
+
+std::string quote(const std::string &S) {
+  std::string Result = "\"";
+  for (char C : S) {
+    if (C == '"' || C == '\\') {
+      Result += '\\';
+    }
+    Result += C;
+  }
+  return Result + "\"";
+}
+
+class SiteAssigner {
+  ProfileSites &Sites;
+  FuncDecl *Func = nullptr;
+  std::string FuncId;
+  // The statements numbered so far in Func.
+  size_t Index = 0;
+  // The functions so far by their names, to tell apart the ones of the same
+  // name such as the static ones in the branches of #if.
+  std::unordered_map<std::string, size_t> Seen;
+
+  size_t add(ProfileSiteKind Kind, std::string Id, Stmt *S, size_t Branch,
+             FuncScope *Body, size_t Parent) {
+    Sites.push_back({std::move(Id), Kind, Func, S, Branch, Body, Parent});
+    return Sites.size() - 1;
+  }
+
+  std::string next_id() { return FuncId + "#" + std::to_string(Index++); }
+
+  // The sites of the bodies are added together before walking into them,
+  // so that the branches of a statement are adjacent.
+  void add_branches(ProfileSiteKind Kind, Stmt *S,
+                    const std::vector<std::pair<Stmt *, FuncScope *>> &Bodies,
+                    size_t Parent) {
+    auto Id = next_id() + ".";
+    auto First = Sites.size();
+    for (size_t I = 0; I < Bodies.size(); ++I) {
+      auto *Owner = Bodies[I].first ? Bodies[I].first : S;
+      add(Kind, Id + std::to_string(I), Owner, I, Bodies[I].second, Parent);
+    }
+    for (size_t I = 0; I < Bodies.size(); ++I) {
+      walk(Bodies[I].second, First + I);
+    }
+  }
+
+  void walk_stmt(Stmt *S, size_t Parent) {
+    switch (S->get_kind()) {
+    case StmtKind::If: {
+      auto *If = static_cast<IfStmt *>(S);
+      std::vector<std::pair<Stmt *, FuncScope *>> Bodies;
+      Bodies.emplace_back(nullptr, If->get_then());
+      for (auto &[Cond, Body] : If->elseifs()) {
+        Bodies.emplace_back(nullptr, Body);
+      }
+      if (If->has_else()) {
+        Bodies.emplace_back(nullptr, If->get_else());
+      }
+      add_branches(ProfileSiteKind::Branch, If, Bodies, Parent);
+      break;
+    }
+    case StmtKind::While: {
+      auto *Body = static_cast<WhileStmt *>(S)->get_body();
+      walk(Body, add(ProfileSiteKind::Loop, next_id(), S, 0, Body, Parent));
+      break;
+    }
+    case StmtKind::For: {
+      auto *Body = static_cast<ForStmt *>(S)->get_body();
+      walk(Body, add(ProfileSiteKind::Loop, next_id(), S, 0, Body, Parent));
+      break;
+    }
+    case StmtKind::Switch: {
+      std::vector<std::pair<Stmt *, FuncScope *>> Bodies;
+      for (auto &Case : static_cast<SwitchStmt *>(S)->cases()) {
+        Bodies.emplace_back(&Case, Case.get_body());
+      }
+      add_branches(ProfileSiteKind::Case, S, Bodies, Parent);
+      break;
+    }
+    case StmtKind::Do: {
+      auto *Body = static_cast<DoStmt *>(S)->get_body();
+      walk(Body, add(ProfileSiteKind::Loop, next_id(), S, 0, Body, Parent));
+      break;
+    }
+    case StmtKind::Block:
+      walk(static_cast<BlockStmt *>(S)->get_scope(), Parent);
+      break;
+    case StmtKind::Label:
+      if (auto *Inner = static_cast<LabelStmt *>(S)->get_stmt()) {
+        walk_stmt(Inner, Parent);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  void walk(FuncScope *Scope, size_t Parent) {
+    for (auto *E : Scope->entries()) {
+      if (auto *S = cast<Stmt>(E)) {
+        walk_stmt(S, Parent);
+      }
+    }
+  }
+
+public:
+  SiteAssigner(ProfileSites &Sites) : Sites(Sites) {}
+
+  void assign(FuncDecl *FD, const std::string &Prefix) {
+    Func = FD;
+    FuncId = Prefix + FD->get_name();
+    if (auto Num = Seen[FuncId]++) {
+      FuncId += "@" + std::to_string(Num);
+    }
+    Index = 0;
+    auto *Body = FD->get_body();
+    walk(Body, add(ProfileSiteKind::Function, FuncId, nullptr, 0, Body,
+                   ProfileSite::npos));
+  }
+};
+
+class ProfileApplier {
+  const ProfileSites &Sites;
+  const ProfileOptions &Opts;
+  std::vector<std::optional<uint64_t>> Counts;
+
+  std::optional<uint64_t> parent_count(const ProfileSite &S) {
+    return S.Parent == ProfileSite::npos ? std::nullopt : Counts[S.Parent];
+  }
+
+  // The likelihood of a branch taken Taken times out of Reached, or
+  // std::nullopt if reached too few times to tell.
+  std::optional<Likelihood> decide(uint64_t Taken, uint64_t Reached) {
+    if (Reached == 0 || Reached < Opts.MinReached) {
+      return std::nullopt;
+    }
+    double Ratio = static_cast<double>(Taken) / static_cast<double>(Reached);
+    if (Ratio >= Opts.LikelyRatio) {
+      return Likelihood::Likely;
+    }
+    if (Ratio <= 1 - Opts.LikelyRatio) {
+      return Likelihood::Unlikely;
+    }
+    return Likelihood::None;
+  }
+
+  void set(ProfileStats &Stats, std::optional<Likelihood> L,
+           const std::function<void(Likelihood)> &Setter) {
+    if (!L) {
+      return;
+    }
+    Setter(*L);
+    if (*L != Likelihood::None) {
+      Stats.Hints++;
+    }
+  }
+
+  // The sites from I of the branches of an IfStmt. Returns the number.
+  size_t apply_if(ProfileStats &Stats, size_t I) {
+    auto *If = static_cast<IfStmt *>(Sites[I].S);
+    size_t Num = 1 + (If->elseifs().end() - If->elseifs().begin()) +
+                 If->has_else();
+    auto Reached = parent_count(Sites[I]);
+    if (If->has_else()) {
+      uint64_t Sum = 0;
+      bool IsAllKnown = true;
+      for (size_t B = 0; B < Num; ++B) {
+        IsAllKnown = IsAllKnown && Counts[I + B];
+        Sum += Counts[I + B].value_or(0);
+      }
+      if (IsAllKnown) {
+        Reached = Sum;
+      }
+    }
+    // The else is not annotated, as the other branches tell it.
+    for (size_t B = 0; Reached && B < Num - If->has_else(); ++B) {
+      auto Taken = Counts[I + B];
+      if (!Taken) {
+        break;
+      }
+      set(Stats, decide(*Taken, *Reached), [&](Likelihood L) {
+        if (B == 0) {
+          If->set_likelihood(L);
+        } else {
+          If->set_elseif_likelihood(B - 1, L);
+        }
+      });
+      *Reached -= std::min(*Reached, *Taken);
+    }
+    return Num;
+  }
+
+  void apply_loop(ProfileStats &Stats, const ProfileSite &S, uint64_t Body) {
+    auto Entered = parent_count(S);
+    if (!Entered) {
+      return;
+    }
+    // The condition of do-while is tested after each run of the body.
+    auto L = cast<DoStmt>(S.S)
+                 ? decide(Body - std::min(Body, *Entered), Body)
+                 : decide(Body, Body + *Entered);
+    if (auto *W = cast<WhileStmt>(S.S)) {
+      set(Stats, L, [&](Likelihood L) { W->set_likelihood(L); });
+    } else if (auto *F = cast<ForStmt>(S.S)) {
+      set(Stats, L, [&](Likelihood L) { F->set_likelihood(L); });
+    } else if (auto *D = cast<DoStmt>(S.S)) {
+      set(Stats, L, [&](Likelihood L) { D->set_likelihood(L); });
+    }
+  }
+
+public:
+  ProfileApplier(const ProfileSites &Sites, const Profile &P,
+                 const ProfileOptions &Opts)
+      : Sites(Sites), Opts(Opts) {
+    for (auto &S : Sites) {
+      Counts.push_back(P.get(S.Id));
+    }
+  }
+
+  void apply_branches(ProfileStats &Stats) {
+    for (size_t I = 0; I < Sites.size();) {
+      auto &S = Sites[I];
+      if (S.Kind == ProfileSiteKind::Branch) {
+        I += apply_if(Stats, I);
+        continue;
+      }
+      if (S.Kind == ProfileSiteKind::Loop && Counts[I]) {
+        apply_loop(Stats, S, *Counts[I]);
+      } else if (S.Kind == ProfileSiteKind::Case && Counts[I]) {
+        if (auto Reached = parent_count(S)) {
+          auto *Case = static_cast<CaseStmt *>(S.S);
+          set(Stats, decide(*Counts[I], *Reached),
+              [&](Likelihood L) { Case->set_likelihood(L); });
+        }
+      }
+      ++I;
+    }
+  }
+
+  FunctionHeat heat() {
+    FunctionHeat Heat;
+    for (size_t I = 0; I < Sites.size(); ++I) {
+      if (Sites[I].Kind == ProfileSiteKind::Function && Counts[I]) {
+        Heat[Sites[I].Func] = *Counts[I];
+      }
+    }
+    return Heat;
+  }
+
+  size_t matched() {
+    return std::count_if(Counts.begin(), Counts.end(),
+                         [](auto &C) { return C.has_value(); });
+  }
+};
+} // namespace
+
+ProfileSites namec::assign_profile_ids(CFile &F, const std::string &Prefix) {
+  ProfileSites Sites;
+  SiteAssigner Assigner(Sites);
+  auto Index = build_ref_index(F);
+  for (auto *FD : Index.functions()) {
+    Assigner.assign(FD, Prefix);
+  }
+  return Sites;
+}
+
+void namec::instrument_profile(CFile &F, const ProfileSites &Sites,
+                               const std::string &Path,
+                               const InstrumentOptions &Opts) {
+  if (Sites.empty()) {
+    return;
+  }
+  auto &C = F.get_context();
+  auto Size = std::to_string(Sites.size());
+  auto Counts = Opts.Symbol + "_counts";
+  for (size_t I = 0; I < Sites.size(); ++I) {
+    auto *Body = Sites[I].Body;
+    auto *Saved = Body->get_insert_point();
+    Body->set_insert_point_start();
+    auto Counter = Counts + "[" + std::to_string(I) + "]";
+    Body->stmt_raw(Opts.IsAtomic ? "__atomic_fetch_add(&" + Counter +
+                                       ",1,__ATOMIC_RELAXED);"
+                                 : Counter + "++;");
+    Body->set_insert_point_before(Saved);
+  }
+  // The counters before all the functions, and the dump after them. They
+  // are not static, so that shard_file() defines them once for the shards.
+  auto *T = F.get_first_top_level();
+  std::vector<Emit *> Old(T->entries().begin(), T->entries().end());
+  T->include_sys("stdio.h");
+  T->def_array_var(Counts, C.type_raw("unsigned long long"),
+                   {C.expr_raw(Size)});
+  std::vector<Emit *> Order(T->entries().begin() + Old.size(),
+                            T->entries().end());
+  Order.insert(Order.end(), Old.begin(), Old.end());
+  T->reorder(Order);
+  std::string Ids;
+  for (auto &S : Sites) {
+    Ids += (Ids.empty() ? "" : ",") + quote(S.Id);
+  }
+  auto *Dump = T->def_func(Opts.Symbol + "_dump", C.type_void(),
+                           {C.decl_var("", C.type_void())});
+  Dump->add_attr(Attribute::destructor());
+  auto *Body = Dump->get_or_add_body();
+  Body->stmt_raw("static const char *const Ids[" + Size + "]={" + Ids +
+                 "};");
+  Body->stmt_raw("FILE *F=fopen(" + quote(Path) + ",\"a\");");
+  Body->stmt_raw("if(!F){return;}");
+  Body->stmt_raw("for(unsigned long I=0;I<" + Size + ";++I){");
+  Body->stmt_raw("fprintf(F,\"%s,%llu\\n\",Ids[I]," + Counts + "[I]);}");
+  Body->stmt_raw("fclose(F);");
+}
+
+void Profile::add(const std::string &Id, uint64_t Count) {
+  Counts[Id] += Count;
+}
+
+std::optional<uint64_t> Profile::get(const std::string &Id) const {
+  auto It = Counts.find(Id);
+  if (It == Counts.end()) {
+    return std::nullopt;
+  }
+  return It->second;
+}
+
+bool Profile::parse_csv(std::string_view Text) {
+  while (!Text.empty()) {
+    auto End = std::min(Text.find('\n'), Text.size());
+    auto Line = trim(Text.substr(0, End));
+    Text.remove_prefix(std::min(End + 1, Text.size()));
+    if (Line.empty() || Line.front() == '#') {
+      continue;
+    }
+    auto Comma = Line.rfind(',');
+    if (Comma == std::string_view::npos) {
+      return false;
+    }
+    auto Count = parse_count(trim(Line.substr(Comma + 1)));
+    if (!Count) {
+      return false;
+    }
+    add(std::string(trim(Line.substr(0, Comma))), *Count);
+  }
+  return true;
+}
+
+bool Profile::parse_gcov_json(std::string_view Text,
+                              const std::string &Prefix) {
+  auto Root = parse_json(Text);
+  auto *Files = Root ? Root->get("files") : nullptr;
+  if (!Files || Files->K != JsonValue::Kind::Array) {
+    return false;
+  }
+  std::vector<std::pair<std::string, uint64_t>> Found;
+  for (auto &File : Files->Items) {
+    auto *Functions = File.get("functions");
+    if (!Functions) {
+      continue;
+    }
+    for (auto &Function : Functions->Items) {
+      auto *Name = Function.get("name");
+      auto *Count = Function.get("execution_count");
+      if (!Name || !Count || Name->K != JsonValue::Kind::String) {
+        return false;
+      }
+      auto V = parse_count(Count->Text);
+      if (!V) {
+        return false;
+      }
+      Found.emplace_back(Prefix + Name->Text, *V);
+    }
+  }
+  for (auto &[Id, Count] : Found) {
+    add(Id, Count);
+  }
+  return true;
+}
+
+ProfileStats namec::apply_profile(CFile &F, const Profile &P,
+                                  const ProfileOptions &Opts) {
+  ProfileStats Stats;
+  auto Sites = assign_profile_ids(F, Opts.Prefix);
+  ProfileApplier Applier(Sites, P, Opts);
+  Stats.Matched = Applier.matched();
+  Applier.apply_branches(Stats);
+  auto Heat = Applier.heat();
+  uint64_t Max = 0;
+  for (auto &[FD, Count] : Heat) {
+    Max = std::max(Max, Count);
+  }
+  auto Threshold = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(Max * Opts.HotRatio)));
+  if (Opts.IsLayout) {
+    LayoutOptions Layout;
+    Layout.HotThreshold = Threshold;
+    Layout.IsMarkHotCold = Opts.IsMarkHotCold;
+    Layout.HotSection = Opts.HotSection;
+    Layout.ColdSection = Opts.ColdSection;
+    Stats.Layout = layout_functions(F, Heat, Layout);
+  } else if (Opts.IsMarkHotCold) {
+    for (auto &[FD, Count] : Heat) {
+      if (Count >= Threshold) {
+        FD->remove_attr(AttributeKind::Cold);
+        FD->add_attr(Attribute::hot());
+      } else if (Count == 0) {
+        FD->remove_attr(AttributeKind::Hot);
+        FD->add_attr(Attribute::cold());
+      }
+    }
+  }
+  return Stats;
+}
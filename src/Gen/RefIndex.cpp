@@ -0,0 +1,88 @@
+#include "internal/Gen.h"
+
+#include <unordered_map>
+
+using namespace namec;
+
+namespace {
+class RefIndexBuilder : public RecursiveVisitor<RefIndexBuilder> {
+  RefIndex &Index;
+  // The function whose body is traversed.
+  FuncDecl *Current = nullptr;
+  // The definition, or the first declaration, of each name.
+  std::unordered_map<std::string, FuncDecl *> Functions;
+  // The calls to resolve after all the functions are seen.
+  std::vector<std::pair<FuncDecl *, CallExpr *>> Calls;
+
+  void add_function(FuncDecl *FD) {
+    auto [It, IsNew] = Functions.emplace(FD->get_name(), FD);
+    if (!IsNew && It->second->is_forward() && !FD->is_forward()) {
+      It->second = FD;
+    }
+  }
+
+  FuncDecl *resolve(CallExpr *Call) {
+    auto *Callee = Call->get_callee();
+    while (auto *P = cast<ParenExpr>(Callee)) {
+      Callee = P->get_inside();
+    }
+    auto *Raw = cast<RawExpr>(Callee);
+    if (!Raw) {
+      return nullptr;
+    }
+    auto It = Functions.find(Raw->get_val());
+    return It == Functions.end() ? nullptr : It->second;
+  }
+
+public:
+  RefIndexBuilder(RefIndex &Index) : Index(Index) {}
+
+  bool traverse_decl(Decl *D) {
+    if (auto *FF = cast<FuncSplitForwardDecl>(D)) {
+      add_function(FF->get_func_decl());
+      return true;
+    }
+    auto *FD = cast<FuncDecl>(D);
+    if (!FD) {
+      return RecursiveVisitor::traverse_decl(D);
+    }
+    add_function(FD);
+    FD->materialize();
+    if (FD->is_forward()) {
+      return RecursiveVisitor::traverse_decl(D);
+    }
+    Index.add_function(FD);
+    auto *Outer = Current;
+    Current = FD;
+    bool Result = RecursiveVisitor::traverse_decl(D);
+    Current = Outer;
+    return Result;
+  }
+  bool visit_call_expr(CallExpr *E) {
+    Calls.emplace_back(Current, E);
+    return true;
+  }
+  bool visit_variable_expr(VariableExpr *E) {
+    Index.add_use(E->get_decl(), Current, E);
+    return true;
+  }
+
+  void resolve_calls() {
+    for (auto &[Caller, Call] : Calls) {
+      if (auto *Callee = resolve(Call)) {
+        Index.add_call(Caller, Callee, Call);
+      } else {
+        Index.add_unresolved_call(Caller, Call);
+      }
+    }
+  }
+};
+} // namespace
+
+RefIndex namec::build_ref_index(CFile &F) {
+  RefIndex Index;
+  RefIndexBuilder Builder(Index);
+  Builder.traverse_file(&F);
+  Builder.resolve_calls();
+  return Index;
+}
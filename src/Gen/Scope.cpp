@@ -1,11 +1,25 @@
 #include "internal/Gen.h"
 
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+
 using namespace namec;
 
 FuncDecl *TopLevel::def_func(std::string Name, Type *RetTy,
                              std::vector<VarDecl *> Params, bool IsVarArg) {
   auto *F = C.decl_func(Name, RetTy, Params, IsVarArg);
   Entries.push_back(F);
+  note_modified();
+  return F;
+}
+
+FuncDecl *TopLevel::def_func_lazy(std::string Name, Type *RetTy,
+                                  std::vector<VarDecl *> Params,
+                                  std::function<void(FuncScope *)> Builder,
+                                  bool IsVarArg) {
+  auto *F = def_func(Name, RetTy, Params, IsVarArg);
+  F->set_builder(std::move(Builder));
   return F;
 }
 
@@ -15,28 +29,297 @@ FuncSplitDecl *TopLevel::def_func_declare(std::string Name, Type *RetTy,
   auto *FD = C.decl_func_split(Name, RetTy, Params, IsVarArg);
   auto *Fwd = C.decl_func_split_forward(FD);
   Entries.push_back(Fwd);
+  note_modified();
   return FD;
 }
 
-void TopLevel::def_func_define(FuncSplitDecl *D) { Entries.push_back(D); }
+void TopLevel::def_func_define(FuncSplitDecl *D) {
+  Entries.push_back(D);
+  note_modified();
+}
+
+void TopLevel::materialize() {
+  for (auto *E : Entries) {
+    E->materialize();
+  }
+}
+
+bool TopLevel::contains(Emit *E) {
+  return std::find(Entries.begin(), Entries.end(), E) != Entries.end();
+}
+
+decltype(TopLevel::OwnedEntries)::iterator
+TopLevel::owned_position(decltype(Entries)::iterator It) {
+  // Owned entries are in the order of Entries.
+  return OwnedEntries.begin() +
+         std::count_if(Entries.begin(), It, [](Emit *E) {
+           return cast<ScopeEntry>(E) != nullptr;
+         });
+}
+
+bool TopLevel::replace(Emit *Old, std::unique_ptr<ScopeEntry> New) {
+  auto It = std::find(Entries.begin(), Entries.end(), Old);
+  if (It == Entries.end()) {
+    return false;
+  }
+  auto OwnedIt = owned_position(It);
+  note_modified();
+  *It = New.get();
+  if (cast<ScopeEntry>(Old)) {
+    *OwnedIt = std::move(New);
+  } else {
+    OwnedEntries.insert(OwnedIt, std::move(New));
+  }
+  return true;
+}
+
+size_t TopLevel::remove_if(const std::function<bool(Emit *)> &Pred) {
+  size_t Kept = 0, KeptOwned = 0, Owned = 0;
+  for (size_t I = 0; I < Entries.size(); ++I) {
+    auto *E = Entries[I];
+    bool IsOwned = cast<ScopeEntry>(E) != nullptr;
+    if (!Pred(E)) {
+      Entries[Kept++] = E;
+      if (IsOwned && KeptOwned++ != Owned) {
+        OwnedEntries[KeptOwned - 1] = std::move(OwnedEntries[Owned]);
+      }
+    }
+    Owned += IsOwned;
+  }
+  size_t Removed = Entries.size() - Kept;
+  if (Removed) {
+    note_modified();
+  }
+  Entries.resize(Kept);
+  OwnedEntries.resize(KeptOwned);
+  return Removed;
+}
+
+bool TopLevel::splice(Emit *At, TopLevel *From) {
+  auto It = std::find(Entries.begin(), Entries.end(), At);
+  if (It == Entries.end() || From == this) {
+    return false;
+  }
+  auto OwnedIt = owned_position(It);
+  note_modified();
+  // Take the entries first, since destroying At may destroy From.
+  auto Moved = std::move(From->Entries);
+  auto MovedOwned = std::move(From->OwnedEntries);
+  From->Entries.clear();
+  From->OwnedEntries.clear();
+  std::unique_ptr<ScopeEntry> Old;
+  if (cast<ScopeEntry>(At)) {
+    Old = std::move(*OwnedIt);
+    OwnedIt = OwnedEntries.erase(OwnedIt);
+  }
+  OwnedEntries.insert(OwnedIt, std::make_move_iterator(MovedOwned.begin()),
+                      std::make_move_iterator(MovedOwned.end()));
+  It = Entries.erase(It);
+  Entries.insert(It, Moved.begin(), Moved.end());
+  return true;
+}
+
+bool TopLevel::reorder(const std::vector<Emit *> &Order) {
+  if (Order.size() != Entries.size()) {
+    return false;
+  }
+  std::unordered_map<Emit *, size_t> Counts;
+  for (auto *E : Entries) {
+    Counts[E]++;
+  }
+  for (auto *E : Order) {
+    auto It = Counts.find(E);
+    if (It == Counts.end() || It->second-- == 0) {
+      return false;
+    }
+  }
+  note_modified();
+  std::unordered_map<Emit *, std::unique_ptr<ScopeEntry>> Owned;
+  for (auto &E : OwnedEntries) {
+    Owned.emplace(E.get(), std::move(E));
+  }
+  OwnedEntries.clear();
+  for (auto *E : Order) {
+    if (auto It = Owned.find(E); It != Owned.end()) {
+      OwnedEntries.push_back(std::move(It->second));
+    }
+  }
+  Entries = Order;
+  return true;
+}
+
+StructDecl *TopLevel::declare_struct(Struct *S) {
+  auto *D = C.decl_struct(S, true);
+  add_owned(std::make_unique<DeclStmt>(C, D));
+  return D;
+}
+
+UnionDecl *TopLevel::declare_union(Union *U) {
+  auto *D = C.decl_union(U, true);
+  add_owned(std::make_unique<DeclStmt>(C, D));
+  return D;
+}
+
+FuncDecl *TopLevel::declare_func(FuncDecl *FD) {
+  auto *P = C.decl_func(FD->get_name(), FD->get_ret_type(), FD->get_params(),
+                        FD->is_vararg());
+  P->set_static(FD->is_static());
+  P->copy_attrs(*FD);
+  Entries.push_back(P);
+  note_modified();
+  return P;
+}
+
+std::unique_ptr<TopLevel> TopLevel::split_until(Emit *Last) {
+  auto Part = std::make_unique<TopLevel>(C);
+  note_modified();
+  auto End = std::find(Entries.begin(), Entries.end(), Last);
+  if (End != Entries.end()) {
+    ++End;
+  }
+  // Owned entries are in the order of Entries, so the moved ones are the
+  // first ones.
+  size_t OwnedCount = 0;
+  for (auto I = Entries.begin(); I != End; ++I) {
+    if (cast<ScopeEntry>(*I)) {
+      OwnedCount++;
+    }
+    Part->Entries.push_back(*I);
+  }
+  Entries.erase(Entries.begin(), End);
+  auto OwnedEnd = OwnedEntries.begin() + OwnedCount;
+  std::move(OwnedEntries.begin(), OwnedEnd,
+            std::back_inserter(Part->OwnedEntries));
+  OwnedEntries.erase(OwnedEntries.begin(), OwnedEnd);
+  Part->set_comment_before(get_comment_before());
+  set_comment_before("");
+  return Part;
+}
 
 void TopLevel::emit_impl(std::ostream &SS) {
+  // Only reads the entries if they are built, as sealed ones.
+  materialize();
+  if (auto *OE = OriginEmitter::active(SS)) {
+    for (auto *E : Entries) {
+      OE->emit(E);
+      SS << "\n";
+    }
+    return;
+  }
   for (auto *E : Entries) {
     E->emit(SS);
     SS << "\n";
   }
 }
 
+FuncScope::~FuncScope() {
+  // Not recursive, since a scope may have millions of entries.
+  while (First) {
+    auto *Next = First->Next;
+    delete First;
+    First = Next;
+  }
+}
+
+void FuncScope::link(ScopeEntry *Pos, ScopeEntry *Begin, ScopeEntry *End) {
+  note_modified();
+  ScopeEntry *Prev = Pos ? Pos->Prev : Last;
+  Begin->Prev = Prev;
+  End->Next = Pos;
+  if (Prev) {
+    Prev->Next = Begin;
+  } else {
+    First = Begin;
+  }
+  if (Pos) {
+    Pos->Prev = End;
+  } else {
+    Last = End;
+  }
+}
+
+void FuncScope::unlink(ScopeEntry *Begin, ScopeEntry *End) {
+  note_modified();
+  // Keep the insertion point out of the unlinked entries. Checking a whole
+  // range is O(n), so it is reset to the end instead.
+  if (Begin == End && InsertPoint == Begin) {
+    InsertPoint = End->Next;
+  } else if (Begin != End && InsertPoint) {
+    InsertPoint = nullptr;
+  }
+  if (Begin->Prev) {
+    Begin->Prev->Next = End->Next;
+  } else {
+    First = End->Next;
+  }
+  if (End->Next) {
+    End->Next->Prev = Begin->Prev;
+  } else {
+    Last = Begin->Prev;
+  }
+  Begin->Prev = nullptr;
+  End->Next = nullptr;
+}
+
+void FuncScope::insert_before(ScopeEntry *Pos, std::unique_ptr<ScopeEntry> E) {
+  auto *Raw = E.release();
+  link(Pos, Raw, Raw);
+}
+
+std::unique_ptr<ScopeEntry> FuncScope::remove(ScopeEntry *E) {
+  unlink(E, E);
+  return std::unique_ptr<ScopeEntry>(E);
+}
+
+void FuncScope::move_before(ScopeEntry *Pos, ScopeEntry *E) {
+  if (Pos == E) {
+    return;
+  }
+  unlink(E, E);
+  link(Pos, E, E);
+}
+
+bool FuncScope::splice_before(ScopeEntry *Pos, FuncScope *Other,
+                              ScopeEntry *Begin, ScopeEntry *End) {
+  if (Other == this && Pos) {
+    for (auto *E = Begin; E != End->Next; E = E->Next) {
+      if (E == Pos) {
+        return false;
+      }
+    }
+  }
+  Other->unlink(Begin, End);
+  link(Pos, Begin, End);
+  return true;
+}
+
+void FuncScope::splice_before(ScopeEntry *Pos, FuncScope *Other) {
+  if (Other->empty()) {
+    return;
+  }
+  auto *Begin = Other->First;
+  auto *End = Other->Last;
+  Other->note_modified();
+  Other->First = Other->Last = Other->InsertPoint = nullptr;
+  link(Pos, Begin, End);
+}
+
 void FuncScope::emit_impl(std::ostream &SS) {
-  for (auto *E : Entries) {
+  if (auto *OE = OriginEmitter::active(SS)) {
+    for (auto *E : entries()) {
+      OE->emit(E);
+    }
+    return;
+  }
+  for (auto *E : entries()) {
     SS << E;
   }
 }
 
 void MacroFuncScope::emit_impl(std::ostream &SS) {
   std::stringstream LocalSS;
-  for (auto *E : Entries) {
-    LocalSS << E;
+  for (auto &E : Entries) {
+    LocalSS << E.get();
   }
   std::string LocalStr = LocalSS.str();
   // Replace all newline with newline in macro
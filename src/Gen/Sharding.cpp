@@ -0,0 +1,138 @@
+#include "internal/Gen.h"
+
+#include <sstream>
+#include <unordered_set>
+
+using namespace namec;
+
+namespace {
+std::string emit_forward(FuncDecl *FD) {
+  std::ostringstream SS;
+  FD->emit_forward(SS);
+  return SS.str();
+}
+
+std::string emit_extern(VarDecl *V) {
+  std::ostringstream SS;
+  V->emit_extern(SS);
+  SS << ";";
+  return SS.str();
+}
+
+void find_definitions(IfDirectiveBase *If, std::vector<std::string> &Names);
+
+// Add the functions and variables defined in T to Names.
+void find_definitions(TopLevel *T, std::vector<std::string> &Names) {
+  for (auto *E : T->entries()) {
+    auto *D = cast<Decl>(E);
+    if (auto *S = cast<DeclStmt>(E)) {
+      D = S->get_decl();
+    }
+    if (auto *If = cast<IfDirectiveBase>(E)) {
+      find_definitions(If, Names);
+    } else if (auto *FD = cast<FuncDecl>(D)) {
+      if (!FD->is_forward() || !FD->get_alias().empty()) {
+        Names.push_back(FD->get_name());
+      }
+    } else if (auto *V = cast<VarDecl>(D); V && !V->is_extern()) {
+      Names.push_back(V->get_name());
+    }
+  }
+}
+
+// Add the functions and variables defined in the branches of If to Names.
+void find_definitions(IfDirectiveBase *If, std::vector<std::string> &Names) {
+  find_definitions(If->get_then(), Names);
+  for (auto &[Cond, Branch] : If->elifs()) {
+    find_definitions(Branch.get(), Names);
+  }
+  if (If->has_else()) {
+    find_definitions(If->get_else(), Names);
+  }
+}
+
+// Classify the top-level entries of F into ShardUnit in order. The
+// definitions in #if branches, which go to the header with the branches, are
+// added to Warnings.
+std::vector<ShardUnit> make_units(CFile &F,
+                                  std::vector<std::string> &Warnings) {
+  std::vector<ShardUnit> Units;
+  // Functions whose prototypes are already in the header.
+  std::unordered_set<FuncDecl *> Declared;
+  for (auto &T : F.top_levels()) {
+    for (auto *E : T.entries()) {
+      ShardUnit U;
+      U.Text = E->to_string();
+      if (auto *If = cast<IfDirectiveBase>(E)) {
+        std::vector<std::string> Names;
+        find_definitions(If, Names);
+        for (auto &Name : Names) {
+          Warnings.push_back("The definition of " + Name +
+                             " in an #if branch is put in the header.");
+        }
+      }
+      auto *D = cast<Decl>(E);
+      if (auto *S = cast<DeclStmt>(E)) {
+        D = S->get_decl();
+      }
+      if (auto *FF = cast<FuncSplitForwardDecl>(D)) {
+        auto *FD = FF->get_func_decl();
+        if (FD->is_static()) {
+          U.Kind = ShardUnitKind::Local;
+          U.Names.push_back(FD->get_name());
+        } else {
+          Declared.insert(FD);
+        }
+      } else if (auto *FD = cast<FuncDecl>(D)) {
+        if (!FD->get_alias().empty()) {
+          U.Anchors.push_back(FD->get_alias());
+        } else if (FD->is_forward() && !FD->is_static()) {
+          Units.push_back(std::move(U));
+          continue;
+        }
+        U.Names.push_back(FD->get_name());
+        if (FD->is_static()) {
+          U.Kind = ShardUnitKind::Local;
+        } else {
+          U.Kind = ShardUnitKind::Definition;
+          if (!Declared.count(FD)) {
+            U.Declaration = emit_forward(FD);
+          }
+        }
+      } else if (auto *V = cast<VarDecl>(D); V && !V->is_extern()) {
+        U.Names.push_back(V->get_name());
+        if (V->is_static()) {
+          U.Kind = ShardUnitKind::Local;
+        } else {
+          U.Kind = ShardUnitKind::Definition;
+          U.Declaration = emit_extern(V);
+        }
+      }
+      Units.push_back(std::move(U));
+    }
+  }
+  return Units;
+}
+} // namespace
+
+static ShardedFile add_warnings(ShardedFile Shards,
+                               std::vector<std::string> &Warnings) {
+  for (auto &W : Warnings) {
+    Shards.add_warning(std::move(W));
+  }
+  return Shards;
+}
+
+ShardedFile namec::shard_file(CFile &F, size_t NumShards,
+                              const std::string &Stem) {
+  std::vector<std::string> Warnings;
+  auto Units = make_units(F, Warnings);
+  return add_warnings(plan_shards(Units, NumShards, Stem, ".h", ".c"),
+                      Warnings);
+}
+
+ShardedFile namec::split_file(CFile &F, const std::string &Stem) {
+  std::vector<std::string> Warnings;
+  auto Units = make_units(F, Warnings);
+  return add_warnings(plan_split(Units, Stem, ".h", ".c"), Warnings);
+}
@@ -0,0 +1,360 @@
+#include "internal/Gen.h"
+
+#include <cctype>
+#include <sstream>
+#include <string_view>
+
+using namespace namec;
+
+namespace {
+bool is_ident_char(char C) {
+  return std::isalnum(static_cast<unsigned char>(C)) || C == '_';
+}
+
+std::string_view trim(std::string_view S) {
+  while (!S.empty() && std::isspace(static_cast<unsigned char>(S.front()))) {
+    S.remove_prefix(1);
+  }
+  while (!S.empty() && std::isspace(static_cast<unsigned char>(S.back()))) {
+    S.remove_suffix(1);
+  }
+  return S;
+}
+
+// The leading identifier of S, removed from S. "" if none.
+std::string_view take_identifier(std::string_view &S) {
+  size_t N = 0;
+  while (N < S.size() && is_ident_char(S[N])) {
+    ++N;
+  }
+  if (N > 0 && std::isdigit(static_cast<unsigned char>(S[0]))) {
+    return "";
+  }
+  auto Ident = S.substr(0, N);
+  S.remove_prefix(N);
+  return Ident;
+}
+
+// All integers are intmax_t or uintmax_t in #if.
+IntValue widen(IntValue V) {
+  return V.convert(V.is_signed() ? IntKind::LLong : IntKind::ULLong);
+}
+
+std::optional<IntValue> widen(std::optional<IntValue> V) {
+  if (!V) {
+    return std::nullopt;
+  }
+  return widen(*V);
+}
+
+std::optional<IntValue> eval_defined(std::string_view Name,
+                                     const MacroEnv &Env) {
+  auto IsDefined = Env.is_defined(std::string(Name));
+  if (!IsDefined) {
+    return std::nullopt;
+  }
+  return widen(IntValue::of_bool(*IsDefined));
+}
+
+class CondEvaluator {
+  const MacroEnv &Env;
+
+  // An identifier, an integer literal, or defined X or defined(X).
+  std::optional<IntValue> eval_text(std::string_view Text) {
+    Text = trim(Text);
+    auto Rest = Text;
+    auto Ident = take_identifier(Rest);
+    if (Ident.empty()) {
+      return widen(parse_int_literal(Text));
+    }
+    Rest = trim(Rest);
+    if (Rest.empty()) {
+      return widen(Env.get_value(std::string(Ident)));
+    }
+    if (Ident != "defined") {
+      return std::nullopt;
+    }
+    bool IsParen = Rest.front() == '(';
+    if (IsParen) {
+      Rest = trim(Rest.substr(1));
+    }
+    auto Name = take_identifier(Rest);
+    Rest = trim(Rest);
+    if (Name.empty() || Rest != (IsParen ? ")" : "")) {
+      return std::nullopt;
+    }
+    return eval_defined(Name, Env);
+  }
+
+  std::optional<IntValue> eval_logical(BinaryOp *B) {
+    bool IsAnd = B->get_op() == "&&";
+    auto L = eval(B->get_lhs());
+    auto R = eval(B->get_rhs());
+    // Either side decides the result, since #if has no side effect.
+    for (auto &V : {L, R}) {
+      if (V && V->is_zero() == IsAnd) {
+        return widen(IntValue::of_bool(!IsAnd));
+      }
+    }
+    if (!L || !R) {
+      return std::nullopt;
+    }
+    return widen(eval_binary(B->get_op(), *L, *R));
+  }
+
+public:
+  CondEvaluator(const MacroEnv &Env) : Env(Env) {}
+
+  std::optional<IntValue> eval(Expr *E) {
+    switch (E->get_kind()) {
+    case ExprKind::Raw:
+      if (auto *L = cast<IntLiteral>(E)) {
+        return widen(L->get_value());
+      }
+      return eval_text(static_cast<RawExpr *>(E)->get_val());
+    case ExprKind::Paren:
+      return eval(static_cast<ParenExpr *>(E)->get_inside());
+    case ExprKind::Call: {
+      auto *Call = static_cast<CallExpr *>(E);
+      auto *Callee = cast<RawExpr>(Call->get_callee());
+      auto Args = Call->get_args();
+      if (!Callee || trim(Callee->get_val()) != "defined" ||
+          Args.size() != 1 || !cast<RawExpr>(Args[0])) {
+        return std::nullopt;
+      }
+      auto Text = trim(static_cast<RawExpr *>(Args[0])->get_val());
+      auto Rest = Text;
+      if (take_identifier(Rest).empty() || !Rest.empty()) {
+        return std::nullopt;
+      }
+      return eval_defined(Text, Env);
+    }
+    case ExprKind::UnaryOp: {
+      auto *U = static_cast<UnaryOp *>(E);
+      auto V = eval(U->get_operand());
+      if (!U->is_prefix() || !V) {
+        return std::nullopt;
+      }
+      return widen(eval_unary(U->get_op(), *V));
+    }
+    case ExprKind::BinaryOp: {
+      auto *B = static_cast<BinaryOp *>(E);
+      if (B->get_op() == "&&" || B->get_op() == "||") {
+        return eval_logical(B);
+      }
+      auto L = eval(B->get_lhs());
+      auto R = eval(B->get_rhs());
+      if (!L || !R) {
+        return std::nullopt;
+      }
+      return widen(eval_binary(B->get_op(), *L, *R));
+    }
+    case ExprKind::TernaryOp: {
+      auto *T = static_cast<TernaryOp *>(E);
+      auto Cond = eval(T->get_cond());
+      auto Then = eval(T->get_then());
+      auto Else = eval(T->get_else());
+      if (!Cond || !Then || !Else) {
+        return std::nullopt;
+      }
+      auto K = IntValue::common_kind(Then->get_kind(), Else->get_kind());
+      return (Cond->is_zero() ? *Else : *Then).convert(K);
+    }
+    default:
+      return std::nullopt;
+    }
+  }
+};
+
+class DirectiveSpecializer {
+  MacroEnv Env;
+  // The macros changed so far, to forget after an undecided directive.
+  std::vector<std::string> Changed;
+
+  std::optional<bool> decide(Expr *Cond) {
+    auto V = eval_directive_cond(Cond, Env);
+    if (!V) {
+      return std::nullopt;
+    }
+    return !V->is_zero();
+  }
+
+  // The live branch of If, nullptr if none, or std::nullopt if undecided.
+  std::optional<TopLevel *> live_branch(IfDirectiveBase *If) {
+    std::optional<bool> IsThen;
+    if (auto *I = cast<IfDirective>(If)) {
+      IsThen = decide(I->get_cond());
+    } else if (auto *I = cast<Ifdef>(If)) {
+      IsThen = Env.is_defined(I->get_cond());
+    } else if (auto *I = cast<Ifndef>(If)) {
+      if (auto IsDefined = Env.is_defined(I->get_cond())) {
+        IsThen = !*IsDefined;
+      }
+    }
+    if (!IsThen) {
+      return std::nullopt;
+    }
+    if (*IsThen) {
+      return If->get_then();
+    }
+    for (auto &[Cond, Branch] : If->elifs()) {
+      auto IsLive = decide(Cond);
+      if (!IsLive) {
+        return std::nullopt;
+      }
+      if (*IsLive) {
+        return Branch.get();
+      }
+    }
+    return If->get_else();
+  }
+
+  // #define or #undef in raw text, possibly of several lines.
+  void track_raw(const std::string &Text) {
+    std::istringstream Lines(Text);
+    std::string Line;
+    while (std::getline(Lines, Line)) {
+      auto Rest = trim(Line);
+      if (Rest.empty() || Rest.front() != '#') {
+        continue;
+      }
+      Rest = trim(Rest.substr(1));
+      auto Keyword = take_identifier(Rest);
+      if (Keyword != "define" && Keyword != "undef") {
+        continue;
+      }
+      Rest = trim(Rest);
+      if (auto Name = take_identifier(Rest); !Name.empty()) {
+        Env.forget(std::string(Name));
+        Changed.emplace_back(Name);
+      }
+    }
+  }
+
+  void track(Emit *E) {
+    if (auto *D = cast<Define>(E)) {
+      Env.define(D->get_name(), D->get_value());
+      Changed.push_back(D->get_name());
+    } else if (auto *D = cast<DefineFuncMacro>(E)) {
+      Env.define(D->get_name());
+      Changed.push_back(D->get_name());
+    } else if (auto *U = cast<Undef>(E)) {
+      Env.undefine(U->get_name());
+      Changed.push_back(U->get_name());
+    } else if (auto *R = cast<RawDirective>(E)) {
+      track_raw(R->get_val());
+    }
+  }
+
+  void specialize_branches(IfDirectiveBase *If) {
+    auto Begin = Changed.size();
+    auto Saved = Env;
+    auto Specialize = [&](TopLevel *Branch) {
+      specialize(Branch);
+      Env = Saved;
+    };
+    Specialize(If->get_then());
+    for (auto &[Cond, Branch] : If->elifs()) {
+      Specialize(Branch.get());
+    }
+    if (If->has_else()) {
+      Specialize(If->get_else());
+    }
+    // Which branch changed them is not known.
+    for (auto I = Begin; I < Changed.size(); ++I) {
+      Env.forget(Changed[I]);
+    }
+  }
+
+public:
+  SpecializeStats Stats;
+
+  DirectiveSpecializer(MacroEnv Env) : Env(std::move(Env)) {}
+
+  void specialize(TopLevel *T) {
+    auto Size = [T] { return T->entries().end() - T->entries().begin(); };
+    for (ptrdiff_t I = 0; I < Size();) {
+      auto *E = T->entries().begin()[I];
+      auto *If = cast<IfDirectiveBase>(E);
+      if (!If) {
+        track(E);
+        ++I;
+        continue;
+      }
+      auto Live = live_branch(If);
+      if (!Live) {
+        Stats.Kept++;
+        specialize_branches(If);
+        ++I;
+        continue;
+      }
+      // Continue with the spliced entries at I.
+      Stats.Resolved++;
+      if (*Live) {
+        T->splice(If, *Live);
+      } else {
+        T->remove_if([&](Emit *X) { return X == If; });
+      }
+    }
+  }
+};
+} // namespace
+
+void MacroEnv::define(const std::string &Name, IntValue V) {
+  Undefined.erase(Name);
+  Unknown.erase(Name);
+  Defined[Name] = V;
+}
+
+void MacroEnv::define(const std::string &Name, const std::string &Value) {
+  Undefined.erase(Name);
+  Unknown.erase(Name);
+  Defined[Name] = parse_int_literal(trim(Value));
+}
+
+void MacroEnv::undefine(const std::string &Name) {
+  Defined.erase(Name);
+  Unknown.erase(Name);
+  Undefined.insert(Name);
+}
+
+void MacroEnv::forget(const std::string &Name) {
+  Defined.erase(Name);
+  Undefined.erase(Name);
+  Unknown.insert(Name);
+}
+
+std::optional<bool> MacroEnv::is_defined(const std::string &Name) const {
+  if (Defined.count(Name)) {
+    return true;
+  }
+  if (Undefined.count(Name) || (IsClosed && !Unknown.count(Name))) {
+    return false;
+  }
+  return std::nullopt;
+}
+
+std::optional<IntValue> MacroEnv::get_value(const std::string &Name) const {
+  if (auto It = Defined.find(Name); It != Defined.end()) {
+    return It->second;
+  }
+  auto IsDefined = is_defined(Name);
+  if (!IsDefined) {
+    return std::nullopt;
+  }
+  // Identifiers other than macros are 0 in #if.
+  return IntValue(IntKind::Int, 0);
+}
+
+std::optional<IntValue> namec::eval_directive_cond(Expr *Cond,
+                                                   const MacroEnv &Env) {
+  return CondEvaluator(Env).eval(Cond);
+}
+
+SpecializeStats namec::specialize_directives(CFile &F, MacroEnv Env) {
+  DirectiveSpecializer S(std::move(Env));
+  for (auto &T : F.top_levels()) {
+    S.specialize(&T);
+  }
+  return S.Stats;
+}
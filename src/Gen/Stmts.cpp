@@ -2,14 +2,29 @@
 
 using namespace namec;
 
+namespace {
+void emit_cond(std::ostream &SS, Expr *Cond, Likelihood Hint) {
+  if (Hint == Likelihood::None) {
+    SS << Cond;
+    return;
+  }
+  SS << "__builtin_expect(!!(" << Cond << "),"
+     << (Hint == Likelihood::Likely) << ")";
+}
+} // namespace
+
 void RawStmt::emit_impl(std::ostream &SS) { SS << get_val(); }
 
 void DeclStmt::emit_impl(std::ostream &SS) { SS << get_decl() << ";"; }
 
 void IfStmt::emit_impl(std::ostream &SS) {
-  SS << "if(" << get_cond() << "){" << get_then() << "}";
-  for (auto &[ECond, EBody] : Elseifs) {
-    SS << "else if(" << ECond << "){" << EBody << "}";
+  SS << "if(";
+  emit_cond(SS, get_cond(), Hint);
+  SS << "){" << get_then() << "}";
+  for (size_t I = 0; I < Elseifs.size(); ++I) {
+    SS << "else if(";
+    emit_cond(SS, Elseifs[I].first, ElseifHints[I]);
+    SS << "){" << Elseifs[I].second << "}";
   }
   if (has_else()) {
     SS << "else{" << Else << "}";
@@ -17,7 +32,9 @@ void IfStmt::emit_impl(std::ostream &SS) {
 }
 
 void WhileStmt::emit_impl(std::ostream &SS) {
-  SS << "while(" << get_cond() << "){" << get_body() << "}";
+  SS << "while(";
+  emit_cond(SS, get_cond(), Hint);
+  SS << "){" << get_body() << "}";
 }
 
 void ForStmt::emit_impl(std::ostream &SS) {
@@ -29,7 +46,8 @@ void ForStmt::emit_impl(std::ostream &SS) {
     SS << ";";
   }
   if (get_cond()) {
-    SS << get_cond() << ";";
+    emit_cond(SS, get_cond(), Hint);
+    SS << ";";
   } else {
     SS << ";";
   }
@@ -40,7 +58,9 @@ void ForStmt::emit_impl(std::ostream &SS) {
 }
 
 void DoStmt::emit_impl(std::ostream &SS) {
-  SS << "do{" << get_body() << "}while(" << get_cond() << ")";
+  SS << "do{" << get_body() << "}while(";
+  emit_cond(SS, get_cond(), Hint);
+  SS << ")";
 }
 
 void BlockStmt::emit_impl(std::ostream &SS) { SS << "{" << get_scope() << "}"; }
@@ -88,6 +108,7 @@ CaseStmt *SwitchStmt::add_case(Expr *Val, bool IsFallThrough) {
   auto Case = std::make_unique<CaseStmt>(C, Val, IsFallThrough);
   auto *Ret = Case.get();
   Cases.push_back(std::move(Case));
+  note_modified();
   return Ret;
 }
 
@@ -95,6 +116,7 @@ CaseStmt *SwitchStmt::add_default(bool IsFallThrough) {
   auto Case = std::make_unique<CaseStmt>(C, nullptr, IsFallThrough);
   auto *Ret = Case.get();
   Cases.push_back(std::move(Case));
+  note_modified();
   return Ret;
 }
 
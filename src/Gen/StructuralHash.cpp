@@ -0,0 +1,454 @@
+#include "internal/Gen.h"
+
+using namespace namec;
+
+namespace {
+// Tags distinguishing the node categories. The kinds are added to them.
+enum : uint64_t {
+  NullTag = 0,
+  ExprTag = 0x100,
+  StmtTag = 0x200,
+  DeclTag = 0x300,
+  TypeTag = 0x400,
+  DirectiveTag = 0x500,
+  ScopeTag = 0x600,
+};
+
+uint64_t tag(uint64_t Base, uint64_t Kind) { return Base + Kind; }
+
+// Comments and whitespace inserted by DirectiveDefineMixin.
+bool is_trivia(Emit *E) {
+  return E->get_emit_kind() == EmitKind::Directive &&
+         static_cast<Directive *>(E)->get_kind() == DirectiveKind::Raw &&
+         static_cast<RawDirective *>(E)->is_trivia();
+}
+} // namespace
+
+void StructuralHasher::depend(const Emit *N) {
+  if (Computing.empty()) {
+    return;
+  }
+  auto &U = Users[N];
+  // A child read twice by the same parent, as in x+x.
+  if (U.empty() || U.back() != Computing.back()) {
+    U.push_back(Computing.back());
+  }
+}
+
+template <typename T> Hash128 StructuralHasher::memoize(T *N) {
+  if (!N) {
+    return Hash128Builder().add(NullTag).get();
+  }
+  depend(N);
+  auto It = Cache.find(N);
+  if (It != Cache.end() && It->second.Id == N->Id) {
+    return It->second.Hash;
+  }
+  Computing.push_back(N);
+  auto H = compute(N);
+  Computing.pop_back();
+  Cache[N] = Memo{H, N->Id};
+  return H;
+}
+
+void StructuralHasher::on_modified(const Emit *E) {
+  std::vector<const Emit *> Stack{E};
+  while (!Stack.empty()) {
+    auto *N = Stack.back();
+    Stack.pop_back();
+    Cache.erase(N);
+    // The users recorded again when they are hashed next.
+    auto It = Users.find(N);
+    if (It == Users.end()) {
+      continue;
+    }
+    Stack.insert(Stack.end(), It->second.begin(), It->second.end());
+    Users.erase(It);
+  }
+}
+
+Hash128 StructuralHasher::hash_attrs(const Attributed &A) {
+  Hash128Builder B;
+  B.add(static_cast<uint64_t>(A.attrs().size()));
+  for (auto &Attr : A.attrs()) {
+    B.add(static_cast<uint64_t>(Attr.get_kind())).add(Attr.get_arg());
+  }
+  return B.get();
+}
+
+Hash128 StructuralHasher::compute(Expr *E) {
+  Hash128Builder B;
+  B.add(tag(ExprTag, static_cast<uint64_t>(E->get_kind())));
+  switch (E->get_kind()) {
+  case ExprKind::Raw:
+    B.add(static_cast<RawExpr *>(E)->get_val());
+    break;
+  case ExprKind::Variable:
+    B.add(static_cast<VariableExpr *>(E)->get_decl()->get_name());
+    break;
+  case ExprKind::Subscript: {
+    auto *S = static_cast<SubscriptExpr *>(E);
+    B.add(hash(S->get_array())).add(hash(S->get_index()));
+    break;
+  }
+  case ExprKind::Call: {
+    auto *C = static_cast<CallExpr *>(E);
+    B.add(hash(C->get_callee()));
+    for (auto *A : C->args()) {
+      B.add(hash(A));
+    }
+    break;
+  }
+  case ExprKind::UnaryOp: {
+    auto *U = static_cast<UnaryOp *>(E);
+    B.add(U->get_op()).add(U->is_prefix()).add(hash(U->get_operand()));
+    break;
+  }
+  case ExprKind::BinaryOp: {
+    auto *Bin = static_cast<BinaryOp *>(E);
+    B.add(Bin->get_op()).add(hash(Bin->get_lhs())).add(hash(Bin->get_rhs()));
+    break;
+  }
+  case ExprKind::TernaryOp: {
+    auto *T = static_cast<TernaryOp *>(E);
+    B.add(hash(T->get_cond())).add(hash(T->get_then()));
+    B.add(hash(T->get_else()));
+    break;
+  }
+  case ExprKind::Cast: {
+    auto *C = static_cast<CastExpr *>(E);
+    B.add(hash(C->get_type())).add(hash(C->get_operand()));
+    break;
+  }
+  case ExprKind::Paren:
+    B.add(hash(static_cast<ParenExpr *>(E)->get_inside()));
+    break;
+  case ExprKind::DesignatedInit:
+    for (auto &[Name, Value] :
+         static_cast<DesignatedInitExpr *>(E)->designators()) {
+      B.add(Name).add(hash(Value));
+    }
+    break;
+  case ExprKind::InitList:
+    for (auto *Value : static_cast<InitListExpr *>(E)->values()) {
+      B.add(hash(Value));
+    }
+    break;
+  case ExprKind::GenericSelection: {
+    auto *G = static_cast<GenericSelection *>(E);
+    B.add(hash(G->get_control()));
+    for (auto &[T, Value] : G->assocs()) {
+      B.add(hash(T)).add(hash(Value));
+    }
+    break;
+  }
+  }
+  return B.get();
+}
+
+Hash128 StructuralHasher::compute(Stmt *S) {
+  Hash128Builder B;
+  B.add(tag(StmtTag, static_cast<uint64_t>(S->get_kind())));
+  switch (S->get_kind()) {
+  case StmtKind::Raw:
+    B.add(static_cast<RawStmt *>(S)->get_val());
+    break;
+  case StmtKind::Decl:
+    B.add(hash(static_cast<DeclStmt *>(S)->get_decl()));
+    break;
+  case StmtKind::If: {
+    auto *If = static_cast<IfStmt *>(S);
+    B.add(hash(If->get_cond())).add(hash(If->get_then()));
+    B.add(static_cast<uint64_t>(If->get_likelihood()));
+    size_t I = 0;
+    for (auto &[Cond, Body] : If->elseifs()) {
+      B.add(hash(Cond)).add(hash(Body));
+      B.add(static_cast<uint64_t>(If->get_elseif_likelihood(I++)));
+    }
+    B.add(hash(If->get_else()));
+    break;
+  }
+  case StmtKind::While: {
+    auto *W = static_cast<WhileStmt *>(S);
+    B.add(hash(W->get_cond())).add(hash(W->get_body()));
+    B.add(static_cast<uint64_t>(W->get_likelihood()));
+    break;
+  }
+  case StmtKind::For: {
+    auto *F = static_cast<ForStmt *>(S);
+    B.add(hash(F->get_init())).add(hash(F->get_cond()));
+    B.add(hash(F->get_step())).add(hash(F->get_body()));
+    B.add(static_cast<uint64_t>(F->get_likelihood()));
+    break;
+  }
+  case StmtKind::Do: {
+    auto *D = static_cast<DoStmt *>(S);
+    B.add(hash(D->get_body())).add(hash(D->get_cond()));
+    B.add(static_cast<uint64_t>(D->get_likelihood()));
+    break;
+  }
+  case StmtKind::Block:
+    B.add(hash(static_cast<BlockStmt *>(S)->get_scope()));
+    break;
+  case StmtKind::Expr:
+    B.add(hash(static_cast<ExprStmt *>(S)->get_expr()));
+    break;
+  case StmtKind::Return:
+    B.add(hash(static_cast<ReturnStmt *>(S)->get_expr()));
+    break;
+  case StmtKind::Break:
+  case StmtKind::Continue:
+    break;
+  case StmtKind::Label: {
+    auto *L = static_cast<LabelStmt *>(S);
+    B.add(L->get_name()).add(hash(L->get_stmt()));
+    break;
+  }
+  case StmtKind::Goto:
+    B.add(static_cast<GotoStmt *>(S)->get_name());
+    break;
+  case StmtKind::Case: {
+    auto *C = static_cast<CaseStmt *>(S);
+    B.add(hash(C->get_val())).add(C->is_fall_through());
+    B.add(hash(C->get_body()));
+    break;
+  }
+  case StmtKind::Switch: {
+    auto *Sw = static_cast<SwitchStmt *>(S);
+    B.add(hash(Sw->get_cond()));
+    for (auto &C : Sw->cases()) {
+      B.add(hash(&C));
+    }
+    break;
+  }
+  }
+  return B.get();
+}
+
+Hash128 StructuralHasher::compute(Decl *D) {
+  Hash128Builder B;
+  switch (D->get_kind()) {
+  case DeclKind::Raw:
+    // Identified by the name, as it is emitted.
+    B.add(tag(DeclTag, 0)).add(D->get_name());
+    break;
+  case DeclKind::Var:
+  case DeclKind::ArrayVar: {
+    auto *V = static_cast<VarDecl *>(D);
+    B.add(tag(DeclTag, 1)).add(V->get_name()).add(hash(V->get_type()));
+    B.add(V->is_const()).add(V->is_extern()).add(V->is_static());
+    B.add(V->is_volatile()).add(V->is_restrict()).add(hash_attrs(*V));
+    if (D->get_kind() == DeclKind::ArrayVar) {
+      for (auto *Size : static_cast<ArrayVarDecl *>(D)->sizes()) {
+        B.add(hash(Size));
+      }
+    }
+    B.add(hash(V->get_init()));
+    break;
+  }
+  case DeclKind::Func:
+  case DeclKind::FuncSplit: {
+    auto *F = static_cast<FuncDecl *>(D);
+    B.add(tag(DeclTag, 2)).add(F->get_name()).add(hash(F->get_ret_type()));
+    for (auto *P : F->params()) {
+      B.add(hash(P));
+    }
+    B.add(F->is_vararg()).add(F->is_extern()).add(F->is_static());
+    B.add(F->is_split_definition()).add(F->get_alias());
+    B.add(hash_attrs(*F)).add(hash(F->get_body()));
+    break;
+  }
+  case DeclKind::FuncSplitForward: {
+    // The prototype of the split function, which does not depend on the body.
+    auto *F = static_cast<FuncSplitForwardDecl *>(D)->get_func_decl();
+    depend(F);
+    B.add(tag(DeclTag, 3)).add(F->get_name()).add(hash(F->get_ret_type()));
+    for (auto *P : F->params()) {
+      B.add(hash(P));
+    }
+    B.add(F->is_vararg()).add(F->is_extern()).add(F->is_static());
+    B.add(hash_attrs(*F));
+    break;
+  }
+  case DeclKind::Typedef: {
+    auto *T = static_cast<TypedefDecl *>(D);
+    B.add(tag(DeclTag, 4)).add(T->get_name());
+    B.add(hash(T->get_type_alias()->get_type()));
+    break;
+  }
+  case DeclKind::Struct: {
+    auto *S = static_cast<StructDecl *>(D);
+    B.add(tag(DeclTag, 5)).add(S->is_forward());
+    B.add(S->is_forward() ? Hash128Builder().add(S->get_name()).get()
+                          : hash(S->get_struct()));
+    break;
+  }
+  case DeclKind::Union: {
+    auto *U = static_cast<UnionDecl *>(D);
+    B.add(tag(DeclTag, 6)).add(U->is_forward());
+    B.add(U->is_forward() ? Hash128Builder().add(U->get_name()).get()
+                          : hash(U->get_union()));
+    break;
+  }
+  case DeclKind::Enum: {
+    auto *E = static_cast<EnumDecl *>(D);
+    B.add(tag(DeclTag, 7)).add(E->is_forward());
+    B.add(E->is_forward() ? Hash128Builder().add(E->get_name()).get()
+                          : hash(E->get_enum()));
+    break;
+  }
+  }
+  return B.get();
+}
+
+Hash128 StructuralHasher::compute(Type *T) {
+  Hash128Builder B;
+  if (auto *R = cast<RawType>(T)) {
+    B.add(tag(TypeTag, 0)).add(R->get_val());
+  } else if (cast<Void>(T)) {
+    B.add(tag(TypeTag, 1));
+  } else if (auto *N = cast<Named>(T)) {
+    // Referred by the name, with the kind for struct, union and enum.
+    if (auto *D = N->get_decl()) {
+      uint64_t Kind = cast<StructDecl>(D)  ? 1
+                      : cast<UnionDecl>(D) ? 2
+                      : cast<EnumDecl>(D)  ? 3
+                                           : 0;
+      B.add(tag(TypeTag, 2)).add(Kind).add(D->get_name());
+    } else {
+      // Released by sealing.
+      B.add(tag(TypeTag, 11)).add(N->to_string());
+    }
+  } else if (auto *A = cast<TypeAlias>(T)) {
+    B.add(tag(TypeTag, 3)).add(A->get_name());
+  } else if (auto *P = cast<Pointer>(T)) {
+    B.add(tag(TypeTag, 4)).add(hash(P->get_elm_type()));
+  } else if (auto *A = cast<Array>(T)) {
+    B.add(tag(TypeTag, 5)).add(hash(A->get_elm_type()));
+    for (auto *Size : A->sizes()) {
+      B.add(hash(Size));
+    }
+  } else if (auto *F = cast<Function>(T)) {
+    B.add(tag(TypeTag, 6)).add(hash(F->get_ret_type())).add(F->is_vararg());
+    for (auto *P : F->params()) {
+      B.add(hash(P));
+    }
+  } else if (auto *M = cast<MembersType>(T)) {
+    B.add(tag(TypeTag, cast<Struct>(T) ? 7 : 8)).add(M->get_name());
+    for (auto &V : M->members()) {
+      B.add(hash(&V));
+    }
+  } else if (auto *E = cast<Enum>(T)) {
+    B.add(tag(TypeTag, 9)).add(E->get_name());
+    for (auto &[Name, Value] : E->members()) {
+      B.add(Name).add(hash(Value));
+    }
+  } else {
+    // A type defined outside, hashed by the emitted code.
+    B.add(tag(TypeTag, 10)).add(T->to_string());
+  }
+  return B.get();
+}
+
+Hash128 StructuralHasher::compute(Directive *D) {
+  Hash128Builder B;
+  switch (D->get_kind()) {
+  case DirectiveKind::Include:
+    B.add(tag(DirectiveTag, 0)).add(static_cast<Include *>(D)->get_path());
+    break;
+  case DirectiveKind::SystemInclude:
+    B.add(tag(DirectiveTag, 1));
+    B.add(static_cast<SystemInclude *>(D)->get_path());
+    break;
+  case DirectiveKind::Raw:
+    B.add(tag(DirectiveTag, 2)).add(static_cast<RawDirective *>(D)->get_val());
+    break;
+  case DirectiveKind::Define: {
+    auto *Def = static_cast<Define *>(D);
+    B.add(tag(DirectiveTag, 3)).add(Def->get_name()).add(Def->get_value());
+    break;
+  }
+  case DirectiveKind::DefineFuncMacro: {
+    auto *M = static_cast<DefineFuncMacro *>(D);
+    B.add(tag(DirectiveTag, 4)).add(M->get_name()).add(M->is_vararg());
+    for (auto &Arg : M->args()) {
+      B.add(Arg);
+    }
+    B.add(hash(M->get_body()));
+    break;
+  }
+  case DirectiveKind::Undef:
+    B.add(tag(DirectiveTag, 5)).add(static_cast<Undef *>(D)->get_name());
+    break;
+  case DirectiveKind::Pragma:
+    B.add(tag(DirectiveTag, 6)).add(static_cast<Pragma *>(D)->get_value());
+    break;
+  case DirectiveKind::If:
+  case DirectiveKind::Ifdef:
+  case DirectiveKind::Ifndef: {
+    if (D->get_kind() == DirectiveKind::If) {
+      B.add(tag(DirectiveTag, 7));
+      B.add(hash(static_cast<IfDirective *>(D)->get_cond()));
+    } else if (D->get_kind() == DirectiveKind::Ifdef) {
+      B.add(tag(DirectiveTag, 8)).add(static_cast<Ifdef *>(D)->get_cond());
+    } else {
+      B.add(tag(DirectiveTag, 9)).add(static_cast<Ifndef *>(D)->get_cond());
+    }
+    auto *If = static_cast<IfDirectiveBase *>(D);
+    B.add(hash(If->get_then()));
+    for (auto &[Cond, T] : If->elifs()) {
+      B.add(hash(Cond)).add(hash(T.get()));
+    }
+    B.add(hash(If->get_else()));
+    break;
+  }
+  }
+  return B.get();
+}
+
+void StructuralHasher::add_entry(Hash128Builder &B, Emit *E) {
+  if (is_trivia(E)) {
+    return;
+  }
+  switch (E->get_emit_kind()) {
+  case EmitKind::Stmt:
+    B.add(hash(static_cast<Stmt *>(E)));
+    break;
+  case EmitKind::Directive:
+    B.add(hash(static_cast<Directive *>(E)));
+    break;
+  case EmitKind::Decl:
+    B.add(hash(static_cast<Decl *>(E)));
+    break;
+  case EmitKind::Other:
+    // Not an entry of the scopes.
+    break;
+  }
+}
+
+Hash128 StructuralHasher::compute(FuncScope *S) {
+  Hash128Builder B;
+  B.add(tag(ScopeTag, 0));
+  for (auto *E : S->entries()) {
+    add_entry(B, E);
+  }
+  return B.get();
+}
+
+Hash128 StructuralHasher::compute(MacroFuncScope *S) {
+  Hash128Builder B;
+  B.add(tag(ScopeTag, 1));
+  for (auto &E : S->entries()) {
+    B.add(hash(&E));
+  }
+  return B.get();
+}
+
+Hash128 StructuralHasher::compute(TopLevel *T) {
+  Hash128Builder B;
+  B.add(tag(ScopeTag, 2));
+  for (auto *E : T->entries()) {
+    add_entry(B, E);
+  }
+  return B.get();
+}
@@ -7,7 +7,9 @@ void RawType::emit_impl(std::ostream &SS) { SS << get_val(); }
 void Void::emit_impl(std::ostream &SS) { SS << "void"; }
 
 void Named::emit_impl(std::ostream &SS) {
-  if (auto *S = cast<StructDecl>(D)) {
+  if (!D) {
+    SS << Spelling;
+  } else if (auto *S = cast<StructDecl>(D)) {
     SS << "struct " << S->get_name();
   } else if (auto *U = cast<UnionDecl>(D)) {
     SS << "union " << U->get_name();
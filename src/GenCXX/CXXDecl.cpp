@@ -41,6 +41,18 @@ void VarDecl::emit_impl(std::ostream &SS) {
   }
 }
 
+void VarDecl::emit_extern(std::ostream &SS) {
+  if (is_volatile()) {
+    SS << "volatile ";
+  }
+  SS << "extern " << get_type() << " " << get_name_str();
+}
+
+void ArrayVarDecl::emit_extern(std::ostream &SS) {
+  SS << "extern " << get_type() << " " << get_name_str();
+  SS << "[" << join(sizes(), "][") << "]";
+}
+
 void ArrayVarDecl::emit_impl(std::ostream &SS) {
   emit_type_qual(SS, this);
   SS << get_type() << " " << get_name_str();
@@ -89,6 +101,11 @@ FuncScope *FuncDecl::get_or_add_body() {
   return Body;
 }
 
+FuncScope *FuncDecl::replace_body() {
+  Body = C.add_func_scope();
+  return Body;
+}
+
 static void emit_func_qual(std::ostream &SS, FuncDecl *D) {
   if (D->is_extern()) {
     SS << "extern ";
@@ -213,7 +230,8 @@ void MethodDecl::emit_impl_impl(std::ostream &SS, bool IsForward,
 MethodSplitDecl::MethodSplitDecl(Context &C, ClassOrUnion *Parent,
                                  QualName Name, Type *RetTy,
                                  std::vector<VarDecl *> Params, bool IsVarArg)
-    : MethodDecl(C, C.QN(Parent->get_name(), Name), RetTy, Params, IsVarArg),
+    : MethodDecl(DeclKind::MethodSplit, C, C.QN(Parent->get_name(), Name),
+                 RetTy, Params, IsVarArg),
       Parent(Parent) {
   get_or_add_body();
 }
@@ -230,17 +248,29 @@ void MethodSplitForwardDecl::emit_impl(std::ostream &SS) {
 
 CtorDecl::CtorDecl(Context &C, QualName Name, std::vector<VarDecl *> Params,
                    bool IsVarArg)
-    : MethodDecl(C, Name, nullptr, Params, IsVarArg) {}
+    : CtorDecl(DeclKind::Ctor, C, Name, Params, IsVarArg) {}
 
 void CtorDecl::emit_impl_impl(std::ostream &SS, bool IsForward,
                               bool IsSplitDefinition) {
   emit_func_qual(SS, this);
-  SS << get_name().to_string() << "(" << join(params());
+  // The declaration of a split constructor in the class has the unqualified
+  // name and no initializers.
+  bool IsSplitForward = IsForward && IsSplitDefinition;
+  if (IsSplitForward) {
+    SS << get_name().last();
+  } else {
+    SS << get_name().to_string();
+  }
+  SS << "(" << join(params());
   if (is_vararg()) {
     SS << ",...";
   }
   SS << ")";
   emit_method_qual(SS, this, IsForward, IsSplitDefinition);
+  if (IsSplitForward) {
+    SS << ";";
+    return;
+  }
   if (Inits.size() > 0) {
     SS << ":" << join_map(inits(), ",", [](auto &P) {
       return P->first.to_string() + "(" + P->second->to_string() + ")";
@@ -255,7 +285,8 @@ void CtorDecl::emit_impl_impl(std::ostream &SS, bool IsForward,
 }
 CtorSplitDecl::CtorSplitDecl(Context &C, ClassOrUnion *Parent,
                              std::vector<VarDecl *> Params, bool IsVarArg)
-    : CtorDecl(C, C.QN(Parent->get_name(), Parent->get_name().last()), Params,
+    : CtorDecl(DeclKind::CtorSplit, C,
+               C.QN(Parent->get_name(), Parent->get_name().last()), Params,
                IsVarArg),
       Parent(Parent) {
   get_or_add_body();
@@ -27,7 +27,8 @@ void Define::emit_impl(std::ostream &SS) {
 
 DefineFuncMacro::DefineFuncMacro(Context &C, std::string Name,
                                  std::vector<std::string> Args, bool IsVarArg)
-    : C(C), Name(Name), Args(Args), IsVarArg(IsVarArg) {
+    : Directive(DirectiveKind::DefineFuncMacro), C(C), Name(Name), Args(Args),
+      IsVarArg(IsVarArg) {
   Body.reset(new MacroFuncScope(C));
 }
 
@@ -87,7 +88,7 @@ void IfDirectiveBase::emit_impl(std::ostream &SS) {
 }
 
 IfDirective::IfDirective(Context &C, Expr *Cond)
-    : IfDirectiveBase(C), Cond(Cond) {}
+    : IfDirectiveBase(C, DirectiveKind::If), Cond(Cond) {}
 
 void IfDirective::emit_impl(std::ostream &SS) {
   SS << "\n";
@@ -75,8 +75,8 @@ void QualNameExpr::emit_impl(std::ostream &SS) { SS << get_name().to_string(); }
 LambdaExpr::LambdaExpr(Context &C, std::vector<Expr *> Captures,
                        std::vector<VarDecl *> Params, bool IsVarArgs,
                        Type *RetTy)
-    : Captures(Captures), Params(Params), IsVarArgs(IsVarArgs),
-      Body(C.add_func_scope()), RetTy(RetTy) {}
+    : Expr(ExprKind::Lambda), Captures(Captures), Params(Params),
+      IsVarArgs(IsVarArgs), Body(C.add_func_scope()), RetTy(RetTy) {}
 
 void LambdaExpr::emit_impl(std::ostream &SS) {
   SS << "[" << join(captures()) << "]";
@@ -1,7 +1,5 @@
 #include "internal/GenCXX.h"
 
-#include <fstream>
-
 using namespace namecxx;
 
 CXXFile::CXXFile(Context &C) : C(C) { TopLevels.push_back(C.add_top_level()); }
@@ -11,9 +9,10 @@ TopLevel *CXXFile::add_top_level() {
   return TopLevels.back();
 }
 
-void CXXFile::emit_to_file(std::filesystem::path Path) {
-  std::ofstream OS(Path);
-  emit(OS);
+WriteResult CXXFile::emit_to_file(std::filesystem::path Path,
+                                 bool IsSkipUnchanged) {
+  return write_file(Path, IsSkipUnchanged,
+                    [this](std::ostream &OS) { emit(OS); });
 }
 
 void CXXFile::emit_impl(std::ostream &SS) {
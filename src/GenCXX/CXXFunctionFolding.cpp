@@ -0,0 +1,92 @@
+#include "internal/GenCXX.h"
+
+#include <unordered_map>
+
+using namespace namecxx;
+
+namespace {
+// Hash of the function except its name.
+Hash128 hash_definition(StructuralHasher &H, FuncDecl *FD) {
+  Hash128Builder B;
+  B.add(H.hash_emitted(FD->get_ret_type()));
+  for (auto *P : FD->params()) {
+    B.add(H.hash_emitted(P));
+  }
+  B.add(FD->is_vararg()).add(FD->is_extern()).add(FD->is_static());
+  B.add(FD->is_constexpr()).add(FD->is_inline());
+  return B.add(H.hash(FD->get_body())).get();
+}
+
+// Finds a static local, which the folded functions would share.
+class StaticLocalFinder : public RecursiveVisitor<StaticLocalFinder> {
+public:
+  bool visit_decl(Decl *D) {
+    auto *V = dynamic_cast<VarDecl *>(D);
+    return !V || !V->is_static();
+  }
+};
+
+bool is_foldable(FuncDecl *FD) {
+  if (dynamic_cast<MethodDecl *>(FD) || !FD->get_body() || FD->is_vararg() ||
+      FD->get_name().get_names().size() != 1 ||
+      !StaticLocalFinder().traverse_func_scope(FD->get_body())) {
+    return false;
+  }
+  for (auto *P : FD->params()) {
+    auto *Ty = P->get_type();
+    if (P->get_name_str().empty() || dynamic_cast<PackedType *>(Ty)) {
+      return false;
+    }
+    // Forwarding an rvalue reference by name would pass an lvalue.
+    auto TyStr = Ty->to_string();
+    if (TyStr.size() >= 2 && TyStr.compare(TyStr.size() - 2, 2, "&&") == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void fold(Context &C, FuncDecl *FD, FuncDecl *Kept) {
+  std::vector<Expr *> Args;
+  for (auto *P : FD->params()) {
+    Args.push_back(C.expr_var(P));
+  }
+  auto *Call = C.expr_call(C.expr_raw(Kept->get_name_str()), Args);
+  auto *Body = FD->replace_body();
+  if (dynamic_cast<Void *>(FD->get_ret_type())) {
+    Body->stmt_expr(Call);
+  } else {
+    Body->stmt_return(Call);
+  }
+}
+
+void fold_top_level(Context &C, TopLevel *T, StructuralHasher &H,
+                    FoldStats &Stats) {
+  std::unordered_map<Hash128, FuncDecl *, Hash128Hash> Kept;
+  for (auto *E : T->entries()) {
+    if (auto *NS = dynamic_cast<Namespace *>(E)) {
+      fold_top_level(C, NS->get_body(), H, Stats);
+      continue;
+    }
+    auto *FD = dynamic_cast<FuncDecl *>(E);
+    if (!FD || !is_foldable(FD)) {
+      continue;
+    }
+    Stats.Functions++;
+    auto [It, IsNew] = Kept.emplace(hash_definition(H, FD), FD);
+    if (!IsNew) {
+      fold(C, FD, It->second);
+      Stats.Folded++;
+    }
+  }
+}
+} // namespace
+
+FoldStats namecxx::fold_identical_functions(Context &C, CXXFile &F) {
+  FoldStats Stats;
+  StructuralHasher H;
+  for (auto *T : F.top_levels()) {
+    fold_top_level(C, T, H, Stats);
+  }
+  return Stats;
+}
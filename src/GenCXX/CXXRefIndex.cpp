@@ -0,0 +1,228 @@
+#include "internal/GenCXX.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <unordered_map>
+
+using namespace namecxx;
+
+namespace {
+// Split "a::b" into the names, or nothing if it is not a qualified name.
+std::vector<std::string> split_qualified(const std::string &Text) {
+  std::vector<std::string> Names(1);
+  for (size_t I = 0; I < Text.size(); ++I) {
+    char C = Text[I];
+    if (std::isalnum(static_cast<unsigned char>(C)) || C == '_') {
+      Names.back() += C;
+    } else if (Text.compare(I, 2, "::") == 0 && !Names.back().empty()) {
+      Names.emplace_back();
+      ++I;
+    } else {
+      return {};
+    }
+  }
+  if (Names.back().empty()) {
+    return {};
+  }
+  return Names;
+}
+
+class RefIndexBuilder : public RecursiveVisitor<RefIndexBuilder> {
+  struct Candidate {
+    // Qualified with the enclosing namespaces and classes.
+    std::vector<std::string> Path;
+    FuncDecl *FD;
+  };
+
+  struct Call {
+    FuncDecl *Caller;
+    CallExpr *E;
+    // The index of the enclosing scopes in ScopePaths.
+    size_t Scope;
+  };
+
+  RefIndex &Index;
+  FuncDecl *Current = nullptr;
+  // The enclosing namespaces and classes.
+  std::vector<std::string> Scopes;
+  // The values of Scopes where the calls are, and the index of the current.
+  std::vector<std::vector<std::string>> ScopePaths = {{}};
+  size_t CurrentScope = 0;
+  // The functions by the last name.
+  std::unordered_map<std::string, std::vector<Candidate>> Functions;
+  std::vector<Call> Calls;
+
+  static bool is_same_signature(FuncDecl *L, FuncDecl *R) {
+    auto LParams = L->get_params(), RParams = R->get_params();
+    return LParams.size() == RParams.size() &&
+           L->is_vararg() == R->is_vararg();
+  }
+
+  static bool accepts(FuncDecl *FD, size_t Args) {
+    auto Params = FD->get_params();
+    size_t Required = 0;
+    for (auto *P : Params) {
+      Required += P->get_init() == nullptr;
+    }
+    return Required <= Args && (Args <= Params.size() || FD->is_vararg());
+  }
+
+  // Path is Names qualified with the first Depth names of Scope.
+  static bool is_qualified(const std::vector<std::string> &Path,
+                           const std::vector<std::string> &Scope,
+                           size_t Depth,
+                           const std::vector<std::string> &Names) {
+    return Path.size() == Depth + Names.size() &&
+           std::equal(Scope.begin(), Scope.begin() + Depth, Path.begin()) &&
+           std::equal(Names.begin(), Names.end(), Path.begin() + Depth);
+  }
+
+  // Traverse by Traverse with Names appended to the enclosing scopes.
+  template <typename FnT>
+  bool in_scope(const std::vector<std::string> &Names, FnT Traverse) {
+    if (Names.empty()) {
+      return Traverse();
+    }
+    auto Size = Scopes.size();
+    auto Outer = CurrentScope;
+    Scopes.insert(Scopes.end(), Names.begin(), Names.end());
+    CurrentScope = ScopePaths.size();
+    ScopePaths.push_back(Scopes);
+    bool Result = Traverse();
+    Scopes.resize(Size);
+    CurrentScope = Outer;
+    return Result;
+  }
+
+  void add_function(FuncDecl *FD) {
+    auto Path = Scopes;
+    for (auto &Name : FD->get_name().get_names()) {
+      Path.push_back(Name);
+    }
+    auto &Same = Functions[Path.back()];
+    for (auto &Cand : Same) {
+      // A declaration and the definition of one function.
+      if (Cand.Path == Path && is_same_signature(Cand.FD, FD)) {
+        if (Cand.FD->is_forward() && !FD->is_forward()) {
+          Cand.FD = FD;
+        }
+        return;
+      }
+    }
+    Same.push_back({std::move(Path), FD});
+  }
+
+  FuncDecl *resolve(const Call &Call) {
+    auto *Callee = Call.E->get_callee();
+    while (auto *P = cast<ParenExpr>(Callee)) {
+      Callee = P->get_inside();
+    }
+    std::vector<std::string> Names;
+    if (auto *Q = cast<QualNameExpr>(Callee)) {
+      Names = Q->get_name().get_names();
+    } else if (auto *Raw = cast<RawExpr>(Callee)) {
+      Names = split_qualified(Raw->get_val());
+    }
+    if (Names.empty()) {
+      return nullptr;
+    }
+    auto It = Functions.find(Names.back());
+    if (It == Functions.end()) {
+      return nullptr;
+    }
+    size_t Args = std::distance(Call.E->args().begin(), Call.E->args().end());
+    // Looked up from the innermost enclosing scope outwards, stopping at the
+    // first scope declaring the name, as C++ does.
+    auto &Scope = ScopePaths[Call.Scope];
+    for (size_t Depth = Scope.size() + 1; Depth-- > 0;) {
+      FuncDecl *Found = nullptr;
+      bool IsDeclared = false;
+      for (auto &Cand : It->second) {
+        if (!is_qualified(Cand.Path, Scope, Depth, Names)) {
+          continue;
+        }
+        IsDeclared = true;
+        if (accepts(Cand.FD, Args)) {
+          if (Found) {
+            return nullptr;
+          }
+          Found = Cand.FD;
+        }
+      }
+      if (IsDeclared) {
+        return Found;
+      }
+    }
+    return nullptr;
+  }
+
+public:
+  RefIndexBuilder(RefIndex &Index) : Index(Index) {}
+
+  bool traverse_directive(Directive *D) {
+    auto *N = cast<Namespace>(D);
+    if (!N) {
+      return RecursiveVisitor::traverse_directive(D);
+    }
+    return in_scope(N->get_name().get_names(), [&] {
+      return RecursiveVisitor::traverse_directive(D);
+    });
+  }
+
+  bool traverse_decl(Decl *D) {
+    if (auto *CD = cast<ClassDecl>(D); CD && !CD->is_forward()) {
+      return in_scope({CD->get_name().last()},
+                      [&] { return RecursiveVisitor::traverse_decl(D); });
+    }
+    if (auto *FF = cast<FuncSplitForwardDecl>(D)) {
+      add_function(FF->get_func_decl());
+      return true;
+    }
+    auto *FD = cast<FuncDecl>(D);
+    if (!FD) {
+      return RecursiveVisitor::traverse_decl(D);
+    }
+    add_function(FD);
+    if (FD->is_forward()) {
+      return RecursiveVisitor::traverse_decl(D);
+    }
+    Index.add_function(FD);
+    auto *Outer = Current;
+    Current = FD;
+    // The body of A::f is in the scope of A.
+    auto Qualifiers = FD->get_name().get_names();
+    Qualifiers.pop_back();
+    bool Result = in_scope(
+        Qualifiers, [&] { return RecursiveVisitor::traverse_decl(D); });
+    Current = Outer;
+    return Result;
+  }
+  bool visit_call_expr(CallExpr *E) {
+    Calls.push_back({Current, E, CurrentScope});
+    return true;
+  }
+  bool visit_variable_expr(VariableExpr *E) {
+    Index.add_use(E->get_decl(), Current, E);
+    return true;
+  }
+
+  void resolve_calls() {
+    for (auto &Call : Calls) {
+      if (auto *Callee = resolve(Call)) {
+        Index.add_call(Call.Caller, Callee, Call.E);
+      } else {
+        Index.add_unresolved_call(Call.Caller, Call.E);
+      }
+    }
+  }
+};
+} // namespace
+
+RefIndex namecxx::build_ref_index(CXXFile &F) {
+  RefIndex Index;
+  RefIndexBuilder Builder(Index);
+  Builder.traverse_file(&F);
+  Builder.resolve_calls();
+  return Index;
+}
@@ -1,5 +1,7 @@
 #include "internal/GenCXX.h"
 
+#include <algorithm>
+
 using namespace namecxx;
 
 FuncDecl *TopLevel::def_func(QualName Name, Type *RetTy,
@@ -64,6 +66,13 @@ MethodDecl *TopLevel::def_dtor(QualName ClassName) {
 
 void TopLevel::def_dtor_define(MethodSplitDecl *MD) { Entries.push_back(MD); }
 
+size_t TopLevel::remove_if(const std::function<bool(Emit *)> &Pred) {
+  auto It = std::remove_if(Entries.begin(), Entries.end(), Pred);
+  size_t Removed = Entries.end() - It;
+  Entries.erase(It, Entries.end());
+  return Removed;
+}
+
 void TopLevel::emit_impl(std::ostream &SS) {
   for (auto *E : Entries) {
     SS << E << "\n";
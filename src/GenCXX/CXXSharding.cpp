@@ -0,0 +1,183 @@
+#include "internal/GenCXX.h"
+
+#include <sstream>
+#include <unordered_set>
+
+using namespace namecxx;
+
+namespace {
+class UnitBuilder {
+  std::vector<ShardUnit> Units;
+  // Functions whose prototypes are already in the header.
+  std::unordered_set<FuncDecl *> Declared;
+  // Class templates, whose members are defined in the header.
+  std::unordered_set<ClassOrUnion *> Templates;
+  std::vector<std::string> Warnings;
+
+  ClassOrUnion *get_parent(FuncDecl *FD) {
+    if (auto *MD = cast<MethodSplitDecl>(FD)) {
+      return MD->get_parent();
+    }
+    if (auto *CD = cast<CtorSplitDecl>(FD)) {
+      return CD->get_parent();
+    }
+    return nullptr;
+  }
+
+  void add_func(ShardUnit &U, FuncDecl *FD, bool IsLocal) {
+    U.Names.push_back(FD->get_name_str());
+    if (FD->is_inline() || FD->is_constexpr() ||
+        Templates.count(get_parent(FD))) {
+      return;
+    }
+    if (FD->is_forward()) {
+      if (FD->is_static() || IsLocal) {
+        U.Kind = ShardUnitKind::Local;
+      }
+      return;
+    }
+    if (FD->is_static() || IsLocal) {
+      U.Kind = ShardUnitKind::Local;
+      return;
+    }
+    U.Kind = ShardUnitKind::Definition;
+    // Methods and qualified names are declared in their scopes.
+    if (!Declared.count(FD) && !cast<MethodDecl>(FD) &&
+        FD->get_name().get_names().size() == 1) {
+      std::ostringstream SS;
+      FD->emit_forward(SS);
+      U.Declaration = SS.str();
+    }
+  }
+
+  void add_var(ShardUnit &U, VarDecl *V, bool IsLocal) {
+    if (V->is_extern() || V->is_const() || V->is_inline()) {
+      return;
+    }
+    U.Names.push_back(V->get_name_str());
+    if (V->is_static() || IsLocal) {
+      U.Kind = ShardUnitKind::Local;
+      return;
+    }
+    U.Kind = ShardUnitKind::Definition;
+    // Static members and qualified names are declared in their scopes.
+    if (V->get_name().get_names().size() != 1) {
+      return;
+    }
+    std::ostringstream SS;
+    V->emit_extern(SS);
+    SS << ";";
+    U.Declaration = SS.str();
+  }
+
+  // Warn the functions and variables defined in T, which is in an #if branch
+  // put in the header.
+  void warn_definitions(TopLevel *T) {
+    for (auto *E : T->entries()) {
+      auto *D = cast<Decl>(E);
+      if (auto *S = cast<DeclStmt>(E)) {
+        D = S->get_decl();
+      }
+      std::string Name;
+      if (auto *N = cast<Namespace>(E)) {
+        warn_definitions(N->get_body());
+      } else if (auto *If = cast<IfDirectiveBase>(E)) {
+        warn_branches(If);
+      } else if (auto *FD = cast<FuncDecl>(D)) {
+        if (!FD->is_forward() && !FD->is_inline() && !FD->is_constexpr()) {
+          Name = FD->get_name_str();
+        }
+      } else if (auto *V = cast<VarDecl>(D)) {
+        if (!V->is_extern() && !V->is_const() && !V->is_inline()) {
+          Name = V->get_name_str();
+        }
+      }
+      if (!Name.empty()) {
+        Warnings.push_back("The definition of " + Name +
+                           " in an #if branch is put in the header.");
+      }
+    }
+  }
+
+  void warn_branches(IfDirectiveBase *If) {
+    warn_definitions(If->get_then());
+    for (auto &[Cond, Branch] : If->elifs()) {
+      warn_definitions(Branch);
+    }
+    if (If->has_else()) {
+      warn_definitions(If->get_else());
+    }
+  }
+
+public:
+  void add_top_level(TopLevel *T, const std::vector<std::string> &Namespaces,
+                     bool IsLocal) {
+    for (auto *E : T->entries()) {
+      if (auto *N = cast<Namespace>(E)) {
+        auto Inner = Namespaces;
+        Inner.push_back(N->get_name_str());
+        add_top_level(N->get_body(), Inner,
+                      IsLocal || Inner.back().empty());
+        continue;
+      }
+      ShardUnit U;
+      U.Text = E->to_string();
+      U.Namespaces = Namespaces;
+      if (auto *If = cast<IfDirectiveBase>(E)) {
+        warn_branches(If);
+      }
+      auto *D = cast<Decl>(E);
+      if (auto *S = cast<DeclStmt>(E)) {
+        D = S->get_decl();
+      }
+      if (auto *CT = cast<ClassTemplateDecl>(D)) {
+        Templates.insert(CT->get_decl()->get_class());
+      } else if (auto *UT = cast<UnionTemplateDecl>(D)) {
+        Templates.insert(UT->get_decl()->get_union());
+      } else if (auto *FF = cast<FuncSplitForwardDecl>(D)) {
+        auto *FD = FF->get_func_decl();
+        if (FD->is_static() || IsLocal) {
+          U.Kind = ShardUnitKind::Local;
+          U.Names.push_back(FD->get_name_str());
+        } else {
+          Declared.insert(FD);
+        }
+      } else if (auto *FD = cast<FuncDecl>(D)) {
+        add_func(U, FD, IsLocal);
+      } else if (auto *V = cast<VarDecl>(D)) {
+        add_var(U, V, IsLocal);
+      }
+      Units.push_back(std::move(U));
+    }
+  }
+  std::vector<ShardUnit> take() { return std::move(Units); }
+  std::vector<std::string> take_warnings() { return std::move(Warnings); }
+};
+} // namespace
+
+static UnitBuilder make_units(CXXFile &F) {
+  UnitBuilder B;
+  for (auto *T : F.top_levels()) {
+    B.add_top_level(T, {}, false);
+  }
+  return B;
+}
+
+static ShardedFile add_warnings(ShardedFile Shards, UnitBuilder &B) {
+  for (auto &W : B.take_warnings()) {
+    Shards.add_warning(std::move(W));
+  }
+  return Shards;
+}
+
+ShardedFile namecxx::shard_file(CXXFile &F, size_t NumShards,
+                                const std::string &Stem) {
+  auto B = make_units(F);
+  return add_warnings(plan_shards(B.take(), NumShards, Stem, ".hpp", ".cpp"),
+                      B);
+}
+
+ShardedFile namecxx::split_file(CXXFile &F, const std::string &Stem) {
+  auto B = make_units(F);
+  return add_warnings(plan_split(B.take(), Stem, ".hpp", ".cpp"), B);
+}
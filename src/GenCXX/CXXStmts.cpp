@@ -2,6 +2,17 @@
 
 using namespace namecxx;
 
+namespace {
+// The attribute on the branch, such as if(c)[[likely]]{...}.
+void emit_hint(std::ostream &SS, Likelihood Hint) {
+  if (Hint == Likelihood::Likely) {
+    SS << "[[likely]]";
+  } else if (Hint == Likelihood::Unlikely) {
+    SS << "[[unlikely]]";
+  }
+}
+} // namespace
+
 void RawStmt::emit_impl(std::ostream &SS) { SS << get_val(); }
 
 void DeclStmt::emit_impl(std::ostream &SS) { SS << get_decl() << ";"; }
@@ -15,13 +26,18 @@ void IfStmt::emit_impl(std::ostream &SS) {
   if (get_init()) {
     SS << get_init() << ";";
   }
-  SS << get_cond() << "){" << get_then() << "}";
-  for (auto &[ECond, EBody, EInit] : Elseifs) {
+  SS << get_cond() << ")";
+  emit_hint(SS, Hint);
+  SS << "{" << get_then() << "}";
+  for (size_t I = 0; I < Elseifs.size(); ++I) {
+    auto &[ECond, EBody, EInit] = Elseifs[I];
     SS << "else if(";
     if (EInit) {
       SS << EInit << ";";
     }
-    SS << ECond << "){" << EBody << "}";
+    SS << ECond << ")";
+    emit_hint(SS, ElseifHints[I]);
+    SS << "{" << EBody << "}";
   }
   if (has_else()) {
     SS << "else{" << Else << "}";
@@ -29,7 +45,9 @@ void IfStmt::emit_impl(std::ostream &SS) {
 }
 
 void WhileStmt::emit_impl(std::ostream &SS) {
-  SS << "while(" << get_cond() << "){";
+  SS << "while(" << get_cond() << ")";
+  emit_hint(SS, Hint);
+  SS << "{";
   SS << get_body();
   SS << "}";
 }
@@ -50,7 +68,9 @@ void ForStmt::emit_impl(std::ostream &SS) {
   if (get_step()) {
     SS << get_step();
   }
-  SS << "){" << get_body() << "}";
+  SS << ")";
+  emit_hint(SS, Hint);
+  SS << "{" << get_body() << "}";
 }
 
 void ForRangeStmt::emit_impl(std::ostream &SS) {
@@ -95,6 +115,7 @@ void GotoStmt::emit_impl(std::ostream &SS) {
 }
 
 void CaseStmt::emit_impl(std::ostream &SS) {
+  emit_hint(SS, Hint);
   if (get_val()) {
     SS << "case " << get_val() << ":";
   } else {
@@ -123,7 +144,7 @@ CaseStmt *SwitchStmt::add_default(bool IsFallThrough) {
 void SwitchStmt::emit_impl(std::ostream &SS) {
   SS << "switch(" << get_cond() << "){";
   for (auto &C : Cases) {
-    SS << C;
+    SS << C.get();
   }
   SS << "}";
 }
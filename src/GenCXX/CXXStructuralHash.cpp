@@ -0,0 +1,326 @@
+#include "internal/GenCXX.h"
+
+using namespace namecxx;
+
+namespace {
+// Tags distinguishing the node categories. The kinds are added to them.
+enum : uint64_t {
+  NullTag = 0,
+  ExprTag = 0x100,
+  StmtTag = 0x200,
+  ScopeTag = 0x300,
+  EmittedTag = 0x400,
+};
+
+uint64_t tag(uint64_t Base, uint64_t Kind) { return Base + Kind; }
+
+void add_name(Hash128Builder &B, QualName Name) {
+  B.add(static_cast<uint64_t>(Name.get_names().size()));
+  for (auto &N : Name.names()) {
+    B.add(N);
+  }
+}
+} // namespace
+
+void StructuralHasher::add_emitted(Hash128Builder &B, Emit *E) {
+  if (!E) {
+    B.add(NullTag);
+    return;
+  }
+  HashStreamBuf Buf;
+  std::ostream OS(&Buf);
+  E->emit(OS);
+  B.add(EmittedTag).add(Buf.get());
+}
+
+void StructuralHasher::add(Hash128Builder &B, Expr *E) {
+  if (!E) {
+    B.add(NullTag);
+    return;
+  }
+  B.add(tag(ExprTag, static_cast<uint64_t>(E->get_kind())));
+  switch (E->get_kind()) {
+  case ExprKind::Raw:
+    B.add(static_cast<RawExpr *>(E)->get_val());
+    break;
+  case ExprKind::Variable:
+    add_name(B, static_cast<VariableExpr *>(E)->get_decl()->get_name());
+    break;
+  case ExprKind::Subscript: {
+    auto *S = static_cast<SubscriptExpr *>(E);
+    add(B, S->get_array());
+    add(B, S->get_index());
+    break;
+  }
+  case ExprKind::Call: {
+    auto *C = static_cast<CallExpr *>(E);
+    add(B, C->get_callee());
+    for (auto *A : C->args()) {
+      add(B, A);
+    }
+    B.add(NullTag);
+    break;
+  }
+  case ExprKind::UnaryOp: {
+    auto *U = static_cast<UnaryOp *>(E);
+    B.add(U->get_op()).add(U->is_prefix());
+    add(B, U->get_operand());
+    break;
+  }
+  case ExprKind::BinaryOp: {
+    auto *Bin = static_cast<BinaryOp *>(E);
+    B.add(Bin->get_op());
+    add(B, Bin->get_lhs());
+    add(B, Bin->get_rhs());
+    break;
+  }
+  case ExprKind::TernaryOp: {
+    auto *T = static_cast<TernaryOp *>(E);
+    add(B, T->get_cond());
+    add(B, T->get_then());
+    add(B, T->get_else());
+    break;
+  }
+  case ExprKind::Cast: {
+    auto *C = static_cast<CastExpr *>(E);
+    add_emitted(B, C->get_type());
+    add(B, C->get_operand());
+    break;
+  }
+  case ExprKind::Paren:
+    add(B, static_cast<ParenExpr *>(E)->get_inside());
+    break;
+  case ExprKind::InitList:
+    for (auto *V : static_cast<InitListExpr *>(E)->values()) {
+      add(B, V);
+    }
+    B.add(NullTag);
+    break;
+  case ExprKind::New: {
+    auto *N = static_cast<NewExpr *>(E);
+    add(B, N->get_placement());
+    add_emitted(B, N->get_type());
+    add(B, N->get_array_size());
+    B.add(N->is_list_init());
+    for (auto *A : N->args()) {
+      add(B, A);
+    }
+    B.add(NullTag);
+    break;
+  }
+  case ExprKind::Delete: {
+    auto *D = static_cast<DeleteExpr *>(E);
+    B.add(D->is_array());
+    add(B, D->get_expr());
+    break;
+  }
+  case ExprKind::UserDefinedLiteral: {
+    auto *U = static_cast<UserDefinedLiteral *>(E);
+    B.add(U->get_postfix());
+    add(B, U->get_expr());
+    break;
+  }
+  case ExprKind::QualName:
+    add_name(B, static_cast<QualNameExpr *>(E)->get_name());
+    break;
+  case ExprKind::Lambda: {
+    auto *L = static_cast<LambdaExpr *>(E);
+    for (auto *C : L->captures()) {
+      add(B, C);
+    }
+    B.add(NullTag);
+    for (auto *P : L->params()) {
+      add_emitted(B, P);
+    }
+    B.add(NullTag).add(L->is_vararg());
+    add_emitted(B, L->get_ret_type());
+    add(B, L->get_body());
+    break;
+  }
+  case ExprKind::Instantiate: {
+    auto *I = static_cast<InstantiateExpr *>(E);
+    add_name(B, I->get_template_decl()->get_name());
+    for (auto *A : I->args()) {
+      if (auto *AE = dynamic_cast<Expr *>(A)) {
+        add(B, AE);
+      } else {
+        add_emitted(B, A);
+      }
+    }
+    B.add(NullTag);
+    break;
+  }
+  case ExprKind::PackExpansion:
+    add(B, static_cast<PackExpansionExpr *>(E)->get_expr());
+    break;
+  case ExprKind::Fold: {
+    auto *F = static_cast<FoldExpr *>(E);
+    B.add(F->get_op()).add(F->is_left_fold());
+    add(B, F->get_pack());
+    add(B, F->get_init());
+    break;
+  }
+  }
+}
+
+void StructuralHasher::add(Hash128Builder &B, Stmt *S) {
+  if (!S) {
+    B.add(NullTag);
+    return;
+  }
+  B.add(tag(StmtTag, static_cast<uint64_t>(S->get_kind())));
+  switch (S->get_kind()) {
+  case StmtKind::Raw:
+    B.add(static_cast<RawStmt *>(S)->get_val());
+    break;
+  case StmtKind::Decl:
+    add_emitted(B, static_cast<DeclStmt *>(S)->get_decl());
+    break;
+  case StmtKind::If: {
+    auto *If = static_cast<IfStmt *>(S);
+    B.add(If->is_constexpr());
+    B.add(static_cast<uint64_t>(If->get_likelihood()));
+    add_emitted(B, If->get_init());
+    add(B, If->get_cond());
+    add(B, If->get_then());
+    size_t I = 0;
+    for (auto &[Cond, Body, Init] : If->elseifs()) {
+      B.add(static_cast<uint64_t>(If->get_elseif_likelihood(I++)));
+      add_emitted(B, Init);
+      add(B, Cond);
+      add(B, Body);
+    }
+    B.add(NullTag);
+    add(B, If->get_else());
+    break;
+  }
+  case StmtKind::While: {
+    auto *W = static_cast<WhileStmt *>(S);
+    B.add(static_cast<uint64_t>(W->get_likelihood()));
+    add(B, W->get_cond());
+    add(B, W->get_body());
+    break;
+  }
+  case StmtKind::For: {
+    auto *F = static_cast<ForStmt *>(S);
+    B.add(static_cast<uint64_t>(F->get_likelihood()));
+    add(B, F->get_init());
+    add(B, F->get_cond());
+    add(B, F->get_step());
+    add(B, F->get_body());
+    break;
+  }
+  case StmtKind::ForRange: {
+    auto *F = static_cast<ForRangeStmt *>(S);
+    add_emitted(B, F->get_decl());
+    add(B, F->get_range());
+    add(B, F->get_body());
+    break;
+  }
+  case StmtKind::Do: {
+    auto *D = static_cast<DoStmt *>(S);
+    add(B, D->get_body());
+    add(B, D->get_cond());
+    break;
+  }
+  case StmtKind::Block:
+    add(B, static_cast<BlockStmt *>(S)->get_scope());
+    break;
+  case StmtKind::Expr:
+    add(B, static_cast<ExprStmt *>(S)->get_expr());
+    break;
+  case StmtKind::Return:
+    add(B, static_cast<ReturnStmt *>(S)->get_expr());
+    break;
+  case StmtKind::Break:
+  case StmtKind::Continue:
+    break;
+  case StmtKind::Label: {
+    auto *L = static_cast<LabelStmt *>(S);
+    B.add(L->get_label_name());
+    add(B, L->get_stmt());
+    break;
+  }
+  case StmtKind::Goto:
+    B.add(static_cast<GotoStmt *>(S)->get_label_name());
+    break;
+  case StmtKind::Case: {
+    auto *C = static_cast<CaseStmt *>(S);
+    B.add(C->is_fall_through());
+    B.add(static_cast<uint64_t>(C->get_likelihood()));
+    add(B, C->get_val());
+    add(B, C->get_body());
+    break;
+  }
+  case StmtKind::Switch: {
+    auto *Sw = static_cast<SwitchStmt *>(S);
+    add_emitted(B, Sw->get_init());
+    add(B, Sw->get_cond());
+    for (auto &C : Sw->cases()) {
+      add(B, &C);
+    }
+    B.add(NullTag);
+    break;
+  }
+  case StmtKind::Throw:
+    add(B, static_cast<ThrowStmt *>(S)->get_expr());
+    break;
+  case StmtKind::Try: {
+    auto *T = static_cast<TryStmt *>(S);
+    add(B, T->get_body());
+    for (auto &[D, Body] : T->handlers()) {
+      add_emitted(B, D);
+      add(B, Body);
+    }
+    B.add(NullTag);
+    break;
+  }
+  case StmtKind::UsingNamespace:
+    add_name(B, static_cast<UsingNamespaceStmt *>(S)->get_name());
+    break;
+  }
+}
+
+void StructuralHasher::add_entry(Hash128Builder &B, Emit *E) {
+  if (auto *S = dynamic_cast<Stmt *>(E)) {
+    add(B, S);
+  } else {
+    add_emitted(B, E);
+  }
+}
+
+void StructuralHasher::add(Hash128Builder &B, FuncScope *S) {
+  if (!S) {
+    B.add(NullTag);
+    return;
+  }
+  B.add(ScopeTag);
+  for (auto *E : S->entries()) {
+    add_entry(B, E);
+  }
+  B.add(NullTag);
+}
+
+Hash128 StructuralHasher::hash(Expr *E) {
+  Hash128Builder B;
+  add(B, E);
+  return B.get();
+}
+
+Hash128 StructuralHasher::hash(Stmt *S) {
+  Hash128Builder B;
+  add(B, S);
+  return B.get();
+}
+
+Hash128 StructuralHasher::hash(FuncScope *S) {
+  Hash128Builder B;
+  add(B, S);
+  return B.get();
+}
+
+Hash128 StructuralHasher::hash_emitted(Emit *E) {
+  Hash128Builder B;
+  add_emitted(B, E);
+  return B.get();
+}
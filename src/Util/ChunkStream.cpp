@@ -0,0 +1,186 @@
+#include "internal/Util/ChunkStream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+
+using namespace namec_util;
+
+namespace {
+// Thrown out of the producer when the stream is destroyed before the end.
+struct Cancelled {};
+
+// The threads running the producers. They are kept idle for the next streams
+// instead of being started and joined for each stream.
+class ProducerThreads {
+  std::mutex Mutex;
+  std::condition_variable CV;
+  std::vector<std::function<void()>> Tasks;
+  std::vector<std::thread> Threads;
+  size_t Idle = 0;
+  bool IsStopping = false;
+
+  void loop() {
+    std::unique_lock<std::mutex> Lock(Mutex);
+    while (true) {
+      Idle++;
+      CV.wait(Lock, [this] { return IsStopping || !Tasks.empty(); });
+      Idle--;
+      if (Tasks.empty()) {
+        return;
+      }
+      auto Task = std::move(Tasks.back());
+      Tasks.pop_back();
+      Lock.unlock();
+      Task();
+      Lock.lock();
+    }
+  }
+
+public:
+  ~ProducerThreads() {
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      IsStopping = true;
+      CV.notify_all();
+    }
+    for (auto &T : Threads) {
+      T.join();
+    }
+  }
+
+  void run(std::function<void()> Task) {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Tasks.push_back(std::move(Task));
+    if (Idle >= Tasks.size()) {
+      CV.notify_one();
+    } else {
+      Threads.emplace_back([this] { loop(); });
+    }
+  }
+
+  static ProducerThreads &get() {
+    static ProducerThreads Instance;
+    return Instance;
+  }
+};
+} // namespace
+
+// Stream buffer writing directly into the ring buffers of ChunkStream.
+class ChunkStream::RingBuf : public std::streambuf {
+  ChunkStream &S;
+
+  void next_buffer() {
+    if (!S.publish(pptr() - pbase())) {
+      throw Cancelled();
+    }
+    char *Buf = S.current_buffer();
+    setp(Buf, Buf + S.ChunkSize);
+  }
+
+public:
+  RingBuf(ChunkStream &S) : S(S) {
+    char *Buf = S.current_buffer();
+    setp(Buf, Buf + S.ChunkSize);
+  }
+
+  void finish() { S.publish(pptr() - pbase()); }
+
+protected:
+  int_type overflow(int_type Ch) override {
+    next_buffer();
+    if (!traits_type::eq_int_type(Ch, traits_type::eof())) {
+      *pptr() = traits_type::to_char_type(Ch);
+      pbump(1);
+    }
+    return traits_type::not_eof(Ch);
+  }
+
+  std::streamsize xsputn(const char *Str, std::streamsize Count) override {
+    std::streamsize Written = 0;
+    while (Written < Count) {
+      if (pptr() == epptr()) {
+        next_buffer();
+      }
+      std::streamsize Len =
+          std::min<std::streamsize>(epptr() - pptr(), Count - Written);
+      std::memcpy(pptr(), Str + Written, Len);
+      pbump(static_cast<int>(Len));
+      Written += Len;
+    }
+    return Written;
+  }
+};
+
+ChunkStream::ChunkStream(Producer P, size_t ChunkSize, size_t NumBuffers)
+    : ChunkSize(ChunkSize ? ChunkSize : 1) {
+  // At least two, so the producer can write while the consumer reads.
+  NumBuffers = std::max<size_t>(NumBuffers, 2);
+  for (size_t I = 0; I < NumBuffers; ++I) {
+    Buffers.push_back(std::make_unique<char[]>(this->ChunkSize));
+  }
+  Sizes.resize(NumBuffers);
+  ProducerThreads::get().run([this, P = std::move(P)] {
+    RingBuf Buf(*this);
+    std::exception_ptr E;
+    try {
+      std::ostream OS(&Buf);
+      // So that Cancelled thrown by Buf unwinds P instead of setting badbit.
+      OS.exceptions(std::ios::badbit);
+      P(OS);
+    } catch (const Cancelled &) {
+    } catch (...) {
+      E = std::current_exception();
+    }
+    Buf.finish();
+    std::lock_guard<std::mutex> Lock(Mutex);
+    Error = E;
+    IsDone = true;
+    CV.notify_all();
+  });
+}
+
+ChunkStream::~ChunkStream() {
+  std::unique_lock<std::mutex> Lock(Mutex);
+  IsCancelled = true;
+  CV.notify_all();
+  CV.wait(Lock, [this] { return IsDone; });
+}
+
+bool ChunkStream::publish(size_t Size) {
+  std::unique_lock<std::mutex> Lock(Mutex);
+  if (IsCancelled) {
+    return false;
+  }
+  if (Size == 0) {
+    // Nothing to hand over. Reuse the current buffer.
+    return true;
+  }
+  Sizes[Filled % Buffers.size()] = Size;
+  Filled++;
+  CV.notify_all();
+  CV.wait(Lock, [this] {
+    return IsCancelled || Filled - Consumed < Buffers.size();
+  });
+  return !IsCancelled;
+}
+
+std::string_view ChunkStream::next() {
+  std::unique_lock<std::mutex> Lock(Mutex);
+  if (IsReading) {
+    IsReading = false;
+    Consumed++;
+    CV.notify_all();
+  }
+  CV.wait(Lock, [this] { return IsDone || Filled > Consumed; });
+  if (Filled == Consumed) {
+    if (Error) {
+      std::rethrow_exception(Error);
+    }
+    return {};
+  }
+  IsReading = true;
+  size_t Index = Consumed % Buffers.size();
+  return std::string_view(Buffers[Index].get(), Sizes[Index]);
+}
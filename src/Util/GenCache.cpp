@@ -0,0 +1,206 @@
+#include "internal/Util/GenCache.h"
+
+#include <algorithm>
+#include <fstream>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#include "internal/Util/FileUtil.h"
+#include "internal/Util/Hash.h"
+
+using namespace namec_util;
+namespace fs = std::filesystem;
+
+// Each entry is "<fingerprint size>\n<fingerprint><content>" in a file named
+// by the hash of the fingerprint.
+static const char *EntryExt = ".gen";
+
+namespace {
+// A streambuf passing through to the output and copying to the entry being
+// stored. The failures of the entry do not fail the output.
+class TeeBuf : public std::streambuf {
+  std::streambuf *Out;
+  std::streambuf *Entry;
+
+public:
+  bool IsEntryFailed = false;
+  TeeBuf(std::streambuf *Out, std::streambuf *Entry)
+      : Out(Out), Entry(Entry) {}
+
+protected:
+  int_type overflow(int_type Ch) override {
+    if (traits_type::eq_int_type(Ch, traits_type::eof())) {
+      return traits_type::not_eof(Ch);
+    }
+    auto C = traits_type::to_char_type(Ch);
+    IsEntryFailed |= traits_type::eq_int_type(Entry->sputc(C),
+                                              traits_type::eof());
+    return Out->sputc(C);
+  }
+  std::streamsize xsputn(const char *S, std::streamsize N) override {
+    IsEntryFailed |= Entry->sputn(S, N) != N;
+    return Out->sputn(S, N);
+  }
+  int sync() override {
+    IsEntryFailed |= Entry->pubsync() != 0;
+    return Out->pubsync();
+  }
+};
+} // namespace
+
+GenCache::GenCache(fs::path Dir, uintmax_t MaxBytes)
+    : Dir(Dir), MaxBytes(MaxBytes) {
+  std::error_code EC;
+  fs::create_directories(Dir, EC);
+  std::vector<std::pair<fs::file_time_type, fs::path>> Found;
+  for (auto &E : fs::directory_iterator(Dir, EC)) {
+    if (E.is_regular_file(EC) && E.path().extension() == EntryExt) {
+      Found.emplace_back(E.last_write_time(EC), E.path());
+    }
+  }
+  // Hits refresh the write time, so the order is kept across instances.
+  std::sort(Found.begin(), Found.end());
+  for (auto &[Time, Path] : Found) {
+    use_entry(Path);
+  }
+}
+
+fs::path GenCache::entry_path(const std::string &Fingerprint) {
+  return Dir / (to_hex(hash_fnv1a(Fingerprint)) + EntryExt);
+}
+
+bool GenCache::open_entry(const std::string &Fingerprint, std::ifstream &IS) {
+  IS.open(entry_path(Fingerprint), std::ios::binary);
+  if (!IS) {
+    return false;
+  }
+  size_t Size = 0;
+  if (!(IS >> Size) || IS.get() != '\n' || Size != Fingerprint.size()) {
+    return false;
+  }
+  std::string Stored(Size, '\0');
+  return IS.read(Stored.data(), Size) && Stored == Fingerprint;
+}
+
+void GenCache::use_entry(const fs::path &Path) {
+  auto Name = Path.filename().string();
+  auto It = Entries.find(Name);
+  if (It == Entries.end()) {
+    std::error_code EC;
+    auto Size = fs::file_size(Path, EC);
+    if (EC) {
+      return;
+    }
+    It = Entries.emplace(Name, EntryInfo{Size, 0}).first;
+    TotalBytes += Size;
+  } else {
+    ByUse.erase(It->second.LastUse);
+  }
+  It->second.LastUse = UseCount++;
+  ByUse.emplace(It->second.LastUse, Name);
+}
+
+void GenCache::forget_entry(const std::string &Name) {
+  auto It = Entries.find(Name);
+  if (It == Entries.end()) {
+    return;
+  }
+  TotalBytes -= It->second.Size;
+  ByUse.erase(It->second.LastUse);
+  Entries.erase(It);
+}
+
+void GenCache::evict() {
+  if (MaxBytes == 0) {
+    return;
+  }
+  while (TotalBytes > MaxBytes && !ByUse.empty()) {
+    auto Name = ByUse.begin()->second;
+    auto Size = Entries[Name].Size;
+    std::error_code EC;
+    fs::remove(Dir / Name, EC);
+    forget_entry(Name);
+    Stats.Evictions++;
+    Stats.EvictedBytes += Size;
+  }
+}
+
+bool GenCache::emit(const std::string &Fingerprint, std::ostream &SS,
+                    Generator Gen) {
+  auto Path = entry_path(Fingerprint);
+  std::ifstream IS;
+  if (open_entry(Fingerprint, IS)) {
+    Stats.Hits++;
+    if (IS.peek() != std::ifstream::traits_type::eof()) {
+      SS << IS.rdbuf();
+    }
+    IS.close();
+    std::error_code EC;
+    fs::last_write_time(Path, fs::file_time_type::clock::now(), EC);
+    use_entry(Path);
+    return true;
+  }
+  IS.close();
+  Stats.Misses++;
+  // The output goes to SS and the entry at once, without holding it.
+  auto TmpPath = unique_tmp_path(Path);
+  std::ofstream Entry(TmpPath, std::ios::binary);
+  Entry << Fingerprint.size() << "\n" << Fingerprint;
+  TeeBuf Tee(SS.rdbuf(), Entry.rdbuf());
+  std::ostream Out(&Tee);
+  std::error_code EC;
+  try {
+    Gen(Out);
+  } catch (...) {
+    Entry.close();
+    fs::remove(TmpPath, EC);
+    throw;
+  }
+  Out.flush();
+  if (!Out) {
+    SS.setstate(std::ios::badbit);
+  }
+  Entry.close();
+  if (Tee.IsEntryFailed || Entry.fail()) {
+    fs::remove(TmpPath, EC);
+    return false;
+  }
+  // Rename so that a reader never sees a partially written entry.
+  forget_entry(Path.filename().string());
+  fs::rename(TmpPath, Path, EC);
+  if (EC) {
+    fs::remove(TmpPath, EC);
+    return false;
+  }
+  use_entry(Path);
+  evict();
+  return false;
+}
+
+WriteResult GenCache::emit_to_file(const std::string &Fingerprint,
+                                   fs::path Path, Generator Gen,
+                                   bool IsSkipUnchanged) {
+  return write_file(Path, IsSkipUnchanged, [&](std::ostream &OS) {
+    emit(Fingerprint, OS, Gen);
+  });
+}
+
+bool GenCache::contains(const std::string &Fingerprint) {
+  std::ifstream IS;
+  return open_entry(Fingerprint, IS);
+}
+
+uintmax_t GenCache::size_bytes() { return TotalBytes; }
+
+void GenCache::clear() {
+  std::error_code EC;
+  for (auto &E : fs::directory_iterator(Dir, EC)) {
+    if (E.is_regular_file(EC) && E.path().extension() == EntryExt) {
+      fs::remove(E.path(), EC);
+    }
+  }
+  Entries.clear();
+  ByUse.clear();
+  TotalBytes = 0;
+}
@@ -0,0 +1,226 @@
+#include "internal/Util/Json.h"
+
+#include <cctype>
+#include <charconv>
+
+using namespace namec_util;
+
+namespace {
+class JsonParser {
+  static constexpr int MaxDepth = 256;
+  std::string_view Text;
+  size_t Pos = 0;
+
+  void skip_space() {
+    while (Pos < Text.size() &&
+           std::isspace(static_cast<unsigned char>(Text[Pos]))) {
+      ++Pos;
+    }
+  }
+
+  bool consume(char C) {
+    skip_space();
+    if (Pos < Text.size() && Text[Pos] == C) {
+      ++Pos;
+      return true;
+    }
+    return false;
+  }
+
+  static void append_utf8(std::string &S, unsigned Code) {
+    if (Code < 0x80) {
+      S += static_cast<char>(Code);
+    } else if (Code < 0x800) {
+      S += static_cast<char>(0xc0 | (Code >> 6));
+      S += static_cast<char>(0x80 | (Code & 0x3f));
+    } else if (Code < 0x10000) {
+      S += static_cast<char>(0xe0 | (Code >> 12));
+      S += static_cast<char>(0x80 | ((Code >> 6) & 0x3f));
+      S += static_cast<char>(0x80 | (Code & 0x3f));
+    } else {
+      S += static_cast<char>(0xf0 | (Code >> 18));
+      S += static_cast<char>(0x80 | ((Code >> 12) & 0x3f));
+      S += static_cast<char>(0x80 | ((Code >> 6) & 0x3f));
+      S += static_cast<char>(0x80 | (Code & 0x3f));
+    }
+  }
+
+  // The 4 hex digits after \u.
+  bool parse_hex4(unsigned &Code) {
+    auto Hex = Text.substr(Pos, 4);
+    auto [End, EC] =
+        std::from_chars(Hex.data(), Hex.data() + Hex.size(), Code, 16);
+    if (Hex.size() != 4 || EC != std::errc() ||
+        End != Hex.data() + Hex.size()) {
+      return false;
+    }
+    Pos += 4;
+    return true;
+  }
+
+  // The code point of \u after the backslash and 'u', combining a pair of
+  // UTF-16 surrogates.
+  bool parse_escaped_code(unsigned &Code) {
+    if (!parse_hex4(Code)) {
+      return false;
+    }
+    if (Code >= 0xdc00 && Code < 0xe000) {
+      return false;
+    }
+    if (Code < 0xd800 || Code >= 0xdc00) {
+      return true;
+    }
+    unsigned Low;
+    if (Text.substr(Pos, 2) != "\\u") {
+      return false;
+    }
+    Pos += 2;
+    if (!parse_hex4(Low) || Low < 0xdc00 || Low >= 0xe000) {
+      return false;
+    }
+    Code = 0x10000 + ((Code - 0xd800) << 10) + (Low - 0xdc00);
+    return true;
+  }
+
+  bool parse_string(std::string &S) {
+    if (!consume('"')) {
+      return false;
+    }
+    while (Pos < Text.size() && Text[Pos] != '"') {
+      char C = Text[Pos++];
+      if (C != '\\') {
+        S += C;
+        continue;
+      }
+      if (Pos >= Text.size()) {
+        return false;
+      }
+      switch (char E = Text[Pos++]) {
+      case 'b':
+        S += '\b';
+        break;
+      case 'f':
+        S += '\f';
+        break;
+      case 'n':
+        S += '\n';
+        break;
+      case 'r':
+        S += '\r';
+        break;
+      case 't':
+        S += '\t';
+        break;
+      case 'u': {
+        unsigned Code;
+        if (!parse_escaped_code(Code)) {
+          return false;
+        }
+        append_utf8(S, Code);
+        break;
+      }
+      case '"':
+      case '\\':
+      case '/':
+        S += E;
+        break;
+      default:
+        return false;
+      }
+    }
+    return consume('"');
+  }
+
+  bool parse_scalar(JsonValue &V) {
+    auto Begin = Pos;
+    while (Pos < Text.size() &&
+           (std::isalnum(static_cast<unsigned char>(Text[Pos])) ||
+            Text[Pos] == '-' || Text[Pos] == '+' || Text[Pos] == '.')) {
+      ++Pos;
+    }
+    V.Text = Text.substr(Begin, Pos - Begin);
+    if (V.Text == "null") {
+      V.K = JsonValue::Kind::Null;
+    } else if (V.Text == "true" || V.Text == "false") {
+      V.K = JsonValue::Kind::Bool;
+    } else if (!V.Text.empty() &&
+               (std::isdigit(static_cast<unsigned char>(V.Text[0])) ||
+                V.Text[0] == '-')) {
+      V.K = JsonValue::Kind::Number;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  bool parse_value(JsonValue &V, int Depth) {
+    skip_space();
+    if (Depth > MaxDepth || Pos >= Text.size()) {
+      return false;
+    }
+    switch (Text[Pos]) {
+    case '"':
+      V.K = JsonValue::Kind::String;
+      return parse_string(V.Text);
+    case '[':
+      ++Pos;
+      V.K = JsonValue::Kind::Array;
+      if (consume(']')) {
+        return true;
+      }
+      do {
+        V.Items.emplace_back();
+        if (!parse_value(V.Items.back(), Depth + 1)) {
+          return false;
+        }
+      } while (consume(','));
+      return consume(']');
+    case '{':
+      ++Pos;
+      V.K = JsonValue::Kind::Object;
+      if (consume('}')) {
+        return true;
+      }
+      do {
+        V.Members.emplace_back();
+        auto &[Name, Member] = V.Members.back();
+        if (!parse_string(Name) || !consume(':') ||
+            !parse_value(Member, Depth + 1)) {
+          return false;
+        }
+      } while (consume(','));
+      return consume('}');
+    default:
+      return parse_scalar(V);
+    }
+  }
+
+public:
+  JsonParser(std::string_view Text) : Text(Text) {}
+
+  std::optional<JsonValue> parse() {
+    JsonValue V;
+    if (!parse_value(V, 0)) {
+      return std::nullopt;
+    }
+    skip_space();
+    if (Pos != Text.size()) {
+      return std::nullopt;
+    }
+    return V;
+  }
+};
+} // namespace
+
+const JsonValue *JsonValue::get(std::string_view Key) const {
+  for (auto &[Name, V] : Members) {
+    if (Name == Key) {
+      return &V;
+    }
+  }
+  return nullptr;
+}
+
+std::optional<JsonValue> namec_util::parse_json(std::string_view Text) {
+  return JsonParser(Text).parse();
+}
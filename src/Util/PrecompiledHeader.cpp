@@ -0,0 +1,95 @@
+#include "internal/Util/PrecompiledHeader.h"
+
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "internal/Util/FileUtil.h"
+
+using namespace namec_util;
+
+std::string PrecompiledHeader::get_header() const {
+  std::ostringstream SS;
+  SS << "#pragma once\n";
+  for (auto &Path : Includes) {
+    SS << "#include " << Path << "\n";
+  }
+  return SS.str();
+}
+
+std::string PrecompiledHeader::get_source() const {
+  return "#include \"" + get_header_name() + "\"\n";
+}
+
+std::string PrecompiledHeader::cmake_snippet(
+    const std::string &Target, const std::vector<std::string> &Sources) const {
+  std::ostringstream SS;
+  SS << "# Compile " << get_header_name() << " once and reuse it for "
+     << Target << ".\n";
+  SS << "add_library(" << Name << " OBJECT " << get_source_name() << ")\n";
+  SS << "target_precompile_headers(" << Name << " PRIVATE "
+     << get_header_name() << ")\n";
+  SS << "target_precompile_headers(" << Target << " REUSE_FROM " << Name
+     << ")\n";
+  std::string Skipped;
+  for (auto I : this->Skipped) {
+    if (I < Sources.size()) {
+      Skipped += " " + Sources[I];
+    }
+  }
+  if (!Skipped.empty()) {
+    SS << "set_source_files_properties(" << Skipped.substr(1)
+       << " PROPERTIES SKIP_PRECOMPILE_HEADERS ON)\n";
+  }
+  return SS.str();
+}
+
+std::optional<size_t>
+PrecompiledHeader::emit_to_dir(const std::filesystem::path &Dir,
+                               bool IsSkipUnchanged) const {
+  return count_written(
+      {write_file(Dir / get_header_name(), get_header(), IsSkipUnchanged),
+       write_file(Dir / get_source_name(), get_source(), IsSkipUnchanged)});
+}
+
+std::vector<std::string> namec_util::select_common_includes(
+    const std::vector<std::vector<std::string>> &PerFile, size_t MinFiles) {
+  std::vector<std::string> Order;
+  std::unordered_map<std::string, size_t> Counts;
+  for (auto &Includes : PerFile) {
+    // Counted once per file.
+    std::unordered_set<std::string> Seen;
+    for (auto &Path : Includes) {
+      if (!Seen.insert(Path).second) {
+        continue;
+      }
+      if (Counts[Path]++ == 0) {
+        Order.push_back(Path);
+      }
+    }
+  }
+  std::vector<std::string> Common;
+  for (auto &Path : Order) {
+    if (Counts[Path] >= MinFiles) {
+      Common.push_back(Path);
+    }
+  }
+  return Common;
+}
+
+std::vector<size_t> namec_util::select_skipped_files(
+    const std::vector<std::vector<std::string>> &PerFile,
+    const std::vector<std::string> &Common) {
+  std::vector<size_t> Skipped;
+  for (size_t I = 0; I < PerFile.size(); ++I) {
+    std::unordered_set<std::string> Leading(PerFile[I].begin(),
+                                            PerFile[I].end());
+    for (auto &Path : Common) {
+      if (!Leading.count(Path)) {
+        Skipped.push_back(I);
+        break;
+      }
+    }
+  }
+  return Skipped;
+}
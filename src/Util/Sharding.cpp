@@ -0,0 +1,220 @@
+#include "internal/Util/Sharding.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <functional>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
+
+#include "internal/Util/FileUtil.h"
+#include "internal/Util/TextScan.h"
+
+using namespace namec_util;
+
+std::optional<size_t>
+ShardedFile::emit_to_dir(const std::filesystem::path &Dir,
+                         bool IsSkipUnchanged) const {
+  std::vector<WriteResult> Results = {
+      write_file(Dir / HeaderName, Header, IsSkipUnchanged)};
+  for (auto &[Name, Content] : Sources) {
+    Results.push_back(write_file(Dir / Name, Content, IsSkipUnchanged));
+  }
+  return count_written(Results);
+}
+
+namespace {
+class UnionFind {
+  std::vector<size_t> Parent;
+
+public:
+  UnionFind(size_t N) : Parent(N) {
+    std::iota(Parent.begin(), Parent.end(), 0);
+  }
+  size_t find(size_t I) {
+    while (Parent[I] != I) {
+      Parent[I] = Parent[Parent[I]];
+      I = Parent[I];
+    }
+    return I;
+  }
+  void unite(size_t A, size_t B) {
+    A = find(A);
+    B = find(B);
+    // The smaller index is the root, to keep the result deterministic.
+    if (A != B) {
+      Parent[std::max(A, B)] = std::min(A, B);
+    }
+  }
+};
+
+// Writes the units, opening and closing the namespaces between them.
+class NamespaceWriter {
+  std::ostringstream &SS;
+  std::vector<std::string> Current;
+
+public:
+  NamespaceWriter(std::ostringstream &SS) : SS(SS) {}
+  void write(const std::vector<std::string> &Namespaces,
+             const std::string &Text) {
+    size_t Common = 0;
+    while (Common < Current.size() && Common < Namespaces.size() &&
+           Current[Common] == Namespaces[Common]) {
+      ++Common;
+    }
+    close(Common);
+    for (size_t I = Common; I < Namespaces.size(); ++I) {
+      SS << "namespace " << Namespaces[I] << "{\n";
+    }
+    Current = Namespaces;
+    SS << Text << "\n";
+  }
+  void close(size_t Depth = 0) {
+    if (Current.size() > Depth) {
+      SS << std::string(Current.size() - Depth, '}') << "\n";
+      Current.resize(Depth);
+    }
+  }
+};
+
+std::string guard_macro(const std::string &Name) {
+  std::string Guard;
+  if (Name.empty() || std::isdigit(static_cast<unsigned char>(Name[0]))) {
+    Guard = "_";
+  }
+  for (char C : Name) {
+    auto U = static_cast<unsigned char>(C);
+    Guard += std::isalnum(U) ? static_cast<char>(std::toupper(U)) : '_';
+  }
+  return Guard;
+}
+
+// The shard of each unit, or 0 for the header units.
+std::vector<size_t> assign_shards(const std::vector<ShardUnit> &Units,
+                                  size_t NumShards) {
+  std::vector<size_t> ShardOf(Units.size(), 0);
+  if (NumShards == 1) {
+    return ShardOf;
+  }
+  // Group the units sharing the local definitions.
+  UnionFind Groups(Units.size());
+  std::unordered_map<std::string, size_t> Locals, Definitions;
+  for (size_t I = 0; I < Units.size(); ++I) {
+    auto &U = Units[I];
+    if (U.Kind == ShardUnitKind::Header) {
+      continue;
+    }
+    auto &Map = U.Kind == ShardUnitKind::Local ? Locals : Definitions;
+    for (auto &Name : U.Names) {
+      // A forward declaration and the definition are in the same group.
+      if (auto [It, IsNew] = Map.emplace(Name, I); !IsNew) {
+        Groups.unite(It->second, I);
+      }
+    }
+  }
+  for (size_t I = 0; I < Units.size(); ++I) {
+    auto &U = Units[I];
+    if (U.Kind == ShardUnitKind::Header) {
+      continue;
+    }
+    if (!Locals.empty()) {
+      for_each_identifier(U.Text, [&](std::string_view Name) {
+        if (auto It = Locals.find(std::string(Name)); It != Locals.end()) {
+          Groups.unite(It->second, I);
+        }
+      });
+    }
+    for (auto &Name : U.Anchors) {
+      if (auto It = Definitions.find(Name); It != Definitions.end()) {
+        Groups.unite(It->second, I);
+      } else if (auto It = Locals.find(Name); It != Locals.end()) {
+        Groups.unite(It->second, I);
+      }
+    }
+  }
+
+  // Sizes of the groups, keyed by the roots.
+  std::unordered_map<size_t, size_t> Sizes;
+  for (size_t I = 0; I < Units.size(); ++I) {
+    if (Units[I].Kind != ShardUnitKind::Header) {
+      Sizes[Groups.find(I)] += Units[I].Text.size() + 1;
+    }
+  }
+  std::vector<std::pair<size_t, size_t>> Order(Sizes.begin(), Sizes.end());
+  std::sort(Order.begin(), Order.end(), [](auto &L, auto &R) {
+    return L.second != R.second ? L.second > R.second : L.first < R.first;
+  });
+  std::vector<size_t> Loads(NumShards, 0);
+  std::unordered_map<size_t, size_t> ShardOfRoot;
+  for (auto &[Root, Size] : Order) {
+    size_t Least =
+        std::min_element(Loads.begin(), Loads.end()) - Loads.begin();
+    Loads[Least] += Size;
+    ShardOfRoot[Root] = Least;
+  }
+  for (size_t I = 0; I < Units.size(); ++I) {
+    if (Units[I].Kind != ShardUnitKind::Header) {
+      ShardOf[I] = ShardOfRoot[Groups.find(I)];
+    }
+  }
+  return ShardOf;
+}
+
+// Place Units to the header HeaderName and NumShards sources named by
+// SourceName.
+ShardedFile place_units(const std::vector<ShardUnit> &Units, size_t NumShards,
+                        const std::string &HeaderName,
+                        const std::function<std::string(size_t)> &SourceName) {
+  assert(NumShards > 0 && "No shard to place the definitions");
+  auto ShardOf = assign_shards(Units, NumShards);
+
+  std::ostringstream HS;
+  auto Guard = guard_macro(HeaderName);
+  HS << "#ifndef " << Guard << "\n#define " << Guard << "\n";
+  NamespaceWriter HW(HS);
+  std::vector<std::ostringstream> Shards(NumShards);
+  std::vector<NamespaceWriter> Writers;
+  for (auto &SS : Shards) {
+    SS << "#include \"" << HeaderName << "\"\n";
+    Writers.emplace_back(SS);
+  }
+  for (size_t I = 0; I < Units.size(); ++I) {
+    auto &U = Units[I];
+    if (U.Kind == ShardUnitKind::Header) {
+      HW.write(U.Namespaces, U.Text);
+      continue;
+    }
+    if (!U.Declaration.empty()) {
+      HW.write(U.Namespaces, U.Declaration);
+    }
+    Writers[ShardOf[I]].write(U.Namespaces, U.Text);
+  }
+  HW.close();
+  HS << "#endif // " << Guard << "\n";
+
+  ShardedFile Result(HeaderName, HS.str());
+  for (size_t I = 0; I < NumShards; ++I) {
+    Writers[I].close();
+    Result.add_source(SourceName(I), Shards[I].str());
+  }
+  return Result;
+}
+} // namespace
+
+ShardedFile namec_util::plan_shards(const std::vector<ShardUnit> &Units,
+                                    size_t NumShards, const std::string &Stem,
+                                    const std::string &HeaderExt,
+                                    const std::string &SourceExt) {
+  return place_units(Units, NumShards, Stem + HeaderExt, [&](size_t I) {
+    return Stem + "_" + std::to_string(I) + SourceExt;
+  });
+}
+
+ShardedFile namec_util::plan_split(const std::vector<ShardUnit> &Units,
+                                   const std::string &Stem,
+                                   const std::string &HeaderExt,
+                                   const std::string &SourceExt) {
+  return place_units(Units, 1, Stem + HeaderExt,
+                     [&](size_t) { return Stem + SourceExt; });
+}
@@ -0,0 +1,72 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+TEST(AttributeTest, Emit) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *Void = C.decl_var("", C.type_void());
+  auto *Sq = T->def_func("sq", C.type_int(), {Void});
+  Sq->add_attr(Attribute::const_());
+  Sq->add_attr(Attribute::always_inline());
+  Sq->add_attr(Attribute::target("avx2"));
+  // Replaces the one of the same kind, keeping the others in order.
+  Sq->add_attr(Attribute::target("arch=haswell"));
+  Sq->get_or_add_body()->stmt_return(C.expr_int(4));
+  auto *Buf = T->def_array_var("buf", C.type_char(), {C.expr_int(64)});
+  Buf->add_attr(Attribute::aligned(64));
+  auto *N = T->def_var("n", C.type_int());
+  N->add_attr(Attribute::visibility("hidden"));
+  N->add_attr(Attribute::aligned());
+  auto *Run = T->def_func("run", C.type_void(), {Void});
+  Run->add_attr(Attribute::pure());
+  Run->add_attr(Attribute::noinline());
+  Run->add_attr(Attribute::flatten());
+  Run->remove_attr(AttributeKind::Pure);
+  EXPECT_TRUE(Run->has_attr(AttributeKind::Flatten));
+  EXPECT_FALSE(Run->has_attr(AttributeKind::Pure));
+  EXPECT_EQ(Sq->get_attr(AttributeKind::Target)->get_arg(), "arch=haswell");
+  EXPECT_EQ(F.to_string(),
+            "__attribute__((const,always_inline,target(\"arch=haswell\"))) "
+            "int sq(void){return 4;}\n"
+            "__attribute__((aligned(64))) char buf[64];\n"
+            "__attribute__((visibility(\"hidden\"),aligned)) int n;\n"
+            "__attribute__((noinline,flatten)) void run(void);\n\n");
+}
+
+TEST(AttributeTest, Split) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Scale = T->def_func_declare("scale", C.type_int(), {X});
+  Scale->add_attr(Attribute::hot());
+  Scale->add_attr(Attribute::target("avx2"));
+  auto *Count = T->def_var("count", C.type_int(), C.expr_int(0));
+  Count->add_attr(Attribute::aligned(16));
+  auto *Y = C.decl_var("y", C.type_int());
+  auto *Slow = T->def_func("slow", C.type_int(), {Y});
+  Slow->add_attr(Attribute::cold());
+  Slow->add_attr(Attribute::noinline());
+  Slow->get_or_add_body()->stmt_return(C.expr_var(Y));
+  Scale->get_body()->stmt_return(
+      C.expr_call(C.expr_raw("slow"), {C.expr_var(X)}));
+  T->def_func_define(Scale);
+  auto Split = split_file(F, "scale");
+  // The declarations and the definitions have the same attributes.
+  EXPECT_EQ(Split.get_header(),
+            "#ifndef SCALE_H\n#define SCALE_H\n"
+            "__attribute__((hot,target(\"avx2\"))) int scale(int x);\n"
+            "__attribute__((aligned(16))) extern int count;\n"
+            "__attribute__((cold,noinline)) int slow(int y);\n"
+            "#endif // SCALE_H\n");
+  ASSERT_EQ(Split.source_count(), 1u);
+  EXPECT_EQ(Split.get_source(0),
+            "#include \"scale.h\"\n"
+            "__attribute__((aligned(16))) int count=0;\n"
+            "__attribute__((cold,noinline)) int slow(int y){return y;}\n"
+            "__attribute__((hot,target(\"avx2\"))) "
+            "int scale(int x){return slow(x);}\n");
+}
@@ -0,0 +1,143 @@
+#include "NameC.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+// Whether the C compiler accepts the translation unit Code.
+static bool compiles(const std::string &Code) {
+  auto Path = std::filesystem::temp_directory_path() / "namec_cse_test.c";
+  std::ofstream(Path) << Code;
+  auto Command = std::string(NAMEC_TEST_C_COMPILER) +
+                 " -std=c11 -pedantic-errors -fsyntax-only " + Path.string();
+  bool Result = std::system(Command.c_str()) == 0;
+  std::filesystem::remove(Path);
+  return Result;
+}
+
+TEST(CSETest, Hoist) {
+  Context C;
+  auto *S = C.add_scope();
+  auto *Base = C.decl_var("base", C.type_ptr(C.type_int()));
+  auto *I = C.decl_var("i", C.type_int());
+  auto *Stride = C.decl_var("stride", C.type_int());
+  auto Addr = [&] { return C.EX(Base, "+", C.EX(I, "*", Stride)); };
+  S->stmt_expr(C.expr_binary("=", C.expr_pre_unary("*", Addr()),
+                             C.EX(C.expr_pre_unary("*", Addr()), "+",
+                                  C.EX(I, "*", Stride))));
+  auto *X = C.decl_var("x", C.type_int());
+  auto Square = [&] { return C.EX(C.EX(I, "+", X), "*", C.EX(I, "+", X)); };
+  S->stmt_return(C.EX(Square(), "-", Square()));
+  auto Stats = hoist_common_subexprs(C, S);
+  EXPECT_EQ(Stats.Hoisted, 3u);
+  EXPECT_EQ(Stats.Replaced, 6u);
+  EXPECT_EQ(S->to_string(),
+            "int* _cse0=base+((i*stride));"
+            "*_cse0=((*_cse0)+((i*stride)));"
+            "const int _cse2=i+x;const int _cse1=_cse2*_cse2;"
+            "return (_cse1-_cse1);");
+}
+
+TEST(CSETest, SequencedKept) {
+  Context C;
+  auto *S = C.add_scope();
+  auto *A = C.decl_var("a", C.type_int());
+  auto *B = C.decl_var("b", C.type_int());
+  // The right of && is evaluated conditionally.
+  S->stmt_return(C.EX(C.EX(A, "+", B), "&&", C.EX(A, "+", B)));
+  // Calls are not pure.
+  S->stmt_expr(C.EX(C.EX(C.expr_call(C.expr_raw("f"), {}), "+", A), "*",
+                    C.EX(C.expr_call(C.expr_raw("f"), {}), "+", A)));
+  // Loop conditions are evaluated repeatedly.
+  S->stmt_while(C.EX(C.EX(A, "+", B), "<", C.EX(A, "+", B)));
+  EXPECT_EQ(hoist_common_subexprs(C, S).Hoisted, 0u);
+}
+
+TEST(CSETest, NestedScopes) {
+  Context C;
+  CFile F(C);
+  auto *A = C.decl_var("a", C.type_long());
+  auto *B = C.decl_var("b", C.type_uint());
+  auto *Body = F.get_first_top_level()
+                   ->def_func("f", C.type_long(), {A, B})
+                   ->get_or_add_body();
+  auto *If = Body->stmt_if(C.EX(C.EX(A, "-", B), "==", C.EX(A, "-", B)));
+  If->get_then()->stmt_return(C.EX(C.EX(A, "<<", 2), "|", C.EX(A, "<<", 2)));
+  auto Stats = hoist_common_subexprs(C, F);
+  EXPECT_EQ(Stats.Hoisted, 2u);
+  EXPECT_EQ(F.to_string(), "long f(long a,unsigned int b){"
+                           "const long _cse0=a-b;if((_cse0==_cse0)){"
+                           "const long _cse1=a<<2;return (_cse1|_cse1);}}\n\n");
+}
+
+TEST(CSETest, Case) {
+  Context C;
+  auto *S = C.add_scope();
+  auto *A = C.decl_var("a", C.type_int());
+  auto *B = C.decl_var("b", C.type_int());
+  auto *Sw = S->stmt_switch(C.expr_var(A));
+  auto *Body = Sw->add_case(C.expr_int(1))->get_body();
+  Body->stmt_return(C.EX(C.EX(A, "*", B), "+", C.EX(A, "*", B)));
+  Body->stmt_return(C.EX(C.EX(A, "-", B), "+", C.EX(A, "-", B)));
+  auto Stats = hoist_common_subexprs(C, S);
+  EXPECT_EQ(Stats.Hoisted, 2u);
+  // The first statement is in a block, since a declaration cannot follow
+  // the label.
+  EXPECT_EQ(S->to_string(),
+            "switch(a){case 1:{const int _cse0=a*b;return (_cse0+_cse0);}"
+            "const int _cse1=a-b;return (_cse1+_cse1);break;}");
+}
+
+TEST(CSETest, NotHoisted) {
+  Context C;
+  auto *S = C.add_scope();
+  // Each read of a volatile is a side effect.
+  auto *V = C.decl_var("v", C.type_int());
+  V->set_volatile(true);
+  S->stmt_return(C.EX(C.EX(V, "+", 1), "*", C.EX(V, "+", 1)));
+  // The type of the local cannot be spelled.
+  auto *N = C.expr_raw("n");
+  S->stmt_return(C.EX(C.EX(N, "+", 1), "*", C.EX(N, "+", 1)));
+  EXPECT_EQ(hoist_common_subexprs(C, S).Hoisted, 0u);
+}
+
+TEST(CSETest, ArrayDecay) {
+  Context C;
+  CFile F(C);
+  auto *I = C.decl_var("i", C.type_int());
+  auto *Body = F.get_first_top_level()
+                   ->def_func("f", C.type_int(), {I})
+                   ->get_or_add_body();
+  // The local is a pointer, not the element type.
+  auto *A = Body->def_array_var("a", C.type_int(), {C.expr_int(4)});
+  auto Elem = [&] { return C.expr_pre_unary("*", C.EX(A, "+", I)); };
+  Body->stmt_expr(C.EX(Elem(), "+", Elem()));
+  // The pointer to the rows is not spelled.
+  auto *M = Body->def_array_var("m", C.type_int(),
+                                {C.expr_int(2), C.expr_int(3)});
+  auto Row = [&] { return C.expr_pre_unary("*", C.EX(M, "+", I)); };
+  Body->stmt_return(C.EX(C.expr_pre_unary("*", Row()), "+",
+                         C.expr_pre_unary("*", Row())));
+  EXPECT_EQ(hoist_common_subexprs(C, F).Hoisted, 1u);
+  auto Code = F.to_string();
+  EXPECT_NE(Code.find("int* _cse0=a+i;"), std::string::npos);
+  EXPECT_TRUE(compiles(Code)) << Code;
+}
+
+TEST(CSETest, StaticInit) {
+  Context C;
+  CFile F(C);
+  auto *Body = F.get_first_top_level()
+                   ->def_func("f", C.type_int(), {})
+                   ->get_or_add_body();
+  // Initialized before any local is defined.
+  auto Sum = [&] { return C.EX(C.expr_int(1), "+", C.expr_int(2)); };
+  auto *S = Body->def_var("s", C.type_int(), C.EX(Sum(), "*", Sum()));
+  S->set_static(true);
+  Body->stmt_return(C.expr_var(S));
+  EXPECT_EQ(hoist_common_subexprs(C, F).Hoisted, 0u);
+  auto Code = F.to_string();
+  EXPECT_TRUE(compiles(Code)) << Code;
+}
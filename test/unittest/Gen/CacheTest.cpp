@@ -0,0 +1,121 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+using namespace namec;
+
+static void gen_main(std::ostream &SS, int Ret) {
+  Context C;
+  CFile F(C);
+  auto *Main = F.get_first_top_level()->def_func("main", C.type_int(), {});
+  Main->get_or_add_body()->stmt_return(C.expr_int(Ret));
+  F.emit(SS);
+}
+
+TEST(CacheTest, HitAndMiss) {
+  std::filesystem::path Dir = "gen_cache_hit_and_miss";
+  std::filesystem::remove_all(Dir);
+  GenCache Cache(Dir);
+  int Calls = 0;
+  auto Gen = [&](std::ostream &SS) {
+    Calls++;
+    gen_main(SS, 0);
+  };
+  std::stringstream SS1;
+  EXPECT_FALSE(Cache.emit("main-v1", SS1, Gen));
+  EXPECT_TRUE(Cache.contains("main-v1"));
+  std::stringstream SS2;
+  EXPECT_TRUE(Cache.emit("main-v1", SS2, Gen));
+  EXPECT_EQ(Calls, 1);
+  EXPECT_EQ(SS1.str(), "int main(){return 0;}\n\n");
+  EXPECT_EQ(SS2.str(), SS1.str());
+  EXPECT_FALSE(Cache.contains("main-v2"));
+  auto Stats = Cache.get_stats();
+  EXPECT_EQ(Stats.Hits, 1u);
+  EXPECT_EQ(Stats.Misses, 1u);
+  // A throwing generator leaves no temporary entry.
+  std::stringstream SS3;
+  EXPECT_THROW(Cache.emit("main-v3", SS3,
+                          [](std::ostream &) {
+                            throw std::runtime_error("failed");
+                          }),
+               std::runtime_error);
+  EXPECT_FALSE(Cache.contains("main-v3"));
+  auto Files = std::distance(std::filesystem::directory_iterator(Dir),
+                             std::filesystem::directory_iterator());
+  EXPECT_EQ(Files, 1);
+  std::filesystem::remove_all(Dir);
+}
+
+TEST(CacheTest, Persistent) {
+  std::filesystem::path Dir = "gen_cache_persistent";
+  std::filesystem::remove_all(Dir);
+  std::filesystem::path P = "gen_cache_persistent.c";
+  {
+    GenCache Cache(Dir);
+    EXPECT_EQ(Cache.emit_to_file("main", P,
+                                 [](std::ostream &SS) { gen_main(SS, 1); }),
+              WriteResult::Written);
+  }
+  GenCache Cache(Dir);
+  bool IsCalled = false;
+  // Hit from the previous instance, and the output file is kept untouched.
+  EXPECT_EQ(Cache.emit_to_file("main", P,
+                               [&](std::ostream &) { IsCalled = true; }),
+            WriteResult::Unchanged);
+  EXPECT_FALSE(IsCalled);
+  EXPECT_EQ(Cache.get_stats().Hits, 1u);
+  std::ifstream IS(P);
+  std::string Str;
+  std::getline(IS, Str);
+  EXPECT_EQ(Str, "int main(){return 1;}");
+  IS.close();
+  std::filesystem::remove(P);
+  std::filesystem::remove_all(Dir);
+}
+
+TEST(CacheTest, Eviction) {
+  std::filesystem::path Dir = "gen_cache_eviction";
+  std::filesystem::remove_all(Dir);
+  GenCache Cache(Dir, 64);
+  auto Gen = [](std::ostream &SS) { SS << std::string(40, 'x'); };
+  std::stringstream SS;
+  Cache.emit("first", SS, Gen);
+  EXPECT_TRUE(Cache.contains("first"));
+  Cache.emit("second", SS, Gen);
+  EXPECT_FALSE(Cache.contains("first"));
+  EXPECT_TRUE(Cache.contains("second"));
+  EXPECT_LE(Cache.size_bytes(), 64u);
+  EXPECT_EQ(Cache.get_stats().Evictions, 1u);
+  Cache.clear();
+  EXPECT_EQ(Cache.size_bytes(), 0u);
+  std::filesystem::remove_all(Dir);
+}
+
+TEST(CacheTest, LeastRecentlyUsed) {
+  std::filesystem::path Dir = "gen_cache_lru";
+  std::filesystem::remove_all(Dir);
+  auto Gen = [](std::ostream &SS) { SS << std::string(40, 'x'); };
+  std::stringstream SS;
+  {
+    GenCache Cache(Dir);
+    Cache.emit("first", SS, Gen);
+    Cache.emit("second", SS, Gen);
+  }
+  // The entries of the previous instance are indexed, and the hit refreshes
+  // the first.
+  GenCache Cache(Dir, 128);
+  EXPECT_EQ(Cache.size_bytes(), 95u);
+  EXPECT_TRUE(Cache.emit("first", SS, Gen));
+  Cache.emit("third", SS, Gen);
+  EXPECT_TRUE(Cache.contains("first"));
+  EXPECT_FALSE(Cache.contains("second"));
+  EXPECT_TRUE(Cache.contains("third"));
+  EXPECT_EQ(Cache.size_bytes(), 94u);
+  EXPECT_EQ(Cache.get_stats().Evictions, 1u);
+  std::filesystem::remove_all(Dir);
+}
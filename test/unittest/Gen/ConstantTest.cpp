@@ -0,0 +1,110 @@
+#include "NameC.h"
+#include <climits>
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+static std::string fold(Context &C, Expr *E) {
+  return fold_constants(C, E)->to_string();
+}
+
+TEST(ConstantTest, Literals) {
+  Context C;
+  EXPECT_EQ(C.expr_int(-5)->to_string(), "-5");
+  EXPECT_EQ(C.expr_ulong(5)->to_string(), "5ul");
+  EXPECT_EQ(C.expr_int(INT_MIN)->to_string(), "(-2147483647-1)");
+  EXPECT_EQ(C.expr_llong(LLONG_MIN)->to_string(),
+            "(-9223372036854775807ll-1)");
+  EXPECT_EQ(get_int_constant(C.EX(C.EX(true)))->to_string(), "1");
+  EXPECT_FALSE(get_int_constant(C.expr_raw("1")));
+  // Typed through the mixin too.
+  LiteralExprAPIMixin<Context, Expr, RawExpr> &Mixin = C;
+  EXPECT_TRUE(get_int_constant(Mixin.expr_uint(3)));
+}
+
+TEST(ConstantTest, Parse) {
+  auto Parse = [](std::string_view Text) -> std::string {
+    auto V = parse_int_literal(Text);
+    return V ? V->to_string() : "none";
+  };
+  EXPECT_EQ(Parse("42"), "42");
+  EXPECT_EQ(Parse("0"), "0");
+  EXPECT_EQ(Parse("010"), "8");
+  EXPECT_EQ(Parse("0x10UL"), "16ul");
+  EXPECT_EQ(Parse("1LLu"), "1ull");
+  // Hexadecimal ones may be unsigned, decimal ones without u not.
+  EXPECT_EQ(Parse("0xffffffff"), "4294967295u");
+  EXPECT_EQ(Parse("4294967295"), "4294967295l");
+  EXPECT_EQ(Parse("18446744073709551615"), "none");
+  EXPECT_EQ(Parse("08"), "none");
+  EXPECT_EQ(Parse("1lul"), "none");
+}
+
+TEST(ConstantTest, Arithmetic) {
+  Context C;
+  EXPECT_EQ(fold(C, C.EX(C.EX(C.EX(4), "*", C.EX(8)), "+", C.EX(0))), "32");
+  EXPECT_EQ(fold(C, C.EX(C.EX(3), "-", 5)), "(-2)");
+  EXPECT_EQ(fold(C, C.EX("!", C.EX(7, "%", 7))), "1");
+  EXPECT_EQ(fold(C, C.EX(C.expr_raw("4"), "*", 2)), "((4)*2)");
+}
+
+TEST(ConstantTest, Conversions) {
+  Context C;
+  // -1 is converted to UINT_MAX, but long represents all unsigned int.
+  EXPECT_EQ(fold(C, C.EX(-1, "<", 1u)), "0");
+  EXPECT_EQ(fold(C, C.EX(-1l, "<", 1u)), "1");
+  EXPECT_EQ(fold(C, C.EX(-1ll, "<", 1ul)), "0");
+  EXPECT_EQ(fold(C, C.EX(0u, "-", 1u)), "4294967295u");
+  EXPECT_EQ(fold(C, C.EX(2, "+", 3ul)), "5ul");
+  EXPECT_EQ(fold(C, C.EX(1u, "<<", 31)), "2147483648u");
+  EXPECT_EQ(fold(C, C.expr_ternary(C.expr_int(1), C.expr_int(2),
+                                   C.expr_long(3))),
+            "2l");
+}
+
+TEST(ConstantTest, UndefinedKept) {
+  Context C;
+  EXPECT_EQ(fold(C, C.EX(INT_MAX, "+", 1)), "(2147483647+1)");
+  EXPECT_EQ(fold(C, C.EX(1, "/", 0)), "(1/0)");
+  EXPECT_EQ(fold(C, C.EX(1, "<<", 31)), "(1<<31)");
+  EXPECT_EQ(fold(C, C.EX(-8, ">>", 1)), "(-8>>1)");
+  EXPECT_EQ(fold(C, C.EX("-", C.expr_int(INT_MIN))), "(-(-2147483647-1))");
+  auto *Min = C.expr_int(INT_MIN);
+  EXPECT_EQ(fold(C, C.EX(Min, "-", 1)), "((-2147483647-1)-1)");
+  EXPECT_EQ(fold(C, C.EX(Min, "*", -1)), "((-2147483647-1)*-1)");
+  EXPECT_EQ(fold(C, C.EX(-2, "*", INT_MAX)), "(-2*2147483647)");
+  EXPECT_EQ(fold(C, C.EX(-1, "*", INT_MAX)), "(-2147483647)");
+  EXPECT_EQ(fold(C, C.EX(LLONG_MAX, "*", -1ll)), "(-9223372036854775807ll)");
+}
+
+TEST(ConstantTest, Identities) {
+  Context C;
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Y = C.decl_var("y", C.type_char());
+  EXPECT_EQ(fold(C, C.EX(X, "*", 1)), "x");
+  EXPECT_EQ(fold(C, C.EX(0, "+", C.EX(X))), "x");
+  EXPECT_EQ(fold(C, C.EX(X, "<<", 0u)), "x");
+  // Would change the type.
+  EXPECT_EQ(fold(C, C.EX(X, "*", 1l)), "(x*1l)");
+  EXPECT_EQ(fold(C, C.EX(Y, "+", 0)), "(y+0)");
+  EXPECT_EQ(fold(C, C.EX(1, "-", X)), "(1-x)");
+  // a+0 is a pointer, as sizeof(a+0) is not sizeof(a).
+  auto *A = C.decl_array_var("a", C.type_int(), {C.expr_int(4)});
+  EXPECT_EQ(fold(C, C.EX(A, "+", 0)), "(a+0)");
+  EXPECT_EQ(fold(C, C.expr_ternary(C.expr_int(0), C.expr_var(X),
+                                   C.expr_var(X))),
+            "x");
+}
+
+TEST(ConstantTest, File) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  T->def_var("size", C.type_int(), C.EX(4, "*", C.EX(8)));
+  auto *X = C.decl_var("x", C.type_int());
+  T->def_func("f", C.type_int(), {X})
+      ->get_or_add_body()
+      ->stmt_return(C.EX(X, "+", C.EX(1, "-", 1)));
+  EXPECT_EQ(fold_constants(C, F), 8u);
+  EXPECT_EQ(F.to_string(), "int size=32;\nint f(int x){return x;}\n\n");
+}
@@ -0,0 +1,109 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+static FuncDecl *def_static_func(Context &C, TopLevel *T, std::string Name,
+                                 Type *RetTy) {
+  auto *FD = T->def_func(Name, RetTy, {C.decl_var("", C.type_void())});
+  FD->set_static(true);
+  return FD;
+}
+
+TEST(DeadDeclTest, Reachability) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *Int = T->def_typedef("myint", C.type_int());
+  T->def_typedef("unused_t", C.type_int());
+  auto *S = T->def_struct("S");
+  S->get_struct()->def_member("v", C.type_int());
+  T->def_var("s", C.type_name(S))->set_static(true);
+  auto *Counter = T->def_var("counter", Int->get_type_alias(), C.expr_int(0));
+  Counter->set_static(true);
+  def_static_func(C, T, "helper", C.type_int())
+      ->get_or_add_body()
+      ->stmt_return(C.expr_var(Counter));
+  def_static_func(C, T, "dead_helper", C.type_int())
+      ->get_or_add_body()
+      ->stmt_return(C.expr_call(C.expr_raw("helper"), {}));
+  def_static_func(C, T, "exported", C.type_void());
+  T->def_func("main", C.type_int(), {C.decl_var("", C.type_void())})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_call(C.expr_raw("helper"), {}));
+
+  auto Before = F.to_string().size();
+  auto Stats = eliminate_dead_decls(F, {"exported"});
+  EXPECT_EQ(Stats.Removed, 4u);
+  EXPECT_EQ(Stats.Bytes, Before - F.to_string().size());
+  EXPECT_EQ(F.to_string(), "typedef int myint;\n"
+                           "static myint counter=0;\n"
+                           "static int helper(void){return counter;}\n"
+                           "static void exported(void);\n"
+                           "int main(void){return helper();}\n\n");
+}
+
+TEST(DeadDeclTest, RawReferences) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  T->def_var("table", C.type_int(), C.expr_int(1))->set_static(true);
+  T->def_var("unused", C.type_int(), C.expr_int(2))->set_static(true);
+  T->def_macro_value("TABLE", "table");
+  EXPECT_EQ(eliminate_dead_decls(F).Removed, 1u);
+  EXPECT_EQ(F.to_string(), "static int table=1;\n\n#define TABLE table\n\n\n");
+}
+
+TEST(DeadDeclTest, Lazy) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  size_t Built = 0;
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Used = T->def_func_lazy("used", C.type_int(), {X}, [&](FuncScope *S) {
+    Built++;
+    S->stmt_return(C.expr_call(C.expr_raw("leaf"), {C.expr_var(X)}));
+  });
+  Used->set_static(true);
+  EXPECT_TRUE(Used->is_lazy());
+  EXPECT_FALSE(Used->is_forward());
+  EXPECT_EQ(Built, 0u);
+  for (auto *Name : {"leaf", "unused"}) {
+    auto *Y = C.decl_var("y", C.type_int());
+    auto *FD = T->def_func_lazy(Name, C.type_int(), {Y}, [&, Y](FuncScope *S) {
+      Built++;
+      S->stmt_return(C.expr_var(Y));
+    });
+    FD->set_static(true);
+  }
+  T->def_func("main", C.type_int(), {C.decl_var("", C.type_void())})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_call(C.expr_raw("used"), {C.expr_int(1)}));
+
+  auto Stats = eliminate_dead_decls(F);
+  EXPECT_EQ(Stats.Removed, 1u);
+  EXPECT_EQ(Stats.Unbuilt, 1u);
+  EXPECT_EQ(Stats.Bytes, 0u);
+  EXPECT_EQ(Built, 2u);
+  EXPECT_FALSE(Used->is_lazy());
+  // emit() of the file builds the bodies left, if any.
+  std::stringstream SS;
+  F.emit(SS);
+  EXPECT_EQ(SS.str(), "static int used(int x){return leaf(x);}\n"
+                      "static int leaf(int y){return y;}\n"
+                      "int main(void){return used(1);}\n\n");
+}
+
+TEST(DeadDeclTest, LazyEmit) {
+  Context C;
+  CFile F(C);
+  auto *X = C.decl_var("x", C.type_int());
+  F.get_first_top_level()
+      ->def_func_lazy("used", C.type_int(), {X},
+                      [&](FuncScope *S) { S->stmt_return(C.expr_var(X)); })
+      ->set_static(true);
+  // Without eliminate_dead_decls() or materialize(), the output still links.
+  std::stringstream SS;
+  F.emit(SS);
+  EXPECT_EQ(SS.str(), "static int used(int x){return x;}\n\n");
+}
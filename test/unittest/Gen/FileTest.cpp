@@ -1,7 +1,9 @@
 #include "NameC.h"
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <fstream>
+#include <stdexcept>
 #include <string>
 
 using namespace namec;
@@ -56,6 +58,52 @@ TEST(FileTest, HelloWorld) {
                            "}\n\n");
 }
 
+TEST(FileTest, SkipUnchanged) {
+  CFile F(C);
+  auto *Main = F.get_first_top_level()->def_func("main", C.type_int(), {});
+  Main->get_or_add_body()->stmt_return(C.expr_int(0));
+  std::filesystem::path P = "skip_unchanged.c";
+  std::filesystem::remove(P);
+  EXPECT_EQ(F.emit_to_file(P, true), WriteResult::Written);
+  auto Time = std::filesystem::last_write_time(P);
+  EXPECT_EQ(F.emit_to_file(P, true), WriteResult::Unchanged);
+  EXPECT_EQ(std::filesystem::last_write_time(P), Time);
+  // Default behavior always writes.
+  EXPECT_EQ(F.emit_to_file(P), WriteResult::Written);
+  Main->get_or_add_body()->stmt_return(C.expr_int(1));
+  EXPECT_EQ(F.emit_to_file(P, true), WriteResult::Written);
+  auto has_tmp = [&] {
+    for (auto &E : std::filesystem::directory_iterator(".")) {
+      auto Name = E.path().filename().string();
+      if (Name.rfind(P.string() + ".", 0) == 0) {
+        return true;
+      }
+    }
+    return false;
+  };
+  EXPECT_FALSE(has_tmp());
+  std::ifstream IS(P);
+  std::string Str;
+  std::getline(IS, Str);
+  EXPECT_EQ(Str, "int main(){return 0;return 1;}");
+  IS.close();
+  // The existing file with the content as a prefix is rewritten.
+  std::ofstream(P, std::ios::app) << "int x;\n";
+  EXPECT_EQ(F.emit_to_file(P, true), WriteResult::Written);
+  EXPECT_EQ(F.emit_to_file(P, true), WriteResult::Unchanged);
+  // The temporary file is removed when the output throws.
+  EXPECT_THROW(namec_util::write_file(P, true,
+                                      [](std::ostream &OS) {
+                                        OS << "int";
+                                        throw std::runtime_error("failed");
+                                      }),
+               std::runtime_error);
+  EXPECT_FALSE(has_tmp());
+  std::filesystem::remove(P);
+  EXPECT_EQ(F.emit_to_file("no_such_dir/skip_unchanged.c", true),
+            WriteResult::Failed);
+}
+
 TEST(FileTest, VarArgFunc) {
   CFile F(C);
   auto *T = F.get_first_top_level();
@@ -89,3 +137,215 @@ TEST(FileTest, SplitFunc) {
   EXPECT_EQ(F.to_string(), "int func1(int x);\n"
                            "int func1(int x){return x;}\n\n");
 }
+
+static FuncDecl *def_square(Context &C, TopLevel *T, std::string Name) {
+  auto *X = C.decl_var("x", C.type_int());
+  auto *FD = T->def_func(Name, C.type_int(), {X});
+  FD->get_or_add_body()->stmt_return(C.EX(C.EX(X), "*", C.EX(X)));
+  return FD;
+}
+
+static void def_file(Context &C, CFile &F, bool IsStreaming) {
+  auto *T = F.get_first_top_level();
+  T->include_sys("stdio.h");
+  for (int I = 0; I < 3; ++I) {
+    auto *FD = def_square(C, T, "f" + std::to_string(I));
+    if (IsStreaming) {
+      F.seal(FD);
+    }
+  }
+  auto *T2 = F.add_top_level();
+  T2->set_comment_before("second");
+  def_square(C, T2, "g");
+  if (IsStreaming) {
+    F.seal(T2);
+  }
+  def_square(C, F.add_top_level(), "h");
+}
+
+TEST(FileTest, Streaming) {
+  Context ExpectedC;
+  CFile Expected(ExpectedC);
+  def_file(ExpectedC, Expected, false);
+
+  Context C;
+  CFile F(C);
+  std::stringstream SS;
+  auto Start = C.get_arena_mark();
+  F.start_stream(SS);
+  EXPECT_TRUE(F.is_streaming());
+  def_file(C, F, true);
+  // f0 to f2 and g are already emitted and released.
+  EXPECT_EQ(SS.str(), "\n#include <stdio.h>\n\n"
+                      "int f0(int x){return ((x)*(x));}\n"
+                      "int f1(int x){return ((x)*(x));}\n"
+                      "int f2(int x){return ((x)*(x));}\n\n"
+                      "/* second */int g(int x){return ((x)*(x));}\n\n");
+  EXPECT_EQ(F.to_string(), "int h(int x){return ((x)*(x));}\n\n");
+  F.end_stream();
+  EXPECT_FALSE(F.is_streaming());
+  EXPECT_EQ(F.get_first_top_level(), nullptr);
+  EXPECT_EQ(SS.str(), Expected.to_string());
+  auto End = C.get_arena_mark();
+  EXPECT_EQ(End.Decls, Start.Decls);
+  EXPECT_EQ(End.Exprs, Start.Exprs);
+  EXPECT_EQ(End.Scopes, Start.Scopes);
+}
+
+TEST(FileTest, EditErrors) {
+  Context C;
+  TopLevel T(C), Other(C);
+  auto *V = T.def_func("v", C.type_int(), {});
+  auto *W = Other.def_func("w", C.type_int(), {});
+  EXPECT_FALSE(T.replace(W, std::make_unique<Define>("X", "1")));
+  EXPECT_TRUE(T.replace(V, std::make_unique<Define>("X", "1")));
+  EXPECT_EQ(T.to_string(), "\n#define X 1\n\n");
+  auto *Y = T.def_func("y", C.type_int(), {});
+  auto *X = *T.entries().begin();
+  EXPECT_FALSE(T.reorder({Y}));
+  EXPECT_FALSE(T.reorder({Y, Y}));
+  EXPECT_FALSE(T.reorder({Y, W}));
+  EXPECT_EQ(T.to_string(), "\n#define X 1\n\nint y();\n");
+  EXPECT_TRUE(T.reorder({Y, X}));
+  EXPECT_EQ(T.to_string(), "int y();\n\n#define X 1\n\n");
+  EXPECT_FALSE(T.splice(W, &Other));
+  EXPECT_FALSE(T.splice(Y, &T));
+  EXPECT_TRUE(T.splice(Y, &Other));
+  EXPECT_EQ(T.to_string(), "int w();\n\n#define X 1\n\n");
+  EXPECT_EQ(Other.to_string(), "");
+}
+
+TEST(FileTest, SealErrors) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  EXPECT_FALSE(F.seal(T));
+  std::stringstream SS;
+  F.start_stream(SS);
+  auto *S = T->def_struct("S");
+  S->get_struct()->def_member("a", C.type_int());
+  auto *Ty = C.type_name(S);
+  EXPECT_TRUE(F.seal(T));
+  EXPECT_FALSE(F.seal(T));
+  Context Other;
+  EXPECT_FALSE(F.seal(def_square(Other, CFile(Other).add_top_level(), "f")));
+  // The type of the released struct is still emitted by the name.
+  EXPECT_EQ(Ty->get_decl(), nullptr);
+  F.add_top_level()->def_var("s", Ty);
+  F.end_stream();
+  EXPECT_EQ(SS.str(), "struct S{int a;};\n\nstruct S s;\n\n");
+}
+
+TEST(FileTest, SealReleasedUsed) {
+  // The entries left unsealed must not use the released nodes.
+  Context C;
+  CFile F(C);
+  std::stringstream SS;
+  F.start_stream(SS);
+  auto *T = F.get_first_top_level();
+  auto *FD = def_square(C, T, "f");
+  auto *V = T->def_var("v", C.type_int(), C.expr_int(1));
+  EXPECT_FALSE(F.seal(FD));
+  auto *U = F.add_top_level();
+  U->def_var("u", C.type_int(), C.expr_var(V));
+  EXPECT_FALSE(F.seal(T));
+  EXPECT_EQ(SS.str(), "");
+  EXPECT_TRUE(F.seal(U));
+  F.end_stream();
+  EXPECT_EQ(SS.str(), "int f(int x){return ((x)*(x));}\nint v=1;\n\n"
+                      "int u=v;\n\n");
+}
+
+TEST(FileTest, AsyncStreaming) {
+  Context ExpectedC;
+  CFile Expected(ExpectedC);
+  def_file(ExpectedC, Expected, false);
+
+  Context C;
+  CFile F(C);
+  std::stringstream SS;
+  // Capacity 1 to make the generator wait for the emitter.
+  AsyncEmitter E(SS, 1);
+  E.attach(F);
+  def_file(C, F, true);
+  F.end_stream();
+  E.finish();
+  EXPECT_EQ(SS.str(), Expected.to_string());
+  EXPECT_EQ(E.get_stats().Regions, 5u);
+}
+
+TEST(FileTest, AsyncError) {
+  // A stream failing on any write.
+  struct FailingBuf : std::streambuf {
+    int_type overflow(int_type) override { return traits_type::eof(); }
+  } Buf;
+  std::ostream OS(&Buf);
+  OS.exceptions(std::ios::badbit);
+  Context C;
+  CFile F(C);
+  AsyncEmitter E(OS, 1);
+  E.attach(F);
+  def_file(C, F, true);
+  F.end_stream();
+  EXPECT_THROW(E.finish(), std::ios_base::failure);
+  EXPECT_EQ(E.get_stats().Regions, 5u);
+
+  // Destroying the emitter ends the streaming mode.
+  std::stringstream SS;
+  CFile F2(C);
+  {
+    AsyncEmitter E2(SS);
+    E2.attach(F2);
+  }
+  EXPECT_FALSE(F2.is_streaming());
+}
+
+TEST(FileTest, EmitChunks) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  for (int I = 0; I < 20; ++I) {
+    def_square(C, T, "f" + std::to_string(I));
+  }
+  std::string Expected = F.to_string();
+  std::string Joined;
+  size_t Count = 0;
+  for (std::string_view Chunk : F.emit_chunks(16, 2)) {
+    EXPECT_LE(Chunk.size(), 16u);
+    EXPECT_FALSE(Chunk.empty());
+    Joined += Chunk;
+    Count++;
+  }
+  EXPECT_EQ(Joined, Expected);
+  EXPECT_EQ(Count, (Expected.size() + 15) / 16);
+  // Stop pulling in the middle.
+  auto Chunks = F.emit_chunks(16, 2);
+  EXPECT_EQ(Chunks.next(), std::string_view(Expected).substr(0, 16));
+}
+
+TEST(FileTest, EmitChunksCancel) {
+  // Destroying the stream after the first chunk stops the producer.
+  std::atomic<size_t> Writes = 0;
+  {
+    ChunkStream Chunks(
+        [&](std::ostream &OS) {
+          for (size_t I = 0; I < 1000; ++I) {
+            OS << "0123456789abcdef";
+            Writes++;
+          }
+        },
+        16, 2);
+    EXPECT_EQ(Chunks.next(), "0123456789abcdef");
+  }
+  EXPECT_LT(Writes, 10u);
+
+  // An exception of the producer is rethrown after the chunks before it.
+  ChunkStream Chunks(
+      [](std::ostream &OS) {
+        OS << "abc";
+        throw std::runtime_error("producer");
+      },
+      16, 2);
+  EXPECT_EQ(Chunks.next(), "abc");
+  EXPECT_THROW(Chunks.next(), std::runtime_error);
+}
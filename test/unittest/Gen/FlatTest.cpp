@@ -0,0 +1,167 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+using namespace namec;
+
+// The bytes allocated and not yet freed by operator new, to measure the
+// memory of the ASTs. The size is kept before the block.
+static std::atomic<size_t> LiveBytes = 0;
+
+void *operator new(std::size_t Size) {
+  auto *Block = static_cast<std::max_align_t *>(
+      std::malloc(Size + sizeof(std::max_align_t)));
+  if (!Block) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<std::size_t *>(Block) = Size;
+  LiveBytes += Size;
+  return Block + 1;
+}
+
+void operator delete(void *Ptr) noexcept {
+  if (!Ptr) {
+    return;
+  }
+  auto *Block = static_cast<std::max_align_t *>(Ptr) - 1;
+  LiveBytes -= *reinterpret_cast<std::size_t *>(Block);
+  std::free(Block);
+}
+
+void operator delete(void *Ptr, std::size_t) noexcept { operator delete(Ptr); }
+
+// The same generator code for both of Context and FlatContext.
+template <typename ContextT, typename TopLevelT>
+static void gen(ContextT &C, TopLevelT T) {
+  T->include_sys("stdio.h");
+  auto G = T->def_var("g", C.type_int(), C.expr_int(3));
+  auto X = C.decl_var("x", C.type_int());
+  auto F = T->def_func("f", C.type_int(), {X});
+  auto S = F->get_or_add_body();
+  auto I = S->def_var("i", C.type_int(), C.expr_int(0));
+  auto If = S->stmt_if(C.EX(X, "<", 0));
+  If->get_then()->stmt_return(C.EX("-", X));
+  If->get_or_add_else()->stmt_break();
+  If->add_elseif(C.EX(X, "==", 0))->stmt_return(C.expr_int(0));
+  auto Sum = S->def_var("sum", C.type_int(), C.expr_int(0));
+  auto For =
+      S->stmt_for(I, C.EX(I, "<", X), C.expr_post_unary("++", C.EX(I)));
+  For->get_body()->stmt_assign(C.EX(Sum), C.EX(Sum, "+", I));
+  auto Sw = S->stmt_switch(C.EX(Sum));
+  Sw->add_case(C.expr_int(1))->get_body()->stmt_return(C.CALL("f", G));
+  Sw->add_case(C.expr_int(2), true)->get_body()->stmt_continue();
+  auto *Long = C.type_long();
+  Sw->add_default()->get_body()->stmt_call(
+      C.expr_raw("printf"), {C.expr_str("%d"), C.expr_cast(Long, C.EX(Sum))});
+  auto W = S->stmt_while(C.expr_true());
+  W->get_body()->stmt_do(C.EX(X, ">", 1))->get_body()->stmt_expr(
+      C.expr_ternary(C.EX(X), C.expr_pre_unary("--", C.EX(X)), C.EX(I)));
+  S->stmt_block()->get_scope()->stmt_raw("/* raw */");
+  S->stmt_return(C.EX(Sum));
+  T->def_func("h", C.type_void(), {});
+}
+
+TEST(FlatTest, SameAsPointerAST) {
+  Context C;
+  CFile F(C);
+  gen(C, F.get_first_top_level());
+  gen(C, F.add_top_level());
+
+  FlatContext FC;
+  gen(FC, FC.get_first_top_level());
+  gen(FC, FC.add_top_level());
+  EXPECT_EQ(FC.to_string(), F.to_string());
+}
+
+TEST(FlatTest, Append) {
+  Context C;
+  CFile F(C);
+  gen(C, F.get_first_top_level());
+  // Copied as the emitted code.
+  auto *T = F.get_first_top_level();
+  T->def_var("s", C.type_int(), C.expr_int(1))->set_static(true);
+  auto *Y = C.decl_var("y", C.type_int());
+  auto *S = T->def_func("k", C.type_int(), {Y})->get_or_add_body();
+  S->stmt_label("again");
+  S->stmt_goto("again");
+  auto *W = S->stmt_while(C.EX(Y, ">", 0));
+  W->set_likelihood(Likelihood::Likely);
+  W->get_body()->stmt_break();
+  S->stmt_return(C.EX(Y))->set_comment_after("done");
+  auto *Sum = C.expr_binary("+", C.expr_var(Y), C.expr_int(1));
+  Sum->set_comment_before("next");
+  S->stmt_return(Sum);
+  T->def_func_lazy("lazy", C.type_int(), {}, [&](FuncScope *Body) {
+    Body->stmt_return(C.expr_int(0));
+  });
+  auto *R = C.decl_var("r", C.type_int());
+  R->set_extern(true);
+  T->def_func("extern_param", C.type_int(), {R});
+
+  FlatContext FC;
+  FC.get_first_top_level()->append(T);
+  EXPECT_EQ(FC.to_string(), F.to_string());
+  // A scope alone, from a scratch context dropped after the copy.
+  auto Body = FC.get_first_top_level()
+                  ->def_func("m", FC.type_int(), {})
+                  ->get_or_add_body();
+  {
+    Context Scratch;
+    auto *From = Scratch.add_scope();
+    auto *I = From->def_var("i", Scratch.type_int(), Scratch.expr_int(2));
+    From->stmt_return(Scratch.EX(I, "*", I));
+    Body->append(From);
+  }
+  EXPECT_EQ(FC.to_string().substr(F.to_string().size() - 1),
+            "int m(){int i=2;return (i*i);}\n\n");
+}
+
+TEST(FlatTest, CompactTables) {
+  FlatContext C;
+  auto X = C.decl_var("x", C.type_int());
+  auto S = C.get_first_top_level()->def_func("f", C.type_int(), {X})
+               ->get_or_add_body();
+  constexpr size_t Count = 10000;
+  for (size_t I = 0; I < Count; ++I) {
+    S->stmt_assign(C.EX(X), C.EX(X, "+", 1));
+  }
+  // 6 exprs and a statement per assignment, each a few 32-bit fields, with
+  // the slack of vector growth.
+  EXPECT_LT(C.get_memory_usage() / Count, 200u);
+  // "int f(int x){" + "x=(x+1);" * Count + "}\n\n"
+  EXPECT_EQ(C.to_string().size(), 13 + 8 * Count + 3);
+}
+
+TEST(FlatTest, MemoryReduction) {
+  // Measured by the allocations, so that FlatContext::get_memory_usage() is
+  // checked too.
+  constexpr size_t Count = 1000;
+  size_t Before = LiveBytes;
+  size_t PointerBytes;
+  {
+    Context C;
+    CFile F(C);
+    for (size_t I = 0; I < Count; ++I) {
+      gen(C, F.add_top_level());
+    }
+    PointerBytes = LiveBytes - Before;
+  }
+  Before = LiveBytes;
+  size_t FlatBytes;
+  {
+    FlatContext FC;
+    for (size_t I = 0; I < Count; ++I) {
+      gen(FC, FC.add_top_level());
+    }
+    FlatBytes = LiveBytes - Before;
+    EXPECT_LE(FC.get_memory_usage(), FlatBytes);
+    EXPECT_GE(FC.get_memory_usage(), FlatBytes * 9 / 10);
+  }
+  // Several times smaller for the same code.
+  EXPECT_GE(PointerBytes, 3 * FlatBytes);
+}
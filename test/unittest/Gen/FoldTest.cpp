@@ -0,0 +1,109 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+static FuncDecl *def_getter(Context &C, TopLevel *T, std::string Name) {
+  auto *P = C.decl_var("p", C.type_ptr(C.type_int()));
+  auto *FD = T->def_func(Name, C.type_int(), {P});
+  FD->get_or_add_body()->stmt_return(C.expr_pre_unary("*", C.expr_var(P)));
+  return FD;
+}
+
+static void def_file(Context &C, CFile &F) {
+  auto *T = F.get_first_top_level();
+  def_getter(C, T, "get_a");
+  def_getter(C, T, "get_b");
+  T->def_func("other", C.type_void(), {C.decl_var("", C.type_void())})
+      ->get_or_add_body()
+      ->stmt_return(nullptr);
+}
+
+TEST(FoldTest, Forward) {
+  Context C;
+  CFile F(C);
+  def_file(C, F);
+  auto Stats = fold_identical_functions(C, F);
+  EXPECT_EQ(Stats.Functions, 3u);
+  EXPECT_EQ(Stats.Folded, 1u);
+  EXPECT_EQ(F.to_string(),
+            "int get_a(int* p){return *p;}\n"
+            "int get_b(int* p){return get_a(p);}\n"
+            "void other(void){return;}\n\n");
+}
+
+TEST(FoldTest, Alias) {
+  Context C;
+  CFile F(C);
+  def_file(C, F);
+  EXPECT_EQ(fold_identical_functions(C, F, FoldMode::Alias).Folded, 1u);
+  EXPECT_EQ(F.to_string(),
+            "int get_a(int* p){return *p;}\n"
+            "int get_b(int* p) __attribute__((alias(\"get_a\")));\n"
+            "void other(void){return;}\n\n");
+}
+
+TEST(FoldTest, Define) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *P = C.decl_var("p", C.type_ptr(C.type_int()));
+  T->def_func("get_d", C.type_int(), {P})->set_static(true);
+  def_getter(C, T, "get_a")->set_static(true);
+  def_getter(C, T, "get_b")->set_static(true);
+  // The external symbol is kept by the forwarding definition.
+  def_getter(C, T, "get_c");
+  // So is the definition of the prototype.
+  def_getter(C, T, "get_d")->set_static(true);
+  EXPECT_EQ(fold_identical_functions(C, F, FoldMode::Define).Folded, 3u);
+  EXPECT_EQ(F.to_string(),
+            "static int get_d(int* p);\n"
+            "static int get_a(int* p){return *p;}\n\n"
+            "#define get_b get_a\n\n"
+            "int get_c(int* p){return get_a(p);}\n"
+            "static int get_d(int* p){return get_a(p);}\n\n");
+}
+
+TEST(FoldTest, Attributes) {
+  // The same bodies with different attributes are different functions.
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *X = C.decl_var("x", C.type_int());
+  std::vector<FuncDecl *> Fs;
+  for (auto *Name : {"scale_avx2", "scale_generic", "scale_hot"}) {
+    Fs.push_back(T->def_func(Name, C.type_int(), {X}));
+    Fs.back()->get_or_add_body()->stmt_return(C.expr_raw("x*2"));
+  }
+  Fs[0]->add_attr(Attribute::target("avx2"));
+  Fs[2]->add_attr(Attribute::hot());
+  EXPECT_EQ(fold_identical_functions(C, F, FoldMode::Alias).Folded, 0u);
+  Fs[2]->remove_attr(AttributeKind::Hot);
+  Fs[2]->add_attr(Attribute::target("avx2"));
+  EXPECT_EQ(fold_identical_functions(C, F, FoldMode::Alias).Folded, 1u);
+  EXPECT_EQ(F.to_string(),
+            "__attribute__((target(\"avx2\"))) int scale_avx2(int x)"
+            "{return x*2;}\n"
+            "int scale_generic(int x){return x*2;}\n"
+            "__attribute__((target(\"avx2\"))) int scale_hot(int x) "
+            "__attribute__((alias(\"scale_avx2\")));\n\n");
+}
+
+TEST(FoldTest, StaticLocal) {
+  // The folded functions would share the static locals.
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  for (auto *Name : {"next_a", "next_b"}) {
+    auto *Block = T->def_func(Name, C.type_int(), {})
+                      ->get_or_add_body()
+                      ->stmt_block()
+                      ->get_scope();
+    auto *N = Block->def_var("n", C.type_int());
+    N->set_static(true);
+    Block->stmt_return(C.expr_pre_unary("++", C.expr_var(N)));
+  }
+  auto Stats = fold_identical_functions(C, F);
+  EXPECT_EQ(Stats.Folded, 0u);
+  EXPECT_EQ(F.to_string().find("next_a("), F.to_string().rfind("next_a("));
+}
@@ -0,0 +1,145 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+static FuncDecl *def_abs(Context &C, TopLevel *T, std::string Name) {
+  auto *X = C.decl_var("x", C.type_int());
+  auto *FD = T->def_func(Name, C.type_int(), {X});
+  auto *S = FD->get_or_add_body();
+  S->insert_comment("returns the absolute value");
+  auto *If = S->stmt_if(C.expr_binary("<", C.expr_var(X), C.expr_int(0)));
+  If->get_then()->stmt_return(C.expr_pre_unary("-", C.expr_var(X)));
+  S->insert_newline();
+  S->stmt_return(C.expr_var(X));
+  return FD;
+}
+
+TEST(HashTest, Structural) {
+  Context C1, C2;
+  TopLevel T1(C1), T2(C2);
+  auto *F1 = def_abs(C1, &T1, "abs1");
+  auto *F2 = def_abs(C2, &T2, "abs1");
+  auto *F3 = def_abs(C2, &T2, "abs2");
+  StructuralHasher H;
+  // Independent of the pointers and the comments.
+  EXPECT_EQ(H.hash(F1), H.hash(F2));
+  EXPECT_EQ(H.hash(F1->get_body()), H.hash(F3->get_body()));
+  EXPECT_NE(H.hash(F1), H.hash(F3));
+  F3->get_body()->stmt_return(C2.expr_int(0));
+  EXPECT_NE(H.hash(F1->get_body()), H.hash(F3->get_body()));
+
+  auto *E1 = C1.expr_binary("+", C1.expr_int(1), C1.expr_int(2));
+  auto *E2 = C1.expr_binary("-", C1.expr_int(1), C1.expr_int(2));
+  EXPECT_NE(H.hash(E1), H.hash(E2));
+  EXPECT_EQ(H.hash(E1), H.hash(C2.expr_binary("+", C2.expr_int(1),
+                                              C2.expr_int(2))));
+}
+
+TEST(HashTest, RawDirective) {
+  // A raw directive is code even if it begins with a comment.
+  Context C;
+  TopLevel T(C);
+  auto *Void = C.decl_var("", C.type_void());
+  auto *F = T.def_func("f", C.type_int(), {Void});
+  F->get_or_add_body()->directive_raw("// tuned\n#define K 1\n");
+  F->get_body()->stmt_return(C.expr_raw("K"));
+  auto *G = T.def_func("g", C.type_int(), {Void});
+  G->get_or_add_body()->directive_raw("// tuned\n#define K 2\n");
+  G->get_body()->stmt_return(C.expr_raw("K"));
+  StructuralHasher H;
+  EXPECT_NE(H.hash(F->get_body()), H.hash(G->get_body()));
+  auto Hash = H.hash(F);
+  F->get_body()->insert_line_comment("tuned");
+  EXPECT_EQ(H.hash(F), Hash);
+}
+
+TEST(HashTest, Memoized) {
+  Context C;
+  TopLevel T(C);
+  auto *F = def_abs(C, &T, "abs");
+  StructuralHasher H;
+  auto Hash = H.hash(F);
+  auto Size = H.cache_size();
+  EXPECT_GT(Size, 10u);
+  EXPECT_EQ(H.hash(F), Hash);
+  EXPECT_EQ(H.cache_size(), Size);
+  H.clear();
+  EXPECT_EQ(H.cache_size(), 0u);
+  EXPECT_EQ(H.hash(F), Hash);
+}
+
+TEST(HashTest, Modified) {
+  // The memoized hashes of the ancestors are dropped by the mutators.
+  Context C;
+  TopLevel T(C);
+  auto *F = def_abs(C, &T, "abs");
+  StructuralHasher H;
+  auto Hash = H.hash(F);
+  auto *If = static_cast<IfStmt *>(F->get_body()->get_first()->get_next());
+  auto *Cond = static_cast<BinaryOp *>(If->get_cond());
+  Cond->set_rhs(C.expr_int(1));
+  auto Changed = H.hash(F);
+  EXPECT_NE(Changed, Hash);
+  Cond->set_rhs(C.expr_int(0));
+  EXPECT_EQ(H.hash(F), Hash);
+  F->add_attr(Attribute::hot());
+  EXPECT_NE(H.hash(F), Hash);
+  F->remove_attr(AttributeKind::Hot);
+  EXPECT_EQ(H.hash(F), Hash);
+  // A removed entry may be freed and its address reused.
+  auto Body = H.hash(F->get_body());
+  F->get_body()->remove(If);
+  EXPECT_NE(H.hash(F->get_body()), Body);
+}
+
+TEST(HashTest, Spliced) {
+  // Both scopes of a splice are modified.
+  Context C;
+  TopLevel T(C);
+  auto *A = def_abs(C, &T, "a")->get_body();
+  auto *B = def_abs(C, &T, "b")->get_body();
+  StructuralHasher H;
+  auto AHash = H.hash(A);
+  auto BHash = H.hash(B);
+  B->splice_before(nullptr, A);
+  EXPECT_EQ(A->to_string(), "");
+  EXPECT_NE(H.hash(A), AHash);
+  EXPECT_EQ(H.hash(A), H.hash(C.add_scope()));
+  EXPECT_NE(H.hash(B), BHash);
+}
+
+TEST(HashTest, ModifiedLocally) {
+  Context C;
+  TopLevel T(C);
+  auto *F = def_abs(C, &T, "abs");
+  auto *G = def_abs(C, &T, "abs2");
+  StructuralHasher H;
+  auto Hash = H.hash(&T);
+  auto Size = H.cache_size();
+  // Other contexts, alive or destroyed, do not drop the hashes.
+  {
+    Context Other;
+    auto *V = Other.decl_var("v", Other.type_int());
+    V->set_const(true);
+    Other.add_scope()->stmt_return(Other.expr_var(V));
+  }
+  auto GHash = H.hash(G);
+  EXPECT_EQ(H.cache_size(), Size);
+  // Only the modified node and its ancestors are dropped, not G.
+  auto *Ret = static_cast<ReturnStmt *>(F->get_body()->get_last());
+  Ret->set_expr(C.expr_int(0));
+  EXPECT_LT(H.cache_size(), Size);
+  EXPECT_GT(H.cache_size(), Size / 2);
+  EXPECT_NE(H.hash(&T), Hash);
+  EXPECT_EQ(H.cache_size(), Size + 1);
+  EXPECT_EQ(H.hash(G), GHash);
+}
+
+TEST(HashTest, Stable) {
+  // Fixed value, since the hash is used as an on-disk key across processes.
+  Context C;
+  StructuralHasher H;
+  auto *E = C.expr_binary("+", C.expr_raw("a"), C.expr_int(1));
+  EXPECT_EQ(H.hash(E).to_hex(), "35205ecda940b2365df928f4668211f8");
+}
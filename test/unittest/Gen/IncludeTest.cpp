@@ -0,0 +1,69 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+TEST(IncludeTest, Dedup) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  T->include_sys("stdio.h");
+  T->include("gen.h");
+  T->include("ops.def");
+  T->include_sys("stdio.h");
+  auto *If = T->directive_ifdef("DEBUG");
+  If->get_then()->include_sys("stdio.h");
+  If->get_then()->include_sys("assert.h");
+  If->get_then()->include_sys("assert.h");
+  If->get_or_add_else()->include_sys("string.h");
+  auto *T2 = F.add_top_level();
+  // Not in effect after the #ifdef.
+  T2->include_sys("assert.h");
+  T2->include("gen.h");
+  T2->include("ops.def");
+  EXPECT_EQ(dedup_includes(F, {"ops.def"}), 4u);
+  EXPECT_EQ(F.to_string(), "\n#include <stdio.h>\n\n"
+                           "\n#include \"gen.h\"\n\n"
+                           "\n#include \"ops.def\"\n\n"
+                           "\n#ifdef DEBUG\n"
+                           "\n#include <assert.h>\n\n"
+                           "\n#else\n"
+                           "\n#include <string.h>\n\n"
+                           "\n#endif\n\n\n"
+                           "\n#include <assert.h>\n\n"
+                           "\n#include \"ops.def\"\n\n\n");
+}
+
+TEST(IncludeTest, PrecompiledHeader) {
+  Context C;
+  CFile F1(C), F2(C), F3(C);
+  for (auto *F : {&F1, &F2, &F3}) {
+    F->get_first_top_level()->include_sys("stdio.h");
+  }
+  F1.get_first_top_level()->include_sys("stdlib.h");
+  F2.get_first_top_level()->include_sys("stdlib.h");
+  F3.get_first_top_level()->include_sys("math.h");
+  // After a macro, so not a candidate.
+  F3.get_first_top_level()->def_macro_value("_GNU_SOURCE", "1");
+  F3.get_first_top_level()->include_sys("stdlib.h");
+  auto PCH = extract_common_includes({&F1, &F2, &F3}, 2, "gen_pch");
+  EXPECT_EQ(PCH.get_header_name(), "gen_pch.h");
+  EXPECT_EQ(PCH.get_header(),
+            "#pragma once\n#include <stdio.h>\n#include <stdlib.h>\n");
+  EXPECT_EQ(PCH.get_source(), "#include \"gen_pch.h\"\n");
+  // The header would include stdlib.h before _GNU_SOURCE in F3.
+  EXPECT_EQ(PCH.get_skipped(), std::vector<size_t>{2});
+  EXPECT_EQ(PCH.cmake_snippet("gen_lib", {"f1.c", "f2.c", "f3.c"}),
+            "# Compile gen_pch.h once and reuse it for gen_lib.\n"
+            "add_library(gen_pch OBJECT gen_pch.c)\n"
+            "target_precompile_headers(gen_pch PRIVATE gen_pch.h)\n"
+            "target_precompile_headers(gen_lib REUSE_FROM gen_pch)\n"
+            "set_source_files_properties(f3.c PROPERTIES "
+            "SKIP_PRECOMPILE_HEADERS ON)\n");
+  // After a declaration, so not a candidate either.
+  CFile F4(C);
+  F4.get_first_top_level()->def_var("x", C.type_int());
+  F4.get_first_top_level()->include_sys("stdio.h");
+  EXPECT_EQ(extract_common_includes({&F1, &F4}, 2, "gen_pch").get_header(),
+            "#pragma once\n");
+}
@@ -0,0 +1,68 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+static FuncDecl *def_caller(Context &C, TopLevel *T, std::string Name,
+                            std::string Callee) {
+  auto *FD = T->def_func(Name, C.type_void(), {C.decl_var("", C.type_void())});
+  auto *Body = FD->get_or_add_body();
+  if (!Callee.empty()) {
+    Body->stmt_expr(C.expr_call(C.expr_raw(Callee), {}));
+  }
+  return FD;
+}
+
+TEST(LayoutTest, HotCold) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *A = def_caller(C, T, "a", "c");
+  def_caller(C, T, "b", "");
+  auto *Cf = def_caller(C, T, "c", "");
+  auto *D = def_caller(C, T, "d", "a");
+  auto *E = def_caller(C, T, "e", "");
+  // Hot by the annotation.
+  def_caller(C, T, "f", "a")->add_attr(Attribute::hot());
+  T->include("g.h");
+  def_caller(C, T, "g", "");
+
+  LayoutOptions Opts;
+  Opts.HotThreshold = 10;
+  Opts.IsMarkHotCold = true;
+  Opts.HotSection = ".text.hot";
+  auto Stats = layout_functions(F, {{A, 50}, {Cf, 40}, {D, 5}, {E, 0}}, Opts);
+  EXPECT_EQ(Stats.Hot, 3u);
+  EXPECT_EQ(Stats.Cold, 1u);
+  EXPECT_EQ(Stats.Prototypes, 3u);
+  // a and c are called most closely.
+  EXPECT_EQ(F.to_string(),
+            "__attribute__((hot,section(\".text.hot\"))) void a(void);\n"
+            "void b(void){}\n"
+            "__attribute__((hot,section(\".text.hot\"))) void c(void);\n"
+            "void d(void){a();}\n"
+            "__attribute__((hot,section(\".text.hot\"))) void c(void){}\n"
+            "__attribute__((hot,section(\".text.hot\"))) void a(void){c();}\n"
+            "__attribute__((cold)) void e(void);\n"
+            "__attribute__((hot,section(\".text.hot\"))) void f(void){a();}\n"
+            "__attribute__((cold)) void e(void){}\n\n"
+            "#include \"g.h\"\n\n"
+            "void g(void){}\n\n");
+}
+
+TEST(LayoutTest, Prototypes) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *X = def_caller(C, T, "x", "");
+  def_caller(C, T, "y", "");
+  auto *Z = def_caller(C, T, "z", "");
+  auto Stats = layout_functions(F, {{X, 50}, {Z, 0}});
+  // Only y is moved before x. Nothing is moved before z.
+  EXPECT_EQ(Stats.Prototypes, 1u);
+  EXPECT_EQ(Stats.Moved, 2u);
+  EXPECT_EQ(F.to_string(), "void x(void);\n"
+                           "void y(void){}\n"
+                           "void x(void){}\n"
+                           "void z(void){}\n\n");
+}
@@ -0,0 +1,124 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+TEST(OrderTest, Types) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *List = T->def_struct("list");
+  auto *Node = T->def_struct("node");
+  auto *Pair = T->def_struct("pair");
+  // By value needs the definition, by pointer only the declaration.
+  List->get_struct()->def_member("head", C.type_name(Node));
+  Node->get_struct()->def_member("next", C.type_ptr(C.type_name(Node)));
+  Node->get_struct()->def_member("owner", C.type_ptr(C.type_name(Pair)));
+  Pair->get_struct()->def_member("v", C.type_int());
+  auto Stats = order_declarations(F);
+  EXPECT_EQ(Stats.Moved, 2u);
+  EXPECT_EQ(Stats.Forwards, 1u);
+  EXPECT_EQ(Stats.Cycles, 0u);
+  EXPECT_EQ(F.to_string(),
+            "struct pair;\n"
+            "struct node{struct node* next;struct pair* owner;};\n"
+            "struct list{struct node head;};\n"
+            "struct pair{int v;};\n\n");
+}
+
+TEST(OrderTest, Functions) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *Void = C.decl_var("", C.type_void());
+  auto *Main = T->def_func("main", C.type_int(), {Void});
+  T->include_sys("stdio.h");
+  auto *Helper = T->def_func("helper", C.type_int(), {Void});
+  auto *Counter = T->def_var("counter", C.type_int(), C.expr_int(0));
+  Helper->get_or_add_body()->stmt_return(C.expr_var(Counter));
+  auto *N = C.decl_var("n", C.type_int());
+  auto *Even = T->def_func("is_even", C.type_int(), {N});
+  auto *M = C.decl_var("n", C.type_int());
+  auto *Odd = T->def_func("is_odd", C.type_int(), {M});
+  // Mutually recursive, so is_odd needs the prototype.
+  Even->get_or_add_body()->stmt_return(
+      C.expr_call(C.expr_raw("is_odd"), {C.expr_var(N)}));
+  Odd->get_or_add_body()->stmt_return(
+      C.expr_call(C.expr_raw("is_even"), {C.expr_var(M)}));
+  // helper is after #include, so main needs the prototype.
+  Main->get_or_add_body()->stmt_raw("return helper();");
+  auto Stats = order_declarations(F);
+  EXPECT_EQ(Stats.Moved, 2u);
+  EXPECT_EQ(Stats.Forwards, 2u);
+  EXPECT_EQ(F.to_string(), "int helper(void);\n"
+                           "int main(void){return helper();}\n\n"
+                           "#include <stdio.h>\n\n"
+                           "int counter=0;\n"
+                           "int helper(void){return counter;}\n"
+                           "int is_odd(int n);\n"
+                           "int is_even(int n){return is_odd(n);}\n"
+                           "int is_odd(int n){return is_even(n);}\n\n");
+}
+
+TEST(OrderTest, Cycle) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *A = T->def_struct("a");
+  auto *B = T->def_struct("b");
+  A->get_struct()->def_member("x", C.type_name(B));
+  B->get_struct()->def_member("y", C.type_name(A));
+  auto Stats = order_declarations(F);
+  EXPECT_EQ(Stats.Cycles, 1u);
+  EXPECT_EQ(Stats.Moved, 0u);
+}
+
+TEST(OrderTest, Lazy) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *Void = C.decl_var("", C.type_void());
+  bool IsBuilt = false;
+  T->def_func_lazy("user", C.type_int(), {Void}, [&](FuncScope *S) {
+    IsBuilt = true;
+    S->stmt_raw("struct pair p={0};return helper()+p.v;");
+  });
+  auto *Pair = T->def_struct("pair");
+  Pair->get_struct()->def_member("v", C.type_int());
+  T->include_sys("stdio.h");
+  T->def_func("helper", C.type_int(), {Void})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_int(1));
+  auto Stats = order_declarations(F);
+  EXPECT_FALSE(IsBuilt);
+  // user follows pair, and helper after #include needs the prototype.
+  EXPECT_EQ(Stats.Moved, 2u);
+  EXPECT_EQ(Stats.Forwards, 1u);
+  EXPECT_EQ(F.to_string(),
+            "struct pair{int v;};\n"
+            "int helper(void);\n"
+            "int user(void){struct pair p={0};return helper()+p.v;}\n\n"
+            "#include <stdio.h>\n\n"
+            "int helper(void){return 1;}\n\n");
+  EXPECT_TRUE(IsBuilt);
+}
+
+TEST(OrderTest, SplitDeclare) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *Void = C.decl_var("", C.type_void());
+  T->def_func("a", C.type_int(), {Void})
+      ->get_or_add_body()
+      ->stmt_raw("return b();");
+  auto *B = T->def_func_declare("b", C.type_int(), {Void});
+  B->get_or_add_body()->stmt_return(C.expr_int(1));
+  T->def_func_define(B);
+  auto Stats = order_declarations(F);
+  // The first declaration of b is the split one, declared again before a.
+  EXPECT_EQ(Stats.Forwards, 1u);
+  EXPECT_EQ(F.to_string(), "int b(void);\n"
+                           "int a(void){return b();}\n"
+                           "int b(void);\n"
+                           "int b(void){return 1;}\n\n");
+}
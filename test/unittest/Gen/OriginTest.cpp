@@ -0,0 +1,141 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+namespace {
+void generate(Context &C, CFile &F) {
+  auto *T = F.get_first_top_level();
+  auto *N = C.decl_var("n", C.type_int());
+  T->def_func("id", C.type_int(), {N})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_raw("n"));
+  auto *Step = T->def_func("step", C.type_int(), {N});
+  Step->set_origin(C.add_origin("m.model", 10));
+  auto *S = Step->get_or_add_body();
+  auto *If = S->stmt_if(C.expr_raw("n<0"));
+  If->set_origin(C.add_origin("m.model", 12));
+  If->get_then()->stmt_raw("n=0;")->set_origin(C.add_origin("gen.py", 40));
+  S->stmt_return(C.expr_raw("n"));
+}
+} // namespace
+
+TEST(OriginTest, Emit) {
+  Context C;
+  CFile F(C);
+  generate(C, F);
+  std::string Plain = F.to_string();
+  std::stringstream SS;
+  OriginOptions Opts;
+  Opts.FileName = "out.c";
+  auto Map = emit_with_origins(F, SS, Opts);
+  std::string Out = SS.str();
+  EXPECT_EQ(Out, "int id(int n){return n;}\n"
+                 "\n#line 10 \"m.model\"\n"
+                 "int step(int n){"
+                 "\n#line 12 \"m.model\"\n"
+                 "if(n<0){"
+                 "\n#line 40 \"gen.py\"\n"
+                 "n=0;"
+                 "\n#line 12 \"m.model\"\n"
+                 "}"
+                 "\n#line 10 \"m.model\"\n"
+                 "return n;}"
+                 "\n#line 14 \"out.c\"\n"
+                 "\n\n");
+  auto &Ranges = Map.ranges();
+  ASSERT_EQ(Ranges.size(), 3u);
+  EXPECT_EQ(Out.substr(Ranges[0].Begin, Ranges[0].End - Ranges[0].Begin),
+            "int step(int n){\n#line 12 \"m.model\"\nif(n<0){\n#line 40 "
+            "\"gen.py\"\nn=0;\n#line 12 \"m.model\"\n}\n#line 10 "
+            "\"m.model\"\nreturn n;}");
+  EXPECT_EQ(Out.substr(Ranges[2].Begin, Ranges[2].End - Ranges[2].Begin),
+            "n=0;");
+  auto *R = Map.find(Out.find("n=0;") + 1);
+  ASSERT_NE(R, nullptr);
+  EXPECT_EQ(Map.get_file(*R), "gen.py");
+  R = Map.find(Out.find("return n;}\n#line 14"));
+  ASSERT_NE(R, nullptr);
+  EXPECT_EQ(R->Line, 10u);
+  EXPECT_EQ(Map.find(0), nullptr);
+
+  // Without the directives, only the map is made.
+  std::stringstream SS2;
+  Opts.IsLineDirectives = false;
+  Map = emit_with_origins(F, SS2, Opts);
+  EXPECT_EQ(SS2.str(), Plain);
+  EXPECT_EQ(F.to_string(), Plain);
+  ASSERT_EQ(Map.ranges().size(), 3u);
+  EXPECT_EQ(Plain.substr(Map.ranges()[1].Begin,
+                         Map.ranges()[1].End - Map.ranges()[1].Begin),
+            "if(n<0){n=0;}");
+}
+
+TEST(OriginTest, Map) {
+  OriginMap Map;
+  EXPECT_TRUE(Map.add(0, 20, "a.model", 1));
+  EXPECT_TRUE(Map.add(5, 10, "b.model", 7));
+  EXPECT_TRUE(Map.add(12, 15, "a.model", 3));
+  EXPECT_FALSE(Map.add(3, 4, "a.model", 2));   // Out of order.
+  EXPECT_FALSE(Map.add(14, 16, "a.model", 2)); // Overlapping.
+  EXPECT_EQ(Map.ranges()[2].Parent, 0u);
+  EXPECT_EQ(Map.ranges()[0].Parent, OriginMap::npos);
+  EXPECT_EQ(Map.to_string(), "namec-origins 1\nf a.model\nf b.model\n"
+                             "0 20 0 1\n5 10 1 7\n12 15 0 3\n");
+  EXPECT_EQ(Map.find(11)->Line, 1u);
+  EXPECT_EQ(Map.find(12)->Line, 3u);
+  EXPECT_EQ(Map.find(20), nullptr);
+  OriginMap Parsed;
+  EXPECT_TRUE(Parsed.parse(Map.to_string()));
+  EXPECT_EQ(Parsed.to_string(), Map.to_string());
+  EXPECT_FALSE(OriginMap().parse("0 1 0 1\n"));
+  EXPECT_FALSE(OriginMap().parse("namec-origins 1\n0 1 0 1\n"));
+  EXPECT_FALSE(OriginMap().parse("namec-origins 1\nf a\n5 9 0 1\n0 1 0 1\n"));
+  EXPECT_FALSE(OriginMap().parse("namec-origins 1\nf a\n0 1 0 x\n"));
+}
+
+TEST(OriginTest, Siblings) {
+  // The gaps between the ranges are found through the parents only.
+  OriginMap Map;
+  EXPECT_TRUE(Map.add(0, 10, "a.model", 1));
+  for (uint64_t I = 0; I < 1000; ++I) {
+    EXPECT_TRUE(Map.add(20 + I * 10, 25 + I * 10, "a.model", 2));
+  }
+  EXPECT_EQ(Map.find(5)->Line, 1u);
+  EXPECT_EQ(Map.find(10), nullptr);
+  EXPECT_EQ(Map.find(5027), nullptr);
+  EXPECT_EQ(Map.find(5024)->Begin, 5020u);
+  EXPECT_EQ(Map.ranges().back().Parent, OriginMap::npos);
+}
+
+TEST(OriginTest, Nested) {
+  Context C;
+  CFile F(C);
+  generate(C, F);
+  std::stringstream SS;
+  OriginOptions Opts;
+  Opts.FileName = "out.c";
+  {
+    OriginEmitter Outer(C, SS, Opts);
+    // Another emission in between leaves the outer one active.
+    Context C2;
+    CFile F2(C2);
+    std::stringstream SS2;
+    emit_with_origins(F2, SS2, Opts);
+    F.emit(Outer.stream());
+    EXPECT_EQ(Outer.take_map().ranges().size(), 3u);
+  }
+  EXPECT_EQ(OriginEmitter::active(SS), nullptr);
+}
+
+TEST(OriginTest, Macro) {
+  // The entries of MacroFuncScope are emitted through a temporary stream.
+  Context C;
+  CFile F(C);
+  auto *M = F.get_first_top_level()->def_macro_func("M", {"x"});
+  M->get_body()->stmt_raw("x++;")->set_origin(C.add_origin("m.model", 3));
+  std::stringstream SS;
+  auto Map = emit_with_origins(F, SS, {"out.c"});
+  EXPECT_EQ(SS.str(), F.to_string());
+  EXPECT_TRUE(Map.ranges().empty());
+}
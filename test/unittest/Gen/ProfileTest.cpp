@@ -0,0 +1,182 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+namespace {
+// The same file for each generation.
+void generate(Context &C, CFile &F) {
+  auto *T = F.get_first_top_level();
+  auto *Void = C.decl_var("", C.type_void());
+  auto *Err = T->def_func("err", C.type_void(), {Void});
+  Err->get_or_add_body()->stmt_raw("n=0;");
+  auto *N = C.decl_var("n", C.type_int());
+  auto *Step = T->def_func("step", C.type_int(), {N});
+  auto *S = Step->get_or_add_body();
+  auto *If = S->stmt_if(C.expr_raw("n<0"));
+  If->get_then()->stmt_raw("err();");
+  If->add_elseif(C.expr_raw("n==0"))->stmt_return(C.expr_int(0));
+  If->get_or_add_else()->stmt_raw("n--;");
+  auto *W = S->stmt_while(C.expr_raw("n>1"));
+  auto *Sw = W->get_body()->stmt_switch(C.expr_raw("n%2"));
+  Sw->add_case(C.expr_int(0))->get_body()->stmt_raw("n/=2;");
+  Sw->add_default()->get_body()->stmt_raw("n=3*n+1;");
+  S->stmt_return(C.expr_raw("n"));
+}
+} // namespace
+
+TEST(ProfileTest, Ids) {
+  Context C;
+  CFile F(C);
+  generate(C, F);
+  auto Sites = assign_profile_ids(F, "m.");
+  std::vector<std::string> Ids;
+  std::vector<size_t> Parents;
+  for (auto &S : Sites) {
+    Ids.push_back(S.Id);
+    Parents.push_back(S.Parent);
+  }
+  auto None = ProfileSite::npos;
+  EXPECT_EQ(Ids, (std::vector<std::string>{"m.err", "m.step", "m.step#0.0",
+                                           "m.step#0.1", "m.step#0.2",
+                                           "m.step#1", "m.step#2.0",
+                                           "m.step#2.1"}));
+  EXPECT_EQ(Parents, (std::vector<size_t>{None, None, 1, 1, 1, 1, 5, 5}));
+  EXPECT_EQ(Sites[7].Kind, ProfileSiteKind::Case);
+}
+
+TEST(ProfileTest, Parse) {
+  Profile P;
+  EXPECT_TRUE(P.parse_csv("# id,count\nstep,10\n\nstep#0.0, 1\r\n"));
+  EXPECT_TRUE(P.parse_csv("step,5\n"));
+  EXPECT_EQ(P.get("step"), 15u);
+  EXPECT_EQ(P.get("step#0.0"), 1u);
+  EXPECT_EQ(P.get("err"), std::nullopt);
+  EXPECT_FALSE(P.parse_csv("step\n"));
+  EXPECT_FALSE(P.parse_csv("step,x\n"));
+  EXPECT_TRUE(P.parse_gcov_json(
+      R"({"format_version": "1", "files": [{"file": "m.c", "functions": [)"
+      R"({"name": "err", "demangled_name": "err", "start_line": 1,)"
+      R"( "blocks": 2, "execution_count": 0},)"
+      R"({"name": "main", "execution_count": 1, "blocks_executed": 3}],)"
+      R"( "lines": [{"line_number": 1, "count": 0, "branches": []}]}]})",
+      "m."));
+  EXPECT_EQ(P.get("m.err"), 0u);
+  EXPECT_EQ(P.get("m.main"), 1u);
+  EXPECT_FALSE(P.parse_gcov_json(R"({"files": [)"));
+  EXPECT_EQ(P.size(), 4u);
+}
+
+TEST(ProfileTest, Instrument) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *Void = C.decl_var("", C.type_void());
+  auto *Main = T->def_func("main", C.type_int(), {Void});
+  auto *If = Main->get_or_add_body()->stmt_if(C.expr_raw("1"));
+  If->get_then()->stmt_return(C.expr_int(0));
+  auto Sites = assign_profile_ids(F);
+  instrument_profile(F, Sites, "prof.csv");
+  EXPECT_EQ(F.to_string(),
+            "\n#include <stdio.h>\n\n"
+            "unsigned long long namec_profile_counts[2];\n"
+            "int main(void){namec_profile_counts[0]++;"
+            "if(1){namec_profile_counts[1]++;return 0;}}\n"
+            "__attribute__((destructor)) void namec_profile_dump(void){"
+            "static const char *const Ids[2]={\"main\",\"main#0.0\"};"
+            "FILE *F=fopen(\"prof.csv\",\"a\");if(!F){return;}"
+            "for(unsigned long I=0;I<2;++I){"
+            "fprintf(F,\"%s,%llu\\n\",Ids[I],namec_profile_counts[I]);}"
+            "fclose(F);}\n\n");
+  // The counters are defined once for all the shards.
+  auto Shards = shard_file(F, 2, "prof");
+  EXPECT_NE(Shards.get_header().find(
+                "extern unsigned long long namec_profile_counts[2];"),
+            std::string::npos);
+  size_t Defined = 0;
+  for (size_t I = 0; I < Shards.source_count(); ++I) {
+    Defined += Shards.get_source(I).find(
+                   "\nunsigned long long namec_profile_counts[2];") !=
+               std::string::npos;
+  }
+  EXPECT_EQ(Defined, 1u);
+}
+
+TEST(ProfileTest, InstrumentAtomic) {
+  Context C;
+  CFile F(C);
+  auto *Void = C.decl_var("", C.type_void());
+  // The static functions of the same name, such as in the branches of #if.
+  F.get_first_top_level()->def_func("f", C.type_void(), {Void})
+      ->set_static(true);
+  F.add_top_level()->def_func("f", C.type_void(), {Void})->set_static(true);
+  for (auto &T : F.top_levels()) {
+    for (auto *E : T.entries()) {
+      static_cast<FuncDecl *>(E)->get_or_add_body();
+    }
+  }
+  auto Sites = assign_profile_ids(F);
+  ASSERT_EQ(Sites.size(), 2u);
+  EXPECT_EQ(Sites[0].Id, "f");
+  EXPECT_EQ(Sites[1].Id, "f@1");
+  InstrumentOptions Opts;
+  Opts.Symbol = "lib_prof";
+  Opts.IsAtomic = true;
+  instrument_profile(F, Sites, "prof.csv", Opts);
+  auto Out = F.to_string();
+  EXPECT_NE(Out.find("unsigned long long lib_prof_counts[2];"),
+            std::string::npos);
+  EXPECT_NE(Out.find("static void f(void){"
+                     "__atomic_fetch_add(&lib_prof_counts[1],1,"
+                     "__ATOMIC_RELAXED);}"),
+            std::string::npos);
+  EXPECT_NE(Out.find("void lib_prof_dump(void)"), std::string::npos);
+}
+
+TEST(ProfileTest, Apply) {
+  Profile P;
+  // n<0 never, n==0 rarely, and the loop mostly continues.
+  EXPECT_TRUE(P.parse_csv("err,0\nstep,100\n"
+                          "step#0.0,0\nstep#0.1,2\nstep#0.2,98\n"
+                          "step#1,900\nstep#2.0,600\nstep#2.1,300\n"));
+  Context C;
+  CFile F(C);
+  generate(C, F);
+  auto Stats = apply_profile(F, P);
+  EXPECT_EQ(Stats.Matched, 8u);
+  EXPECT_EQ(Stats.Hints, 3u);
+  EXPECT_EQ(Stats.Layout.Hot, 1u);
+  EXPECT_EQ(Stats.Layout.Cold, 1u);
+  EXPECT_EQ(F.to_string(),
+            "__attribute__((cold)) void err(void);\n"
+            "__attribute__((hot)) int step(int n){"
+            "if(__builtin_expect(!!(n<0),0)){err();}"
+            "else if(__builtin_expect(!!(n==0),0)){return 0;}"
+            "else{n--;}"
+            "while(__builtin_expect(!!(n>1),1)){switch(n%2){"
+            "case 0:n/=2;break;default:n=3*n+1;break;}}return n;}\n"
+            "__attribute__((cold)) void err(void){n=0;}\n\n");
+}
+
+TEST(ProfileTest, DoLoop) {
+  Context C;
+  CFile F(C);
+  auto *N = C.decl_var("n", C.type_int());
+  auto *S = F.get_first_top_level()
+                ->def_func("f", C.type_void(), {N})
+                ->get_or_add_body();
+  S->stmt_do(C.expr_raw("n--"))->get_body()->stmt_raw("g();");
+  auto Sites = assign_profile_ids(F);
+  ASSERT_EQ(Sites.size(), 2u);
+  EXPECT_EQ(Sites[1].Id, "f#0");
+  EXPECT_EQ(Sites[1].Kind, ProfileSiteKind::Loop);
+  // Entered 10 times and run 100 times, so the condition holds 90 of 100.
+  Profile P;
+  EXPECT_TRUE(P.parse_csv("f,10\nf#0,100\n"));
+  ProfileOptions Opts;
+  Opts.IsLayout = false;
+  Opts.IsMarkHotCold = false;
+  EXPECT_EQ(apply_profile(F, P, Opts).Hints, 1u);
+  EXPECT_EQ(F.to_string(), "void f(int n){do{g();}while("
+                           "__builtin_expect(!!(n--),1))}\n\n");
+}
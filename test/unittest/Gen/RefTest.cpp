@@ -0,0 +1,37 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+TEST(RefTest, CallGraph) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *Counter = T->def_var("counter", C.type_int(), C.expr_int(0));
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Step = T->def_func_declare("step", C.type_int(), {X});
+  auto *Y = C.decl_var("y", C.type_int());
+  auto *Run = T->def_func("run", C.type_int(), {Y});
+  auto *Body = Run->get_or_add_body();
+  Body->stmt_assign(C.expr_var(Counter),
+                    C.expr_call(C.expr_raw("step"), {C.expr_var(Y)}));
+  Body->stmt_expr(C.expr_call(C.expr_paren(C.expr_raw("step")), {C.EX(1)}));
+  Body->stmt_return(C.expr_call(C.expr_raw("puts"), {C.EX("\"done\"")}));
+  T->def_func_define(Step);
+  Step->get_or_add_body()->stmt_return(
+      C.expr_binary("+", C.expr_var(X), C.expr_var(Counter)));
+
+  auto Index = build_ref_index(F);
+  EXPECT_EQ(Index.functions(), (std::vector<FuncDecl *>{Run, Step}));
+  EXPECT_EQ(Index.callees(Run), std::vector<FuncDecl *>{Step});
+  EXPECT_EQ(Index.callers(Step), std::vector<FuncDecl *>{Run});
+  EXPECT_TRUE(Index.callers(Run).empty());
+  EXPECT_EQ(Index.call_sites(Step).size(), 2u);
+  ASSERT_EQ(Index.unresolved_calls().size(), 1u);
+  EXPECT_EQ(Index.unresolved_calls()[0].E->to_string(), "puts(\"done\")");
+  auto &Uses = Index.uses(Counter);
+  ASSERT_EQ(Uses.size(), 2u);
+  EXPECT_EQ(Uses[0].User, Run);
+  EXPECT_EQ(Uses[1].User, Step);
+  EXPECT_EQ(Index.uses(X).size(), 1u);
+}
@@ -0,0 +1,124 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <random>
+
+using namespace namec;
+
+static void def_file(Context &C, CFile &F) {
+  auto *T = F.get_first_top_level();
+  T->include_sys("stdio.h");
+  auto *S = T->def_struct("S");
+  S->get_struct()->def_member("v", C.type_int());
+  auto *Counter = T->def_var("counter", C.type_int(), C.expr_int(0));
+  Counter->set_static(true);
+  auto *Void = C.decl_var("", C.type_void());
+  auto *Bump = T->def_func_declare("bump", C.type_int(), {Void});
+  Bump->set_static(true);
+  T->def_func("first", C.type_int(), {Void})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_call(C.expr_raw("bump"), {}));
+  T->def_func("second", C.type_int(), {Void})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_int(2));
+  T->def_var("global", C.type_name(S));
+  Bump->get_body()->stmt_return(
+      C.expr_post_unary("++", C.expr_var(Counter)));
+  T->def_func_define(Bump);
+  T->def_func("third", C.type_int(), {Void})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_int(3));
+}
+
+TEST(ShardTest, Split) {
+  Context C;
+  CFile F(C);
+  def_file(C, F);
+  auto Shards = shard_file(F, 2, "gen");
+  EXPECT_EQ(Shards.get_header_name(), "gen.h");
+  EXPECT_EQ(Shards.get_header(), "#ifndef GEN_H\n#define GEN_H\n"
+                                 "\n#include <stdio.h>\n\n"
+                                 "struct S{int v;};\n"
+                                 "int first(void);\n"
+                                 "int second(void);\n"
+                                 "extern struct S global;\n"
+                                 "int third(void);\n"
+                                 "#endif // GEN_H\n");
+  ASSERT_EQ(Shards.source_count(), 2u);
+  EXPECT_EQ(Shards.get_source_name(0), "gen_0.c");
+  // The static ones are kept with their user.
+  EXPECT_EQ(Shards.get_source(0), "#include \"gen.h\"\n"
+                                  "static int counter=0;\n"
+                                  "static int bump(void);\n"
+                                  "int first(void){return bump();}\n"
+                                  "static int bump(void){return counter++;}\n");
+  EXPECT_EQ(Shards.get_source_name(1), "gen_1.c");
+  EXPECT_EQ(Shards.get_source(1), "#include \"gen.h\"\n"
+                                  "int second(void){return 2;}\n"
+                                  "struct S global;\n"
+                                  "int third(void){return 3;}\n");
+}
+
+TEST(ShardTest, EmitToDir) {
+  Context C;
+  CFile F(C);
+  def_file(C, F);
+  auto Shards = shard_file(F, 3, "gen");
+  // Unique, so that the concurrent runs do not share the files.
+  std::filesystem::path Dir =
+      "shard_emit_to_dir_" + std::to_string(std::random_device()());
+  std::filesystem::remove_all(Dir);
+  std::filesystem::create_directories(Dir);
+  EXPECT_EQ(Shards.emit_to_dir(Dir, true), 4u);
+  EXPECT_TRUE(std::filesystem::exists(Dir / "gen_2.c"));
+  EXPECT_EQ(Shards.emit_to_dir(Dir, true), 0u);
+  std::filesystem::remove_all(Dir);
+  EXPECT_EQ(Shards.emit_to_dir(Dir, true), std::nullopt);
+}
+
+TEST(ShardTest, HeaderSource) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  T->def_macro_value("LIMIT", "16");
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Clamp = T->def_func_declare("clamp", C.type_int(), {X});
+  auto *Helper = T->def_func("helper", C.type_int(), {X});
+  Helper->set_static(true);
+  Helper->get_or_add_body()->stmt_return(C.expr_raw("x<LIMIT?x:LIMIT"));
+  Clamp->get_body()->stmt_return(
+      C.expr_call(C.expr_raw("helper"), {C.expr_var(X)}));
+  T->def_func_define(Clamp);
+  auto Split = split_file(F, "clamp");
+  EXPECT_EQ(Split.get_header_name(), "clamp.h");
+  EXPECT_EQ(Split.get_header(), "#ifndef CLAMP_H\n#define CLAMP_H\n"
+                                "\n#define LIMIT 16\n\n"
+                                "int clamp(int x);\n"
+                                "#endif // CLAMP_H\n");
+  ASSERT_EQ(Split.source_count(), 1u);
+  EXPECT_EQ(Split.get_source_name(0), "clamp.c");
+  EXPECT_EQ(Split.get_source(0),
+            "#include \"clamp.h\"\n"
+            "static int helper(int x){return x<LIMIT?x:LIMIT;}\n"
+            "int clamp(int x){return helper(x);}\n");
+  EXPECT_TRUE(Split.warnings().empty());
+}
+
+TEST(ShardTest, DefinitionInIf) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *If = T->directive_ifdef("DEBUG");
+  auto *Void = C.decl_var("", C.type_void());
+  If->get_then()->def_func("trace", C.type_void(), {Void})->get_or_add_body();
+  If->get_then()->def_func("check", C.type_int(), {Void});
+  If->get_or_add_else()->def_var("level", C.type_int(), C.expr_int(0));
+  auto Shards = shard_file(F, 2, "gen");
+  EXPECT_EQ(Shards.warnings(),
+            (std::vector<std::string>{
+                "The definition of trace in an #if branch is put in the "
+                "header.",
+                "The definition of level in an #if branch is put in the "
+                "header."}));
+}
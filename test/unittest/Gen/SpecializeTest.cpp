@@ -0,0 +1,72 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+TEST(SpecializeTest, Conditions) {
+  Context C;
+  MacroEnv Env;
+  Env.define("LEVEL", IntValue(IntKind::Int, 2));
+  Env.define("NAME", "foo");
+  Env.undefine("DEBUG");
+  auto Eval = [&](Expr *E) -> std::string {
+    auto V = eval_directive_cond(E, Env);
+    return V ? V->to_string() : "unknown";
+  };
+  EXPECT_EQ(Eval(C.EX(C.EX("LEVEL", ">", 1), "&&", C.EX("!", "DEBUG"))),
+            "1ll");
+  EXPECT_EQ(Eval(C.expr_raw("defined(NAME)")), "1ll");
+  EXPECT_EQ(Eval(C.expr_call(C.expr_raw("defined"), {C.expr_raw("DEBUG")})),
+            "0ll");
+  // Not an integer, and not known.
+  EXPECT_EQ(Eval(C.expr_raw("NAME")), "unknown");
+  EXPECT_EQ(Eval(C.expr_raw("OTHER")), "unknown");
+  // Decided by one side.
+  EXPECT_EQ(Eval(C.EX("OTHER", "||", "LEVEL")), "1ll");
+  EXPECT_EQ(Eval(C.EX("OTHER", "&&", "DEBUG")), "0ll");
+  // Both are uintmax_t in #if, unlike in C.
+  EXPECT_EQ(Eval(C.EX(-1, "<", 0u)), "0ll");
+  EXPECT_EQ(Eval(C.EX(C.expr_raw("0x10"), "<<", 30)), "17179869184ll");
+  Env.set_closed(true);
+  EXPECT_EQ(Eval(C.expr_raw("OTHER")), "0ll");
+}
+
+TEST(SpecializeTest, Branches) {
+  Context C;
+  CFile F(C);
+  auto *T = F.get_first_top_level();
+  T->def_macro_value("MAX", "16");
+  auto *If = T->directive_if(C.EX(C.EX("LEVEL", ">", 1), "&&",
+                                  C.EX("MAX", ">=", 16)));
+  If->get_then()->def_var("a", C.type_int());
+  If->get_or_add_else()->def_var("b", C.type_int());
+  auto *Ifdef = T->directive_ifdef("DEBUG");
+  Ifdef->get_then()->def_var("x", C.type_int());
+  Ifdef->add_elif(C.EX("LEVEL", "==", 2))->def_var("y", C.type_int());
+  auto *Unknown = T->directive_ifdef("UNKNOWN");
+  Unknown->get_then()->def_macro_value("MAX", "8");
+  // Nested ones are specialized in the kept branches.
+  Unknown->get_then()->directive_ifndef("DEBUG")->get_then()->def_var(
+      "z", C.type_int());
+  // MAX may have been redefined.
+  T->directive_if(C.EX("MAX", "==", 16))
+      ->get_then()
+      ->def_var("w", C.type_int());
+
+  MacroEnv Env;
+  Env.define("LEVEL", IntValue(IntKind::Int, 2));
+  Env.undefine("DEBUG");
+  auto Stats = specialize_directives(F, Env);
+  EXPECT_EQ(Stats.Resolved, 3u);
+  EXPECT_EQ(Stats.Kept, 2u);
+  EXPECT_EQ(F.to_string(), "\n#define MAX 16\n\n"
+                           "int a;\n"
+                           "int y;\n\n"
+                           "#ifdef UNKNOWN\n"
+                           "\n#define MAX 8\n\n"
+                           "int z;\n\n"
+                           "#endif\n\n\n"
+                           "#if (MAX==16)\n"
+                           "int w;\n\n"
+                           "#endif\n\n\n");
+}
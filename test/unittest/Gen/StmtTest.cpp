@@ -144,9 +144,93 @@ TEST(StmtTest, SwitchStmtTest) {
                             "default:raw_default_stmt;break;}");
 }
 
+TEST(StmtTest, LikelihoodTest) {
+  auto *I = S.stmt_if(C.expr_raw("x<0"));
+  I->set_likelihood(Likelihood::Unlikely);
+  I->add_elseif(C.expr_raw("x==0"), Likelihood::Likely);
+  I->add_elseif(C.expr_raw("x==1"));
+  EXPECT_EQ(I->to_string(), "if(__builtin_expect(!!(x<0),0)){}"
+                            "else if(__builtin_expect(!!(x==0),1)){}"
+                            "else if(x==1){}");
+  auto *W = S.stmt_while(C.expr_raw("more"));
+  W->set_likelihood(Likelihood::Likely);
+  EXPECT_EQ(W->to_string(), "while(__builtin_expect(!!(more),1)){}");
+  // The likelihood of a case is not emitted, keeping the controlling
+  // expression as it is.
+  auto *Sw = S.stmt_switch(C.expr_raw("op"));
+  Sw->add_case(C.expr_int(1))->set_likelihood(Likelihood::Unlikely);
+  Sw->add_case(C.expr_int(2))->set_likelihood(Likelihood::Likely);
+  EXPECT_EQ(Sw->to_string(), "switch(op){case 1:break;case 2:break;}");
+}
+
 TEST(StmtTest, SeqTest) {
   FuncScope S(C); // Local scope
   auto *S1 = S.stmt_raw("stmt1;");
   auto *S2 = S.stmt_raw("stmt2;");
   EXPECT_EQ(S.to_string(), "stmt1;stmt2;");
 }
+
+TEST(StmtTest, InsertPointTest) {
+  FuncScope S(C); // Local scope
+  auto *Ret = S.stmt_return(C.expr_raw("x"));
+  S.set_insert_point_before(Ret);
+  S.stmt_raw("a;");
+  S.stmt_raw("b;");
+  S.set_insert_point_start();
+  S.def_var("x", C.type_int());
+  S.set_insert_point_after(Ret);
+  S.stmt_raw("c;");
+  EXPECT_EQ(S.to_string(), "int x;a;b;return x;c;");
+  S.set_insert_point_end();
+  S.stmt_raw("d;");
+  EXPECT_EQ(S.to_string(), "int x;a;b;return x;c;d;");
+}
+
+TEST(StmtTest, RemoveAndMoveTest) {
+  FuncScope S(C); // Local scope
+  auto *S1 = S.stmt_raw("stmt1;");
+  auto *S2 = S.stmt_raw("stmt2;");
+  auto *S3 = S.stmt_raw("stmt3;");
+  S.hoist_to_start(S3);
+  EXPECT_EQ(S.to_string(), "stmt3;stmt1;stmt2;");
+  S.move_before(nullptr, S1);
+  EXPECT_EQ(S.to_string(), "stmt3;stmt2;stmt1;");
+  S.set_insert_point_before(S2);
+  auto Removed = S.remove(S2);
+  EXPECT_EQ(Removed.get(), S2);
+  EXPECT_EQ(S.get_insert_point(), S1);
+  EXPECT_EQ(S.to_string(), "stmt3;stmt1;");
+  S.insert_before(S3, std::move(Removed));
+  EXPECT_EQ(S.to_string(), "stmt2;stmt3;stmt1;");
+  EXPECT_EQ(S.get_first(), S2);
+  EXPECT_EQ(S.get_last(), S1);
+  EXPECT_EQ(S3->get_prev(), S2);
+  EXPECT_EQ(S3->get_next(), S1);
+}
+
+TEST(StmtTest, SpliceTest) {
+  FuncScope S(C); // Local scope
+  FuncScope Other(C);
+  auto *S1 = S.stmt_raw("stmt1;");
+  S.stmt_raw("stmt2;");
+  auto *O1 = Other.stmt_raw("other1;");
+  auto *O2 = Other.stmt_raw("other2;");
+  Other.stmt_raw("other3;");
+  EXPECT_TRUE(S.splice_before(S1, &Other, O1, O2));
+  EXPECT_EQ(S.to_string(), "other1;other2;stmt1;stmt2;");
+  // Within the same scope, not before an entry of the range itself.
+  EXPECT_FALSE(S.splice_before(O2, &S, O1, S1));
+  EXPECT_TRUE(S.splice_before(nullptr, &S, O1, O2));
+  EXPECT_EQ(S.to_string(), "stmt1;stmt2;other1;other2;");
+  EXPECT_TRUE(S.splice_before(S1, &S, O1, O2));
+  EXPECT_EQ(Other.to_string(), "other3;");
+  S.splice_before(nullptr, &Other);
+  EXPECT_EQ(S.to_string(), "other1;other2;stmt1;stmt2;other3;");
+  EXPECT_TRUE(Other.empty());
+  size_t Count = 0;
+  for (auto *E : S.entries()) {
+    EXPECT_NE(cast<Stmt>(E), nullptr);
+    Count++;
+  }
+  EXPECT_EQ(Count, 5u);
+}
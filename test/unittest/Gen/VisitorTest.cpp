@@ -0,0 +1,133 @@
+#include "NameC.h"
+#include <gtest/gtest.h>
+
+using namespace namec;
+
+static void def_file(Context &C, CFile &F) {
+  auto *T = F.get_first_top_level();
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Main = T->def_func("main", C.type_int(), {X})->get_or_add_body();
+  auto *If = Main->stmt_if(C.expr_binary(
+      ">", C.expr_var(X),
+      C.expr_paren(C.expr_binary("+", C.expr_int(1), C.expr_int(2)))));
+  If->get_then()->stmt_expr(C.expr_call(C.expr_raw("f"), {C.expr_var(X)}));
+  If->add_elseif(C.expr_paren(C.expr_var(X)))->stmt_return(C.expr_int(1));
+  auto *W = Main->stmt_while(
+      C.expr_paren(C.expr_binary("<", C.expr_var(X), C.expr_int(3))));
+  W->get_body()->stmt_expr(C.expr_call(C.expr_raw("g"), {}));
+  Main->stmt_return(C.expr_paren(C.expr_int(0)));
+}
+
+struct Counter : RecursiveVisitor<Counter> {
+  size_t Exprs = 0, Calls = 0, Stmts = 0, Binaries = 0;
+  bool visit_expr(Expr *) {
+    Exprs++;
+    return true;
+  }
+  bool visit_call_expr(CallExpr *) {
+    Calls++;
+    return true;
+  }
+  bool visit_stmt(Stmt *) {
+    Stmts++;
+    return true;
+  }
+  bool visit_binary_op(BinaryOp *) {
+    Binaries++;
+    return true;
+  }
+};
+
+TEST(VisitorTest, RecursiveVisitor) {
+  Context C;
+  CFile F(C);
+  def_file(C, F);
+  Counter V;
+  EXPECT_TRUE(V.traverse_file(&F));
+  EXPECT_EQ(V.Calls, 2u);
+  EXPECT_EQ(V.Binaries, 3u);
+  EXPECT_EQ(V.Stmts, 6u);
+  // x>(1+2):6, f(x):3, (x):2, 1:1, (x<3):4, g():2, (0):2.
+  EXPECT_EQ(V.Exprs, 20u);
+}
+
+struct FirstCall : RecursiveVisitor<FirstCall> {
+  CallExpr *Found = nullptr;
+  bool visit_call_expr(CallExpr *E) {
+    Found = E;
+    return false;
+  }
+};
+
+TEST(VisitorTest, StopTraversal) {
+  Context C;
+  CFile F(C);
+  def_file(C, F);
+  FirstCall V;
+  EXPECT_FALSE(V.traverse_file(&F));
+  ASSERT_NE(V.Found, nullptr);
+  EXPECT_EQ(V.Found->to_string(), "f(x)");
+}
+
+struct ParenRemover : Rewriter<ParenRemover> {
+  Expr *transform_expr(Expr *E) {
+    if (auto *P = cast<ParenExpr>(E)) {
+      return P->get_inside();
+    }
+    return E;
+  }
+  // Remove the calls of g.
+  void transform_entry(FuncScope *S, ScopeEntry *E) {
+    auto *ES = cast<ExprStmt>(E);
+    if (ES && ES->get_expr()->to_string() == "g()") {
+      S->remove(E);
+    }
+  }
+};
+
+TEST(VisitorTest, Rewriter) {
+  Context C;
+  CFile F(C);
+  def_file(C, F);
+  ParenRemover().rewrite_file(&F);
+  EXPECT_EQ(F.to_string(), "int main(int x){if(x>1+2){f(x);}"
+                           "else if(x){return 1;}while(x<3){}return 0;}\n\n");
+}
+
+// Doubles the integer literals, and skips the bodies of the while loops.
+struct Doubler : Rewriter<Doubler> {
+  Context &C;
+  size_t Transformed = 0;
+  Doubler(Context &C) : C(C) {}
+  Expr *transform_expr(Expr *E) {
+    Transformed++;
+    if (auto *I = cast<IntLiteral>(E)) {
+      return C.expr_int(static_cast<int>(I->get_value().get_signed() * 2));
+    }
+    return E;
+  }
+  void rewrite_stmt(Stmt *S) {
+    if (S->get_kind() != StmtKind::While) {
+      Rewriter::rewrite_stmt(S);
+    }
+  }
+};
+
+TEST(VisitorTest, RewriterShared) {
+  Context C;
+  CFile F(C);
+  auto *Shared = C.expr_binary("+", C.expr_int(1), C.expr_int(2));
+  auto *S = F.get_first_top_level()
+                ->def_func("f", C.type_void(), {C.decl_var("", C.type_void())})
+                ->get_or_add_body();
+  auto *If = S->stmt_if(Shared);
+  If->get_then()->stmt_expr(Shared);
+  If->get_then()->stmt_while(C.expr_int(5))->get_body()->stmt_expr(Shared);
+  Doubler D(C);
+  D.rewrite_file(&F);
+  // The shared 1+2 is rewritten once, and the while is skipped in the then
+  // branch too.
+  EXPECT_EQ(D.Transformed, 3u);
+  EXPECT_EQ(F.to_string(),
+            "void f(void){if(2+4){2+4;while(5){2+4;}}}\n\n");
+}
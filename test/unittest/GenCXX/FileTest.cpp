@@ -31,6 +31,29 @@ TEST(FileTest, FileOutPut) {
   std::filesystem::remove(P);
 }
 
+TEST(FileTest, SkipUnchanged) {
+  CXXFile F(C);
+  auto *Main = F.get_first_top_level()->def_func("main", C.type_int(), {});
+  Main->get_or_add_body()->stmt_return(C.expr_int(0));
+  std::filesystem::path P = "skip_unchanged.cpp";
+  std::filesystem::remove(P);
+  EXPECT_EQ(F.emit_to_file(P, true), WriteResult::Written);
+  auto Time = std::filesystem::last_write_time(P);
+  EXPECT_EQ(F.emit_to_file(P, true), WriteResult::Unchanged);
+  EXPECT_EQ(std::filesystem::last_write_time(P), Time);
+  // Default behavior always writes.
+  EXPECT_EQ(F.emit_to_file(P), WriteResult::Written);
+  Main->get_or_add_body()->stmt_return(C.expr_int(1));
+  EXPECT_EQ(F.emit_to_file(P, true), WriteResult::Written);
+  EXPECT_FALSE(std::filesystem::exists(P.string() + ".tmp"));
+  std::ifstream IS(P);
+  std::string Str;
+  std::getline(IS, Str);
+  EXPECT_EQ(Str, "int main(){return 0;return 1;}");
+  IS.close();
+  std::filesystem::remove(P);
+}
+
 TEST(FileTest, VarArgFunc) {
   CXXFile F(C);
   auto *T = F.get_first_top_level();
@@ -99,3 +122,18 @@ TEST(FileTest, TemplateInstantiations) {
             "template<typename T,int I> cls<T> func(T x){return cls<T>(x);}\n"
             "T cls::method(T x)const {return x+field1;}\n\n");
 }
+
+TEST(FileTest, EmitChunks) {
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  T->def_func("main", C.type_int(), {})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_int(0));
+  std::string Joined;
+  for (std::string_view Chunk : F.emit_chunks(4)) {
+    EXPECT_LE(Chunk.size(), 4u);
+    Joined += Chunk;
+  }
+  EXPECT_EQ(Joined, F.to_string());
+}
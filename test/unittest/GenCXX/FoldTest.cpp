@@ -0,0 +1,92 @@
+#include "NameCXX.h"
+#include <gtest/gtest.h>
+
+using namespace namecxx;
+
+static void def_getter(Context &C, TopLevel *T, std::string Name) {
+  auto *P = C.decl_var("p", C.type_ref(C.type_int()));
+  auto *FD = T->def_func(Name, C.type_int(), {P});
+  FD->get_or_add_body()->stmt_return(C.expr_var(P));
+}
+
+TEST(FoldTest, Forward) {
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  def_getter(C, T, "get_a");
+  def_getter(C, T, "get_b");
+  auto *NS = T->def_namespace("ns");
+  // Not folded across the namespaces.
+  def_getter(C, NS, "get_c");
+  def_getter(C, NS, "get_d");
+  auto Stats = fold_identical_functions(C, F);
+  EXPECT_EQ(Stats.Functions, 4u);
+  EXPECT_EQ(Stats.Folded, 2u);
+  EXPECT_EQ(F.to_string(),
+            "int get_a(int& p){return p;}\n"
+            "int get_b(int& p){return get_a(p);}\n\n"
+            "namespace ns{int get_c(int& p){return p;}\n"
+            "int get_d(int& p){return get_c(p);}\n}\n\n");
+}
+
+TEST(FoldTest, Linkage) {
+  // The folded functions keep their linkage and inline-ness.
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  def_getter(C, T, "get_a");
+  def_getter(C, T, "get_b");
+  def_getter(C, T, "get_c");
+  def_getter(C, T, "get_d");
+  std::vector<FuncDecl *> Fs;
+  for (auto *E : T->entries()) {
+    Fs.push_back(dynamic_cast<FuncDecl *>(E));
+  }
+  Fs[2]->set_static(true);
+  Fs[3]->set_static(true);
+  Fs[3]->get_body()->stmt_raw("p++;");
+  auto Stats = fold_identical_functions(C, F);
+  EXPECT_EQ(Stats.Folded, 1u);
+  EXPECT_FALSE(Fs[1]->is_inline());
+  EXPECT_FALSE(Fs[1]->is_static());
+  EXPECT_EQ(Fs[3]->get_body()->to_string(), "return p;p++;");
+}
+
+TEST(FoldTest, StructuralHash) {
+  Context C;
+  StructuralHasher H;
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Y = C.decl_var("y", C.type_int());
+  EXPECT_EQ(H.hash(C.expr_binary("+", C.expr_var(X), C.expr_int(1))),
+            H.hash(C.expr_binary("+", C.expr_var(X), C.expr_int(1))));
+  EXPECT_NE(H.hash(C.expr_binary("+", C.expr_var(X), C.expr_int(1))),
+            H.hash(C.expr_binary("+", C.expr_var(Y), C.expr_int(1))));
+  // f(a,b) and f(a)(b) differ, though both have f, a and b in order.
+  auto *F = C.expr_raw("f");
+  auto *A = C.expr_raw("a");
+  auto *B = C.expr_raw("b");
+  EXPECT_NE(H.hash(C.expr_call(F, {A, B})),
+            H.hash(C.expr_call(C.expr_call(F, {A}), {B})));
+  // The declarations are hashed by their emitted code.
+  EXPECT_EQ(H.hash_emitted(X), H.hash_emitted(C.decl_var("x", C.type_int())));
+  EXPECT_NE(H.hash_emitted(X), H.hash_emitted(Y));
+}
+
+TEST(FoldTest, StaticLocal) {
+  // The folded functions would share the static locals.
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  for (auto *Name : {"next_a", "next_b"}) {
+    auto *Block = T->def_func(Name, C.type_int(), {})
+                      ->get_or_add_body()
+                      ->stmt_block()
+                      ->get_scope();
+    auto *N = Block->def_var("n", C.type_int());
+    N->set_static(true);
+    Block->stmt_return(C.expr_pre_unary("++", C.expr_var(N)));
+  }
+  auto Stats = fold_identical_functions(C, F);
+  EXPECT_EQ(Stats.Folded, 0u);
+  EXPECT_EQ(F.to_string().find("next_a("), F.to_string().rfind("next_a("));
+}
@@ -0,0 +1,29 @@
+#include "NameCXX.h"
+#include <gtest/gtest.h>
+
+using namespace namecxx;
+
+TEST(IncludeTest, Dedup) {
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  T->include_sys("vector");
+  auto *NS = T->def_namespace("ns");
+  NS->include("inner.inc");
+  NS->include("inner.inc");
+  T->include_sys("vector");
+  T->include_sys("string");
+  EXPECT_EQ(dedup_includes(F), 1u);
+  EXPECT_EQ(F.to_string(), "\n#include <vector>\n\n"
+                           "\nnamespace ns{\n#include \"inner.inc\"\n\n"
+                           "\n#include \"inner.inc\"\n\n}\n"
+                           "\n#include <string>\n\n\n");
+
+  CXXFile G(C);
+  G.get_first_top_level()->include_sys("vector");
+  // After the namespace in F, so not a candidate.
+  G.get_first_top_level()->include_sys("string");
+  auto PCH = extract_common_includes({&F, &G}, 2, "pch");
+  EXPECT_EQ(PCH.get_header_name(), "pch.hpp");
+  EXPECT_EQ(PCH.get_includes(), std::vector<std::string>{"<vector>"});
+}
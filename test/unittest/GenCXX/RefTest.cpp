@@ -0,0 +1,72 @@
+#include "NameCXX.h"
+#include <gtest/gtest.h>
+
+using namespace namecxx;
+
+TEST(RefTest, Overloads) {
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *X = C.decl_var("x", C.type_int());
+  auto *NS = T->def_namespace("ns");
+  auto *One = NS->def_func("f", C.type_int(), {X});
+  One->get_or_add_body()->stmt_return(C.expr_var(X));
+  auto *Y = C.decl_var("y", C.type_int());
+  auto *Z = C.decl_var("z", C.type_int(), C.expr_int(0));
+  auto *Two = NS->def_func("f", C.type_int(), {Y, Z});
+  Two->get_or_add_body()->stmt_return(C.expr_var(Z));
+  auto *Other = T->def_namespace("other");
+  auto *Three = Other->def_func("f", C.type_int(), {});
+  Three->get_or_add_body()->stmt_return(C.expr_int(3));
+
+  // Looked up from ns, the enclosing namespace.
+  auto *G = NS->def_func("g", C.type_int(), {});
+  auto *GBody = G->get_or_add_body();
+  // Only ns::f accepts 2 arguments.
+  GBody->stmt_expr(
+      C.expr_call(C.expr_raw("f"), {C.expr_int(1), C.expr_int(2)}));
+  GBody->stmt_return(C.expr_call(C.expr_qual_name(C.QN("other", "f")), {}));
+
+  auto *Main = T->def_func("main", C.type_int(), {});
+  auto *Body = Main->get_or_add_body();
+  // Not found from the global namespace, though ns::f and other::f end
+  // with it.
+  Body->stmt_expr(C.expr_call(C.expr_raw("f"), {}));
+  // Both ns::f accept 1 argument.
+  Body->stmt_expr(C.expr_call(C.expr_raw("ns::f"), {C.expr_int(1)}));
+  Body->stmt_return(C.expr_call(C.expr_raw("ns::g"), {}));
+
+  auto Index = build_ref_index(F);
+  EXPECT_EQ(Index.functions(),
+            (std::vector<FuncDecl *>{One, Two, G, Three, Main}));
+  EXPECT_EQ(Index.callees(G), (std::vector<FuncDecl *>{Two, Three}));
+  EXPECT_EQ(Index.callees(Main), std::vector<FuncDecl *>{G});
+  EXPECT_EQ(Index.unresolved_calls().size(), 2u);
+  EXPECT_EQ(Index.uses(Z).size(), 1u);
+  EXPECT_EQ(Index.uses(Z)[0].User, Two);
+}
+
+TEST(RefTest, Scopes) {
+  // The inner declaration hides the outer one.
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *Outer = T->def_func("h", C.type_void(), {});
+  Outer->get_or_add_body();
+  auto *NS = T->def_namespace("ns");
+  auto *Inner = NS->def_func("h", C.type_void(), {});
+  Inner->get_or_add_body();
+  auto *Nested = NS->def_namespace("nested");
+  auto *K = Nested->def_func("k", C.type_void(), {});
+  K->get_or_add_body()->stmt_expr(C.expr_call(C.expr_raw("h"), {}));
+  // Out of the namespace, the body of ns::nested::m is in it.
+  auto *M = T->def_func(C.QN("ns", "nested", "m"), C.type_void(), {});
+  M->get_or_add_body()->stmt_expr(C.expr_call(C.expr_raw("k"), {}));
+  auto *Main = T->def_func("main", C.type_int(), {});
+  Main->get_or_add_body()->stmt_expr(C.expr_call(C.expr_raw("h"), {}));
+
+  auto Index = build_ref_index(F);
+  EXPECT_EQ(Index.callees(K), std::vector<FuncDecl *>{Inner});
+  EXPECT_EQ(Index.callees(M), std::vector<FuncDecl *>{K});
+  EXPECT_EQ(Index.callees(Main), std::vector<FuncDecl *>{Outer});
+}
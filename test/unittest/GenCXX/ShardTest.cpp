@@ -0,0 +1,150 @@
+#include "NameCXX.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace namecxx;
+
+// Whether the C++ compiler accepts the source of Shards with its header.
+static bool compiles(const ShardedFile &Shards) {
+  auto Dir = std::filesystem::temp_directory_path() / "namecxx_shard_test";
+  std::filesystem::create_directories(Dir);
+  std::ofstream(Dir / Shards.get_header_name()) << Shards.get_header();
+  bool Result = true;
+  for (size_t I = 0; I < Shards.source_count(); ++I) {
+    auto Path = Dir / Shards.get_source_name(I);
+    std::ofstream(Path) << Shards.get_source(I);
+    auto Command = std::string(NAMEC_TEST_CXX_COMPILER) +
+                   " -std=c++17 -fsyntax-only " + Path.string();
+    Result &= std::system(Command.c_str()) == 0;
+  }
+  std::filesystem::remove_all(Dir);
+  return Result;
+}
+
+TEST(ShardTest, Split) {
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  T->include_sys("vector");
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Cls = T->def_class("Cls", {})->get_class();
+  auto *Get = Cls->add_public_scope()->def_method_declare("get", C.type_int(),
+                                                          {X});
+  Get->get_body()->stmt_return(C.expr_var(X));
+  T->def_method_define(Get);
+  auto *NS = T->def_namespace("ns");
+  NS->def_func("square", C.type_int(), {X})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_binary("*", C.expr_var(X), C.expr_var(X)));
+  auto *Anon = NS->def_namespace("");
+  Anon->def_func("twice", C.type_int(), {X})
+      ->get_or_add_body()
+      ->stmt_return(C.expr_binary("+", C.expr_var(X), C.expr_var(X)));
+  NS->def_func("quad", C.type_int(), {X})
+      ->get_or_add_body()
+      ->stmt_return(
+          C.expr_call(C.expr_raw("twice"),
+                      {C.expr_call(C.expr_raw("twice"), {C.expr_var(X)})}));
+  auto *Inl = NS->def_func("id", C.type_int(), {X});
+  Inl->set_inline(true);
+  Inl->get_or_add_body()->stmt_return(C.expr_var(X));
+  auto Shards = shard_file(F, 2, "gen");
+  EXPECT_EQ(Shards.get_header_name(), "gen.hpp");
+  EXPECT_EQ(Shards.get_header(), "#ifndef GEN_HPP\n#define GEN_HPP\n"
+                                 "\n#include <vector>\n\n"
+                                 "class Cls{public:\nint get(int x);\n};\n"
+                                 "namespace ns{\n"
+                                 "int square(int x);\n"
+                                 "int quad(int x);\n"
+                                 "inline int id(int x){return x;}\n"
+                                 "}\n"
+                                 "#endif // GEN_HPP\n");
+  ASSERT_EQ(Shards.source_count(), 2u);
+  EXPECT_EQ(Shards.get_source_name(0), "gen_0.cpp");
+  EXPECT_EQ(Shards.get_source(0), "#include \"gen.hpp\"\n"
+                                  "namespace ns{\n"
+                                  "namespace {\n"
+                                  "int twice(int x){return x+x;}\n"
+                                  "}\n"
+                                  "int quad(int x){return twice(twice(x));}\n"
+                                  "}\n");
+  EXPECT_EQ(Shards.get_source(1), "#include \"gen.hpp\"\n"
+                                  "int Cls::get(int x){return x;}\n"
+                                  "namespace ns{\n"
+                                  "int square(int x){return x*x;}\n"
+                                  "}\n");
+}
+
+TEST(ShardTest, HeaderSource) {
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Cls = T->def_class("Cls", {})->get_class();
+  Cls->add_private_scope()->def_field("v", C.type_int());
+  auto *Ctor = Cls->add_public_scope()->def_ctor_declare({X});
+  Ctor->add_init("v", C.expr_var(X));
+  auto *Get = Cls->add_public_scope()->def_method_declare("get", C.type_int(),
+                                                          {});
+  Get->set_const();
+  Get->get_body()->stmt_return(C.expr_raw("v"));
+  T->def_ctor_define(Ctor);
+  T->def_method_define(Get);
+  auto *TV = C.decl_var("T", C.type_type_name());
+  auto *Box = T->def_class_template("Box", {TV}, {})->get_decl()->get_class();
+  auto *Put = Box->add_public_scope()->def_method_declare("put", C.type_void(),
+                                                          {});
+  T->def_method_define(Put);
+  auto Split = split_file(F, "cls");
+  EXPECT_EQ(Split.get_header_name(), "cls.hpp");
+  EXPECT_EQ(Split.get_header(), "#ifndef CLS_HPP\n#define CLS_HPP\n"
+                                "class Cls{private:\nint v;\n"
+                                "public:\nCls(int x);\n"
+                                "public:\nint get()const ;\n};\n"
+                                "template<typename T> class Box{public:\n"
+                                "void put();\n};\n"
+                                "void Box::put(){}\n"
+                                "#endif // CLS_HPP\n");
+  ASSERT_EQ(Split.source_count(), 1u);
+  EXPECT_EQ(Split.get_source_name(0), "cls.cpp");
+  EXPECT_EQ(Split.get_source(0), "#include \"cls.hpp\"\n"
+                                 "Cls::Cls(int x):v(x){}\n"
+                                 "int Cls::get()const {return v;}\n");
+}
+
+TEST(ShardTest, DefinitionInIf) {
+  Context C;
+  CXXFile F(C);
+  auto *If = F.get_first_top_level()->directive_ifdef("DEBUG");
+  auto *NS = If->get_then()->def_namespace("dbg");
+  NS->def_func("trace", C.type_void(), {})->get_or_add_body();
+  auto *Inline = NS->def_func("check", C.type_void(), {});
+  Inline->set_inline(true);
+  Inline->get_or_add_body();
+  auto Split = split_file(F, "gen");
+  EXPECT_EQ(Split.warnings(),
+            std::vector<std::string>{
+                "The definition of trace in an #if branch is put in the "
+                "header."});
+}
+
+TEST(ShardTest, StaticMember) {
+  // The out-of-class definition is declared by the member, not by extern.
+  Context C;
+  CXXFile F(C);
+  auto *T = F.get_first_top_level();
+  auto *Cls = T->def_class("Cls", {})->get_class();
+  Cls->add_public_scope()->def_field("count", C.type_int())->set_static(true);
+  T->def_var(QualName(std::vector<std::string>{"Cls", "count"}), C.type_int(),
+             C.expr_int(0));
+  T->def_var("total", C.type_int(), C.expr_int(0));
+  auto Split = split_file(F, "cls");
+  EXPECT_EQ(Split.get_header(), "#ifndef CLS_HPP\n#define CLS_HPP\n"
+                                "class Cls{public:\nstatic int count;\n};\n"
+                                "extern int total;\n"
+                                "#endif // CLS_HPP\n");
+  EXPECT_TRUE(compiles(Split));
+  EXPECT_TRUE(compiles(shard_file(F, 2, "cls")));
+}
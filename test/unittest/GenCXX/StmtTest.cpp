@@ -158,6 +158,24 @@ TEST(StmtTest, SwitchStmtTest) {
                             "default:raw_default_stmt;break;}");
 }
 
+TEST(StmtTest, LikelihoodTest) {
+  auto *I = S.stmt_if(C.expr_raw("x<0"));
+  I->set_likelihood(Likelihood::Unlikely);
+  I->add_elseif(C.expr_raw("x==0"), nullptr, Likelihood::Likely);
+  I->get_or_add_else();
+  EXPECT_EQ(I->to_string(), "if(x<0)[[unlikely]]{}"
+                            "else if(x==0)[[likely]]{}else{}");
+  auto *F = S.stmt_for(C.expr_raw("init"), C.expr_raw("cond"),
+                       C.expr_raw("step"));
+  F->set_likelihood(Likelihood::Likely);
+  EXPECT_EQ(F->to_string(), "for(init;cond;step)[[likely]]{}");
+  auto *Sw = S.stmt_switch(C.expr_raw("op"));
+  Sw->add_case(C.expr_int(1))->set_likelihood(Likelihood::Unlikely);
+  Sw->add_default();
+  EXPECT_EQ(Sw->to_string(),
+            "switch(op){[[unlikely]]case 1:break;default:break;}");
+}
+
 TEST(StmtTest, SeqTest) {
   FuncScope S(C); // Local scope
   auto *S1 = S.stmt_raw("stmt1;");
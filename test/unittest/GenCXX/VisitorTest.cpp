@@ -0,0 +1,67 @@
+#include "NameCXX.h"
+#include <gtest/gtest.h>
+
+using namespace namecxx;
+
+static void def_file(Context &C, CXXFile &F) {
+  auto *NS = F.get_first_top_level()->def_namespace("ns");
+  auto *Cls = NS->def_class("Cls", {})->get_class();
+  auto *X = C.decl_var("x", C.type_int());
+  auto *Method = Cls->add_public_scope()
+                     ->def_method("method", C.type_int(), {X})
+                     ->get_or_add_body();
+  auto *Lambda = C.expr_lambda({}, {}, false);
+  Lambda->get_body()->stmt_return(C.expr_paren(C.expr_var(X)));
+  Method->stmt_expr(C.expr_call(C.expr_paren(Lambda), {}));
+  auto *For = Method->stmt_for_range(C.decl_var("y", C.type_raw("auto")),
+                                     C.expr_raw("vec"));
+  For->get_body()->stmt_expr(C.expr_call(C.expr_raw("f"), {C.expr_raw("y")}));
+  Method->stmt_return(C.expr_paren(C.expr_int(0)));
+}
+
+struct Counter : RecursiveVisitor<Counter> {
+  size_t Calls = 0, Lambdas = 0, Methods = 0;
+  bool visit_call_expr(CallExpr *) {
+    Calls++;
+    return true;
+  }
+  bool visit_lambda_expr(LambdaExpr *) {
+    Lambdas++;
+    return true;
+  }
+  bool visit_decl(Decl *D) {
+    Methods += dynamic_cast<MethodDecl *>(D) != nullptr;
+    return true;
+  }
+};
+
+TEST(VisitorTest, RecursiveVisitor) {
+  Context C;
+  CXXFile F(C);
+  def_file(C, F);
+  Counter V;
+  EXPECT_TRUE(V.traverse_file(&F));
+  EXPECT_EQ(V.Calls, 2u);
+  EXPECT_EQ(V.Lambdas, 1u);
+  EXPECT_EQ(V.Methods, 1u);
+}
+
+struct ParenRemover : Rewriter<ParenRemover> {
+  Expr *transform_expr(Expr *E) {
+    if (auto *P = cast<ParenExpr>(E)) {
+      return P->get_inside();
+    }
+    return E;
+  }
+};
+
+TEST(VisitorTest, Rewriter) {
+  Context C;
+  CXXFile F(C);
+  def_file(C, F);
+  ParenRemover().rewrite_file(&F);
+  EXPECT_EQ(F.to_string(),
+            "\nnamespace ns{class Cls{public:\n"
+            "int method(int x){[](){return x;}();for(auto y:vec){f(y);}"
+            "return 0;}\n};\n}\n\n");
+}
@@ -0,0 +1,48 @@
+#include "internal/Util/Json.h"
+#include <gtest/gtest.h>
+
+using namespace namec_util;
+
+TEST(JsonTest, Values) {
+  auto V = parse_json(R"( {"a": [1, -2.5e3, true, null], "b": {"c": "d"},)"
+                      R"( "a": "dup"} )");
+  ASSERT_TRUE(V);
+  EXPECT_EQ(V->K, JsonValue::Kind::Object);
+  auto *A = V->get("a");
+  ASSERT_NE(A, nullptr);
+  ASSERT_EQ(A->Items.size(), 4u);
+  EXPECT_EQ(A->Items[1].K, JsonValue::Kind::Number);
+  EXPECT_EQ(A->Items[1].Text, "-2.5e3");
+  EXPECT_EQ(A->Items[2].K, JsonValue::Kind::Bool);
+  EXPECT_EQ(A->Items[3].K, JsonValue::Kind::Null);
+  EXPECT_EQ(V->get("b")->get("c")->Text, "d");
+  EXPECT_EQ(V->Members.size(), 3u);
+  EXPECT_EQ(V->get("e"), nullptr);
+  EXPECT_EQ(A->get("a"), nullptr);
+}
+
+TEST(JsonTest, Strings) {
+  auto Str = [](std::string_view Text) -> std::string {
+    auto V = parse_json(Text);
+    return V ? V->Text : "none";
+  };
+  EXPECT_EQ(Str(R"("a\"b\\c\/d\n")"), "a\"b\\c/d\n");
+  EXPECT_EQ(Str(R"("A\u00e9\u20ac")"), "A\xc3\xa9\xe2\x82\xac");
+  // A surrogate pair is one code point.
+  EXPECT_EQ(Str(R"("\ud83d\ude00")"), "\xf0\x9f\x98\x80");
+  EXPECT_EQ(Str(R"("\ud83d")"), "none");
+  EXPECT_EQ(Str(R"("\ud83dx")"), "none");
+  EXPECT_EQ(Str(R"("\ude00")"), "none");
+  EXPECT_EQ(Str(R"("\u12")"), "none");
+  EXPECT_EQ(Str(R"("\q")"), "none");
+}
+
+TEST(JsonTest, Malformed) {
+  EXPECT_FALSE(parse_json(""));
+  EXPECT_FALSE(parse_json("[1,]"));
+  EXPECT_FALSE(parse_json(R"({"a" 1})"));
+  EXPECT_FALSE(parse_json("[1] 2"));
+  EXPECT_FALSE(parse_json("nul"));
+  EXPECT_FALSE(parse_json(std::string(300, '[') + std::string(300, ']')));
+  EXPECT_TRUE(parse_json(std::string(200, '[') + std::string(200, ']')));
+}